@@ -0,0 +1,13 @@
+#!/bin/bash
+
+. build.common
+. build.nix
+
+FILES_LIST="$COMMON_FILES
+$NIX_FILES
+$EMULATOR_FILES \
+main.micro-bench.cpp"
+
+
+# logger is enabled, its cost is one of the benchmarks
+g++ -O2 -g $FILES_LIST $NIX_OPTIONS $EMULATOR_OPTIONS $COMMON_OPTIONS -o micro-bench
@@ -0,0 +1,38 @@
+#!/bin/bash
+
+NIX_FILES="platform/nix/NixPlatform.h \
+platform/nix/NixPlatform.cpp \
+platform/nix/NixMonitor.h \
+platform/nix/NixMonitor.cpp \
+platform/nix/NixFutexMonitor.h \
+platform/nix/NixFutexMonitor.cpp \
+platform/nix/NixThread.h \
+platform/nix/NixThread.cpp \
+platform/nix/NixSocket.h \
+platform/nix/NixSocket.cpp \
+platform/nix/NixShmSocket.h \
+platform/nix/NixShmSocket.cpp \
+platform/nix/NixSocketConnector.h \
+platform/nix/NixSocketConnector.cpp \
+platform/nix/NixMappedFile.h \
+platform/nix/NixMappedFile.cpp"
+
+NIX_OPTIONS="-lpthread -Iplatform/nix"
+
+EMULATOR_FILES="emulator/HubEmulator.h \
+emulator/HubEmulator.cpp \
+emulator/LatencyHistogram.h \
+emulator/LatencyHistogram.cpp \
+emulator/SimulatedHub.h \
+emulator/SimulatedHub.cpp \
+emulator/JournalReplay.h \
+emulator/JournalReplay.cpp \
+emulator/SimulatedBroker.h \
+emulator/SimulatedBroker.cpp"
+
+EMULATOR_OPTIONS="-Iemulator"
+
+RELAY_FILES="relay/TicksRelay.h \
+relay/TicksRelay.cpp"
+
+RELAY_OPTIONS="-Irelay"
@@ -0,0 +1,13 @@
+#!/bin/bash
+
+. build.common
+. build.nix
+
+FILES_LIST="$COMMON_FILES
+$NIX_FILES
+$EMULATOR_FILES
+$RELAY_FILES \
+main.relay-bench.cpp"
+
+
+g++ -O2 -g -DDISABLE_LOGGER $FILES_LIST $NIX_OPTIONS $EMULATOR_OPTIONS $RELAY_OPTIONS $COMMON_OPTIONS -o relay-bench
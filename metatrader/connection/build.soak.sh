@@ -0,0 +1,12 @@
+#!/bin/bash
+
+. build.common
+. build.nix
+
+FILES_LIST="$COMMON_FILES
+$NIX_FILES
+$EMULATOR_FILES \
+main.soak.cpp"
+
+
+g++ -O2 -g -DDISABLE_LOGGER $FILES_LIST $NIX_OPTIONS $EMULATOR_OPTIONS $COMMON_OPTIONS -o soak
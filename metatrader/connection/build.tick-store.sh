@@ -0,0 +1,11 @@
+#!/bin/bash
+
+. build.common
+. build.nix
+
+FILES_LIST="$COMMON_FILES
+$NIX_FILES \
+main.tick-store.cpp"
+
+
+g++ -O2 -g $FILES_LIST $NIX_OPTIONS $COMMON_OPTIONS -o tick-store
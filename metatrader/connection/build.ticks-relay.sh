@@ -0,0 +1,12 @@
+#!/bin/bash
+
+. build.common
+. build.nix
+
+FILES_LIST="$COMMON_FILES
+$NIX_FILES
+$RELAY_FILES \
+main.ticks-relay.cpp"
+
+
+g++ -O2 -g $FILES_LIST $NIX_OPTIONS $RELAY_OPTIONS $COMMON_OPTIONS -o ticks-relay
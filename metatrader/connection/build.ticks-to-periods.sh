@@ -0,0 +1,11 @@
+#!/bin/bash
+
+. build.common
+. build.nix
+
+FILES_LIST="$COMMON_FILES
+$NIX_FILES \
+main.ticks-to-periods.cpp"
+
+
+g++ -O2 -g $FILES_LIST $NIX_OPTIONS $COMMON_OPTIONS -o ticks-to-periods
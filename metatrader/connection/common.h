@@ -2,6 +2,8 @@
 #define __66A6CEC32FB740A46585CF2BE40900CD_COMMON_H_INCLUDED__
 
 typedef unsigned long long uint64;
+typedef long long          int64;
 typedef unsigned int       uint32;
+typedef unsigned char      uint8;
 
 #endif 	// __66A6CEC32FB740A46585CF2BE40900CD_COMMON_H_INCLUDED__
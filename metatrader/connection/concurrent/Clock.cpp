@@ -0,0 +1,45 @@
+#include "Clock.h"
+#include <stdint.h>
+
+class RealClock : public Clock {
+public:
+   Platform::Milliseconds currentTime() {
+      return Platform::instance().currentTime();
+   }
+
+   void waitUntil(Monitor &monitor, Platform::Milliseconds time) {
+      const Platform::Milliseconds now = currentTime();
+
+      if (time > now) monitor.wait(time - now);
+   }
+
+   uint32 seedFor(const void *owner) {
+      // several owners are created at the same millisecond, so mix in
+      // their addresses too
+      return (uint32)(currentTime() ^ (uintptr_t)owner);
+   }
+};
+
+Clock &Clock::real() {
+   static RealClock clock;
+   return clock;
+}
+
+VirtualClock::VirtualClock(Platform::Milliseconds start)
+   : _now(start)
+   , _seeds(0) {
+
+}
+
+Platform::Milliseconds VirtualClock::currentTime() {
+   return _now;
+}
+
+void VirtualClock::waitUntil(Monitor &monitor, Platform::Milliseconds time) {
+   if (time > _now) _now = time;
+}
+
+uint32 VirtualClock::seedFor(const void *owner) {
+   // spreads consecutive numbers over the whole range
+   return ++_seeds * 2654435761u;
+}
@@ -0,0 +1,59 @@
+#ifndef __4E0F6A2B9C1D4F7E8A35B6C2D19E07F4_CLOCK_H_INCLUDED__
+#define __4E0F6A2B9C1D4F7E8A35B6C2D19E07F4_CLOCK_H_INCLUDED__
+
+#include <atomic>
+#include "platform.h"
+
+/**
+ * Source of time for a RunLoop and for everybody scheduling on it.
+ *
+ * Code running on a run loop should take time from RunLoop::currentTime()
+ * rather than from the platform, so it can be run in virtual time.
+ */
+class Clock {
+public:
+
+   virtual Platform::Milliseconds currentTime() = 0;
+
+   /**
+    * Called by the run loop with locked monitor when nothing is due
+    * before time, returns when time has come or monitor is notified.
+    */
+   virtual void waitUntil(Monitor &monitor, Platform::Milliseconds time) = 0;
+
+   // seed for randomness of owner, like reconnect jitter
+   virtual uint32 seedFor(const void *owner) = 0;
+
+   // clock of the platform, default one for run loops
+   static Clock &real();
+
+   virtual ~Clock() {}
+};
+
+/**
+ * Time stands still while the loop has work, when the loop is idle time
+ * jumps straight to the next due task.
+ *
+ * With everything running on the loop, hours of timers pass in
+ * milliseconds and order of events is the same in every run: tasks due at
+ * the same time run in order of posting, seeds are taken from a counter.
+ *
+ * Nothing waits for other threads: if they post to the loop, their tasks
+ * are seen at whatever virtual time the loop has got to.
+ */
+class VirtualClock : public Clock {
+public:
+   VirtualClock(Platform::Milliseconds start = 0);
+
+   Platform::Milliseconds currentTime();
+
+   void waitUntil(Monitor &monitor, Platform::Milliseconds time);
+
+   uint32 seedFor(const void *owner);
+
+private:
+   std::atomic<Platform::Milliseconds> _now;
+   std::atomic<uint32> _seeds;
+};
+
+#endif 	// __4E0F6A2B9C1D4F7E8A35B6C2D19E07F4_CLOCK_H_INCLUDED__
@@ -1,18 +1,57 @@
 #include "RunLoop.h"
+#include "Clock.h"
 #include <algorithm>
 #include <stdio.h>
+#include <atomic>
+#include <chrono>
+
+static std::atomic<int64> tasksAlive(0);
+
+static std::atomic<int64> pollsCaught(0);
+static std::atomic<int64> pollsParked(0);
+
+enum {
+   // clock is read once in these spins
+   SPINS_PER_CLOCK_CHECK = 64,
+
+   // then the oldest ready task runs, whatever its lane is
+   MAX_OVERTAKES = 32
+};
+
+static inline void relax() {
+#if defined(__x86_64__) || defined(__i386__)
+   __builtin_ia32_pause();
+#else
+   asm volatile("" ::: "memory");
+#endif
+}
 
 class RunLoop::TaskInternal : public RunLoop::Task {
 public:
-   TaskInternal(const Platform::Milliseconds targetTime) : _targetTime(targetTime) {}
+   TaskInternal(const Platform::Milliseconds targetTime,
+                const Priority priority)
+      : _targetTime(targetTime)
+      , _priority(priority)
+      , _sequence(0) {
+      ++tasksAlive;
+   }
+
+   virtual ~TaskInternal() { --tasksAlive; }
 
    Platform::Milliseconds targetTime() const { return _targetTime; }
+   Priority priority() const { return _priority; }
+
+   // order of posting, set when queued
+   uint64 sequence() const { return _sequence; }
+   void setSequence(uint64 sequence) { _sequence = sequence; }
 
    virtual bool isTerminate() const = 0;
    virtual void run() = 0;
       
 private:
    const Platform::Milliseconds _targetTime;
+   const Priority _priority;
+   uint64 _sequence;
 };
    
 class RunLoop::ActionTask : public RunLoop::TaskInternal {
@@ -21,8 +60,9 @@ class RunLoop::ActionTask : public RunLoop::TaskInternal {
 
 public:
    ActionTask(const Platform::Milliseconds targetTime,
+              const Priority priority,
               const Action& action)
-      : TaskInternal(targetTime)
+      : TaskInternal(targetTime, priority)
       , _action(action) {
          
    } 
@@ -40,7 +80,7 @@ class RunLoop::TerminateTask : public RunLoop::TaskInternal {
    TerminateTask(const TerminateTask& task);      
 
 public:
-   TerminateTask(const Platform::Milliseconds targetTime) : TaskInternal(targetTime) {}
+   TerminateTask(const Platform::Milliseconds targetTime) : TaskInternal(targetTime, CONTROL) {}
 
    bool isTerminate() const { return true; }
          
@@ -49,13 +89,32 @@ public:
 };
 
 RunLoop::RunLoop()
-   : _taskListMonitor(Platform::instance().createMonitor()) {
+   : _clock(Clock::real())
+   , _taskListMonitor(Platform::instance().createMonitor())
+   , _overtakes(0)
+   , _busyPollMicroseconds(0)
+   , _posts(0) {
    
 } 
 
-RunLoop::Task *RunLoop::post(const Action& action) {
+RunLoop::RunLoop(Clock &clock)
+   : _clock(clock)
+   , _taskListMonitor(Platform::instance().createMonitor())
+   , _overtakes(0)
+   , _busyPollMicroseconds(0)
+   , _posts(0) {
+
+}
+
+Platform::Milliseconds RunLoop::currentTime() {
+   return _clock.currentTime();
+}
+
+RunLoop::Task *RunLoop::post(const Action& action,
+                             Priority priority) {
    return postDelayed(0,
-                      action);
+                      action,
+                      priority);
 } 
 
 bool RunLoop::isFirstTaskEarlier(TaskInternal *first,
@@ -64,12 +123,14 @@ bool RunLoop::isFirstTaskEarlier(TaskInternal *first,
 } 
 
 RunLoop::Task *RunLoop::postDelayed(Platform::Milliseconds delay,
-                                    const Action& action) {
-   const Platform::Milliseconds currentTime = Platform::instance().currentTime();
+                                    const Action& action,
+                                    Priority priority) {
+   const Platform::Milliseconds currentTime = _clock.currentTime();
 
    const Platform::Milliseconds targetTime = currentTime + delay;
    
    ActionTask *task = new ActionTask(targetTime,
+                                     priority,
                                      action);
 
    return putToQueue(task);
@@ -78,9 +139,19 @@ RunLoop::Task *RunLoop::postDelayed(Platform::Milliseconds delay,
 RunLoop::Task *RunLoop::putToQueue(TaskInternal *task) {
    _taskListMonitor->lock();
    
-   _tasks.push_back(task);
-   
-   _tasks.sort(isFirstTaskEarlier);
+   std::list<TaskInternal *> &tasks = _tasks[task->priority()];
+
+   // queue stays sorted, task goes after the tasks of the same time, as
+   // sort would put it; loop serving many connections has timers of all of
+   // them queued, so the queue isn't sorted again on every post
+   if (tasks.empty() || !isFirstTaskEarlier(task, tasks.back())) {
+      tasks.push_back(task);
+   } else {
+      tasks.insert(std::upper_bound(tasks.begin(), tasks.end(), task, isFirstTaskEarlier),
+                   task);
+   }
+
+   task->setSequence(_posts.fetch_add(1, std::memory_order_release));
 
    // if (_tasks.size() > 4000) {
    //    printf("queue size: %d", _tasks.size());
@@ -93,19 +164,26 @@ RunLoop::Task *RunLoop::putToQueue(TaskInternal *task) {
 } 
 
 void RunLoop::cancel(Task *task) {
-   // find task in tasks queue:
+   // find task in tasks queue, by pointer only, as it may be deleted
+   // already:
    _taskListMonitor->lock();
 
-   auto found = std::find(_tasks.begin(), _tasks.end(), task);
+   bool isQueued = false;
 
-   if (found != _tasks.end()) {
-      delete task;
-      _tasks.erase(found);
+   for (int lane = 0; lane < PRIORITIES && !isQueued; ++lane) {
+      auto found = std::find(_tasks[lane].begin(), _tasks[lane].end(), task);
+
+      isQueued = found != _tasks[lane].end();
+
+      if (isQueued) _tasks[lane].erase(found);
    }
 
    _taskListMonitor->notify();
    
    _taskListMonitor->unlock();
+
+   // what action holds is freed without the lock, it may post
+   if (isQueued) delete task;
 } 
 
 RunLoop::TaskInternal *RunLoop::popNextTask() {
@@ -118,28 +196,38 @@ RunLoop::TaskInternal *RunLoop::popNextTask() {
 
       // printf("tasks size: %lu, empty: %d\n", _tasks.size(), _tasks.empty());
       
-      if ( _tasks.empty() ) {
+      bool isEmpty = true;
+      Platform::Milliseconds earliest = 0;
+
+      for (int lane = 0; lane < PRIORITIES; ++lane) {
+         if (_tasks[lane].empty()) continue;
+
+         const Platform::Milliseconds targetTime = _tasks[lane].front()->targetTime();
+
+         if (isEmpty || targetTime < earliest) earliest = targetTime;
+
+         isEmpty = false;
+      }
+
+      if ( isEmpty ) {
+         if (_busyPollMicroseconds > 0 && spinForTask()) continue;
+
+         ++pollsParked;
+
          // printf("entering wait\n");
          _taskListMonitor->wait();
          // printf("leaved wait\n");
       } else {
-         // printf("processing first\n");
-
-         TaskInternal * const candidate = *_tasks.begin();
-
-         const Platform::Milliseconds currentTime = Platform::instance().currentTime();
+         const Platform::Milliseconds currentTime = _clock.currentTime();
 
-         // printf("current time: %llu, target time: %llu\n", currentTime, candidate->targetTime());
+         // printf("current time: %llu, target time: %llu\n", currentTime, earliest);
          
-         if (candidate->targetTime() < currentTime) {
-            // printf("returning first\n");
-            result = candidate;
-            _tasks.pop_front();
-
+         if (earliest <= currentTime) {
+            result = takeReadyTask(currentTime);
             break;
          } else {
             // printf("entering timed wait\n");
-            _taskListMonitor->wait(candidate->targetTime() - currentTime);
+            _clock.waitUntil(*_taskListMonitor, earliest);
             // printf("leaved timed wait\n");
          } 
       } 
@@ -150,6 +238,60 @@ RunLoop::TaskInternal *RunLoop::popNextTask() {
    return result;
 } 
 
+RunLoop::TaskInternal *RunLoop::takeReadyTask(Platform::Milliseconds currentTime) {
+   int highest = -1;
+   int oldest = -1;
+
+   for (int lane = 0; lane < PRIORITIES; ++lane) {
+      if (_tasks[lane].empty() || _tasks[lane].front()->targetTime() > currentTime) continue;
+
+      if (highest < 0) highest = lane;
+
+      if (oldest < 0 || _tasks[lane].front()->sequence() < _tasks[oldest].front()->sequence()) {
+         oldest = lane;
+      }
+   }
+
+   if (highest < 0) return nullptr;
+
+   int chosen = highest;
+
+   if (highest == oldest) {
+      _overtakes = 0;
+   } else if (++_overtakes > MAX_OVERTAKES) {
+      chosen = oldest;
+      _overtakes = 0;
+   }
+
+   TaskInternal * const task = _tasks[chosen].front();
+   _tasks[chosen].pop_front();
+
+   return task;
+}
+
+bool RunLoop::spinForTask() {
+   const uint64 posts = _posts.load(std::memory_order_relaxed);
+
+   _taskListMonitor->unlock();
+
+   const auto deadline = std::chrono::steady_clock::now() + std::chrono::microseconds(_busyPollMicroseconds);
+
+   for (int spins = 1; _posts.load(std::memory_order_acquire) == posts; ++spins) {
+      relax();
+
+      if (spins % SPINS_PER_CLOCK_CHECK == 0 && std::chrono::steady_clock::now() >= deadline) break;
+   }
+
+   _taskListMonitor->lock();
+
+   // a post after the spin is seen here, as the lock is taken again
+   const bool caught = _posts.load(std::memory_order_relaxed) != posts;
+
+   if (caught) ++pollsCaught;
+
+   return caught;
+}
+
 void RunLoop::run() {
 
    bool work = true;
@@ -168,26 +310,53 @@ void RunLoop::run() {
 }
 
 void RunLoop::deleteAllTasks() {
-   for (auto i = _tasks.begin(); i != _tasks.end(); ++i) {
+   for (int lane = 0; lane < PRIORITIES; ++lane) {
+      for (auto i = _tasks[lane].begin(); i != _tasks[lane].end(); ++i) {
 
-      delete *i;
-   }
+         delete *i;
+      }
 
-   _tasks.clear();
+      _tasks[lane].clear();
+   }
 } 
 
 void RunLoop::terminate() {
-   // delete all tasks
+   // delete all tasks, after the lock is released, as in cancel()
+
+   std::list<TaskInternal *> deleted;
 
    _taskListMonitor->lock();
 
-   deleteAllTasks();
+   for (int lane = 0; lane < PRIORITIES; ++lane) {
+      deleted.splice(deleted.end(), _tasks[lane]);
+   }
 
-   _tasks.push_back(new TerminateTask(0));
+   _tasks[CONTROL].push_back(new TerminateTask(0));
+
+   _posts.fetch_add(1, std::memory_order_release);
 
    _taskListMonitor->notify();
    
    _taskListMonitor->unlock();
+
+   for (TaskInternal *task : deleted) delete task;
+}
+
+void RunLoop::setBusyPoll(uint64 microseconds) {
+   _busyPollMicroseconds = Platform::instance().processorsCount() > 1 ? microseconds : 0;
+}
+
+int64 RunLoop::liveTasks() {
+   return tasksAlive;
+}
+
+RunLoop::PollStats RunLoop::pollStats() {
+   PollStats stats;
+
+   stats.caught = pollsCaught;
+   stats.parked = pollsParked;
+
+   return stats;
 }
 
 RunLoop::~RunLoop() {
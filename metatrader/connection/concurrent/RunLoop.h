@@ -2,9 +2,11 @@
 #define __66A6CEC32FB740A46585CF2BE40900CD_RUNLOOP_H_INCLUDED__
 
 #include <list>
+#include <atomic>
 #include <cstddef>
 #include "platform.h"
 
+class Clock;
 
 class RunLoop {
 
@@ -12,6 +14,20 @@ class RunLoop {
 public:
 
    typedef std::function<void()> Action;
+
+   /**
+    * Lanes of tasks, of ready tasks the one of higher lane runs first,
+    * tasks of one lane run in order. Lower lanes aren't starved, a task
+    * which waited while others overtook it too many times runs next.
+    */
+   enum Priority {
+      CONTROL,
+      TRADE,
+      TICKS,
+      LOGGING,
+
+      PRIORITIES
+   };
    
    // task is deleted internally by run loop, either when executed or
    // cancelled
@@ -34,10 +50,19 @@ public:
 
    RunLoop();
 
-   Task *post(const Action &action);
+   // loop in time of the clock, see VirtualClock
+   RunLoop(Clock &clock);
+
+   Platform::Milliseconds currentTime();
+
+   Clock &clock() { return _clock; }
+
+   Task *post(const Action &action,
+              Priority priority = CONTROL);
    
    Task *postDelayed(Platform::Milliseconds delay,
-                     const Action &action);
+                     const Action &action,
+                     Priority priority = CONTROL);
 
    void cancel(Task *task);
    
@@ -46,6 +71,26 @@ public:
 
    void deleteAllTasks();
 
+   /**
+    * Busy poll: loop which runs out of tasks spins this long waiting for a
+    * post before it sleeps, zero (default) sleeps at once. It's cpu for
+    * faster handoff, so spinning is off on one processor.
+    */
+   void setBusyPoll(uint64 microseconds);
+
+   // tasks of all loops which are not deleted yet, to find leaks
+   static int64 liveTasks();
+
+   struct PollStats {
+      // posts caught while spinning
+      int64 caught;
+      // spins which ran out and sleeps without spinning
+      int64 parked;
+   };
+
+   // of all loops, since the start
+   static PollStats pollStats();
+
    virtual ~RunLoop();
 
 private:
@@ -54,14 +99,31 @@ private:
    
    TaskInternal *popNextTask();
 
+   // ready task to run next, of lanes which have one, or nullptr
+   TaskInternal *takeReadyTask(Platform::Milliseconds currentTime);
+
+   // with the lock, which is released while spinning, true if a task was
+   // posted meanwhile
+   bool spinForTask();
+
    static bool isFirstTaskEarlier(TaskInternal *first,
                                   TaskInternal *second);
    
 private:
    
-   std::list<TaskInternal *> _tasks;
+   Clock &_clock;
+
+   // sorted by time
+   std::list<TaskInternal *> _tasks[PRIORITIES];
 
    Monitor *_taskListMonitor;
+
+   // times ready task of lower lane was passed over in a row
+   int _overtakes;
+
+   uint64 _busyPollMicroseconds;
+   // changed by every post, spinning loop watches it
+   std::atomic<uint64> _posts;
 };
 
 #endif 	// __66A6CEC32FB740A46585CF2BE40900CD_RUNLOOP_H_INCLUDED__
@@ -1,4 +1,5 @@
 #include "RunLoopUser.h"
+#include <memory>
 
 class RunLoopUserTask {
 public:
@@ -8,18 +9,19 @@ public:
       : _postedTasks(postedTasks)
       , _synchronization(synchronization)
       , _action(action)
-      , _task(nullptr) {
+      , _task(std::make_shared<RunLoop::Task *>(nullptr)) {
       
    }
 
+   // shared with the copy in the run loop, should be set under the lock
    void setCancelHandle(RunLoop::Task *task) {
-      _task = task;
+      *_task = task;
    } 
 
    void operator()() {
 
       _synchronization.lock();
-      _postedTasks.remove(_task);
+      _postedTasks.remove(*_task);
       _synchronization.unlock();
 
       _action();
@@ -29,7 +31,7 @@ private:
    std::list<RunLoop::Task *> &_postedTasks;
    Monitor &_synchronization;
    const RunLoop::Action _action;
-   RunLoop::Task *_task;
+   std::shared_ptr<RunLoop::Task *> _task;
 };
 
 RunLoopUser::RunLoopUser(RunLoop &loop)
@@ -38,15 +40,19 @@ RunLoopUser::RunLoopUser(RunLoop &loop)
    
 } 
 
-void RunLoopUser::post(const RunLoop::Action& action) {
+void RunLoopUser::post(const RunLoop::Action& action,
+                       RunLoop::Priority priority) {
    RunLoopUserTask task(_postedTasks,
                         *_synchronization,
                         action);
    
+   // task can't run before its handle is set
+   _synchronization->lock();
+
    RunLoop::Task *cancelHandle
-      = _loop.post(task);
+      = _loop.post(task,
+                   priority);
 
-   _synchronization->lock();
    _postedTasks.push_back(cancelHandle);
 
    task.setCancelHandle(cancelHandle);
@@ -54,16 +60,19 @@ void RunLoopUser::post(const RunLoop::Action& action) {
 } 
 
 void RunLoopUser::postDelayed(Platform::Milliseconds delay,
-                              const RunLoop::Action &action) {
+                              const RunLoop::Action &action,
+                              RunLoop::Priority priority) {
    RunLoopUserTask task(_postedTasks,
                         *_synchronization,
                         action);
    
+   _synchronization->lock();
+
    RunLoop::Task *cancelHandle
       = _loop.postDelayed(delay,
-                          task);
+                          task,
+                          priority);
 
-   _synchronization->lock();
    _postedTasks.push_back(cancelHandle);
 
    task.setCancelHandle(cancelHandle);
@@ -9,10 +9,12 @@ class RunLoopUser {
 public:
    RunLoopUser(RunLoop &loop);
 
-   void post(const RunLoop::Action& action);
+   void post(const RunLoop::Action& action,
+             RunLoop::Priority priority = RunLoop::CONTROL);
 
    void postDelayed(Platform::Milliseconds delay,
-                    const RunLoop::Action &action);
+                    const RunLoop::Action &action,
+                    RunLoop::Priority priority = RunLoop::CONTROL);
 
    RunLoop &runLoop() { return _loop; }
    
@@ -1,6 +1,7 @@
 #include "ConnectionHandle.h"
 #include <stdio.h>
 #include "ConnectionHandleListener.h"
+#include "OutputDataBuffer.h"
 #include "StateConnecting.h"
 #include "StateClosed.h"
 
@@ -29,6 +30,26 @@ ConnectionHandle::ConnectionHandle(RunLoop& runLoop,
    
 }
 
+ConnectionHandle::ConnectionHandle(RunLoop& runLoop,
+                                   Logger& logger,
+                                   ConnectionHandleListener &listener,
+                                   const StateFactory &initialState)
+   : RunLoopUser(runLoop)
+   , _nextState(NULL)
+   , _currentState(NULL)
+   , _listener(listener)
+   , _synchronization(Platform::instance().createMonitor())
+   , _stateContext(ConnectionState::Context(runLoop,
+                                            logger,
+                                            _synchronization,
+                                            std::bind(&ConnectionHandle::postSwitchState,
+                                                      this,
+                                                      std::placeholders::_1),
+                                            listener)) {
+
+   switchState(initialState(_stateContext));
+}
+
 void ConnectionHandle::withCurrentState(std::function<void(ConnectionState *)> action) {
    _synchronization->lock();
 
@@ -41,13 +62,27 @@ void ConnectionHandle::withCurrentState(std::function<void(ConnectionState *)> a
    _synchronization->unlock();
 }
 
-void ConnectionHandle::sendRawData(const std::string& buffer) {
+void ConnectionHandle::sendRawData(const std::string& buffer,
+                                   RunLoop::Priority priority) {
    withCurrentState([=](ConnectionState *state) -> void {
-         state->sendData(buffer);
+         state->sendData(buffer, priority);
       } );
 } 
 
+void ConnectionHandle::sendFrame(const SharedFrame &frame,
+                                 RunLoop::Priority priority) {
+   withCurrentState([&frame, priority](ConnectionState *state) -> void {
+         state->sendFrame(frame, priority);
+      } );
+}
+
+ConnectionHandle::SharedFrame ConnectionHandle::frame(const std::string &packet) {
+   return std::make_shared<const std::string>(OutputDataBuffer().putInt(packet.size()).buffer() + packet);
+}
+
 ConnectionHandle::~ConnectionHandle() {
+   deleteReplacedStates();
+
    if (_nextState)    delete _nextState;
    if (_currentState) delete _currentState;
 
@@ -55,11 +90,9 @@ ConnectionHandle::~ConnectionHandle() {
 } 
 
 void ConnectionHandle::postSwitchState(ConnectionState *nextState) {
-   _synchronization->lock();
-
    bool switchingInProgress = _nextState != NULL;
 
-   if (_nextState != NULL) delete _nextState;
+   if (_nextState != NULL) _replacedStates.push_back(_nextState);
 
    _nextState = nextState;
 
@@ -67,6 +100,8 @@ void ConnectionHandle::postSwitchState(ConnectionState *nextState) {
 
    if (!switchingInProgress && switchNeeded) {
       post([=]() -> void {
+            deleteReplacedStates();
+
             _synchronization->lock();
 
             ConnectionState *willSwitchTo = _nextState;
@@ -77,9 +112,17 @@ void ConnectionHandle::postSwitchState(ConnectionState *nextState) {
 
          } );
    } 
-   
+}
+
+void ConnectionHandle::deleteReplacedStates() {
+   _synchronization->lock();
+
+   std::list<ConnectionState *> replaced;
+   replaced.swap(_replacedStates);
 
    _synchronization->unlock();
+
+   for (ConnectionState *state : replaced) delete state;
 }
 
 
@@ -2,6 +2,7 @@
 #define __5B38EFCBEAF9BC48BC4BB89BC5A06F67_CONNECTION_H_INCLUDED__
 
 #include <string>
+#include <list>
 #include "platform.h"
 
 #include "RunLoopUser.h"
@@ -25,6 +26,10 @@ class ConnectionHandle : public RunLoopUser {
    
 public:
 
+   typedef std::function<ConnectionState *(const ConnectionState::Context &)> StateFactory;
+
+   typedef ConnectionState::SharedFrame SharedFrame;
+
    ConnectionHandle(RunLoop& runLoop,
                     Logger& logger,
                     const std::string& addressString,
@@ -32,7 +37,24 @@ public:
                     // connection handle will not delete it's listener
                     ConnectionHandleListener &listener);
 
-   void sendRawData(const std::string& buffer);
+   // starts from custom state instead of connecting, for simulations
+   ConnectionHandle(RunLoop& runLoop,
+                    Logger& logger,
+                    ConnectionHandleListener &listener,
+                    const StateFactory &initialState);
+
+   // of the same priority packets are sent in order
+   void sendRawData(const std::string& buffer,
+                    RunLoop::Priority priority = RunLoop::CONTROL);
+
+   /**
+    * Sends packet framed by frame(), the same frame can be sent to many
+    * connections without copying.
+    */
+   void sendFrame(const SharedFrame &frame,
+                  RunLoop::Priority priority = RunLoop::CONTROL);
+
+   static SharedFrame frame(const std::string &packet);
 
    // void close();
 
@@ -40,12 +62,16 @@ public:
 
 private: // methods
    /**
-    * The only method can be called from different threads.
+    * The only method can be called from different threads, with
+    * _synchronization locked.
     *
     * However, no state should call this method if deleted
     */ 
    void postSwitchState(ConnectionState *targetState);
 
+   // deletes states which were replaced before switching to them
+   void deleteReplacedStates();
+
    // void switchToError();
 
    /**
@@ -59,6 +85,9 @@ private: // data
 
    ConnectionState *_nextState;
    ConnectionState *_currentState;
+
+   // states lock in destructors, so they are deleted without the lock
+   std::list<ConnectionState *> _replacedStates;
    ConnectionHandleListener &_listener;
 
    Monitor *_synchronization;
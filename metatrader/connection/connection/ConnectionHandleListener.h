@@ -6,6 +6,7 @@
 class ConnectionHandleListener {
 public:
    virtual void onPacket(const std::string& buffer) = 0;
+   virtual void onConnected() = 0;
    virtual void onConnectFailed() = 0;
    virtual void onDisconnect() = 0;
 
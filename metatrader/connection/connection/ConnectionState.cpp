@@ -1,4 +1,26 @@
 #include "ConnectionState.h"
+#include <atomic>
+
+enum {
+   FRAME_HEADER_SIZE = 4
+};
+
+static std::atomic<int64> liveStates(0);
+
+ConnectionState::ConnectionState(const Context &context)
+   : _context(context) {
+   ++liveStates;
+}
+
+int64 ConnectionState::instances() {
+   return liveStates;
+}
+
+void ConnectionState::sendFrame(const SharedFrame &frame,
+                                RunLoop::Priority priority) {
+   sendData(frame->substr(FRAME_HEADER_SIZE),
+            priority);
+}
 
 void ConnectionState::locked(const std::function<void()> &action) {
    Monitor *lock = _context.externalSynchronization;
@@ -9,3 +31,7 @@ void ConnectionState::locked(const std::function<void()> &action) {
    
    lock->unlock();
 } 
+
+ConnectionState::~ConnectionState() {
+   --liveStates;
+}
@@ -2,6 +2,7 @@
 #define __00DBA47363BD6C60F9371B85F61DDC11_CONNECTIONSTATE_H_INCLUDED__
 
 #include <string>
+#include <memory>
 #include <functional>
 #include "logger.h"
 #include "platform.h"
@@ -31,23 +32,39 @@ public:
       
       RunLoop &ctRunLoop;
       Logger &logger;
+      // not recursive, sendData(), sendFrame() and stateSwitcher are called
+      // with it locked
       Monitor *externalSynchronization;
       const StateSwitcher stateSwitcher;
       ConnectionHandleListener &connectionListener;
    };
       
-   ConnectionState(const Context &context)
-      : _context(context) {}
+   /**
+    * Packet with its size prefix, serialized once and shared between
+    * connections which send it.
+    */
+   typedef std::shared_ptr<const std::string> SharedFrame;
+
+   ConnectionState(const Context &context);
 
 
    virtual void initState() = 0;
 
-   virtual void sendData(const std::string &buffer) = 0;
+   // priority is the lane of send queue, for states which have one
+   virtual void sendData(const std::string &buffer,
+                         RunLoop::Priority priority) = 0;
+
+   // sends packet of frame, by default as a copy of it
+   virtual void sendFrame(const SharedFrame &frame,
+                          RunLoop::Priority priority);
    // virtual void onDataReceived(const std::string &data) = 0;
 
    virtual bool shouldDeliverEvents() = 0;
 
-   virtual ~ConnectionState() {};
+   virtual ~ConnectionState();
+
+   // states which are not deleted yet, to find leaks
+   static int64 instances();
 
 protected:
 
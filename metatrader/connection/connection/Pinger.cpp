@@ -1,35 +1,124 @@
 #include "Pinger.h"
+#include "InputDataBuffer.h"
+#include "OutputDataBuffer.h"
+#include <math.h>
 
-#define PING_TIMEOUT_MS 7000
-#define PING_INTERVAL_MS 1000
+enum {
+   PING_INTERVAL_MS = 1000,
+   PING_MIN_TIMEOUT_MS = 2500,
+   PING_MAX_TIMEOUT_MS = 7000,
+   PROBE_EVERY_INTERVALS = 5,
+
+   // probe and it's reply are distinguished from regular packets by
+   // negative size of packet name, which is impossible for real packet
+   PROBE_MARKER = -1,
+   PROBE_REPLY_MARKER = -2,
+   PROBE_SIZE = 12
+};
+
+// rfc 6298 smoothing factors
+static const double RTT_ALPHA = 1.0 / 8;
+static const double RTT_BETA = 1.0 / 4;
 
 const std::string Pinger::PING_PACKET = "";
 
+Pinger::Config::Config()
+   : interval(PING_INTERVAL_MS)
+   , minTimeout(PING_MIN_TIMEOUT_MS)
+   , maxTimeout(PING_MAX_TIMEOUT_MS)
+   , probeEveryIntervals(PROBE_EVERY_INTERVALS) {
+
+}
+
 Pinger::Pinger(RunLoop &runLoop,
-               PingerListener &listener)
+               PingerListener &listener,
+               const Config &config)
    : _runLoop(runLoop)
    , _listener(listener)
+   , _config(config)
    , _pingTask(nullptr)
-   , _pingTimeoutTask(nullptr) {
+   , _pingTimeoutTask(nullptr)
+   , _lastReceived(_runLoop.currentTime())
+   , _dataSent(false)
+   // first interval should send probe, to get rtt as soon as possible
+   , _intervalsSinceProbe(config.probeEveryIntervals)
+   , _rttSamples(0)
+   , _smoothedRtt(0)
+   , _rttVariation(0) {
 
    postSendPing();
+   postCheckTimeout(currentTimeout());
+}
+
+bool Pinger::isProbe(const std::string &packet, int marker) {
+   return packet.size() == PROBE_SIZE
+      && InputDataBuffer(packet).nextInt() == marker;
 }
 
 bool Pinger::isPing(const std::string &packet) {
-   if (packet.size() == 0) {
+   _lastReceived = _runLoop.currentTime();
+
+   if (packet.size() == 0) return true;
 
-      if (_pingTimeoutTask) {
-         _runLoop.cancel(_pingTimeoutTask);
-      } 
+   if (isProbe(packet, PROBE_MARKER)) {
+      InputDataBuffer input(packet);
+      input.nextInt();
 
-      _pingTimeoutTask = _runLoop.postDelayed(PING_TIMEOUT_MS,
-                                              std::bind(&Pinger::ctPingTimeout, this));
-            
+      _listener.sendPing(OutputDataBuffer()
+                         .putInt(PROBE_REPLY_MARKER)
+                         .putLong(input.nextLong())
+                         .buffer());
       return true;
-   } 
+   }
+
+   if (isProbe(packet, PROBE_REPLY_MARKER)) {
+      InputDataBuffer input(packet);
+      input.nextInt();
+
+      const Platform::Milliseconds sentAt = input.nextLong();
+
+      if (sentAt <= _lastReceived) onRttSample(_lastReceived - sentAt);
+
+      return true;
+   }
 
    return false;
-} 
+}
+
+void Pinger::onRttSample(Platform::Milliseconds sample) {
+   const double value = sample;
+
+   if (_rttSamples == 0) {
+      _smoothedRtt = value;
+      _rttVariation = value / 2;
+   } else {
+      _rttVariation = (1 - RTT_BETA) * _rttVariation + RTT_BETA * fabs(_smoothedRtt - value);
+      _smoothedRtt = (1 - RTT_ALPHA) * _smoothedRtt + RTT_ALPHA * value;
+   }
+
+   ++_rttSamples;
+
+   // timeout could shrink, so recheck it earlier than was planned
+   if (_pingTimeoutTask) {
+      _runLoop.cancel(_pingTimeoutTask);
+      postCheckTimeout(currentTimeout());
+   }
+}
+
+Platform::Milliseconds Pinger::currentTimeout() const {
+   if (!haveRtt()) return _config.maxTimeout;
+
+   // peer sends something at least every interval, so allow two of them to
+   // be missed, plus the time they could be late
+   const Platform::Milliseconds timeout
+      = 2 * _config.interval
+      + (Platform::Milliseconds)ceil(_smoothedRtt + 4 * _rttVariation);
+
+   if (timeout < _config.minTimeout) return _config.minTimeout;
+   if (timeout > _config.maxTimeout) return _config.maxTimeout;
+
+   return timeout;
+}
 
 void Pinger::stop() {
    if (_pingTask) {
@@ -41,22 +130,51 @@ void Pinger::stop() {
       _runLoop.cancel(_pingTimeoutTask);
       _pingTimeoutTask = nullptr;
    }
-} 
+}
 
-void Pinger::ctPingTimeout() {
+void Pinger::ctCheckTimeout() {
    _pingTimeoutTask = nullptr;
 
+   const Platform::Milliseconds silence
+      = _runLoop.currentTime() - _lastReceived;
+
+   const Platform::Milliseconds timeout = currentTimeout();
+
+   if (silence < timeout) {
+      postCheckTimeout(timeout - silence);
+      return;
+   }
+
    stop();
-   
+
    _listener.onPingTimedOut();
 }
 
+void Pinger::postCheckTimeout(Platform::Milliseconds delay) {
+   _pingTimeoutTask = _runLoop.postDelayed(delay,
+                                           std::bind(&Pinger::ctCheckTimeout, this));
+}
+
 void Pinger::ctSendPing() {
    postSendPing();
-   _listener.sendPing();
+
+   ++_intervalsSinceProbe;
+
+   if (_intervalsSinceProbe >= _config.probeEveryIntervals) {
+      _intervalsSinceProbe = 0;
+
+      _listener.sendPing(OutputDataBuffer()
+                         .putInt(PROBE_MARKER)
+                         .putLong(_runLoop.currentTime())
+                         .buffer());
+   } else if (!_dataSent) {
+      _listener.sendPing(PING_PACKET);
+   }
+
+   _dataSent = false;
 }
-   
+
 void Pinger::postSendPing() {
-   _pingTask = _runLoop.postDelayed(PING_INTERVAL_MS,
+   _pingTask = _runLoop.postDelayed(_config.interval,
                                     std::bind(&Pinger::ctSendPing, this));
-} 
+}
@@ -6,37 +6,88 @@
 class PingerListener {
 public:
    virtual void onPingTimedOut() = 0;
-   virtual void sendPing() = 0;
+   virtual void sendPing(const std::string &packet) = 0;
    virtual ~PingerListener() {}
 };
 
+/**
+ * Keeps connection alive and detects dead links.
+ *
+ * Any received packet proves liveness, so keep-alive pings are sent only
+ * when nothing else was sent during ping interval. Every few intervals
+ * ping is replaced with probe, which is echoed back by the hub, this gives
+ * round-trip time samples. Smoothed rtt and rtt variation are used to
+ * scale the dead link timeout.
+ *
+ * All methods should be called on the ct thread.
+ */
 class Pinger {
 public:
 
    const static std::string PING_PACKET;
-   
+
+   struct Config {
+      Config();
+
+      Platform::Milliseconds interval;
+      Platform::Milliseconds minTimeout;
+      Platform::Milliseconds maxTimeout;
+
+      // probe is sent at least once per this count of intervals
+      int probeEveryIntervals;
+   };
+
    Pinger(RunLoop &runLoop,
-          PingerListener &listener);
+          PingerListener &listener,
+          const Config &config = Config());
 
+   /**
+    * Should be called for every received packet, returns true if packet
+    * is ping (or probe, or probe reply) and should not be delivered further.
+    */
    bool isPing(const std::string &packet);
 
+   /**
+    * Should be called when non ping data sent, to suppress next ping.
+    */
+   void onDataSent() { _dataSent = true; }
+
+   bool haveRtt() const { return _rttSamples > 0; }
+   double smoothedRtt() const { return _smoothedRtt; }
+   double rttVariation() const { return _rttVariation; }
+   Platform::Milliseconds currentTimeout() const;
+
    void stop();
 
    virtual ~Pinger() { stop(); }
-   
+
 private:
 
-   void ctPingTimeout();
+   void ctCheckTimeout();
    void ctSendPing();
    void postSendPing();
+   void postCheckTimeout(Platform::Milliseconds delay);
+
+   void onRttSample(Platform::Milliseconds sample);
+
+   static bool isProbe(const std::string &packet, int marker);
 
 private:
-   
+
    RunLoop &_runLoop;
    PingerListener &_listener;
+   const Config _config;
 
    RunLoop::Task *_pingTask;
    RunLoop::Task *_pingTimeoutTask;
+
+   Platform::Milliseconds _lastReceived;
+   bool _dataSent;
+   int _intervalsSinceProbe;
+
+   int _rttSamples;
+   double _smoothedRtt;
+   double _rttVariation;
 };
 
 #endif 	// __E88FD3818043A0B8F3E70E4C30082CC3_PINGER_H_INCLUDED__
@@ -6,12 +6,14 @@
 #include "InputDataBuffer.h"
 #include "OutputDataBuffer.h"
 #include "ConnectionHandleListener.h"
-
-#define PING_TIMEOUT_MS 7000
-#define PING_INTERVAL_MS 1000
+#include "TrafficJournal.h"
 
 #include "StateDisconnected.h"
 
+enum {
+   FRAME_HEADER_SIZE = 4
+};
+
 StateConnected::StateConnected(const Context &context,
                                Socket *socket,
                                const std::list<std::string> &delayedData)
@@ -24,20 +26,51 @@ StateConnected::StateConnected(const Context &context,
    , _socket(socket)
    , _delayedData(delayedData) {
 
+   _sendRunLoop.setBusyPoll(Platform::instance().threadSpec(Thread::WRITE).busyPollMicroseconds);
 }
 
 
-void StateConnected::sendData(const std::string &buffer) {
+void StateConnected::sendData(const std::string &buffer,
+                              RunLoop::Priority priority) {
+   _pinger.onDataSent();
+
+   postSend(buffer, priority);
+}
+
+void StateConnected::sendFrame(const SharedFrame &frame,
+                               RunLoop::Priority priority) {
+   _pinger.onDataSent();
+
+   // frame is never changed, so it's shared with write thread as it is
+   _sendRunLoop.post([this, frame]() -> void {
+         if (TrafficJournal::isCapturing()) {
+            TrafficJournal::record(TrafficJournal::SENT,
+                                   _context.logger.prefix(),
+                                   frame->substr(FRAME_HEADER_SIZE));
+         }
+
+         if (!_socket->write(*frame)) switchToErrorIfNotClosed();
+      },
+      priority);
+}
+
+void StateConnected::postSend(const std::string &buffer,
+                              RunLoop::Priority priority) {
    const std::string bufferToSend = Thread::threadSafeCopy(buffer);
    
    _sendRunLoop.post([=]() -> void {
+         TrafficJournal::record(TrafficJournal::SENT,
+                                _context.logger.prefix(),
+                                bufferToSend);
+
          bool failed = !sendPacket(_socket,
                                    bufferToSend);
 
          if (failed) {
             switchToErrorIfNotClosed();
          } 
-      });
+      },
+      priority);
 } 
 
 void StateConnected::initState() {
@@ -45,16 +78,23 @@ void StateConnected::initState() {
          _context.logger.log("connected");
       });
 
+   TrafficJournal::record(TrafficJournal::CONNECTED,
+                          _context.logger.prefix());
+
+   _context.connectionListener.onConnected();
+
    for (auto packet : _delayedData) {
-      sendData(packet);
+      sendData(packet, RunLoop::CONTROL);
    }
 
    Platform &platform = Platform::instance();
    
-   _readThread = platform.createThread(std::bind(&StateConnected::wtReadThreadMethod,
+   _readThread = platform.createThread(platform.threadSpec(Thread::READ),
+                                       std::bind(&StateConnected::wtReadThreadMethod,
                                                  this));
 
-   _writeThread = platform.createThread(std::bind(&StateConnected::wtWriteThreadMethod,
+   _writeThread = platform.createThread(platform.threadSpec(Thread::WRITE),
+                                        std::bind(&StateConnected::wtWriteThreadMethod,
                                                   this));
 }
 
@@ -62,14 +102,18 @@ void StateConnected::onPingTimedOut() {
    switchToErrorIfNotClosed();
 }
 
-void StateConnected::sendPing() {
-   sendData(Pinger::PING_PACKET);
+void StateConnected::sendPing(const std::string &packet) {
+   postSend(packet, RunLoop::CONTROL);
 }
 
 void StateConnected::wtReadThreadMethod() {
    std::string buffer;
    while (receivePacket(_socket, buffer)) {
 
+      TrafficJournal::record(TrafficJournal::RECEIVED,
+                             _context.logger.prefix(),
+                             buffer);
+
       const std::string delivered = Thread::threadSafeCopy(buffer);
       
       post([this, delivered]() -> void {
@@ -91,20 +135,26 @@ void StateConnected::wtWriteThreadMethod() {
 
 
 void StateConnected::close() {
-   locked([this]() -> void {
-         if (_closed) return;
-
-         _closed = true;
-         _socket->close();
-         _sendRunLoop.terminate();
-      });
+   locked(std::bind(&StateConnected::closeLocked, this));
 } 
 
+void StateConnected::closeLocked() {
+   if (_closed) return;
+
+   _closed = true;
+   _socket->close();
+
+   TrafficJournal::record(TrafficJournal::DISCONNECTED,
+                          _context.logger.prefix());
+
+   _sendRunLoop.terminate();
+}
+
 void StateConnected::switchToErrorIfNotClosed() {
    locked([this]() -> void {
          if (_closed) return;
 
-         close();
+         closeLocked();
          
          _context.stateSwitcher(new StateDisconnected(_context));
       });
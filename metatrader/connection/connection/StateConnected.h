@@ -18,7 +18,11 @@ public:
 
    void initState();
 
-   void sendData(const std::string &buffer);
+   void sendData(const std::string &buffer,
+                 RunLoop::Priority priority);
+
+   void sendFrame(const SharedFrame &frame,
+                  RunLoop::Priority priority);
 
    bool shouldDeliverEvents() { return true; }
 
@@ -26,9 +30,14 @@ public:
 
 private:
    void close();
+   // with external synchronization locked
+   void closeLocked();
 
    void onPingTimedOut();
-   void sendPing();
+   void sendPing(const std::string &packet);
+
+   void postSend(const std::string &buffer,
+                 RunLoop::Priority priority);
 
    void wtReadThreadMethod();
    void wtWriteThreadMethod();
@@ -5,70 +5,57 @@
 #include "StateConnected.h"
 #include "StateConnectFailed.h"
 
+enum {
+   CONNECT_TIMEOUT_MS = 10000
+};
+
 StateConnecting::StateConnecting(const Context &context,
                                  const std::string& addressString,
                                  const int port)
    : ConnectionState(context)
    , _address(addressString)
    , _port(port)
-   , _socket(Platform::instance().createSocket())
-   , _thread(nullptr)
-   , _closed(false)
+   , _attempt(0)
 {
 
 }
 
 void StateConnecting::initState() {
-   _thread = Platform::instance().createThread(std::bind(&StateConnecting::connectThreadMethod,
-                                                         this));
+   _attempt = Platform::instance()
+      .socketConnector()
+      .connect(_address,
+               _port,
+               CONNECT_TIMEOUT_MS,
+               std::bind(&StateConnecting::onConnectFinished,
+                         this,
+                         std::placeholders::_1));
 }
 
-void StateConnecting::connectThreadMethod() {
-
-   bool connected = _socket->connect(_address,
-                                     _port);
+void StateConnecting::onConnectFinished(Socket *connectedSocket) {
 
    locked([=]() -> void {
 
-         if (connected) {
+         if (connectedSocket) {
 
-            Socket *connectedSocket = _socket;
-            _socket = nullptr;
-            
             _context.stateSwitcher(new StateConnected(_context,
                                                       connectedSocket,
                                                       _delayedData));
 
          } else {
 
-            if (!_closed) {
-               _context.stateSwitcher(new StateConnectFailed(_context));
-            }
+            _context.stateSwitcher(new StateConnectFailed(_context));
          }
       } );
 }
 
-void StateConnecting::sendData(const std::string &buffer) {
+void StateConnecting::sendData(const std::string &buffer,
+                               RunLoop::Priority priority) {
 
-   const std::string dataToSend = Thread::threadSafeCopy(buffer);
-   
-   locked([=]() -> void {
-         assert(_socket);
-         _delayedData.push_back(dataToSend);
-      } );
+   // connection handle holds the lock
+   _delayedData.push_back(Thread::threadSafeCopy(buffer));
 }
 
 StateConnecting::~StateConnecting() {
-   locked([=]() -> void {
-
-         _closed = true;
-         if (_socket) _socket->close();
-         
-      } );
-
-   Thread::joinAndDelete(_thread);
-
-   if (_socket) {
-      delete _socket;
-   }
+   // after cancel connect callback is not running and will not be called
+   if (_attempt) Platform::instance().socketConnector().cancel(_attempt);
 }
@@ -15,7 +15,8 @@ public:
 
    void initState();
 
-   void sendData(const std::string &buffer);
+   void sendData(const std::string &buffer,
+                 RunLoop::Priority priority);
 
    bool shouldDeliverEvents() { return false; }
    
@@ -23,21 +24,15 @@ public:
 
 private:
 
-   bool closeStateIfClosed();
-   
-   void connectThreadMethod();
-   void onConnected();
-   void onError();
+   void onConnectFinished(Socket *connectedSocket);
 
 private:
    const std::string _address;
    const int _port;
-   Socket *_socket;   
-   Thread *_thread;
 
-   std::list<std::string> _delayedData;
+   SocketConnector::AttemptId _attempt;
 
-   bool _closed;
+   std::list<std::string> _delayedData;
 };
 
 #endif 	// __00DBA47363BD6C60F9371B85F61DDC11_STATECONNECTING_H_INCLUDED__
@@ -13,7 +13,7 @@ public:
 
    void initState();
 
-   void sendData(const std::string &buffer) { /* no data can be sent in connect failed state */ }
+   void sendData(const std::string &buffer, RunLoop::Priority priority) { /* no data can be sent in connect failed state */ }
 
    bool shouldDeliverEvents() { return false; }
 
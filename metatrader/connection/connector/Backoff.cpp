@@ -0,0 +1,31 @@
+#include "Backoff.h"
+
+Backoff::Backoff(Platform::Milliseconds initial,
+                 Platform::Milliseconds maximum,
+                 uint32 seed)
+   : _initial(initial)
+   , _maximum(maximum)
+   , _base(initial)
+   , _attempts(0)
+   , _random(seed) {
+
+}
+
+Platform::Milliseconds Backoff::nextDelay() {
+   const Platform::Milliseconds half = _base / 2;
+
+   const Platform::Milliseconds delay
+      = half + (half > 0 ? _random() % (half + 1) : 0);
+
+   _base *= 2;
+   if (_base > _maximum) _base = _maximum;
+
+   ++_attempts;
+
+   return delay;
+}
+
+void Backoff::reset() {
+   _base = _initial;
+   _attempts = 0;
+}
@@ -0,0 +1,36 @@
+#ifndef __980283DB26C54B09BE72DFE10247D856_BACKOFF_H_INCLUDED__
+#define __980283DB26C54B09BE72DFE10247D856_BACKOFF_H_INCLUDED__
+
+#include <random>
+#include "platform.h"
+
+/**
+ * Capped exponential backoff with "equal jitter": every delay is random
+ * in [base / 2, base], base doubles after each call up to maximum.
+ *
+ * Jitter keeps many terminals from reconnecting to restarted hub in
+ * lockstep.
+ */
+class Backoff {
+public:
+   Backoff(Platform::Milliseconds initial,
+           Platform::Milliseconds maximum,
+           uint32 seed);
+
+   Platform::Milliseconds nextDelay();
+
+   void reset();
+
+   int attempts() const { return _attempts; }
+
+private:
+   const Platform::Milliseconds _initial;
+   const Platform::Milliseconds _maximum;
+
+   Platform::Milliseconds _base;
+   int _attempts;
+
+   std::minstd_rand _random;
+};
+
+#endif 	// __980283DB26C54B09BE72DFE10247D856_BACKOFF_H_INCLUDED__
@@ -0,0 +1,108 @@
+#include "HubEndpoints.h"
+#include <math.h>
+#include <stdlib.h>
+#include <algorithm>
+
+enum {
+   PENALTY_HALF_LIFE_MS = 60000
+};
+
+static std::string trim(const std::string &string) {
+   const size_t first = string.find_first_not_of(" \t");
+   if (first == std::string::npos) return std::string();
+
+   const size_t last = string.find_last_not_of(" \t");
+   return string.substr(first, last - first + 1);
+}
+
+HubEndpoints::HubEndpoints(const std::string &list, int defaultPort)
+   : _current(0) {
+
+   size_t start = 0;
+
+   while (start <= list.size()) {
+      size_t end = list.find(',', start);
+      if (end == std::string::npos) end = list.size();
+
+      parse(trim(list.substr(start, end - start)),
+            defaultPort,
+            _endpoints);
+
+      start = end + 1;
+   }
+
+   if (_endpoints.empty()) _endpoints.push_back(Endpoint(list, defaultPort));
+}
+
+void HubEndpoints::parse(const std::string &entry,
+                         int defaultPort,
+                         std::vector<Endpoint> &output) {
+   if (entry.empty()) return;
+
+   std::string host = entry;
+   std::string port;
+
+   if (entry.find("://") != std::string::npos) {
+      // local transport address, like shm://name, port is not used
+   } else if (entry[0] == '[') {
+      const size_t closing = entry.find(']');
+
+      if (closing != std::string::npos) {
+         host = entry.substr(1, closing - 1);
+
+         if (closing + 1 < entry.size() && entry[closing + 1] == ':') {
+            port = entry.substr(closing + 2);
+         }
+      }
+   } else if (std::count(entry.begin(), entry.end(), ':') == 1) {
+      // more than one colon means ipv6 address without port
+      const size_t colon = entry.find(':');
+
+      host = entry.substr(0, colon);
+      port = entry.substr(colon + 1);
+   }
+
+   output.push_back(Endpoint(host,
+                             port.empty() ? defaultPort : atoi(port.c_str())));
+}
+
+double HubEndpoints::penaltyAt(const Endpoint &endpoint,
+                               Platform::Milliseconds time) const {
+   if (endpoint.penalty == 0 || time <= endpoint.penaltyTime) return endpoint.penalty;
+
+   const double halfLives = (double)(time - endpoint.penaltyTime) / PENALTY_HALF_LIFE_MS;
+
+   return endpoint.penalty * pow(0.5, halfLives);
+}
+
+const HubEndpoints::Endpoint &HubEndpoints::selectNext(Platform::Milliseconds now) {
+   size_t best = 0;
+   double bestPenalty = floor(penaltyAt(_endpoints[0], now));
+
+   for (size_t i = 1; i < _endpoints.size(); ++i) {
+      const double penalty = floor(penaltyAt(_endpoints[i], now));
+
+      if (penalty < bestPenalty) {
+         best = i;
+         bestPenalty = penalty;
+      }
+   }
+
+   _current = best;
+
+   return current();
+}
+
+void HubEndpoints::onCurrentFailed(Platform::Milliseconds now) {
+   Endpoint &endpoint = _endpoints[_current];
+
+   endpoint.penalty = penaltyAt(endpoint, now) + 1;
+   endpoint.penaltyTime = now;
+}
+
+void HubEndpoints::onCurrentStable() {
+   Endpoint &endpoint = _endpoints[_current];
+
+   endpoint.penalty = 0;
+   endpoint.penaltyTime = 0;
+}
@@ -0,0 +1,62 @@
+#ifndef __F5D01E9C6F584AFA8169A77180F20F07_HUBENDPOINTS_H_INCLUDED__
+#define __F5D01E9C6F584AFA8169A77180F20F07_HUBENDPOINTS_H_INCLUDED__
+
+#include <string>
+#include <vector>
+#include "platform.h"
+
+/**
+ * List of hub addresses to connect to.
+ *
+ * Parsed from comma separated list "host[:port],[v6-host]:port,...",
+ * endpoints without port use default one. Local transport addresses with
+ * scheme, like "shm://name", are kept as is. Order in the list is priority.
+ *
+ * Every failure adds penalty to the endpoint, penalty decays with time.
+ * Endpoint with the least penalty is chosen, ties are resolved by priority,
+ * so connection returns to primary hub once it is healthy again.
+ */
+class HubEndpoints {
+public:
+
+   struct Endpoint {
+      Endpoint(const std::string &address, int port)
+         : address(address)
+         , port(port)
+         , penalty(0)
+         , penaltyTime(0) {}
+
+      std::string address;
+      int port;
+
+      double penalty;
+      Platform::Milliseconds penaltyTime;
+   };
+
+   HubEndpoints(const std::string &list, int defaultPort);
+
+   const Endpoint &current() const { return _endpoints[_current]; }
+
+   // selects endpoint for next connection attempt
+   const Endpoint &selectNext(Platform::Milliseconds now);
+
+   void onCurrentFailed(Platform::Milliseconds now);
+   void onCurrentStable();
+
+   size_t size() const { return _endpoints.size(); }
+
+private:
+
+   double penaltyAt(const Endpoint &endpoint,
+                    Platform::Milliseconds time) const;
+
+   static void parse(const std::string &entry,
+                     int defaultPort,
+                     std::vector<Endpoint> &output);
+
+private:
+   std::vector<Endpoint> _endpoints;
+   size_t _current;
+};
+
+#endif 	// __F5D01E9C6F584AFA8169A77180F20F07_HUBENDPOINTS_H_INCLUDED__
@@ -1,7 +1,14 @@
 #include "HubInteraction.h"
+#include "Clock.h"
+#include <sstream>
 
 enum {
-   RETRY_INTERVAL_MS = 5000
+   FIRST_RETRY_INTERVAL_MS = 50,
+   MAX_RETRY_INTERVAL_MS = 5000,
+
+   // connection lived this long is considered to be lost not by fault of
+   // the hub, so retrying starts over from the fast first retry
+   STABLE_CONNECTION_MS = 10000
 };
 
 HubInteraction::HubInteraction(RunLoop &runLoop,
@@ -10,15 +17,20 @@ HubInteraction::HubInteraction(RunLoop &runLoop,
                                int port,
                                const EventReceiver &onRestarted,
                                const PacketReceiver &onPacket,
-                               const EventReceiver &onDisconnected)
+                               const EventReceiver &onDisconnected,
+                               const ConnectionFactory &connectionFactory)
    : RunLoopUser(runLoop)
    , _logger(logger)
-   , _address(address)
-   , _port(port)
+   , _endpoints(address, port)
+   , _backoff(FIRST_RETRY_INTERVAL_MS,
+              MAX_RETRY_INTERVAL_MS,
+              runLoop.clock().seedFor(this))
+   , _connectedAt(0)
    , _connection(nullptr)
    , _onRestarted(onRestarted)
    , _onPacket(onPacket)
-   , _onDisconnected(onDisconnected) {
+   , _onDisconnected(onDisconnected)
+   , _connectionFactory(connectionFactory) {
 
    startConnecting();
 } 
@@ -36,15 +48,21 @@ void HubInteraction::freeConnection() {
 } 
 
 void HubInteraction::startConnecting() {
-   _logger.log("starting connection");
-
    freeConnection();
 
-   _connection = new ConnectionHandle(runLoop(),
-                                      _logger,
-                                      _address,
-                                      _port,
-                                      *this);
+   const HubEndpoints::Endpoint &endpoint = _endpoints.selectNext(runLoop().currentTime());
+
+   _logger.log([&endpoint](std::ostream &str) -> void {
+         str << "starting connection to " << endpoint.address << ":" << endpoint.port;
+      } );
+
+   _connection = _connectionFactory
+      ? _connectionFactory(endpoint, *this)
+      : new ConnectionHandle(runLoop(),
+                             _logger,
+                             endpoint.address,
+                             endpoint.port,
+                             *this);
 
    if (_onRestarted) _onRestarted();
 } 
@@ -52,9 +70,28 @@ void HubInteraction::startConnecting() {
 void HubInteraction::handleConnectionFailure(bool isDisconnect) {
    freeConnection();
 
+   const bool wasStable
+      = _connectedAt != 0
+      && runLoop().currentTime() - _connectedAt >= STABLE_CONNECTION_MS;
+
+   _connectedAt = 0;
+
+   if (wasStable) {
+      _endpoints.onCurrentStable();
+      _backoff.reset();
+   } else {
+      _endpoints.onCurrentFailed(runLoop().currentTime());
+   }
+
    if (isDisconnect && _onDisconnected) _onDisconnected();
-   
-   postDelayed(RETRY_INTERVAL_MS,
+
+   const Platform::Milliseconds delay = _backoff.nextDelay();
+
+   _logger.log([delay](std::ostream &str) -> void {
+         str << "reconnecting in " << delay << " ms";
+      } );
+
+   postDelayed(delay,
                std::bind(&HubInteraction::startConnecting,
                          this));   
 } 
@@ -64,9 +101,10 @@ bool HubInteraction::haveConnection() {
    return _connection != nullptr;
 }
 
-void HubInteraction::sendRawData(const std::string &data) {
+void HubInteraction::sendRawData(const std::string &data,
+                                 RunLoop::Priority priority) {
    if (haveConnection()) {
-      _connection->sendRawData(data);
+      _connection->sendRawData(data, priority);
    } 
 } 
 
@@ -78,6 +116,10 @@ void HubInteraction::onPacket(const std::string& buffer) {
    } 
 }
 
+void HubInteraction::onConnected() {
+   _connectedAt = runLoop().currentTime();
+}
+
 void HubInteraction::onConnectFailed() {
    _logger.log("connection failed");
 
@@ -6,6 +6,8 @@
 #include "RunLoopUser.h"
 #include "ConnectionHandle.h"
 #include "ConnectionHandleListener.h"
+#include "HubEndpoints.h"
+#include "Backoff.h"
 
 class HubInteraction : protected ConnectionHandleListener
                      , private RunLoopUser {
@@ -17,18 +19,29 @@ public:
 
    typedef std::function<void()>                    EventReceiver;
    typedef std::function<void(const std::string &)> PacketReceiver;
+
+   typedef std::function<ConnectionHandle *(const HubEndpoints::Endpoint &,
+                                            ConnectionHandleListener &)> ConnectionFactory;
    
+   /**
+    * Address can be comma separated list of hub endpoints, see
+    * HubEndpoints.
+    *
+    * Connection factory replaces real connections, for simulations.
+    */
    HubInteraction(RunLoop &runLoop,
                   Logger &logger,
                   const std::string &address,
                   int port,
                   const EventReceiver &onRestarted    = EventReceiver(),
                   const PacketReceiver &onPacket      = PacketReceiver(),
-                  const EventReceiver &onDisconnected = EventReceiver());
+                  const EventReceiver &onDisconnected = EventReceiver(),
+                  const ConnectionFactory &connectionFactory = ConnectionFactory());
 
    bool haveConnection();
 
-   void sendRawData(const std::string &data);
+   void sendRawData(const std::string &data,
+                    RunLoop::Priority priority = RunLoop::CONTROL);
 
    ~HubInteraction();
 private:
@@ -37,6 +50,7 @@ private:
    void startConnecting();
    
    void onPacket(const std::string& buffer);
+   void onConnected();
    void onConnectFailed();
    void onDisconnect();
 
@@ -45,14 +59,19 @@ private:
 private:
    
    Logger &_logger;
-   const std::string _address;
-   const int _port;
+
+   HubEndpoints _endpoints;
+   Backoff _backoff;
+
+   Platform::Milliseconds _connectedAt;
    
    ConnectionHandle *_connection;
 
    const EventReceiver  _onRestarted;
    const PacketReceiver _onPacket;
    const EventReceiver  _onDisconnected;
+
+   const ConnectionFactory _connectionFactory;
 };
 
 #endif 	// __AE17FFA043F62C902EF2CF0C5B94CA1B_HUBINTERACTION_H_INCLUDED__
@@ -59,35 +59,110 @@
 #define FORWARD_CURRENT_TRADE_GET_OPT_BOUNDARY(name) FORWARD_CURRENT_TRADE_GET(Option<Boundary>, name)
 
 
-MTConnector::MTConnector() {
+class MTConnector::Shard {
+   Shard(const Shard &referenceToCopyFrom);
+   void operator=(const Shard &referenceToCopyFrom);
+
+public:
+   Shard(int index)
+      : index(index)
+      , synchronization(Platform::instance().createMonitor()) {
+      // shards are told apart by names
+      ThreadSpec spec = Platform::instance().threadSpec(Thread::CT);
+      if (index > 0) spec.name += "-" + std::to_string(index);
+
+      runLoop.setBusyPoll(spec.busyPollMicroseconds);
+
+      thread = Platform::instance().createThread(spec, std::bind(&Shard::ctThread, this));
+   }
+
+   std::function<void()> locked(const std::function<void()> action) {
+      return [=]() -> void {
+         synchronization->lock();
+         action();
+         synchronization->unlock();
+      };
+   }
+
+   // task is put to the queue under the lock, so tasks of every caller and
+   // priority keep their order
+   void post(const std::function<void()> &action,
+             RunLoop::Priority priority = RunLoop::CONTROL) {
+      synchronization->lock();
+      runLoop.post(locked(action), priority);
+      synchronization->unlock();
+   }
+
+   // connectors left are freed on the run loop, which is stopped then
+   void postTermination() {
+      post([this]() -> void {
+            for (auto sink : tickSinks) delete sink.second;
+            for (auto connector : tradeConnectors) delete connector.second;
+
+            tickSinks.clear();
+            tradeConnectors.clear();
+
+            runLoop.terminate();
+         } );
+   }
+
+   ~Shard() {
+      Thread::joinAndDelete(thread);
+
+      delete synchronization;
+   }
+
+   const int index;
+
+   RunLoop runLoop;
+
+   Thread *thread;
+   Monitor *synchronization;
+
+   std::map<int, MTTicksSink *> tickSinks;
+   std::map<int, MTTradeConnector *> tradeConnectors;
+
+private:
+   void ctThread() {
+      printf("ct thread %d started\n", index);
+      runLoop.run();
+      printf("ct thread %d stopped\n", index);
+   }
+};
+
+MTConnector::MTConnector(int shards) {
    
-   _thread = Platform::instance().createThread(std::bind(&MTConnector::ctThread, this));
+   for (int i = 0; i < (shards > 0 ? shards : 1); ++i) _shards.push_back(new Shard(i));
 
    _synchronization = Platform::instance().createMonitor();
 
    _ids = 0;
 }
 
+MTConnector::Shard &MTConnector::shardOf(int id) {
+   return *_shards[(unsigned int)id % _shards.size()];
+}
+
 int MTConnector::createTicksSink(const std::string inAddress,
                                  int port,
                                  const std::string inKey) {
    
    _synchronization->lock();
+   const int idOfSink = _ids++;
+   _synchronization->unlock();
 
    const std::string address = Thread::threadSafeCopy(inAddress);
    const std::string key = Thread::threadSafeCopy(inKey);
+
+   Shard &shard = shardOf(idOfSink);
    
-   int idOfSink = _ids++;
-
-   _ctRunLoop.post(locked([=]() -> void {
-         this->_tickSinks[idOfSink] = new MTTicksSink(this->_ctRunLoop,
-                                                      address,
-                                                      port,
-                                                      key);
-      }));
- 
-   _synchronization->unlock();
-   
+   shard.post([=, &shard]() -> void {
+         shard.tickSinks[idOfSink] = new MTTicksSink(shard.runLoop,
+                                                     address,
+                                                     port,
+                                                     key);
+      } );
+
    return idOfSink;
 } 
 
@@ -95,35 +170,37 @@ void MTConnector::sendTick(int id,
                            double bid,
                            double ask) {
 
-   _synchronization->lock();
+   // of the terminal's thread, before queues
+   const Platform::Milliseconds time = Platform::instance().currentTime();
+
+   Shard &shard = shardOf(id);
 
-   _ctRunLoop.post(locked([=]() -> void {
-         auto sink = this->_tickSinks.find(id);
-         if (sink != this->_tickSinks.end()) {
-            (*sink).second->sendTick(bid, ask);
+   shard.post([=, &shard]() -> void {
+         auto sink = shard.tickSinks.find(id);
+         if (sink != shard.tickSinks.end()) {
+            (*sink).second->sendTick(time, bid, ask);
          } 
-      } ));
-   
-   _synchronization->unlock();
+      },
+      RunLoop::TICKS);
 } 
    
 void MTConnector::freeTicksSink(int id) {
-   _synchronization->lock();
+   Shard &shard = shardOf(id);
 
-   _ctRunLoop.post(locked([=]() -> void {
-         const auto notFound = this->_tickSinks.end();
-         auto sink = this->_tickSinks.find(id);
+   shard.post([=, &shard]() -> void {
+         const auto notFound = shard.tickSinks.end();
+         auto sink = shard.tickSinks.find(id);
 
          if (sink != notFound) {
             auto connector = (*sink).second;
 
             delete connector;
 
-            this->_tickSinks.erase(sink);
+            shard.tickSinks.erase(sink);
          }
-      }) );
-
-   _synchronization->unlock();
+      },
+      // after the ticks posted before
+      RunLoop::TICKS);
 }
 
 
@@ -133,23 +210,28 @@ int MTConnector::createTradeConnector(const std::string inAddress,
                                       double balance,
                                       double equity) {
    _synchronization->lock();
+   const int idOfConnector = _ids++;
+   _synchronization->unlock();
 
    const std::string address = Thread::threadSafeCopy(inAddress);
    const std::string key = Thread::threadSafeCopy(inKey);
-   
-   const int idOfConnector = _ids++;
 
-   _ctRunLoop.post(locked([=]() -> void {
-         this->_tradeConnectors[idOfConnector]
-            = new MTTradeConnector(this->_ctRunLoop,
-                                   address,
-                                   port,
-                                   key,
-                                   balance,
-                                   equity);
-      }) );
+   Shard &shard = shardOf(idOfConnector);
    
-   _synchronization->unlock();
+   shard.post([=, &shard]() -> void {
+         MTTradeConnector *connector = new MTTradeConnector(shard.runLoop,
+                                                            address,
+                                                            port,
+                                                            key,
+                                                            balance,
+                                                            equity);
+
+         shard.tradeConnectors[idOfConnector] = connector;
+
+         _synchronization->lock();
+         _tradeChanges[idOfConnector] = connector->tradeChanges();
+         _synchronization->unlock();
+      } );
 
    return idOfConnector;
 } 
@@ -157,36 +239,106 @@ int MTConnector::createTradeConnector(const std::string inAddress,
 #include "trade.forwards.inc"
 #include "current.trade.access.inc"
 
-void MTConnector::freeTradeConnector(int id) {
+uint64 MTConnector::PendingTradeChangesSeq(int connectorId) {
+   _synchronization->lock();
+
+   auto found = _tradeChanges.find(connectorId);
+
+   const uint64 sequence = found != _tradeChanges.end() ? found->second->sequence() : 0;
+
+   _synchronization->unlock();
+
+   return sequence;
+}
+
+bool MTConnector::WaitForTradeChanges(int connectorId,
+                                      Platform::Milliseconds timeout) {
+   const std::shared_ptr<TradeChanges> changes = tradeChangesOf(connectorId);
+
+   if (!changes) return false;
+
+   // without any lock, connector can be freed meanwhile
+   return changes->waitForPending(timeout);
+}
+
+int MTConnector::ReconcileTrades(int connectorId,
+                                 const double *market,
+                                 const double *orders,
+                                 int ordersCount,
+                                 bool retryOpenings,
+                                 double *actions,
+                                 int maxActions) {
+   return forTradeConnector<int>(connectorId,
+                                 [=](MTTradeConnector &connector) -> int {
+                                    return connector.ReconcileTrades(market,
+                                                                     orders,
+                                                                     ordersCount,
+                                                                     retryOpenings,
+                                                                     actions,
+                                                                     maxActions);
+                                 });
+}
+
+bool MTConnector::ReportTradeActions(int connectorId,
+                                     const double *results,
+                                     int count) {
+   return forTradeConnector<bool>(connectorId,
+                                  [=](MTTradeConnector &connector) -> bool {
+                                     return connector.ReportTradeActions(results, count);
+                                  });
+}
+
+std::shared_ptr<TradeChanges> MTConnector::tradeChangesOf(int id) {
    _synchronization->lock();
 
-   _ctRunLoop.post(locked([=]() -> void {
-         const auto notFound = this->_tradeConnectors.end();
-         auto sink = this->_tradeConnectors.find(id);
+   auto found = _tradeChanges.find(id);
+
+   std::shared_ptr<TradeChanges> changes;
+
+   if (found != _tradeChanges.end()) changes = found->second;
+
+   _synchronization->unlock();
+
+   return changes;
+}
+
+void MTConnector::freeTradeConnector(int id) {
+   Shard &shard = shardOf(id);
+
+   shard.post([=, &shard]() -> void {
+         const auto notFound = shard.tradeConnectors.end();
+         auto sink = shard.tradeConnectors.find(id);
 
          if (sink != notFound) {
             auto connector = (*sink).second;
 
             delete connector;
             
-            this->_tradeConnectors.erase(sink);
+            shard.tradeConnectors.erase(sink);
          }
-      }) );
-   
-   _synchronization->unlock();
+
+         // after its creation, which was posted before
+         _synchronization->lock();
+         _tradeChanges.erase(id);
+         _synchronization->unlock();
+      },
+      // after the trade messages posted before
+      RunLoop::TRADE);
 }
 
 void MTConnector::forTradeConnector(int id,
                        const std::function<void(MTTradeConnector&)> &action) {
-   _synchronization->lock();
+   Shard &shard = shardOf(id);
+
+   shard.synchronization->lock();
 
-   auto connector = _tradeConnectors.find(id);
+   auto connector = shard.tradeConnectors.find(id);
 
-   if (connector != _tradeConnectors.end()) {
+   if (connector != shard.tradeConnectors.end()) {
       action(*(connector->second));
    }
    
-   _synchronization->unlock();
+   shard.synchronization->unlock();
 } 
 
 template
@@ -201,40 +353,29 @@ template
 MTConnector::forTradeConnector(int id,
                                const std::function<RetVal(MTTradeConnector&)> &action,
                                const RetVal &defaultValue) {
-   _synchronization->lock();
-   auto connector = _tradeConnectors.find(id);
+   Shard &shard = shardOf(id);
+
+   shard.synchronization->lock();
+   auto connector = shard.tradeConnectors.find(id);
 
    auto value = defaultValue;
    
-   if (connector != _tradeConnectors.end()) {
+   if (connector != shard.tradeConnectors.end()) {
       value = action(*(connector->second));
    }
 
-   _synchronization->unlock();
+   shard.synchronization->unlock();
    
    return value;
 } 
 
-std::function<void()> MTConnector::locked(const std::function<void()> action) {
-   return [=]() -> void {
-      _synchronization->lock();
-      action();
-      _synchronization->unlock();
-   };
-} 
-
-
-void MTConnector::ctThread() {
-   printf("ct thread started\n");
-   _ctRunLoop.run();
-   printf("ct thread stopped\n");
-}
-
 
 MTConnector::~MTConnector() {
-   delete _synchronization;
+   // connections have threads of their own, which post to the ct run loops,
+   // so sinks and trade connectors left are freed on them before they stop;
+   // all shards are stopped at once
+   for (Shard *shard : _shards) shard->postTermination();
+   for (Shard *shard : _shards) delete shard;
 
-   _ctRunLoop.terminate();
-
-   Thread::joinAndDelete(_thread);
+   delete _synchronization;
 } 
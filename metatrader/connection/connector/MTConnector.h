@@ -5,9 +5,12 @@
 #include "platform.h"
 #include "RunLoop.h"
 #include <map>
+#include <memory>
+#include <vector>
 
 class MTTicksSink;
 class MTTradeConnector;
+class TradeChanges;
 
 #define TRADE_FORWARD_CALL(method)              \
    void method(int connectorId);
@@ -35,7 +38,12 @@ class MTTradeConnector;
 
 class MTConnector {
 public:
-   MTConnector();
+   /**
+    * Sinks and trade connectors are spread over shards by id, every shard
+    * is a ct run loop with a thread and a lock of its own, so everything of
+    * one connector keeps its order.
+    */
+   explicit MTConnector(int shards = 1);
 
    // ticks sink
 
@@ -61,13 +69,42 @@ public:
    #include "current.trade.access.inc"
 
    // int TradeGetType(int id);
+
+   /**
+    * Changes with every change of trades posted by the hub, doesn't wait
+    * for the shard, so mt code checks it on every tick and runs the trades
+    * cycle only when it changed. 0 till the connector is created.
+    */
+   uint64 PendingTradeChangesSeq(int connectorId);
+
+   /**
+    * True if the hub changed trades since the last trades iteration, waits
+    * up to timeout for it, for mt code with a loop of its own.
+    */
+   bool WaitForTradeChanges(int connectorId,
+                            Platform::Milliseconds timeout);
+
+   // trades cycle in two calls, see MTTradeConnector::ReconcileTrades()
+   int ReconcileTrades(int connectorId,
+                       const double *market,
+                       const double *orders,
+                       int ordersCount,
+                       bool retryOpenings,
+                       double *actions,
+                       int maxActions);
+
+   bool ReportTradeActions(int connectorId,
+                           const double *results,
+                           int count);
    
    void freeTradeConnector(int id);
 
 
    ~MTConnector();
 private:
+   class Shard;
 
+   Shard &shardOf(int id);
 
    void forTradeConnector(int id,
                           const std::function<void(MTTradeConnector&)> &action);
@@ -83,19 +120,17 @@ private:
                      const std::function<RetVal(MTTradeConnector&)> &action,
                      const RetVal &defaultValue);
 
-   std::function<void()> locked(const std::function<void()> action);
-
-   void ctThread();
+   std::vector<Shard *> _shards;
 
-   RunLoop _ctRunLoop;
-
-   Thread *_thread;
+   // guards ids and trade changes only, connectors are guarded by their
+   // shards
    Monitor *_synchronization;
 
    int _ids;
 
-   std::map<int, MTTicksSink *> _tickSinks;
-   std::map<int, MTTradeConnector *> _tradeConnectors;
+   std::map<int, std::shared_ptr<TradeChanges> > _tradeChanges;
+
+   std::shared_ptr<TradeChanges> tradeChangesOf(int id);
 };
 
 #undef FORWARD_STRING
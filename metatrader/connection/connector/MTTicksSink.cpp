@@ -10,25 +10,25 @@ MTTicksSink::MTTicksSink(RunLoop &runLoop,
    : RunLoopUser(runLoop)
    , _logger("ticks", address, port, key)
    , _key(key)
+   , _replay(REPLAY_TICKS)
+   , _resumed(false)
+   , _registeredAt(1)
    , _hubInteraction(runLoop,
                      _logger,
                      address,
                      port,
-                     std::bind(&MTTicksSink::onStartedConnection, this)) {
+                     std::bind(&MTTicksSink::onStartedConnection, this),
+                     std::bind(&MTTicksSink::onPacket, this, std::placeholders::_1)) {
 
 } 
 
-void MTTicksSink::sendTick(double bid, double ask) {
+void MTTicksSink::sendTick(Platform::Milliseconds time, double bid, double ask) {
    post([=]() -> void {
-         if (_hubInteraction.haveConnection()) {
+         const TicksReplay::Tick &tick = _replay.push(time, Price::fromDouble(bid), Price::fromDouble(ask));
 
-            _logger.log([bid, ask](std::ostream &str) -> void {
-                  str << "sending tick: " << bid << "|" << ask;
-               } );
-   
-            _hubInteraction.sendRawData(Protocol::OnTick(bid, ask).buffer());
-         }
-      });
+         if (_resumed && _hubInteraction.haveConnection()) send(tick);
+      },
+      RunLoop::TICKS);
 } 
 
 MTTicksSink::~MTTicksSink() {
@@ -36,5 +36,45 @@ MTTicksSink::~MTTicksSink() {
 }
 
 void MTTicksSink::onStartedConnection() {
+   _resumed = false;
+   _registeredAt = _replay.nextSequence();
+
    _hubInteraction.sendRawData(Protocol::RegisterTicksProvider(_key).buffer());
-} 
+}
+
+void MTTicksSink::onPacket(const std::string &buffer) {
+   InputDataBuffer input(buffer);
+
+   const std::string name = input.nextString();
+
+   if (name == Protocol::ResumeTicks::NAME) {
+      resume(Protocol::ResumeTicks(input).sequence());
+   } else {
+      _logger.log("received packet: " + name);
+   }
+}
+
+void MTTicksSink::resume(uint64 sequence) {
+   // hub which hasn't seen us, or saw more than we have (we were
+   // restarted), gets ticks held since registration
+   if (sequence == 0 || sequence > _replay.nextSequence()) sequence = _registeredAt;
+
+   const uint64 replayed = _replay.nextSequence() - sequence;
+
+   const uint64 lost = _replay.replay(sequence, [this](const TicksReplay::Tick &tick) -> void { send(tick); });
+
+   _logger.log([sequence, replayed, lost](std::ostream &str) -> void {
+         str << "resumed ticks from " << sequence << ", replayed: " << replayed - lost << ", lost: " << lost;
+      } );
+
+   _resumed = true;
+}
+
+void MTTicksSink::send(const TicksReplay::Tick &tick) {
+   _logger.log([&tick](std::ostream &str) -> void {
+         str << "sending tick " << tick.sequence << ": " << tick.bid << "|" << tick.ask;
+      } );
+
+   _hubInteraction.sendRawData(Protocol::OnTick(tick.sequence, tick.time, tick.bid, tick.ask).buffer(),
+                               RunLoop::TICKS);
+}
@@ -4,21 +4,36 @@
 #include "logger.h"
 #include "HubInteraction.h"
 #include "RunLoopUser.h"
-
+#include "TicksReplay.h"
+
+/**
+ * Ticks are numbered and kept in TicksReplay, also while there is no
+ * connection. After (re)registration they are held till the hub answers
+ * with ResumeTicks, then the ones it missed go in one burst before the
+ * new ones.
+ */
 class MTTicksSink : private RunLoopUser {
 public:
 
+   // about a minute of busy symbol
+   static const int REPLAY_TICKS = 4096;
+
    MTTicksSink(RunLoop &runLoop,
                const std::string &address,
                int port,
                const std::string &key);
    
-   void sendTick(double bid, double ask);
+   // time is of terminal, when mt gave the tick
+   void sendTick(Platform::Milliseconds time, double bid, double ask);
 
    ~MTTicksSink();
 private:
 
    void onStartedConnection();
+   void onPacket(const std::string &buffer);
+
+   void resume(uint64 sequence);
+   void send(const TicksReplay::Tick &tick);
 
 private:
 
@@ -26,6 +41,14 @@ private:
 
    const std::string _key;
 
+   TicksReplay _replay;
+
+   // ticks go to the hub only after ResumeTicks of current connection
+   bool _resumed;
+   // first tick after registration, replayed to hub which hasn't seen us
+   // or saw more ticks than we have
+   uint64 _registeredAt;
+
    HubInteraction _hubInteraction;
 };
 
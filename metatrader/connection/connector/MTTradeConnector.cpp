@@ -5,22 +5,32 @@
 #include <iostream>
 #include <stdio.h>
 #include <sstream>
+#include <algorithm>
 
 #define LOCK _synchronization->lock()
 #define UNLOCK _synchronization->unlock()
 
+enum {
+   MAX_ID_RANGE_SIZE = 1024
+};
+
 MTTradeConnector::MTTradeConnector(RunLoop &runLoop,
                                    const std::string &address,
                                    int port,
                                    const std::string &key,
                                    double balance,
-                                   double equity)
+                                   double equity,
+                                   const HubInteraction::ConnectionFactory &connectionFactory)
 : RunLoopUser(runLoop)
 , _balance(balance)
 , _equity(equity)
 , _synchronization(Platform::instance().createMonitor())
 , _ids(0)
 , _lastOrphanedId(0)
+, _idRangeSize(0)
+, _lastUsedId(0)
+, _currentTrade(nullptr)
+, _reconciler(reconcilerEvents())
 , _logger("trade", address, port, key)
 , _key(key)
 , _hubInteraction(runLoop,
@@ -29,7 +39,8 @@ MTTradeConnector::MTTradeConnector(RunLoop &runLoop,
                   port,
                   std::bind(&MTTradeConnector::onStartedConnection, this),
                   std::bind(&MTTradeConnector::onPacket, this, std::placeholders::_1),
-                  std::bind(&MTTradeConnector::onDisconnect, this)) {
+                  std::bind(&MTTradeConnector::onDisconnect, this),
+                  connectionFactory) {
 
 
 } 
@@ -42,8 +53,8 @@ MTTradeConnector::~MTTradeConnector() {
 void MTTradeConnector::onStartedConnection() {
    _synchronization->lock();
    _hubInteraction.sendRawData(Protocol::RegisterTradeConnector(_key,
-                                                                _balance,
-                                                                _equity).buffer());
+                                                                Price::fromDouble(_balance),
+                                                                Price::fromDouble(_equity)).buffer());
    _synchronization->unlock();
 } 
 
@@ -53,25 +64,39 @@ void MTTradeConnector::onPacket(const std::string& buffer) {
 
    const std::string incomingPacketName = input.nextString();
 
-   std::cout << "received packet: " << incomingPacketName << std::endl;
+   _logger.log("received packet: " + incomingPacketName);
 
    if (incomingPacketName == Protocol::RequestNewId::NAME) {
 
-      _hubInteraction.sendRawData(Protocol::NewId(++_ids).buffer());
+      _hubInteraction.sendRawData(Protocol::NewId(++_ids).buffer(),
+                                  RunLoop::TRADE);
+   } else if (incomingPacketName == Protocol::RequestNewIdRange::NAME) {
+      Protocol::RequestNewIdRange packet(input);
+
+      _idRangeSize = std::max(1, std::min<int>(packet.count(), MAX_ID_RANGE_SIZE));
+      _lastUsedId = _ids;
+
+      grantIdRangeIfLow();
    } else if (incomingPacketName == Protocol::OpenTrade::NAME) {
       Protocol::OpenTrade packet(input);
 
-      packet.dump(std::cout);
-
-      std::cout << std::endl;
+      _logger.log([&packet](std::ostream &str) -> void {
+            packet.dump(str);
+         } );
 
       // put the requested trade to the list of trades
 
+      if (_idRangeSize > 0 && packet.id() > _lastUsedId && packet.id() <= _ids) {
+         _lastUsedId = packet.id();
+
+         grantIdRangeIfLow();
+      }
+
       const TradeRequest &request = packet.tradeRequest();
       
       _trades.postAdd(Trade(packet.id(),
                             request.tradeType(),
-                            request.value(),
+                            request.value().toDouble(),
                             request.delay(),
                             packet.stopValue(),
                             packet.takeProfit()));
@@ -79,9 +104,9 @@ void MTTradeConnector::onPacket(const std::string& buffer) {
    } else if (incomingPacketName == Protocol::CloseRequest::NAME) {
       Protocol::CloseRequest packet(input);
 
-      packet.dump(std::cout);
-
-      std::cout << std::endl;
+      _logger.log([&packet](std::ostream &str) -> void {
+            packet.dump(str);
+         } );
 
       _trades.postModify(packet.id(),
                          [](Trade &trade) -> void {
@@ -91,9 +116,9 @@ void MTTradeConnector::onPacket(const std::string& buffer) {
    } else if (incomingPacketName == Protocol::UpdateStopRequest::NAME) {
       Protocol::UpdateStopRequest packet(input);
 
-      packet.dump(std::cout);
-
-      std::cout << std::endl;
+      _logger.log([&packet](std::ostream &str) -> void {
+            packet.dump(str);
+         } );
 
       _trades.postModify(packet.id(),
                          [packet](Trade &trade) -> void {
@@ -103,9 +128,9 @@ void MTTradeConnector::onPacket(const std::string& buffer) {
    } else if (incomingPacketName == Protocol::UpdateTakeProfitRequest::NAME) {
       Protocol::UpdateTakeProfitRequest packet(input);
 
-      packet.dump(std::cout);
-
-      std::cout << std::endl;
+      _logger.log([&packet](std::ostream &str) -> void {
+            packet.dump(str);
+         } );
 
       _trades.postModify(packet.id(),
                          [packet](Trade &trade) -> void {
@@ -114,6 +139,18 @@ void MTTradeConnector::onPacket(const std::string& buffer) {
    } 
 }
 
+void MTTradeConnector::grantIdRangeIfLow() {
+   // a quarter of range is left for ids in flight to the hub
+   if (_ids - _lastUsedId > (uint64)_idRangeSize / 4) return;
+
+   const uint64 start = _ids + 1;
+
+   _ids += _idRangeSize;
+
+   _hubInteraction.sendRawData(Protocol::NewIdRange(start, _idRangeSize).buffer(),
+                               RunLoop::TRADE);
+}
+
 void MTTradeConnector::StartNextTradesIteration() {
    _trades.applyModifications();
    _iterationIds = _trades.idsOfActiveTrades();
@@ -131,23 +168,15 @@ bool MTTradeConnector::ShiftToNextTrade() {
 void MTTradeConnector::LogTradeConnectorMessage(const std::string message) {
    post([this, message]() -> void {
          _logger.log(message);
-      });
+      },
+      RunLoop::LOGGING);
 }
 
 void MTTradeConnector::TradeMessage(const std::string message) {
 
    if (_currentTrade == nullptr) return;
    
-   uint64 currentTradeId = _currentTrade->getId();
-   
-   post([this, message, currentTradeId]() -> void {
-         std::ostringstream line;
-         line << "trade (" << currentTradeId << "): " << message;
-         _logger.log(line.str());
-
-         _hubInteraction.sendRawData(Protocol::MessageAboutTrade(currentTradeId,
-                                                                 message).buffer());
-      });
+   postTradeMessage(_currentTrade->getId(), message);
 }
 
 /**
@@ -156,40 +185,153 @@ void MTTradeConnector::TradeMessage(const std::string message) {
  */ 
 void MTTradeConnector::FreeTrade() {
 
-   const uint64 currentTradeId = _currentTrade->getId();
+   postFreeTrade(_currentTrade->getId());
+   
+   _trades.removeTradeById(_currentTrade->getId());
+}
+
+void MTTradeConnector::TradeNotifyOpened() {
+   postNotifyOpened(_currentTrade->getId());
+}
+
+void MTTradeConnector::TradeNotifyClosed() {
+   postNotifyClosed(_currentTrade->getId());
+}
+
+int MTTradeConnector::ReconcileTrades(const double *market,
+                                      const double *orders,
+                                      int ordersCount,
+                                      bool retryOpenings,
+                                      double *actions,
+                                      int maxActions) {
+   _trades.applyModifications();
+
+   // iteration of mql code is over
+   _iterationIds.clear();
+   _currentTrade = nullptr;
+
+   TradeReconciler::Market snapshot;
+   snapshot.bid         = market[0];
+   snapshot.ask         = market[1];
+   snapshot.point       = market[2];
+   snapshot.digits      = (int)market[3];
+   snapshot.stopLevel   = market[4];
+   snapshot.freezeLevel = market[5];
+   snapshot.minLot      = market[6];
+   snapshot.lotStep     = market[7];
+   snapshot.lotSize     = market[8];
+
+   std::vector<TradeReconciler::Order> currentOrders(std::max(ordersCount, 0));
+
+   for (size_t i = 0; i < currentOrders.size(); ++i) {
+      const double *fields = orders + i * ORDER_FIELDS;
+
+      currentOrders[i].ticket    = (int)fields[0];
+      currentOrders[i].type      = (int)fields[1];
+      currentOrders[i].lots      = fields[2];
+      currentOrders[i].openPrice = fields[3];
+   }
+
+   _reconciler.plan(_trades, snapshot, currentOrders, retryOpenings, _plannedActions);
+
+   // the rest is planned again by the next cycle
+   if ((int)_plannedActions.size() > maxActions) _plannedActions.resize(std::max(maxActions, 0));
+
+   for (size_t i = 0; i < _plannedActions.size(); ++i) {
+      const TradeReconciler::Action &action = _plannedActions[i];
+      double *fields = actions + i * ACTION_FIELDS;
+
+      fields[0] = action.kind;
+      fields[1] = action.ticket;
+      fields[2] = action.opType;
+      fields[3] = action.lots;
+      fields[4] = action.price;
+      fields[5] = action.stop;
+      fields[6] = action.take;
+      fields[7] = action.slippage;
+   }
+
+   return (int)_plannedActions.size();
+}
+
+bool MTTradeConnector::ReportTradeActions(const double *results, int count) {
+   std::vector<TradeReconciler::Result> reported(std::max(0, std::min<int>(count, _plannedActions.size())));
+
+   for (size_t i = 0; i < reported.size(); ++i) {
+      const double *fields = results + i * RESULT_FIELDS;
+
+      reported[i].status     = (int)fields[0];
+      reported[i].error      = (int)fields[1];
+      reported[i].orderType  = (int)fields[2];
+      reported[i].openPrice  = fields[3];
+      reported[i].closePrice = fields[4];
+      reported[i].profit     = fields[5];
+   }
 
-   post([this, currentTradeId]() -> void {
+   const bool retry = _reconciler.report(_trades, _plannedActions, reported);
+
+   _plannedActions.clear();
+
+   return retry;
+}
+
+TradeReconciler::Events MTTradeConnector::reconcilerEvents() {
+   TradeReconciler::Events events;
+
+   events.log = [this](const std::string &message) -> void { LogTradeConnectorMessage(message); };
+   events.message = std::bind(&MTTradeConnector::postTradeMessage, this, std::placeholders::_1, std::placeholders::_2);
+   events.opened = std::bind(&MTTradeConnector::postNotifyOpened, this, std::placeholders::_1);
+   events.closed = std::bind(&MTTradeConnector::postNotifyClosed, this, std::placeholders::_1);
+   events.freed = std::bind(&MTTradeConnector::postFreeTrade, this, std::placeholders::_1);
+
+   return events;
+}
+
+void MTTradeConnector::postTradeMessage(uint64 tradeId, const std::string &message) {
+   post([this, message, tradeId]() -> void {
          std::ostringstream line;
-         line << "trade " << currentTradeId << " freed";
+         line << "trade (" << tradeId << "): " << message;
          _logger.log(line.str());
 
-         if (currentTradeId > _lastOrphanedId) {
-            _hubInteraction.sendRawData(Protocol::FreeTrade(currentTradeId).buffer());
+         _hubInteraction.sendRawData(Protocol::MessageAboutTrade(tradeId,
+                                                                 message).buffer(),
+                                     RunLoop::TRADE);
+      },
+      RunLoop::TRADE);
+}
+
+void MTTradeConnector::postFreeTrade(uint64 tradeId) {
+   post([this, tradeId]() -> void {
+         std::ostringstream line;
+         line << "trade " << tradeId << " freed";
+         _logger.log(line.str());
+
+         if (tradeId > _lastOrphanedId) {
+            _hubInteraction.sendRawData(Protocol::FreeTrade(tradeId).buffer(),
+                                        RunLoop::TRADE);
          } 
-      });
-   
-   
-   _trades.removeTradeById(_currentTrade->getId());
+      },
+      RunLoop::TRADE);
 }
 
-void MTTradeConnector::TradeNotifyOpened() {
-   const uint64 currentTradeId = _currentTrade->getId();
-   
-   post([this, currentTradeId]() -> void {
-         if (currentTradeId > _lastOrphanedId) {
-            _hubInteraction.sendRawData(Protocol::OpenedResponse(currentTradeId).buffer());
+void MTTradeConnector::postNotifyOpened(uint64 tradeId) {
+   post([this, tradeId]() -> void {
+         if (tradeId > _lastOrphanedId) {
+            _hubInteraction.sendRawData(Protocol::OpenedResponse(tradeId).buffer(),
+                                        RunLoop::TRADE);
          }
-      });
+      },
+      RunLoop::TRADE);
 }
 
-void MTTradeConnector::TradeNotifyClosed() {
-   const uint64 currentTradeId = _currentTrade->getId();
-   
-   post([this, currentTradeId]() -> void {
-         if (currentTradeId > _lastOrphanedId) {
-            _hubInteraction.sendRawData(Protocol::ExternallyClosed(currentTradeId).buffer());
+void MTTradeConnector::postNotifyClosed(uint64 tradeId) {
+   post([this, tradeId]() -> void {
+         if (tradeId > _lastOrphanedId) {
+            _hubInteraction.sendRawData(Protocol::ExternallyClosed(tradeId).buffer(),
+                                        RunLoop::TRADE);
          } 
-      });
+      },
+      RunLoop::TRADE);
 }
 
 
@@ -199,8 +341,10 @@ void MTTradeConnector::UpdateBalance(double balance) {
    _balance = balance;
    
    post([this, balance]() -> void {
-         _hubInteraction.sendRawData(Protocol::CurrentBalance(balance).buffer());
-      } );
+         _hubInteraction.sendRawData(Protocol::CurrentBalance(Price::fromDouble(balance)).buffer(),
+                                     RunLoop::TRADE);
+      },
+      RunLoop::TRADE);
    _synchronization->unlock();
 }
 
@@ -210,8 +354,10 @@ void MTTradeConnector::UpdateEquity(double equity) {
    _equity = equity;
    
    post([this, equity]() -> void {
-         _hubInteraction.sendRawData(Protocol::CurrentEquity(equity).buffer());
-      } );
+         _hubInteraction.sendRawData(Protocol::CurrentEquity(Price::fromDouble(equity)).buffer(),
+                                     RunLoop::TRADE);
+      },
+      RunLoop::TRADE);
    _synchronization->unlock();
 }
 
@@ -219,7 +365,10 @@ void MTTradeConnector::onDisconnect() {
    // all trades become orphaned - no events to send about it and close as
    // fast as possible
 
+   // granted ids not used yet are orphaned too, hub asks for ranges
+   // again after reconnect
    _lastOrphanedId = _ids;
+   _idRangeSize = 0;
    
    _trades.postCloseAll();
 }
@@ -4,6 +4,7 @@
 #include "logger.h"
 #include "HubInteraction.h"
 #include "TradesSet.h"
+#include "TradeReconciler.h"
 #include "RunLoopUser.h"
 
 class Monitor;
@@ -23,12 +24,15 @@ class Monitor;
 class MTTradeConnector : private RunLoopUser {
 public:
 
+   // connection factory replaces connections to the hub, see HubInteraction
    MTTradeConnector(RunLoop &runLoop,
                     const std::string &address,
                     int port,
                     const std::string &key,
                     double balance,
-                    double equity);
+                    double equity,
+                    const HubInteraction::ConnectionFactory &connectionFactory
+                       = HubInteraction::ConnectionFactory());
 
    /* these methods should be called from mt's thread */
    
@@ -42,6 +46,38 @@ public:
    /* mt thread */ void LogTradeConnectorMessage(const std::string message);
    /* mt thread */ void TradeMessage(const std::string message);
    /* mt thread */ #include "current.trade.access.inc"
+
+   /**
+    * Trades cycle in two calls instead of calls for every trade, see
+    * TradeReconciler. Market is bid, ask, point, digits, stop level, freeze
+    * level, min lot, lot step and lot size; every order is ticket, type,
+    * lots and open price; every action is kind, ticket, op type, lots,
+    * price, stop, take profit and slippage. Returns count of actions.
+    * Retry of openings after ReportTradeActions() plans only them.
+    */
+   /* mt thread */ int ReconcileTrades(const double *market,
+                                      const double *orders,
+                                      int ordersCount,
+                                      bool retryOpenings,
+                                      double *actions,
+                                      int maxActions);
+
+   /**
+    * Results of actions, every one is status, error, order type, open price,
+    * close price and profit, see TradeReconciler::Result. True if openings
+    * should be reconciled again right away.
+    */
+   /* mt thread */ bool ReportTradeActions(const double *results, int count);
+
+   enum {
+      MARKET_FIELDS = 9,
+      ORDER_FIELDS = 4,
+      ACTION_FIELDS = 8,
+      RESULT_FIELDS = 6
+   };
+
+   // changes of trades not applied yet, any thread
+   const std::shared_ptr<TradeChanges> &tradeChanges() const { return _trades.changes(); }
    
    // void terminateAndFree();
 
@@ -54,6 +90,17 @@ private:
    void onPacket(const std::string& buffer);
    void onDisconnect();
    // void onClosed();
+
+   // next range of ids is granted when few ids of granted are left
+   void grantIdRangeIfLow();
+
+   // to the hub, of any trade
+   void postTradeMessage(uint64 tradeId, const std::string &message);
+   void postFreeTrade(uint64 tradeId);
+   void postNotifyOpened(uint64 tradeId);
+   void postNotifyClosed(uint64 tradeId);
+
+   TradeReconciler::Events reconcilerEvents();
    
 private:
    TradesSet _trades;
@@ -63,12 +110,22 @@ private:
    
    Monitor *_synchronization;
 
+   // last granted id
    uint64 _ids;
    uint64 _lastOrphanedId;
 
+   // zero till hub asks for ranges of ids, see Protocol::NewIdRange
+   int _idRangeSize;
+   // last id of ranges hub opened trade with
+   uint64 _lastUsedId;
+
    std::list<uint64> _iterationIds;
    Trade *_currentTrade;
 
+   TradeReconciler _reconciler;
+   // waiting for their results
+   std::vector<TradeReconciler::Action> _plannedActions;
+
    Logger _logger;
 
    
@@ -0,0 +1,35 @@
+#include "TicksReplay.h"
+#include <algorithm>
+
+TicksReplay::TicksReplay(int capacity)
+   : _ticks(capacity > 0 ? capacity : 1)
+   , _nextSequence(1) {
+
+}
+
+const TicksReplay::Tick &TicksReplay::push(Platform::Milliseconds time, const Price &bid, const Price &ask) {
+   Tick &tick = _ticks[_nextSequence % _ticks.size()];
+
+   tick.sequence = _nextSequence++;
+   tick.time = time;
+   tick.bid = bid;
+   tick.ask = ask;
+
+   return tick;
+}
+
+uint64 TicksReplay::firstSequence() const {
+   const uint64 kept = std::min<uint64>(_nextSequence - 1, _ticks.size());
+
+   return _nextSequence - kept;
+}
+
+uint64 TicksReplay::replay(uint64 sequence, const std::function<void(const Tick &)> &visitor) const {
+   const uint64 first = firstSequence();
+
+   const uint64 lost = sequence < first ? first - sequence : 0;
+
+   for (uint64 i = std::max(sequence, first); i < _nextSequence; ++i) visitor(_ticks[i % _ticks.size()]);
+
+   return lost;
+}
@@ -0,0 +1,51 @@
+#ifndef __CBF5B1FAE4FC421299CEDFD022E30F29_TICKSREPLAY_H_INCLUDED__
+#define __CBF5B1FAE4FC421299CEDFD022E30F29_TICKSREPLAY_H_INCLUDED__
+
+#include <vector>
+#include <functional>
+#include "platform.h"
+#include "types.h"
+
+/**
+ * Last ticks of a sink, numbered from 1, so the hub can ask for ones it
+ * missed while connection was lost.
+ *
+ * Ring of fixed capacity: the oldest tick is overwritten by the newest,
+ * ticks older than firstSequence() are lost for replay.
+ */
+class TicksReplay {
+   TicksReplay(const TicksReplay &referenceToCopyFrom);
+   void operator=(const TicksReplay &referenceToCopyFrom);
+
+public:
+
+   struct Tick {
+      uint64 sequence;
+      // of terminal
+      Platform::Milliseconds time;
+      Price bid;
+      Price ask;
+   };
+
+   TicksReplay(int capacity);
+
+   // returns the tick with its sequence number
+   const Tick &push(Platform::Milliseconds time, const Price &bid, const Price &ask);
+
+   // of the oldest tick kept, nextSequence() if there are none
+   uint64 firstSequence() const;
+   uint64 nextSequence() const { return _nextSequence; }
+
+   /**
+    * Calls visitor for ticks from sequence on in order, returns count of
+    * ticks from sequence which are not kept any more.
+    */
+   uint64 replay(uint64 sequence, const std::function<void(const Tick &)> &visitor) const;
+
+private:
+   std::vector<Tick> _ticks;
+
+   uint64 _nextSequence;
+};
+
+#endif 	// __CBF5B1FAE4FC421299CEDFD022E30F29_TICKSREPLAY_H_INCLUDED__
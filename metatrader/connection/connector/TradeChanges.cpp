@@ -0,0 +1,57 @@
+#include "TradeChanges.h"
+
+TradeChanges::TradeChanges()
+   : _posted(0)
+   , _applied(0)
+   , _closed(false)
+   , _monitor(Platform::instance().createMonitor()) {
+
+}
+
+void TradeChanges::onPosted() {
+   _monitor->lock();
+
+   _posted.fetch_add(1, std::memory_order_release);
+
+   _monitor->notify();
+   _monitor->unlock();
+}
+
+void TradeChanges::onApplied() {
+   _monitor->lock();
+   _applied = _posted.load(std::memory_order_relaxed);
+   _monitor->unlock();
+}
+
+void TradeChanges::close() {
+   _monitor->lock();
+
+   _closed = true;
+
+   _monitor->notify();
+   _monitor->unlock();
+}
+
+bool TradeChanges::waitForPending(Platform::Milliseconds timeout) {
+   const Platform::Milliseconds deadline = Platform::instance().currentTime() + timeout;
+
+   _monitor->lock();
+
+   while (!_closed && _posted.load(std::memory_order_relaxed) == _applied) {
+      const Platform::Milliseconds now = Platform::instance().currentTime();
+
+      if (now >= deadline) break;
+
+      _monitor->wait(deadline - now);
+   }
+
+   const bool pending = !_closed && _posted.load(std::memory_order_relaxed) != _applied;
+
+   _monitor->unlock();
+
+   return pending;
+}
+
+TradeChanges::~TradeChanges() {
+   delete _monitor;
+}
@@ -0,0 +1,46 @@
+#ifndef __97CC28665C10415DB4D61FD8BF7A6F46_TRADECHANGES_H_INCLUDED__
+#define __97CC28665C10415DB4D61FD8BF7A6F46_TRADECHANGES_H_INCLUDED__
+
+#include <atomic>
+#include "types.h"
+#include "platform.h"
+
+/**
+ * Counts changes posted to trades set by the hub, so mt's thread learns
+ * about them without polling. Shared with waiters, which may outlive the
+ * trades set.
+ */
+class TradeChanges {
+   TradeChanges(const TradeChanges &referenceToCopyFrom);
+   void operator=(const TradeChanges &referenceToCopyFrom);
+public:
+
+   TradeChanges();
+
+   // connector's thread, change is posted
+   void onPosted();
+
+   // mt's thread, changes posted till now are applied
+   void onApplied();
+
+   // trades set is freed, waiter returns
+   void close();
+
+   // wait free, changes with every posted change
+   uint64 sequence() const { return _posted.load(std::memory_order_acquire); }
+
+   // true if there are posted changes not applied yet, waits for them up to
+   // timeout; for one waiter
+   bool waitForPending(Platform::Milliseconds timeout);
+
+   ~TradeChanges();
+
+private:
+   std::atomic<uint64> _posted;
+   uint64 _applied;
+   bool _closed;
+
+   Monitor *_monitor;
+};
+
+#endif 	// __97CC28665C10415DB4D61FD8BF7A6F46_TRADECHANGES_H_INCLUDED__
@@ -0,0 +1,539 @@
+#include "TradeReconciler.h"
+#include <algorithm>
+#include <cmath>
+#include <sstream>
+#include <iomanip>
+
+enum {
+   MAX_RETRY_COUNT = 5,
+
+   // mt's error of invalid stops, which are shifted then
+   ERR_INVALID_STOPS = 130,
+
+   SLIPPAGE_POINTS = 4,
+
+   // shift of stops and delay from market, in points
+   STOPS_SHIFT_INCREMENT = 2,
+   STOPS_SHIFT_MAX = 6,
+
+   // of open price, for trades without take profit
+   TP_MAX_MULTIPLIER = 4
+};
+
+static TradeType opposite(TradeType type) {
+   return type == TradeBuy ? TradeSell : TradeBuy;
+}
+
+static Price shiftDirect(TradeType type, const Price &base, const Price &shift) {
+   return type == TradeBuy ? base + shift : base - shift;
+}
+
+static Price shiftContrary(TradeType type, const Price &base, const Price &shift) {
+   return shiftDirect(opposite(type), base, shift);
+}
+
+static Price farStop(TradeType type, const Price &one, const Price &two) {
+   return type == TradeBuy ? std::min(one, two) : std::max(one, two);
+}
+
+static Price farTp(TradeType type, const Price &one, const Price &two) {
+   return farStop(opposite(type), one, two);
+}
+
+static bool isStopCloser(TradeType type, const Price &newStop, const Price &oldStop) {
+   return type == TradeBuy ? newStop > oldStop : oldStop > newStop;
+}
+
+// mt code gets undefined boundaries as zeros
+static Price valueOf(const Option<Boundary> &boundary) {
+   return boundary.isDefined() ? boundary.get().value() : Price();
+}
+
+static Option<Boundary> boundaryOf(const Price &value) {
+   return value.isZero() ? Option<Boundary>() : Option<Boundary>(Boundary(value));
+}
+
+static bool isMarketOrder(int type) {
+   return type == TradeReconciler::OP_BUY || type == TradeReconciler::OP_SELL;
+}
+
+TradeReconciler::TradeReconciler(const Events &events)
+   : _events(events)
+   , _market() {
+
+}
+
+void TradeReconciler::plan(TradesSet &trades,
+                           const Market &market,
+                           const std::vector<Order> &orders,
+                           bool retryOpenings,
+                           std::vector<Action> &actions) {
+   _market = market;
+
+   _bid = priceOf(market.bid);
+   _ask = priceOf(market.ask);
+   _point = Price::point(market.digits);
+
+   _stopDistance = _point * llround(market.stopLevel);
+   _freezeDistance = _point * llround(market.freezeLevel);
+
+   actions.clear();
+
+   std::set<uint64> retried;
+   retried.swap(_retriedOpenings);
+
+   if (retryOpenings) {
+      for (uint64 id : retried) {
+         Trade *trade = trades.tradeById(id);
+
+         if (trade != nullptr && trade->getMtId() == Trade::InvalidId) planOpening(trades, *trade, actions);
+      }
+
+      return;
+   }
+
+   std::map<int, const Order *> byTicket;
+
+   for (const Order &order : orders) byTicket[order.ticket] = &order;
+
+   for (uint64 id : trades.idsOfActiveTrades()) {
+      Trade *trade = trades.tradeById(id);
+
+      if (trade == nullptr) continue;
+
+      if (trade->getMtId() == Trade::InvalidId) {
+         planOpening(trades, *trade, actions);
+         continue;
+      }
+
+      auto order = byTicket.find(trade->getMtId());
+
+      if (order == byTicket.end()) {
+         Action check = Action();
+         check.kind = CHECK;
+         check.tradeId = id;
+         check.ticket = trade->getMtId();
+
+         actions.push_back(check);
+         continue;
+      }
+
+      planOrder(*trade, *order->second, actions);
+   }
+}
+
+void TradeReconciler::planOpening(TradesSet &trades, Trade &trade, std::vector<Action> &actions) {
+   const double lots = lotsOf(trade);
+
+   if (lots == 0) {
+      warning(trade.getId(), "Trade requested with 0 lots volume.");
+      free(trades, trade.getId());
+      return;
+   }
+
+   const Boundaries values = boundaries(trade, _openings[trade.getId()].shift);
+
+   Action open = Action();
+   open.kind = OPEN;
+   open.tradeId = trade.getId();
+   open.ticket = Trade::InvalidId;
+   open.opType = values.opType;
+   open.lots = lots;
+   open.price = values.openPrice.toDouble();
+   open.stop = values.stop.toDouble();
+   open.take = values.take.toDouble();
+   open.slippage = SLIPPAGE_POINTS;
+   open.delay = values.openPrice.toDouble();
+   open.noTakeProfit = values.noTakeProfit.toDouble();
+
+   actions.push_back(open);
+
+   std::ostringstream line;
+   line << "opening " << trade.getId()
+        << ", lots: " << lots
+        << ", op type: " << values.opType
+        << ", requested delay: " << price(valueOf(trade.getRequestedDelay()))
+        << ", open price: " << price(values.openPrice)
+        << ", stop: " << price(values.stop)
+        << ", take profit: " << price(values.take);
+
+   _events.log(line.str());
+}
+
+void TradeReconciler::planOrder(Trade &trade, const Order &order, std::vector<Action> &actions) {
+   const uint64 id = trade.getId();
+   const TradeType type = trade.getType();
+
+   // pending order could be filled
+   if (!trade.getIsOpened() && isMarketOrder(order.type)) {
+      _events.message(id, "opened on price " + price(priceOf(order.openPrice)));
+
+      trade.setIsOpened(true);
+      _events.opened(id);
+   }
+
+   const bool isDelayed = !valueOf(trade.getRequestedDelay()).isZero();
+
+   const Price currentStop = trade.getBestSetStop().value();
+   const Price currentDelay = valueOf(trade.getBestSetDelay());
+   const Price currentTake = valueOf(trade.getBestSetTp());
+
+   // order can't be changed in freeze zone
+   if (isDelayed && !trade.getIsOpened()) {
+      if (isInOpenFreezeZone(type, currentDelay)) return;
+   } else {
+      if (isInCloseFreezeZone(type, currentStop) || isInCloseFreezeZone(type, currentTake)) return;
+   }
+
+   Action action = Action();
+   action.tradeId = id;
+   action.ticket = order.ticket;
+
+   if (trade.getIsWantsClose()) {
+      if (trade.getIsOpened()) {
+         action.kind = CLOSE;
+         action.lots = order.lots;
+         action.price = closingPrice(type).toDouble();
+         action.slippage = SLIPPAGE_POINTS;
+      } else {
+         action.kind = DELETE;
+      }
+
+      actions.push_back(action);
+      return;
+   }
+
+   const Boundaries values = boundaries(trade, Price());
+
+   const Price requestedStop = trade.getRequestedStop().value();
+   const Price requestedDelay = valueOf(trade.getRequestedDelay());
+   const Price requestedTake = valueOf(trade.getRequestedTp());
+
+   std::ostringstream line;
+
+   if (trade.getIsOpened()) {
+      const bool stopSatisfied = same(currentStop, requestedStop);
+      const bool tpSatisfied = same(currentTake, requestedTake);
+
+      if (stopSatisfied && tpSatisfied) return;
+
+      // stops are only moved closer to requested
+      const bool willNotBreakStop = same(values.stop, currentStop) || isStopCloser(type, values.stop, currentStop);
+      const bool willNotBreakTake = same(values.take, currentTake) || isStopCloser(opposite(type), values.take, currentTake);
+
+      if (!willNotBreakStop || !willNotBreakTake) return;
+
+      action.price = order.openPrice;
+
+      line << "setting stop of " << id << " to: " << price(values.stop)
+           << ", requested: " << price(requestedStop) << ", now: " << price(currentStop)
+           << ", take profit to: " << price(values.take)
+           << ", requested: " << price(requestedTake) << ", now: " << price(currentTake);
+   } else {
+      const bool delaySatisfied = requestedDelay.isZero() || same(currentDelay, requestedDelay);
+
+      if (delaySatisfied) return;
+
+      if (!isStopCloser(type, values.openPrice, currentDelay)) return;
+
+      action.price = values.openPrice.toDouble();
+
+      line << "setting delay of " << id << " to: " << price(values.openPrice)
+           << ", requested: " << price(requestedDelay) << ", now: " << price(currentDelay);
+   }
+
+   _events.log(line.str());
+
+   action.kind = MODIFY;
+   action.stop = values.stop.toDouble();
+   action.take = values.take.toDouble();
+   action.delay = values.openPrice.toDouble();
+   action.noTakeProfit = values.noTakeProfit.toDouble();
+
+   actions.push_back(action);
+}
+
+bool TradeReconciler::report(TradesSet &trades,
+                             const std::vector<Action> &actions,
+                             const std::vector<Result> &results) {
+   _retriedOpenings.clear();
+
+   const size_t count = std::min(actions.size(), results.size());
+
+   for (size_t i = 0; i < count; ++i) {
+      const Action &action = actions[i];
+      const Result &result = results[i];
+
+      Trade *trade = trades.tradeById(action.tradeId);
+
+      if (trade == nullptr) continue;
+
+      const uint64 id = action.tradeId;
+
+      std::ostringstream line;
+
+      switch (action.kind) {
+         case OPEN:
+            if (onOpenResult(trades, *trade, action, result)) _retriedOpenings.insert(id);
+            break;
+
+         case MODIFY:
+            if (result.status) {
+               setBestValues(*trade, action);
+            } else {
+               line << "Error modifying " << (trade->getIsOpened() ? "opened" : "pending")
+                    << " order: " << result.error;
+               warning(id, line.str());
+            }
+            break;
+
+         case CLOSE:
+            if (result.status) {
+               line << " closed on price " << price(priceOf(result.closePrice)) << ", profit: " << price(priceOf(result.profit));
+               _events.message(id, line.str());
+
+               free(trades, id);
+            } else {
+               line << "error closing trade (" << action.ticket << "): " << result.error;
+               warning(id, line.str());
+            }
+            break;
+
+         case DELETE:
+            if (result.status) {
+               _events.message(id, "order cancelled");
+
+               free(trades, id);
+            } else {
+               line << "error deleting pending order (" << action.ticket << "): " << result.error;
+               warning(id, line.str());
+            }
+            break;
+
+         case CHECK:
+            onCheckResult(trades, *trade, result);
+            break;
+      }
+   }
+
+   return !_retriedOpenings.empty();
+}
+
+bool TradeReconciler::onOpenResult(TradesSet &trades, Trade &trade, const Action &action, const Result &result) {
+   const uint64 id = trade.getId();
+
+   if (result.status != Trade::InvalidId) {
+      _openings.erase(id);
+
+      trade.setMtId(result.status);
+
+      if (valueOf(trade.getRequestedDelay()).isZero()) {
+         _events.message(id, "opened on price " + price(priceOf(action.price)));
+
+         trade.setIsOpened(true);
+         _events.opened(id);
+      } else {
+         _events.message(id, "delayed request is placed");
+      }
+
+      setBestValues(trade, action);
+
+      return false;
+   }
+
+   std::ostringstream error;
+   error << "opening error is: " << result.error;
+   warning(id, error.str());
+
+   if (result.error != ERR_INVALID_STOPS) {
+      warning(id, "don't know how to handle this error, closing request");
+      free(trades, id);
+
+      return false;
+   }
+
+   Opening &opening = _openings[id];
+
+   opening.shift = opening.shift + _point * STOPS_SHIFT_INCREMENT;
+
+   // next cycle starts from market again, this one doesn't retry it
+   if (++opening.retries >= MAX_RETRY_COUNT) {
+      warning(id, "Too many retries for opening trade, breaking.");
+      _openings.erase(id);
+
+      return false;
+   }
+
+   if (opening.shift > _point * STOPS_SHIFT_MAX) {
+      warning(id, "Too big stops shift, breaking.");
+      _openings.erase(id);
+
+      return false;
+   }
+
+   return true;
+}
+
+void TradeReconciler::onCheckResult(TradesSet &trades, Trade &trade, const Result &result) {
+   const uint64 id = trade.getId();
+
+   if (result.status == 0) {
+      std::ostringstream line;
+      line << "Failed to select order " << trade.getMtId() << " closing";
+      warning(id, line.str());
+
+      free(trades, id);
+      return;
+   }
+
+   // still open, orders changed after the snapshot
+   if (result.status == 1) return;
+
+   if (!trade.getIsOpened() && isMarketOrder(result.orderType)) {
+      _events.message(id, "opened on price " + price(priceOf(result.openPrice)));
+
+      trade.setIsOpened(true);
+      _events.opened(id);
+   }
+
+   if (trade.getIsOpened()) {
+      std::ostringstream line;
+      line << "externally closed on price " << price(priceOf(result.closePrice)) << ", profit: " << price(priceOf(result.profit));
+      _events.message(id, line.str());
+
+      _events.closed(id);
+   } else {
+      _events.message(id, "request externally cancelled");
+   }
+
+   free(trades, id);
+}
+
+void TradeReconciler::setBestValues(Trade &trade, const Action &action) const {
+   const Price take = priceOf(action.take);
+
+   trade.setBestSetDelay(boundaryOf(priceOf(action.delay)));
+   trade.setBestSetStop(Boundary(priceOf(action.stop)));
+   trade.setBestSetTp(same(take, priceOf(action.noTakeProfit)) ? Option<Boundary>() : boundaryOf(take));
+}
+
+TradeReconciler::Boundaries TradeReconciler::boundaries(const Trade &trade, const Price &additionalShift) const {
+   const TradeType type = trade.getType();
+
+   Boundaries values;
+
+   const Price requestedDelay = valueOf(trade.getRequestedDelay());
+   const bool isDelayed = !requestedDelay.isZero();
+
+   if (isDelayed) values.opType = type == TradeBuy ? OP_BUYLIMIT : OP_SELLLIMIT;
+   else           values.opType = type == TradeBuy ? OP_BUY : OP_SELL;
+
+   Price stopsBasePrice;
+   Price stopsShift = additionalShift;
+
+   if (isDelayed && !trade.getIsOpened()) {
+      values.openPrice = norm(shiftContrary(type,
+                                            farStop(type,
+                                                    requestedDelay,
+                                                    closestStopOrDelay(type, openingPrice(type))),
+                                            additionalShift));
+
+      stopsBasePrice = values.openPrice;
+
+      // for delayed trade no sense to shift limit prices
+      stopsShift = Price();
+   } else {
+      values.openPrice = openingPrice(type);
+      stopsBasePrice = closingPrice(type);
+   }
+
+   values.stop = norm(shiftContrary(type,
+                                    farStop(type,
+                                            trade.getRequestedStop().value(),
+                                            closestStopOrDelay(type, stopsBasePrice)),
+                                    stopsShift));
+
+   const Price requestedTake = valueOf(trade.getRequestedTp());
+
+   // without take profit it's put far from the price
+   Price takeProfit = requestedTake;
+
+   if (takeProfit.isZero()) {
+      takeProfit = type == TradeBuy
+         ? openingPrice(type) * TP_MAX_MULTIPLIER
+         : openingPrice(type) / TP_MAX_MULTIPLIER;
+   }
+
+   values.take = norm(shiftDirect(type,
+                                  farTp(type,
+                                        takeProfit,
+                                        closestStopOrDelay(opposite(type), stopsBasePrice)),
+                                  stopsShift));
+
+   values.noTakeProfit = requestedTake.isZero() ? values.take : Price();
+
+   return values;
+}
+
+double TradeReconciler::lotsOf(const Trade &trade) const {
+   if (_market.lotSize <= 0 || _market.lotStep <= 0) return 0;
+
+   const double lots = trade.getValue() / _market.lotSize;
+
+   if (lots < _market.minLot) return 0;
+
+   return std::floor(lots / _market.lotStep) * _market.lotStep;
+}
+
+bool TradeReconciler::isInOpenFreezeZone(TradeType type, const Price &price) const {
+   if (_freezeDistance.isZero()) return false;
+
+   return (openingPrice(type) - price).abs() < _freezeDistance;
+}
+
+bool TradeReconciler::isInCloseFreezeZone(TradeType type, const Price &price) const {
+   return isInOpenFreezeZone(opposite(type), price);
+}
+
+Price TradeReconciler::openingPrice(TradeType type) const {
+   return type == TradeBuy ? _ask : _bid;
+}
+
+Price TradeReconciler::closingPrice(TradeType type) const {
+   return openingPrice(opposite(type));
+}
+
+Price TradeReconciler::closestStopOrDelay(TradeType type, const Price &basePrice) const {
+   return shiftContrary(type, basePrice, _stopDistance);
+}
+
+Price TradeReconciler::priceOf(double value) const {
+   return Price::fromDouble(value, _market.digits);
+}
+
+// as NormalizeDouble() of mt, to digits of the symbol
+Price TradeReconciler::norm(const Price &value) const {
+   return value.rounded(_market.digits);
+}
+
+bool TradeReconciler::same(const Price &one, const Price &two) const {
+   return norm(one - two).isZero();
+}
+
+std::string TradeReconciler::price(const Price &value) const {
+   std::ostringstream output;
+   output << std::fixed << std::setprecision(_market.digits) << value.toDouble();
+
+   return output.str();
+}
+
+void TradeReconciler::free(TradesSet &trades, uint64 id) {
+   _events.freed(id);
+
+   trades.removeTradeById(id);
+   _openings.erase(id);
+}
+
+void TradeReconciler::warning(uint64 id, const std::string &message) {
+   _events.message(id, "Warning: " + message);
+}
@@ -0,0 +1,192 @@
+#ifndef __A84E140C948F486FBFFA2FF28E79D17C_TRADERECONCILER_H_INCLUDED__
+#define __A84E140C948F486FBFFA2FF28E79D17C_TRADERECONCILER_H_INCLUDED__
+
+#include <functional>
+#include <string>
+#include <vector>
+#include <map>
+#include <set>
+#include "TradesSet.h"
+
+/**
+ * Decides what mt should do with its orders, so trades get as close to
+ * requested as market allows: opens requested trades, moves delay, stop
+ * and take profit closer to requested, closes trades hub wants closed and
+ * notices trades closed outside. Works on mt's thread with a snapshot of
+ * market and orders, mt code only executes actions and reports results.
+ */
+class TradeReconciler {
+   TradeReconciler(const TradeReconciler &referenceToCopyFrom);
+   void operator=(const TradeReconciler &referenceToCopyFrom);
+public:
+
+   // of the symbol, levels are in points
+   struct Market {
+      double bid;
+      double ask;
+      double point;
+      int digits;
+      double stopLevel;
+      double freezeLevel;
+      double minLot;
+      double lotStep;
+      double lotSize;
+   };
+
+   // open or pending order of mt
+   struct Order {
+      int ticket;
+      int type;
+      double lots;
+      double openPrice;
+   };
+
+   enum Kind {
+      // OrderSend() with op type, lots, price, stop, take and slippage
+      OPEN = 1,
+      // OrderModify() of ticket with price, stop and take
+      MODIFY,
+      // OrderClose() of ticket with lots, price and slippage
+      CLOSE,
+      // OrderDelete() of ticket
+      DELETE,
+      // order left the orders, OrderSelect() of ticket from history
+      CHECK
+   };
+
+   struct Action {
+      Kind kind;
+      uint64 tradeId;
+      int ticket;
+      int opType;
+      double lots;
+      double price;
+      double stop;
+      double take;
+      // in points
+      int slippage;
+
+      // set as best delay if succeeded, price of opened trade is not its
+      // delay
+      double delay;
+      // take profit which stands for no take profit
+      double noTakeProfit;
+   };
+
+   struct Result {
+      // ticket of opened order, -1 if failed; for others 1 if succeeded, for
+      // CHECK 0 if not found, 1 if still open, 2 if closed
+      int status;
+      int error;
+
+      // of CLOSE and CHECK
+      int orderType;
+      double openPrice;
+      double closePrice;
+      double profit;
+   };
+
+   // what happened to trades, hub is told about it
+   struct Events {
+      std::function<void(const std::string &)> log;
+      std::function<void(uint64, const std::string &)> message;
+      std::function<void(uint64)> opened;
+      std::function<void(uint64)> closed;
+      // trade is removed from the set after it
+      std::function<void(uint64)> freed;
+   };
+
+   TradeReconciler(const Events &events);
+
+   /**
+    * Actions for trades of the set, trades without orders are freed. Retry
+    * of openings plans only openings the last report asked to retry,
+    * nothing else is done twice in a cycle.
+    */
+   void plan(TradesSet &trades,
+             const Market &market,
+             const std::vector<Order> &orders,
+             bool retryOpenings,
+             std::vector<Action> &actions);
+
+   // results of planned actions, true if openings should be retried right
+   // away, with stops shifted
+   bool report(TradesSet &trades,
+               const std::vector<Action> &actions,
+               const std::vector<Result> &results);
+
+   // of mt
+   enum {
+      OP_BUY,
+      OP_SELL,
+      OP_BUYLIMIT,
+      OP_SELLLIMIT
+   };
+
+private:
+
+   struct Boundaries {
+      int opType;
+      Price openPrice;
+      Price stop;
+      Price take;
+      Price noTakeProfit;
+   };
+
+   // retries of opening, while stops are invalid
+   struct Opening {
+      Opening() : retries(0) {}
+
+      Price shift;
+      int retries;
+   };
+
+   Boundaries boundaries(const Trade &trade, const Price &additionalShift) const;
+
+   void planOpening(TradesSet &trades, Trade &trade, std::vector<Action> &actions);
+   void planOrder(Trade &trade, const Order &order, std::vector<Action> &actions);
+
+   // true if opening should be retried
+   bool onOpenResult(TradesSet &trades, Trade &trade, const Action &action, const Result &result);
+   void onCheckResult(TradesSet &trades, Trade &trade, const Result &result);
+
+   void setBestValues(Trade &trade, const Action &action) const;
+
+   void free(TradesSet &trades, uint64 id);
+   void warning(uint64 id, const std::string &message);
+
+   double lotsOf(const Trade &trade) const;
+
+   bool isInOpenFreezeZone(TradeType type, const Price &price) const;
+   bool isInCloseFreezeZone(TradeType type, const Price &price) const;
+
+   Price openingPrice(TradeType type) const;
+   Price closingPrice(TradeType type) const;
+   Price closestStopOrDelay(TradeType type, const Price &basePrice) const;
+
+   // of mt, rounded to digits of the symbol
+   Price priceOf(double value) const;
+
+   bool same(const Price &one, const Price &two) const;
+   Price norm(const Price &value) const;
+   std::string price(const Price &value) const;
+
+private:
+   const Events _events;
+
+   // of the last plan
+   Market _market;
+
+   Price _bid;
+   Price _ask;
+   Price _point;
+   Price _stopDistance;
+   Price _freezeDistance;
+
+   std::map<uint64, Opening> _openings;
+
+   // asked to retry by the last report
+   std::set<uint64> _retriedOpenings;
+};
+
+#endif 	// __A84E140C948F486FBFFA2FF28E79D17C_TRADERECONCILER_H_INCLUDED__
@@ -2,7 +2,8 @@
 #include <algorithm>
 
 TradesSet::TradesSet()
-   : _monitor(Platform::instance().createMonitor()) {
+   : _monitor(Platform::instance().createMonitor())
+   , _changes(std::make_shared<TradeChanges>()) {
    
 }
 
@@ -28,6 +29,8 @@ void TradesSet::postModify(uint64 id,
             modifier(*found);
          } 
       } );
+
+   _changes->onPosted();
    
    _monitor->unlock();
 } 
@@ -38,6 +41,7 @@ void TradesSet::postAdd(const Trade &trade) {
          // TODO: check if trade with this id already present         
          _trades.push_back(trade);
       } );
+   _changes->onPosted();
    _monitor->unlock();
 }
 
@@ -48,6 +52,7 @@ void TradesSet::postCloseAll() {
             trade.setIsWantsClose();
          } 
       } );
+   _changes->onPosted();
    _monitor->unlock();
 } 
 
@@ -59,6 +64,8 @@ void TradesSet::applyModifications() {
                  [](std::function<void()>& action) -> void { action(); } );
 
    _modifications.clear();
+
+   _changes->onApplied();
    
    _monitor->unlock();
 } 
@@ -96,6 +103,8 @@ std::list<uint64> TradesSet::idsOfActiveTrades() const {
 } 
 
 TradesSet::~TradesSet() {
+   _changes->close();
+
    delete _monitor;
 } 
 
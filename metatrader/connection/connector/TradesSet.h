@@ -2,7 +2,9 @@
 #define __9EA460711E4601B02FF255E7D9195508_TRADESSET_H_INCLUDED__
 
 #include <list>
+#include <memory>
 #include "Trade.h"
+#include "TradeChanges.h"
 #include "platform.h"
 
 class TradesSet {
@@ -30,6 +32,9 @@ public:
 
    std::list<uint64> idsOfActiveTrades() const;
 
+   // of posted modifications, for mt's thread to wait for them
+   const std::shared_ptr<TradeChanges> &changes() const { return _changes; }
+
    ~TradesSet();
    
 private:
@@ -40,6 +45,8 @@ private:
    std::list<std::function<void()> > _modifications;
 
    Monitor *_monitor;
+
+   std::shared_ptr<TradeChanges> _changes;
 };
 
 #endif 	// __9EA460711E4601B02FF255E7D9195508_TRADESSET_H_INCLUDED__
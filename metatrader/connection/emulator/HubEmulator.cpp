@@ -0,0 +1,468 @@
+#include "HubEmulator.h"
+#include "NixSocket.h"
+#include "protocol.h"
+#include "InputDataBuffer.h"
+#include "OutputDataBuffer.h"
+#include <chrono>
+#include <memory.h>
+#include <unistd.h>
+#include <sys/socket.h>
+#include <netinet/in.h>
+#include <netinet/tcp.h>
+
+enum {
+   PING_INTERVAL_MS = 1000,
+
+   // see Pinger
+   PROBE_MARKER = -1,
+   PROBE_REPLY_MARKER = -2,
+   PROBE_SIZE = 12
+};
+
+class HubEmulator::Connection {
+public:
+   Connection(int descriptor)
+      : descriptor(descriptor)
+      , socket(descriptor)
+      , writeMonitor(Platform::instance().createMonitor())
+      , thread(nullptr)
+      , finished(false)
+      , silent(false)
+      , readDelayMs(0)
+      , isTradeConnector(false)
+      , tradeId(0)
+      , openSentAt(0)
+      , closeSentAt(0)
+      , idRangeSize(0)
+      , waitsForId(false)
+      , tickSequence(0) {}
+
+   bool send(const std::string &packet) {
+      writeMonitor->lock();
+      const bool result = socket.write(OutputDataBuffer().putInt(packet.size()).buffer() + packet);
+      writeMonitor->unlock();
+
+      return result;
+   }
+
+   void shutdown() {
+      ::shutdown(descriptor, SHUT_RDWR);
+   }
+
+   ~Connection() {
+      Thread::joinAndDelete(thread);
+      socket.close();
+      delete writeMonitor;
+   }
+
+   const int descriptor;
+   NixSocket socket;
+   Monitor *writeMonitor;
+
+   Thread *thread;
+   std::atomic<bool> finished;
+
+   // faults, see Faults
+   std::atomic<bool> silent;
+   std::atomic<int> readDelayMs;
+
+   // touched only by connection's thread
+   std::string key;
+   bool isTradeConnector;
+
+   uint64 tradeId;
+   int64_t openSentAt;
+   int64_t closeSentAt;
+
+   // granted ids not used yet, with ranges of ids
+   int idRangeSize;
+   std::list<uint64> grantedIds;
+   bool waitsForId;
+
+   // of last tick of ticks provider
+   uint64 tickSequence;
+};
+
+static std::string registered() {
+   return OutputDataBuffer().putString("Registered").buffer();
+}
+
+static std::string resumeTicks(uint64 sequence) {
+   return Protocol::ResumeTicks(sequence).buffer();
+}
+
+static std::string requestNewId() {
+   return OutputDataBuffer().putString(Protocol::RequestNewId::NAME).buffer();
+}
+
+static std::string requestNewIdRange(int size) {
+   return OutputDataBuffer()
+      .putString(Protocol::RequestNewIdRange::NAME)
+      .putInt(size)
+      .buffer();
+}
+
+static std::string openTrade(uint64 id) {
+   return OutputDataBuffer()
+      .putString(Protocol::OpenTrade::NAME)
+      .putLong(id)
+      // request: value, type, no delay
+      .putPrice(Price::fromDouble(0.01))
+      .putString("Buy")
+      .putBool(false)
+      // stop: is equal, is below, value
+      .putBool(true)
+      .putBool(true)
+      .putPrice(Price::fromDouble(1.0))
+      // no take profit
+      .putBool(false)
+      .buffer();
+}
+
+static std::string closeRequest(uint64 id) {
+   return OutputDataBuffer()
+      .putString(Protocol::CloseRequest::NAME)
+      .putLong(id)
+      .buffer();
+}
+
+HubEmulator::Faults::Faults()
+   : disconnects(0)
+   , halfOpens(0)
+   , slowReads(0)
+   , slowReadDelayMs(100) {
+
+}
+
+HubEmulator::HubEmulator(Listener &listener, bool driveTrades)
+   : _listener(listener)
+   , _driveTrades(driveTrades)
+   , _idRangeSize(0)
+   , _socket(-1)
+   , _port(0)
+   , _monitor(Platform::instance().createMonitor())
+   , _stopped(false)
+   , _random(1)
+   , _pingThread(nullptr) {
+
+}
+
+int64_t HubEmulator::now() {
+   return std::chrono::duration_cast<std::chrono::nanoseconds>(
+      std::chrono::steady_clock::now().time_since_epoch()).count();
+}
+
+bool HubEmulator::listen(int port) {
+   _socket = socket(AF_INET, SOCK_STREAM | SOCK_CLOEXEC, 0);
+
+   if (_socket < 0) return false;
+
+   int reuse = 1;
+   setsockopt(_socket, SOL_SOCKET, SO_REUSEADDR, &reuse, sizeof(reuse));
+
+   sockaddr_in address;
+   memset(&address, 0, sizeof(address));
+   address.sin_family = AF_INET;
+   address.sin_port = htons(port);
+   address.sin_addr.s_addr = htonl(INADDR_LOOPBACK);
+
+   socklen_t size = sizeof(address);
+
+   if (bind(_socket, (sockaddr *)&address, size) != 0
+       || ::listen(_socket, 128) != 0
+       || getsockname(_socket, (sockaddr *)&address, &size) != 0) {
+      return false;
+   }
+
+   _port = ntohs(address.sin_port);
+
+   return true;
+}
+
+void HubEmulator::run() {
+   _pingThread = Platform::instance().createThread(std::bind(&HubEmulator::pingLoop, this));
+
+   while (true) {
+      const int descriptor = accept4(_socket, NULL, NULL, SOCK_CLOEXEC);
+
+      _monitor->lock();
+      const bool stopped = _stopped;
+      _monitor->unlock();
+
+      if (stopped) {
+         if (descriptor >= 0) ::close(descriptor);
+         break;
+      }
+
+      if (descriptor < 0) continue;
+
+      // hub writes are small and latency is what is measured
+      int noDelay = 1;
+      setsockopt(descriptor, IPPROTO_TCP, TCP_NODELAY, &noDelay, sizeof(noDelay));
+
+      Connection *connection = new Connection(descriptor);
+
+      _monitor->lock();
+      _connections.push_back(connection);
+      connection->thread = Platform::instance().createThread(std::bind(&HubEmulator::serve,
+                                                                       this,
+                                                                       connection));
+      _monitor->unlock();
+   }
+
+   Thread::joinAndDelete(_pingThread);
+
+   reapFinished(true);
+}
+
+void HubEmulator::stop() {
+   _monitor->lock();
+
+   _stopped = true;
+
+   for (Connection *connection : _connections) connection->shutdown();
+
+   _monitor->notify();
+   _monitor->unlock();
+
+   // wakes up accept
+   ::shutdown(_socket, SHUT_RDWR);
+}
+
+void HubEmulator::setFaults(const Faults &faults) {
+   _monitor->lock();
+   _faults = faults;
+   _monitor->unlock();
+}
+
+void HubEmulator::serve(Connection *connection) {
+   std::string size;
+   std::string packet;
+
+   while (true) {
+      const int delay = connection->readDelayMs;
+
+      if (delay > 0) Platform::instance().sleep(delay);
+
+      if (!connection->socket.read(size, 4)) break;
+
+      const int packetSize = InputDataBuffer(size).nextInt();
+
+      if (packetSize < 0 || !connection->socket.read(packet, packetSize)) break;
+
+      handlePacket(connection, packet);
+   }
+
+   if (!connection->key.empty() && !connection->isTradeConnector && connection->tickSequence > 0) {
+      _monitor->lock();
+      _tickSequences[connection->key] = connection->tickSequence;
+      _monitor->unlock();
+   }
+
+   connection->finished = true;
+}
+
+void HubEmulator::handlePacket(Connection *connection, const std::string &packet) {
+   // half open connection is read, so its close is noticed, but not answered
+   if (packet.empty() || connection->silent) return;
+
+   InputDataBuffer input(packet);
+
+   if (packet.size() == PROBE_SIZE) {
+      const int marker = InputDataBuffer(packet).nextInt();
+
+      if (marker == PROBE_MARKER) {
+         input.nextInt();
+
+         connection->send(OutputDataBuffer()
+                          .putInt(PROBE_REPLY_MARKER)
+                          .putLong(input.nextLong())
+                          .buffer());
+      }
+
+      if (marker == PROBE_MARKER || marker == PROBE_REPLY_MARKER) return;
+   }
+
+   const std::string name = input.nextString();
+
+   if (name == "OnTick") {
+      handleTick(connection, input);
+
+   } else if (name == "RegisterTicksProvider" || name == "RegisterTradeConnector") {
+      connection->key = input.nextString();
+      connection->isTradeConnector = name == "RegisterTradeConnector";
+
+      connection->send(registered());
+
+      if (!connection->isTradeConnector) {
+         _monitor->lock();
+         auto found = _tickSequences.find(connection->key);
+         connection->tickSequence = found == _tickSequences.end() ? 0 : found->second;
+         _monitor->unlock();
+
+         connection->send(resumeTicks(connection->tickSequence > 0 ? connection->tickSequence + 1 : 0));
+      }
+
+      _listener.onRegistered(connection->key, connection->isTradeConnector);
+
+      if (connection->isTradeConnector && _driveTrades) {
+         connection->idRangeSize = _idRangeSize;
+
+         if (connection->idRangeSize > 0) connection->send(requestNewIdRange(connection->idRangeSize));
+
+         nextTrade(connection);
+      }
+
+   } else if (name == "NewId") {
+      startTrade(connection, input.nextLong());
+
+   } else if (name == "NewIdRange") {
+      const uint64 start = input.nextLong();
+      const int count = input.nextInt();
+
+      for (int i = 0; i < count; ++i) connection->grantedIds.push_back(start + i);
+
+      if (connection->waitsForId) nextTrade(connection);
+
+   } else if (name == "OpenedResponse") {
+      if (input.nextLong() != connection->tradeId) return;
+
+      const int64_t time = now();
+
+      _listener.onTradeOpened(connection->key, time - connection->openSentAt);
+
+      connection->closeSentAt = time;
+
+      connection->send(closeRequest(connection->tradeId));
+
+   } else if (name == "ExternallyClosed") {
+      if (input.nextLong() != connection->tradeId) return;
+
+      _listener.onTradeClosed(connection->key, now() - connection->closeSentAt);
+
+   } else if (name == "FreeTrade") {
+      if (input.nextLong() != connection->tradeId) return;
+
+      if (_driveTrades) nextTrade(connection);
+   }
+
+   // balance, equity and messages about trades are not interesting
+}
+
+void HubEmulator::nextTrade(Connection *connection) {
+   connection->waitsForId = false;
+
+   if (connection->idRangeSize == 0) {
+      connection->send(requestNewId());
+   } else if (connection->grantedIds.empty()) {
+      connection->waitsForId = true;
+   } else {
+      const uint64 id = connection->grantedIds.front();
+      connection->grantedIds.pop_front();
+
+      startTrade(connection, id);
+   }
+}
+
+void HubEmulator::handleTick(Connection *connection, InputDataBuffer &input) {
+   const uint64 sequence = input.nextLong();
+   const uint64 time = input.nextLong();
+   const double bid = input.nextPrice().toDouble();
+   const double ask = input.nextPrice().toDouble();
+
+   // lower sequence is of restarted provider, it numbers ticks from 1 again
+   if (connection->tickSequence > 0 && sequence > connection->tickSequence + 1) {
+      _listener.onTicksLost(connection->key, sequence - connection->tickSequence - 1);
+   }
+
+   connection->tickSequence = sequence;
+
+   _listener.onTick(connection->key, sequence, time, bid, ask);
+}
+
+void HubEmulator::startTrade(Connection *connection, uint64 id) {
+   connection->tradeId = id;
+   connection->openSentAt = now();
+
+   connection->send(openTrade(connection->tradeId));
+}
+
+void HubEmulator::pingLoop() {
+   _monitor->lock();
+
+   while (!_stopped) {
+      _monitor->wait(PING_INTERVAL_MS);
+
+      if (_stopped) break;
+
+      // empty packet is ping
+      for (Connection *connection : _connections) {
+         if (!connection->finished && !connection->silent) connection->send(std::string());
+      }
+
+      injectFaults();
+
+      _monitor->unlock();
+      reapFinished(false);
+      _monitor->lock();
+   }
+
+   _monitor->unlock();
+}
+
+void HubEmulator::injectFaults() {
+   std::uniform_real_distribution<double> chance(0, 1);
+
+   for (Connection *connection : _connections) {
+      if (connection->finished || connection->silent) continue;
+
+      const double roll = chance(_random);
+
+      Fault fault;
+
+      if (roll < _faults.disconnects) {
+         fault = DISCONNECT;
+         connection->shutdown();
+      } else if (roll < _faults.disconnects + _faults.halfOpens) {
+         fault = HALF_OPEN;
+         connection->silent = true;
+      } else if (roll < _faults.disconnects + _faults.halfOpens + _faults.slowReads
+                 && connection->readDelayMs == 0) {
+         fault = SLOW_READ;
+         connection->readDelayMs = _faults.slowReadDelayMs;
+      } else {
+         continue;
+      }
+
+      _listener.onFault(fault);
+   }
+}
+
+void HubEmulator::reapFinished(bool all) {
+   std::list<Connection *> finished;
+
+   _monitor->lock();
+
+   for (auto i = _connections.begin(); i != _connections.end(); ) {
+      if (all || (*i)->finished) {
+         finished.push_back(*i);
+         i = _connections.erase(i);
+      } else {
+         ++i;
+      }
+   }
+
+   _monitor->unlock();
+
+   // joins connection threads, so can't be done under the lock
+   for (Connection *connection : finished) {
+      connection->shutdown();
+      delete connection;
+   }
+}
+
+HubEmulator::~HubEmulator() {
+   if (_socket >= 0) ::close(_socket);
+
+   delete _monitor;
+}
@@ -0,0 +1,146 @@
+#ifndef __0B7D1C5E2A8F4E61B3C94D27E6A5F813_HUBEMULATOR_H_INCLUDED__
+#define __0B7D1C5E2A8F4E61B3C94D27E6A5F813_HUBEMULATOR_H_INCLUDED__
+
+#include "platform.h"
+#include <string>
+#include <list>
+#include <map>
+#include <atomic>
+#include <random>
+#include <stdint.h>
+
+class InputDataBuffer;
+
+/**
+ * Stand-in for the scala hub, to benchmark and test connector without
+ * running the real one.
+ *
+ * Listens on loopback port and speaks the same framed protocol as
+ * HubProtocol: answers registrations with Registered, echoes ping probes
+ * and pings every connection once a second, like the hub does. Received
+ * ticks are passed to the listener. Last tick sequence of every ticks
+ * provider is kept, reconnected provider is asked with ResumeTicks for the
+ * ones after it and listener is told of the ones which never came.
+ *
+ * If trades are driven, every registered trade connector goes through an
+ * endless trade cycle: RequestNewId, OpenTrade for received NewId, after
+ * OpenedResponse CloseRequest, after ExternallyClosed and FreeTrade all
+ * over again. Listener gets time from OpenTrade to OpenedResponse and from
+ * CloseRequest to ExternallyClosed. With ranges of ids (see setIdRanges())
+ * new trade is opened with granted id, without RequestNewId.
+ *
+ * Faults (see Faults) are injected into live connections once a second,
+ * when pings are sent.
+ *
+ * Times are in nanoseconds of std::chrono::steady_clock.
+ */
+class HubEmulator {
+   HubEmulator(const HubEmulator &referenceToCopyFrom);
+   void operator=(const HubEmulator &referenceToCopyFrom);
+
+public:
+
+   enum Fault {
+      // connection is shut down, connector sees it closed
+      DISCONNECT,
+      // hub stops answering but keeps connection open, only pings of the
+      // connector can notice it
+      HALF_OPEN,
+      // hub reads the connection slowly from then on
+      SLOW_READ
+   };
+
+   /**
+    * Chances of every live connection to get the fault each second, a
+    * connection gets one fault at most.
+    */
+   struct Faults {
+      Faults();
+
+      double disconnects;
+      double halfOpens;
+      double slowReads;
+
+      // pause before every read of slowly read connection
+      int slowReadDelayMs;
+   };
+
+   // called from connection threads, concurrently
+   class Listener {
+   public:
+      virtual void onRegistered(const std::string &key, bool isTradeConnector) {}
+      // time is of terminal, in milliseconds
+      virtual void onTick(const std::string &key, uint64 sequence, uint64 time, double bid, double ask) {}
+      // gap in sequence of ticks of the provider
+      virtual void onTicksLost(const std::string &key, uint64 count) {}
+      virtual void onTradeOpened(const std::string &key, int64_t nanoseconds) {}
+      virtual void onTradeClosed(const std::string &key, int64_t nanoseconds) {}
+
+      // called from the ping thread
+      virtual void onFault(Fault fault) {}
+
+      virtual ~Listener() {}
+   };
+
+   HubEmulator(Listener &listener, bool driveTrades);
+
+   // zero port picks any free one, see port()
+   bool listen(int port);
+
+   int port() const { return _port; }
+
+   // accepts connections until stop()
+   void run();
+
+   // can be called from any thread, drops all connections
+   void stop();
+
+   // can be called from any thread, applies to connections alive then
+   void setFaults(const Faults &faults);
+
+   // trade connectors registered later are asked for ranges of ids of this
+   // size, zero asks for every id
+   void setIdRanges(int size) { _idRangeSize = size; }
+
+   static int64_t now();
+
+   ~HubEmulator();
+
+private:
+
+   class Connection;
+
+   void serve(Connection *connection);
+   void handlePacket(Connection *connection, const std::string &packet);
+   void handleTick(Connection *connection, InputDataBuffer &input);
+
+   // opens trade with granted id, or asks for an id
+   void nextTrade(Connection *connection);
+   void startTrade(Connection *connection, uint64 id);
+
+   void pingLoop();
+   void injectFaults();
+   void reapFinished(bool all);
+
+private:
+   Listener &_listener;
+   const bool _driveTrades;
+   std::atomic<int> _idRangeSize;
+
+   int _socket;
+   int _port;
+
+   Monitor *_monitor;
+   std::list<Connection *> _connections;
+   bool _stopped;
+
+   // last tick of ticks providers, by key
+   std::map<std::string, uint64> _tickSequences;
+
+   Faults _faults;
+   std::minstd_rand _random;
+
+   Thread *_pingThread;
+};
+
+#endif 	// __0B7D1C5E2A8F4E61B3C94D27E6A5F813_HUBEMULATOR_H_INCLUDED__
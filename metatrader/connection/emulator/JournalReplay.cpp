@@ -0,0 +1,177 @@
+#include "JournalReplay.h"
+#include "RunLoopUser.h"
+#include "ConnectionHandle.h"
+#include "ConnectionHandleListener.h"
+#include "InputDataBuffer.h"
+#include "TrafficJournal.h"
+#include <map>
+#include <algorithm>
+
+enum {
+   DEFAULT_BATCH = 256,
+
+   // see Pinger
+   PROBE_SIZE = 12
+};
+
+JournalReplay::Config::Config()
+   : maxSpeed(false)
+   , batch(DEFAULT_BATCH) {
+
+}
+
+JournalReplay::Stats::Stats()
+   : delivered(0)
+   , deliveredBytes(0)
+   , sent(0)
+   , startedAt(0)
+   , finishedAt(0) {
+
+}
+
+class JournalReplay::Link : virtual public ConnectionState
+                          , private RunLoopUser {
+public:
+   Link(const Context &context,
+        JournalReplay &replay)
+      : ConnectionState(context)
+      , RunLoopUser(context.ctRunLoop)
+      , _replay(replay)
+      , _next(0)
+      , _startedAt(0) {}
+
+   void initState() {
+      _context.connectionListener.onConnected();
+
+      _startedAt = runLoop().currentTime();
+      _replay._stats.startedAt = TrafficJournal::monotonicMicroseconds();
+
+      post(std::bind(&Link::deliver, this));
+   }
+
+   void sendData(const std::string &buffer, RunLoop::Priority priority) {
+      ++_replay._stats.sent;
+   }
+
+   bool shouldDeliverEvents() { return true; }
+
+private:
+
+   void deliver() {
+      const std::vector<Frame> &frames = _replay._frames;
+      Stats &stats = _replay._stats;
+
+      const size_t last = _replay._config.maxSpeed
+         ? std::min(frames.size(), _next + _replay._config.batch)
+         : frames.size();
+
+      // frame times are in microseconds, run loop's in milliseconds
+      const uint64 elapsed = (runLoop().currentTime() - _startedAt) * 1000;
+
+      while (_next < last) {
+         const Frame &frame = frames[_next];
+
+         if (!_replay._config.maxSpeed && frame.time - frames.front().time > elapsed) break;
+
+         _context.connectionListener.onPacket(frame.data);
+
+         ++stats.delivered;
+         stats.deliveredBytes += frame.data.size();
+         ++_next;
+      }
+
+      if (_next == frames.size()) {
+         stats.finishedAt = TrafficJournal::monotonicMicroseconds();
+
+         if (_replay._onFinished) _replay._onFinished();
+         return;
+      }
+
+      if (_replay._config.maxSpeed) {
+         post(std::bind(&Link::deliver, this));
+      } else {
+         const uint64 due = frames[_next].time - frames.front().time;
+
+         postDelayed((due - elapsed + 999) / 1000,
+                     std::bind(&Link::deliver, this));
+      }
+   }
+
+private:
+   JournalReplay &_replay;
+
+   size_t _next;
+   Platform::Milliseconds _startedAt;
+};
+
+JournalReplay::JournalReplay(RunLoop &runLoop,
+                             Logger &logger,
+                             const std::string &path,
+                             const std::string &connection,
+                             const Config &config,
+                             const Finished &onFinished)
+   : _runLoop(runLoop)
+   , _logger(logger)
+   , _config(config)
+   , _onFinished(onFinished)
+   , _loaded(false) {
+
+   TrafficJournal::Reader reader(path);
+
+   if (!reader.isValid()) return;
+
+   TrafficJournal::Record record;
+
+   while (reader.next(record)) {
+      if (record.kind != TrafficJournal::RECEIVED
+          || record.connection != connection
+          || isPing(record.frame)) continue;
+
+      _frames.push_back(Frame());
+      _frames.back().time = record.time;
+      _frames.back().data.swap(record.frame);
+   }
+
+   _loaded = true;
+}
+
+HubInteraction::ConnectionFactory JournalReplay::connectionFactory() {
+   return [this](const HubEndpoints::Endpoint &endpoint,
+                 ConnectionHandleListener &listener) -> ConnectionHandle * {
+      return new ConnectionHandle(_runLoop,
+                                  _logger,
+                                  listener,
+                                  [this](const ConnectionState::Context &context) -> ConnectionState * {
+                                     return new Link(context, *this);
+                                  } );
+   };
+}
+
+bool JournalReplay::isPing(const std::string &frame) {
+   return frame.empty()
+      || (frame.size() == PROBE_SIZE && InputDataBuffer(frame).nextInt() < 0);
+}
+
+bool JournalReplay::listConnections(const std::string &path,
+                                    std::vector<std::pair<std::string, uint64> > &connections) {
+   TrafficJournal::Reader reader(path);
+
+   if (!reader.isValid()) return false;
+
+   std::map<std::string, uint64> counts;
+   std::vector<std::string> order;
+
+   TrafficJournal::Record record;
+
+   while (reader.next(record)) {
+      if (counts.find(record.connection) == counts.end()) order.push_back(record.connection);
+
+      uint64 &count = counts[record.connection];
+
+      if (record.kind == TrafficJournal::RECEIVED && !isPing(record.frame)) ++count;
+   }
+
+   for (const std::string &name : order) connections.push_back(std::make_pair(name, counts[name]));
+
+   return true;
+}
@@ -0,0 +1,101 @@
+#ifndef __3D8F51B6E0A24C9F8E17A2C5B94D06E3_JOURNALREPLAY_H_INCLUDED__
+#define __3D8F51B6E0A24C9F8E17A2C5B94D06E3_JOURNALREPLAY_H_INCLUDED__
+
+#include <string>
+#include <vector>
+#include <functional>
+#include "RunLoop.h"
+#include "HubInteraction.h"
+
+/**
+ * Plays frames received by one connection in captured TrafficJournal back
+ * into whoever uses connectionFactory(), like MTTradeConnector, at original
+ * pace or as fast as the run loop can deliver.
+ *
+ * Frames of all sessions of the connection are played as one session,
+ * pings and probes are left out as they would be eaten by Pinger. Frames
+ * are loaded to memory up front, so replay measures the packet path and
+ * not the disk.
+ *
+ * Everything but constructor should be called on the run loop's thread.
+ */
+class JournalReplay {
+   JournalReplay(const JournalReplay &referenceToCopyFrom);
+   void operator=(const JournalReplay &referenceToCopyFrom);
+
+public:
+
+   struct Config {
+      Config();
+
+      bool maxSpeed;
+      // frames delivered by one run loop task at max speed
+      int batch;
+   };
+
+   struct Stats {
+      Stats();
+
+      uint64 delivered;
+      uint64 deliveredBytes;
+      // frames connection has sent back while replaying
+      uint64 sent;
+
+      // monotonic microseconds, see TrafficJournal
+      uint64 startedAt;
+      uint64 finishedAt;
+   };
+
+   typedef std::function<void()> Finished;
+
+   /**
+    * Connection is full name of connection in journal, see
+    * TrafficJournal::Record.
+    */
+   JournalReplay(RunLoop &runLoop,
+                 Logger &logger,
+                 const std::string &path,
+                 const std::string &connection,
+                 const Config &config,
+                 const Finished &onFinished);
+
+   // false if journal can't be read
+   bool isLoaded() const { return _loaded; }
+
+   size_t frames() const { return _frames.size(); }
+
+   HubInteraction::ConnectionFactory connectionFactory();
+
+   const Stats &stats() const { return _stats; }
+
+   /**
+    * Names of connections in journal with count of frames they received,
+    * excluding pings.
+    */
+   static bool listConnections(const std::string &path,
+                               std::vector<std::pair<std::string, uint64> > &connections);
+
+private:
+
+   class Link;
+
+   struct Frame {
+      uint64 time;
+      std::string data;
+   };
+
+   static bool isPing(const std::string &frame);
+
+private:
+   RunLoop &_runLoop;
+   Logger &_logger;
+   const Config _config;
+   const Finished _onFinished;
+
+   bool _loaded;
+   std::vector<Frame> _frames;
+
+   Stats _stats;
+};
+
+#endif 	// __3D8F51B6E0A24C9F8E17A2C5B94D06E3_JOURNALREPLAY_H_INCLUDED__
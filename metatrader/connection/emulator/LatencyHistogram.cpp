@@ -0,0 +1,71 @@
+#include "LatencyHistogram.h"
+#include <algorithm>
+
+LatencyHistogram::LatencyHistogram() {
+   reset();
+}
+
+int LatencyHistogram::bucketOf(uint64_t value) {
+   if (value < SUB_BUCKETS) return value;
+
+   // position of highest bit, values with it in the same place share
+   // group of buckets, next bits choose bucket inside of group
+   const int highest = 63 - __builtin_clzll(value);
+   const int shift = highest - SUB_BUCKET_BITS;
+
+   return (shift + 1) * SUB_BUCKETS + ((value >> shift) & (SUB_BUCKETS - 1));
+}
+
+int64_t LatencyHistogram::upperBoundOf(int bucket) {
+   if (bucket < SUB_BUCKETS) return bucket;
+
+   const int shift = bucket / SUB_BUCKETS - 1;
+   const uint64_t base = (uint64_t)(SUB_BUCKETS + bucket % SUB_BUCKETS) << shift;
+
+   return base + ((uint64_t)1 << shift) - 1;
+}
+
+void LatencyHistogram::record(int64_t nanoseconds) {
+   if (nanoseconds < 0) nanoseconds = 0;
+
+   _buckets[bucketOf(nanoseconds)].fetch_add(1, std::memory_order_relaxed);
+   _count.fetch_add(1, std::memory_order_relaxed);
+
+   int64_t max = _max.load(std::memory_order_relaxed);
+   while (nanoseconds > max
+          && !_max.compare_exchange_weak(max, nanoseconds, std::memory_order_relaxed)) {}
+}
+
+uint64_t LatencyHistogram::count() const {
+   return _count.load();
+}
+
+int64_t LatencyHistogram::max() const {
+   return _max.load();
+}
+
+int64_t LatencyHistogram::percentile(double quantile) const {
+   const uint64_t total = count();
+
+   if (total == 0) return 0;
+
+   uint64_t threshold = (uint64_t)(quantile * total);
+   if (threshold >= total) threshold = total - 1;
+
+   uint64_t seen = 0;
+
+   for (int i = 0; i < BUCKETS; ++i) {
+      seen += _buckets[i].load();
+
+      if (seen > threshold) return std::min(upperBoundOf(i), max());
+   }
+
+   return max();
+}
+
+void LatencyHistogram::reset() {
+   for (int i = 0; i < BUCKETS; ++i) _buckets[i].store(0);
+
+   _count.store(0);
+   _max.store(0);
+}
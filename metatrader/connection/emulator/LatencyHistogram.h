@@ -0,0 +1,46 @@
+#ifndef __0B7D1C5E2A8F4E61B3C94D27E6A5F813_LATENCYHISTOGRAM_H_INCLUDED__
+#define __0B7D1C5E2A8F4E61B3C94D27E6A5F813_LATENCYHISTOGRAM_H_INCLUDED__
+
+#include <atomic>
+#include <stdint.h>
+
+/**
+ * Log-linear histogram of latencies in nanoseconds: every power of two is
+ * split into 16 linear buckets, so percentiles are within ~6% of exact.
+ *
+ * Recording is wait-free and can be done from many threads. Has no
+ * pointers inside, so it can live in memory shared between processes.
+ */
+class LatencyHistogram {
+public:
+
+   LatencyHistogram();
+
+   void record(int64_t nanoseconds);
+
+   uint64_t count() const;
+   int64_t max() const;
+
+   // quantile in [0, 1], returns upper bound of bucket it falls into
+   int64_t percentile(double quantile) const;
+
+   void reset();
+
+private:
+
+   enum {
+      SUB_BUCKET_BITS = 4,
+      SUB_BUCKETS = 1 << SUB_BUCKET_BITS,
+      BUCKETS = (64 - SUB_BUCKET_BITS + 1) * SUB_BUCKETS
+   };
+
+   static int bucketOf(uint64_t value);
+   static int64_t upperBoundOf(int bucket);
+
+private:
+   std::atomic<uint64_t> _buckets[BUCKETS];
+   std::atomic<uint64_t> _count;
+   std::atomic<int64_t> _max;
+};
+
+#endif 	// __0B7D1C5E2A8F4E61B3C94D27E6A5F813_LATENCYHISTOGRAM_H_INCLUDED__
@@ -0,0 +1,349 @@
+#include "SimulatedBroker.h"
+#include <algorithm>
+#include <math.h>
+
+typedef TradeReconciler::Result Result;
+typedef TradeReconciler::Action Action;
+
+static bool isBuy(int type) {
+   return type == TradeReconciler::OP_BUY || type == TradeReconciler::OP_BUYLIMIT;
+}
+
+static bool isPending(int type) {
+   return type == TradeReconciler::OP_BUYLIMIT || type == TradeReconciler::OP_SELLLIMIT;
+}
+
+SimulatedBroker::Config::Config()
+   : digits(5)
+   , stopLevel(10)
+   , freezeLevel(0)
+   , maxSlippage(2)
+   , minLot(0.01)
+   , lotStep(0.01)
+   , lotSize(100000)
+   , balance(10000)
+   , seed(1) {
+
+}
+
+SimulatedBroker::Stats::Stats()
+   : opened(0)
+   , limitsFilled(0)
+   , modified(0)
+   , closed(0)
+   , deleted(0)
+   , stopsHit(0)
+   , takesHit(0)
+   , rejected(0) {
+
+}
+
+SimulatedBroker::SimulatedBroker(const Config &config)
+   : _config(config)
+   , _market()
+   , _random(config.seed)
+   , _tickets(0)
+   , _balance(config.balance) {
+
+   _market.point       = pow(10, -config.digits);
+   _market.digits      = config.digits;
+   _market.stopLevel   = config.stopLevel;
+   _market.freezeLevel = config.freezeLevel;
+   _market.minLot      = config.minLot;
+   _market.lotStep     = config.lotStep;
+   _market.lotSize     = config.lotSize;
+}
+
+void SimulatedBroker::onTick(double bid, double ask) {
+   _market.bid = bid;
+   _market.ask = ask;
+
+   const double half = _market.point / 2;
+
+   for (auto i = _orders.begin(); i != _orders.end(); ) {
+      Order &order = i->second;
+      auto current = i++;
+
+      if (order.type == TradeReconciler::OP_BUYLIMIT && ask <= order.openPrice + half) {
+         order.type = TradeReconciler::OP_BUY;
+         ++_stats.limitsFilled;
+      } else if (order.type == TradeReconciler::OP_SELLLIMIT && bid >= order.openPrice - half) {
+         order.type = TradeReconciler::OP_SELL;
+         ++_stats.limitsFilled;
+      }
+
+      if (isPending(order.type)) continue;
+
+      // buy is closed by bid, sell by ask
+      const double price = order.type == TradeReconciler::OP_BUY ? bid : ask;
+      const double sign = order.type == TradeReconciler::OP_BUY ? 1 : -1;
+
+      if (order.stop != 0 && sign * (price - order.stop) <= half) {
+         ++_stats.stopsHit;
+         closeOrder(current, price);
+      } else if (order.take != 0 && sign * (order.take - price) <= half) {
+         ++_stats.takesHit;
+         closeOrder(current, order.take);
+      }
+   }
+}
+
+void SimulatedBroker::orders(std::vector<TradeReconciler::Order> &orders) const {
+   orders.clear();
+
+   for (auto &i : _orders) {
+      TradeReconciler::Order order;
+      order.ticket    = i.second.ticket;
+      order.type      = i.second.type;
+      order.lots      = i.second.lots;
+      order.openPrice = i.second.openPrice;
+
+      orders.push_back(order);
+   }
+}
+
+Result SimulatedBroker::execute(const Action &action) {
+   switch (action.kind) {
+      case TradeReconciler::OPEN:   return open(action);
+      case TradeReconciler::MODIFY: return modify(action);
+      case TradeReconciler::CLOSE:  return close(action);
+      case TradeReconciler::DELETE: return remove(action);
+      case TradeReconciler::CHECK:  return check(action);
+   }
+
+   return rejected(0, ERR_INVALID_TICKET);
+}
+
+double SimulatedBroker::equity() const {
+   double equity = _balance;
+
+   for (auto &i : _orders) {
+      const Order &order = i.second;
+
+      if (isPending(order.type)) continue;
+
+      equity += profitOf(order, order.type == TradeReconciler::OP_BUY ? _market.bid : _market.ask);
+   }
+
+   return equity;
+}
+
+Result SimulatedBroker::open(const Action &action) {
+   const double steps = action.lots / _config.lotStep;
+
+   if (action.lots < _config.minLot - _config.lotStep / 2 || fabs(steps - floor(steps + 0.5)) > 1e-6) {
+      return rejected(-1, ERR_INVALID_TRADE_VOLUME);
+   }
+
+   Order order = Order();
+   order.type = action.opType;
+   order.lots = action.lots;
+   order.stop = action.stop;
+   order.take = action.take;
+
+   if (isPending(action.opType)) {
+      if (!isPendingPriceValid(action.opType, action.price)) return rejected(-1, ERR_INVALID_STOPS);
+
+      order.openPrice = action.price;
+   } else {
+      // stops are checked against price the order is closed by
+      const double base = isBuy(action.opType) ? _market.bid : _market.ask;
+
+      if (!areStopsValid(action.opType, base, action.stop, action.take)) return rejected(-1, ERR_INVALID_STOPS);
+
+      if (!fill(isBuy(action.opType), action.price, action.slippage, order.openPrice)) return rejected(-1, ERR_REQUOTE);
+   }
+
+   if (isPending(action.opType) && !areStopsValid(action.opType, order.openPrice, action.stop, action.take)) {
+      return rejected(-1, ERR_INVALID_STOPS);
+   }
+
+   order.ticket = ++_tickets;
+   _orders[order.ticket] = order;
+
+   ++_stats.opened;
+
+   return resultOf(order.ticket, order);
+}
+
+Result SimulatedBroker::modify(const Action &action) {
+   auto found = _orders.find(action.ticket);
+
+   if (found == _orders.end()) return rejected(0, ERR_INVALID_TICKET);
+
+   Order &order = found->second;
+
+   if (isFrozen(order)) return rejected(0, ERR_TRADE_MODIFY_DENIED);
+
+   // open price of opened order can't be changed
+   const double price = isPending(order.type) ? action.price : order.openPrice;
+
+   const double half = _market.point / 2;
+
+   if (fabs(price - order.openPrice) < half
+       && fabs(action.stop - order.stop) < half
+       && fabs(action.take - order.take) < half) {
+      return rejected(0, ERR_NO_RESULT);
+   }
+
+   if (isPending(order.type)) {
+      if (!isPendingPriceValid(order.type, price)
+          || !areStopsValid(order.type, price, action.stop, action.take)) {
+         return rejected(0, ERR_INVALID_STOPS);
+      }
+   } else {
+      const double base = order.type == TradeReconciler::OP_BUY ? _market.bid : _market.ask;
+
+      if (!areStopsValid(order.type, base, action.stop, action.take)) return rejected(0, ERR_INVALID_STOPS);
+   }
+
+   order.openPrice = price;
+   order.stop = action.stop;
+   order.take = action.take;
+
+   ++_stats.modified;
+
+   return resultOf(1, order);
+}
+
+Result SimulatedBroker::close(const Action &action) {
+   auto found = _orders.find(action.ticket);
+
+   if (found == _orders.end() || isPending(found->second.type)) return rejected(0, ERR_INVALID_TICKET);
+
+   if (isFrozen(found->second)) return rejected(0, ERR_TRADE_MODIFY_DENIED);
+
+   // buy is closed by selling
+   double price;
+
+   if (!fill(found->second.type != TradeReconciler::OP_BUY, action.price, action.slippage, price)) {
+      return rejected(0, ERR_REQUOTE);
+   }
+
+   const int ticket = action.ticket;
+
+   closeOrder(found, price);
+
+   ++_stats.closed;
+
+   return resultOf(1, _history[ticket]);
+}
+
+Result SimulatedBroker::remove(const Action &action) {
+   auto found = _orders.find(action.ticket);
+
+   if (found == _orders.end() || !isPending(found->second.type)) return rejected(0, ERR_INVALID_TICKET);
+
+   if (isFrozen(found->second)) return rejected(0, ERR_TRADE_MODIFY_DENIED);
+
+   const int ticket = action.ticket;
+
+   closeOrder(found, isBuy(found->second.type) ? _market.ask : _market.bid);
+
+   ++_stats.deleted;
+
+   return resultOf(1, _history[ticket]);
+}
+
+Result SimulatedBroker::check(const Action &action) const {
+   auto open = _orders.find(action.ticket);
+
+   if (open != _orders.end()) return resultOf(1, open->second);
+
+   auto closed = _history.find(action.ticket);
+
+   if (closed != _history.end()) return resultOf(2, closed->second);
+
+   return resultOf(0, Order());
+}
+
+Result SimulatedBroker::rejected(int status, int error) {
+   ++_stats.rejected;
+
+   Result result = Result();
+   result.status = status;
+   result.error = error;
+
+   return result;
+}
+
+Result SimulatedBroker::resultOf(int status, const Order &order) {
+   Result result = Result();
+   result.status     = status;
+   result.orderType  = order.type;
+   result.openPrice  = order.openPrice;
+   result.closePrice = order.closePrice;
+   result.profit     = order.profit;
+
+   return result;
+}
+
+bool SimulatedBroker::fill(bool isBuy, double requested, int slippage, double &price) {
+   const double market = isBuy ? _market.ask : _market.bid;
+
+   if (isBeyond(fabs(requested - market), slippage)) return false;
+
+   const int slipped = std::uniform_int_distribution<int>(0, std::max(_config.maxSlippage, 0))(_random);
+
+   if (slipped > slippage) return false;
+
+   price = isBuy ? market + slipped * _market.point : market - slipped * _market.point;
+
+   return true;
+}
+
+void SimulatedBroker::closeOrder(std::map<int, Order>::iterator order, double price) {
+   Order &closed = _history[order->first] = order->second;
+
+   closed.closePrice = price;
+   closed.profit = isPending(closed.type) ? 0 : profitOf(closed, price);
+
+   _balance += closed.profit;
+
+   _orders.erase(order);
+}
+
+bool SimulatedBroker::areStopsValid(int type, double base, double stop, double take) const {
+   const double sign = isBuy(type) ? 1 : -1;
+
+   return (stop == 0 || isAtLeast(sign * (base - stop), _config.stopLevel))
+      && (take == 0 || isAtLeast(sign * (take - base), _config.stopLevel));
+}
+
+bool SimulatedBroker::isPendingPriceValid(int type, double price) const {
+   return type == TradeReconciler::OP_BUYLIMIT
+      ? isAtLeast(_market.ask - price, _config.stopLevel)
+      : isAtLeast(price - _market.bid, _config.stopLevel);
+}
+
+bool SimulatedBroker::isFrozen(const Order &order) const {
+   if (_config.freezeLevel <= 0) return false;
+
+   switch (order.type) {
+      case TradeReconciler::OP_BUYLIMIT:
+         return !isBeyond(_market.ask - order.openPrice, _config.freezeLevel);
+
+      case TradeReconciler::OP_SELLLIMIT:
+         return !isBeyond(order.openPrice - _market.bid, _config.freezeLevel);
+   }
+
+   const double sign = order.type == TradeReconciler::OP_BUY ? 1 : -1;
+   const double price = order.type == TradeReconciler::OP_BUY ? _market.bid : _market.ask;
+
+   return (order.stop != 0 && !isBeyond(sign * (price - order.stop), _config.freezeLevel))
+      || (order.take != 0 && !isBeyond(sign * (order.take - price), _config.freezeLevel));
+}
+
+double SimulatedBroker::profitOf(const Order &order, double closePrice) const {
+   const double difference = isBuy(order.type) ? closePrice - order.openPrice : order.openPrice - closePrice;
+
+   return difference * order.lots * _config.lotSize;
+}
+
+bool SimulatedBroker::isAtLeast(double distance, double level) const {
+   return distance > (level - 0.5) * _market.point;
+}
+
+bool SimulatedBroker::isBeyond(double distance, double level) const {
+   return distance > (level + 0.5) * _market.point;
+}
@@ -0,0 +1,142 @@
+#ifndef __5044AE62477349FD86CEF9551C7C31E3_SIMULATEDBROKER_H_INCLUDED__
+#define __5044AE62477349FD86CEF9551C7C31E3_SIMULATEDBROKER_H_INCLUDED__
+
+#include <map>
+#include <vector>
+#include <random>
+#include "TradeReconciler.h"
+
+/**
+ * Orders of one symbol executed as mt's server would, for a terminal
+ * simulated without MetaTrader.
+ *
+ * Executes actions of TradeReconciler with mt's rules: stops and pending
+ * orders at least stop level away from market, no changes of orders in
+ * freeze level, fills worse than requested price by random slippage and
+ * requotes when it's more than allowed. Ticks fill limit orders and close
+ * orders whose stop or take profit are hit, stops at market price, take
+ * profits at their price.
+ *
+ * Randomness comes only from the seed.
+ */
+class SimulatedBroker {
+   SimulatedBroker(const SimulatedBroker &referenceToCopyFrom);
+   void operator=(const SimulatedBroker &referenceToCopyFrom);
+
+public:
+
+   struct Config {
+      Config();
+
+      int digits;
+
+      // in points
+      double stopLevel;
+      double freezeLevel;
+      int maxSlippage;
+
+      double minLot;
+      double lotStep;
+      double lotSize;
+
+      double balance;
+      uint32 seed;
+   };
+
+   struct Stats {
+      Stats();
+
+      uint64 opened;
+      uint64 limitsFilled;
+      uint64 modified;
+      uint64 closed;
+      uint64 deleted;
+      uint64 stopsHit;
+      uint64 takesHit;
+      uint64 rejected;
+   };
+
+   // of mt
+   enum Error {
+      ERR_NO_RESULT = 1,
+      ERR_INVALID_STOPS = 130,
+      ERR_INVALID_TRADE_VOLUME = 131,
+      ERR_REQUOTE = 138,
+      ERR_TRADE_MODIFY_DENIED = 145,
+      ERR_INVALID_TICKET = 4108
+   };
+
+   SimulatedBroker(const Config &config);
+
+   // market moves, limit orders are filled, stops and take profits hit
+   void onTick(double bid, double ask);
+
+   const TradeReconciler::Market &market() const { return _market; }
+
+   // open and pending orders
+   void orders(std::vector<TradeReconciler::Order> &orders) const;
+
+   TradeReconciler::Result execute(const TradeReconciler::Action &action);
+
+   double balance() const { return _balance; }
+   double equity() const;
+
+   const Stats &stats() const { return _stats; }
+
+private:
+
+   struct Order {
+      int ticket;
+      int type;
+      double lots;
+      double openPrice;
+      double stop;
+      double take;
+
+      // in history only
+      double closePrice;
+      double profit;
+   };
+
+   TradeReconciler::Result open(const TradeReconciler::Action &action);
+   TradeReconciler::Result modify(const TradeReconciler::Action &action);
+   TradeReconciler::Result close(const TradeReconciler::Action &action);
+   TradeReconciler::Result remove(const TradeReconciler::Action &action);
+   TradeReconciler::Result check(const TradeReconciler::Action &action) const;
+
+   TradeReconciler::Result rejected(int status, int error);
+   static TradeReconciler::Result resultOf(int status, const Order &order);
+
+   // fill of market order at price of market, false if requoted
+   bool fill(bool isBuy, double requested, int slippage, double &price);
+
+   void closeOrder(std::map<int, Order>::iterator order, double price);
+
+   // stops of order of type with base price, see mt's stop level
+   bool areStopsValid(int type, double base, double stop, double take) const;
+   bool isPendingPriceValid(int type, double price) const;
+   bool isFrozen(const Order &order) const;
+
+   double profitOf(const Order &order, double closePrice) const;
+
+   // distance in prices is at least (beyond) level in points
+   bool isAtLeast(double distance, double level) const;
+   bool isBeyond(double distance, double level) const;
+
+private:
+   const Config _config;
+
+   TradeReconciler::Market _market;
+
+   std::minstd_rand _random;
+
+   int _tickets;
+   double _balance;
+
+   std::map<int, Order> _orders;
+   std::map<int, Order> _history;
+
+   Stats _stats;
+};
+
+#endif 	// __5044AE62477349FD86CEF9551C7C31E3_SIMULATEDBROKER_H_INCLUDED__
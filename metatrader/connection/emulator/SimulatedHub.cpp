@@ -0,0 +1,277 @@
+#include "SimulatedHub.h"
+#include "RunLoopUser.h"
+#include "Pinger.h"
+#include "ConnectionHandle.h"
+#include "ConnectionHandleListener.h"
+#include "StateConnectFailed.h"
+#include "StateDisconnected.h"
+#include "InputDataBuffer.h"
+#include "OutputDataBuffer.h"
+#include <sstream>
+#include <math.h>
+
+enum {
+   HUB_PING_INTERVAL_MS = 1000,
+
+   // see Pinger
+   PROBE_MARKER = -1,
+   PROBE_REPLY_MARKER = -2,
+   PROBE_SIZE = 12
+};
+
+SimulatedHub::Config::Config()
+   : refusals(0.05)
+   , maxConnectTime(200)
+   , meanLifetime(20 * 60 * 1000)
+   , silentDeaths(0.3)
+   , minRtt(1)
+   , maxRtt(300)
+   , meanUptime(2 * 60 * 60 * 1000)
+   , meanOutage(5 * 60 * 1000) {
+
+}
+
+SimulatedHub::Stats::Stats()
+   : attempts(0)
+   , refused(0)
+   , connected(0)
+   , closedByHub(0)
+   , wentSilent(0)
+   , pingTimeouts(0)
+   , outages(0) {
+
+}
+
+class SimulatedHub::Link : virtual public ConnectionState
+                         , private PingerListener
+                         , private RunLoopUser {
+public:
+   Link(const Context &context,
+        SimulatedHub &hub,
+        const std::string &address)
+      : ConnectionState(context)
+      , RunLoopUser(context.ctRunLoop)
+      , _hub(hub)
+      , _address(address)
+      , _pinger(nullptr)
+      , _alive(false)
+      , _silent(false)
+      , _rtt(0) {}
+
+   void initState() {
+      ++_hub._stats.attempts;
+
+      const bool refused = _hub.isDown(_address) || _hub.chance(_hub._config.refusals);
+
+      postDelayed(_hub.uniform(1, _hub._config.maxConnectTime),
+                  [this, refused]() -> void {
+                     if (refused) {
+                        refuse();
+                     } else {
+                        connect();
+                     }
+                  } );
+   }
+
+   void sendData(const std::string &buffer, RunLoop::Priority priority) {
+      if (_pinger) _pinger->onDataSent();
+   }
+
+   bool shouldDeliverEvents() { return true; }
+
+   ~Link() {
+      delete _pinger;
+   }
+
+private:
+
+   // switcher is called with the lock of the connection
+   void switchTo(ConnectionState *state) {
+      locked([this, state]() -> void { _context.stateSwitcher(state); } );
+   }
+
+   void refuse() {
+      ++_hub._stats.refused;
+      _hub.trace(_address, "refused");
+
+      switchTo(new StateConnectFailed(_context));
+   }
+
+   void connect() {
+      const Platform::Milliseconds lifetime = _hub.exponential(_hub._config.meanLifetime);
+
+      _rtt = _hub.uniform(_hub._config.minRtt, _hub._config.maxRtt);
+      _silent = _hub.chance(_hub._config.silentDeaths);
+      _alive = true;
+
+      ++_hub._stats.connected;
+
+      std::ostringstream event;
+      event << "connected, rtt " << _rtt << ", lives " << lifetime
+            << (_silent ? ", will go silent" : ", will be closed");
+      _hub.trace(_address, event.str());
+
+      _pinger = new Pinger(_context.ctRunLoop, *this);
+
+      _context.connectionListener.onConnected();
+
+      postHubPing();
+
+      postDelayed(lifetime, std::bind(&Link::die, this));
+   }
+
+   void die() {
+      if (!_alive) return;
+
+      _alive = false;
+
+      if (_silent) {
+         ++_hub._stats.wentSilent;
+         _hub.trace(_address, "went silent");
+      } else {
+         ++_hub._stats.closedByHub;
+         _hub.trace(_address, "closed by hub");
+
+         _pinger->stop();
+         switchTo(new StateDisconnected(_context));
+      }
+   }
+
+   void postHubPing() {
+      postDelayed(HUB_PING_INTERVAL_MS,
+                  [this]() -> void {
+                     if (!_alive) return;
+
+                     deliver(Pinger::PING_PACKET);
+                     postHubPing();
+                  } );
+   }
+
+   void deliver(const std::string &packet) {
+      if (!_pinger->isPing(packet)) _context.connectionListener.onPacket(packet);
+   }
+
+   void sendPing(const std::string &packet) {
+      if (!_alive || packet.size() != PROBE_SIZE) return;
+
+      InputDataBuffer input(packet);
+
+      if (input.nextInt() != PROBE_MARKER) return;
+
+      const std::string reply = OutputDataBuffer()
+         .putInt(PROBE_REPLY_MARKER)
+         .putLong(input.nextLong())
+         .buffer();
+
+      postDelayed(_rtt,
+                  [this, reply]() -> void {
+                     if (_alive) deliver(reply);
+                  } );
+   }
+
+   void onPingTimedOut() {
+      ++_hub._stats.pingTimeouts;
+
+      std::ostringstream event;
+      event << "ping timeout after " << _pinger->currentTimeout() << " ms";
+      _hub.trace(_address, event.str());
+
+      _alive = false;
+
+      switchTo(new StateDisconnected(_context));
+   }
+
+private:
+   SimulatedHub &_hub;
+   const std::string _address;
+
+   Pinger *_pinger;
+
+   bool _alive;
+   bool _silent;
+   Platform::Milliseconds _rtt;
+};
+
+SimulatedHub::SimulatedHub(RunLoop &runLoop,
+                           Logger &logger,
+                           uint32 seed,
+                           const Config &config,
+                           const Tracer &tracer)
+   : _runLoop(runLoop)
+   , _logger(logger)
+   , _config(config)
+   , _tracer(tracer)
+   , _random(seed) {
+
+}
+
+HubInteraction::ConnectionFactory SimulatedHub::connectionFactory() {
+   return [this](const HubEndpoints::Endpoint &endpoint,
+                 ConnectionHandleListener &listener) -> ConnectionHandle * {
+      const std::string address = endpoint.address;
+
+      trace(address, "connecting");
+
+      return new ConnectionHandle(_runLoop,
+                                  _logger,
+                                  listener,
+                                  [this, address](const ConnectionState::Context &context) -> ConnectionState * {
+                                     return new Link(context, *this, address);
+                                  } );
+   };
+}
+
+void SimulatedHub::trace(const std::string &address, const std::string &event) {
+   std::ostringstream line;
+   line << _runLoop.currentTime() << " " << address << ": " << event;
+
+   _tracer(line.str());
+}
+
+bool SimulatedHub::isDown(const std::string &address) {
+   if (_endpoints.find(address) == _endpoints.end()) scheduleOutage(address);
+
+   return _endpoints[address].isDown;
+}
+
+void SimulatedHub::scheduleOutage(const std::string &address) {
+   EndpointState &state = _endpoints[address];
+
+   if (_config.meanUptime == 0) return;
+
+   const Platform::Milliseconds delay
+      = exponential(state.isDown ? _config.meanOutage : _config.meanUptime);
+
+   state.outageTask = _runLoop.postDelayed(delay,
+                                           [this, address]() -> void {
+                                              EndpointState &state = _endpoints[address];
+
+                                              state.isDown = !state.isDown;
+
+                                              if (state.isDown) ++_stats.outages;
+                                              trace(address, state.isDown ? "outage" : "back up");
+
+                                              scheduleOutage(address);
+                                           } );
+}
+
+Platform::Milliseconds SimulatedHub::uniform(Platform::Milliseconds from, Platform::Milliseconds to) {
+   return from + _random() % (to - from + 1);
+}
+
+Platform::Milliseconds SimulatedHub::exponential(Platform::Milliseconds mean) {
+   // inverse transform, stays within what minstd_rand can give
+   const double uniform = (_random() + 1.0) / (std::minstd_rand::max() + 2.0);
+
+   return 1 + (Platform::Milliseconds)(-log(uniform) * mean);
+}
+
+bool SimulatedHub::chance(double probability) {
+   return _random() < probability * std::minstd_rand::max();
+}
+
+SimulatedHub::~SimulatedHub() {
+   for (auto &endpoint : _endpoints) {
+      if (endpoint.second.outageTask) _runLoop.cancel(endpoint.second.outageTask);
+   }
+}
@@ -0,0 +1,109 @@
+#ifndef __0B7D1C5E2A8F4E61B3C94D27E6A5F813_SIMULATEDHUB_H_INCLUDED__
+#define __0B7D1C5E2A8F4E61B3C94D27E6A5F813_SIMULATEDHUB_H_INCLUDED__
+
+#include <string>
+#include <map>
+#include <random>
+#include <functional>
+#include "RunLoop.h"
+#include "HubInteraction.h"
+
+/**
+ * Hubs and network simulated on the run loop, to run HubInteraction and
+ * Pinger in virtual time (see VirtualClock) instead of against sockets.
+ *
+ * Connections made by connectionFactory() connect or get refused after a
+ * while, then live for random time with the hub pinging them and echoing
+ * probes after random rtt. In the end connection is either closed by the
+ * hub or goes silent, which Pinger has to notice. Every endpoint has
+ * outages, when all its connections are refused.
+ *
+ * Randomness comes only from the seed, so with virtual clock every run
+ * with the same seed gives the same trace.
+ *
+ * Everything should be called on the run loop's thread.
+ */
+class SimulatedHub {
+   SimulatedHub(const SimulatedHub &referenceToCopyFrom);
+   void operator=(const SimulatedHub &referenceToCopyFrom);
+
+public:
+
+   struct Config {
+      Config();
+
+      // share of attempts refused by healthy endpoint
+      double refusals;
+      Platform::Milliseconds maxConnectTime;
+
+      Platform::Milliseconds meanLifetime;
+      // share of connections ending without close, detected by pings only
+      double silentDeaths;
+
+      Platform::Milliseconds minRtt;
+      Platform::Milliseconds maxRtt;
+
+      Platform::Milliseconds meanUptime;
+      Platform::Milliseconds meanOutage;
+   };
+
+   struct Stats {
+      Stats();
+
+      int attempts;
+      int refused;
+      int connected;
+      int closedByHub;
+      int wentSilent;
+      int pingTimeouts;
+      int outages;
+   };
+
+   typedef std::function<void(const std::string &)> Tracer;
+
+   SimulatedHub(RunLoop &runLoop,
+                Logger &logger,
+                uint32 seed,
+                const Config &config,
+                const Tracer &tracer);
+
+   HubInteraction::ConnectionFactory connectionFactory();
+
+   const Stats &stats() const { return _stats; }
+
+   ~SimulatedHub();
+
+private:
+
+   class Link;
+
+   struct EndpointState {
+      EndpointState() : isDown(false), outageTask(nullptr) {}
+
+      bool isDown;
+      RunLoop::Task *outageTask;
+   };
+
+   void trace(const std::string &address, const std::string &event);
+
+   bool isDown(const std::string &address);
+   void scheduleOutage(const std::string &address);
+
+   Platform::Milliseconds uniform(Platform::Milliseconds from, Platform::Milliseconds to);
+   Platform::Milliseconds exponential(Platform::Milliseconds mean);
+   bool chance(double probability);
+
+private:
+   RunLoop &_runLoop;
+   Logger &_logger;
+   const Config _config;
+   const Tracer _tracer;
+
+   std::minstd_rand _random;
+
+   std::map<std::string, EndpointState> _endpoints;
+
+   Stats _stats;
+};
+
+#endif 	// __0B7D1C5E2A8F4E61B3C94D27E6A5F813_SIMULATEDHUB_H_INCLUDED__
@@ -20,14 +20,8 @@ std::string InputDataBuffer::nextString() {
    return output;
 } 
 
-double InputDataBuffer::nextDouble() {
-   std::string nextDoubleAsString = nextString();
-
-   double output;
-
-   sscanf(nextDoubleAsString.c_str(), "%lf", &output);
-
-   return output;
+Price InputDataBuffer::nextPrice() {
+   return Price::fromUnits((int64)nextLong());
 }
 
 int InputDataBuffer::nextInt() {
@@ -2,6 +2,7 @@
 #define __2B5A6FE3DD5B95658C72A83EC7713EEE_INPUTDATABUFFER_H_INCLUDED__
 
 #include "common.h"
+#include "types.h"
 #include <string>
 
 class InputDataBuffer {
@@ -10,7 +11,8 @@ public:
 
    std::string nextString();
 
-   double nextDouble();
+   // 8 bytes of Fraction
+   Price nextPrice();
 
    int nextInt();
 
@@ -10,14 +10,8 @@ OutputDataBuffer &OutputDataBuffer::putString(const std::string& string) {
    return *this;
 } 
 
-OutputDataBuffer &OutputDataBuffer::putDouble(double value) {
-   char buffer[1024];
-
-   sprintf(buffer, "%lf", value);
-
-   return putString(buffer);
-   
-   return *this;
+OutputDataBuffer &OutputDataBuffer::putPrice(const Price &value) {
+   return putLong(value.units());
 } 
 
 OutputDataBuffer &OutputDataBuffer::putInt(int value) {
@@ -38,3 +32,9 @@ OutputDataBuffer &OutputDataBuffer::putLong(uint64 value) {
    return *this;
 }
 
+OutputDataBuffer &OutputDataBuffer::putBool(bool value) {
+
+   _data.push_back(value ? 1 : 0);
+
+   return *this;
+}
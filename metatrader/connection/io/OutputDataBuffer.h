@@ -2,6 +2,7 @@
 #define __2B5A6FE3DD5B95658C72A83EC7713EEE_OUTPUTDATABUFFER_H_INCLUDED__
 
 #include "common.h"
+#include "types.h"
 #include <string>
 
 class OutputDataBuffer {
@@ -10,12 +11,15 @@ public:
 
    OutputDataBuffer &putString(const std::string& string);
 
-   OutputDataBuffer &putDouble(double value);
+   // as 8 bytes of Fraction
+   OutputDataBuffer &putPrice(const Price &value);
 
    OutputDataBuffer &putInt(int value);
 
    OutputDataBuffer &putLong(uint64 value);
 
+   OutputDataBuffer &putBool(bool value);
+
    std::string buffer() { return _data; }
    
    ~OutputDataBuffer() {}
@@ -0,0 +1,254 @@
+#include "TrafficJournal.h"
+#include <chrono>
+
+enum {
+   FLUSH_INTERVAL_MS = 100,
+   // writer is woken before interval when this much is pending
+   WAKE_SIZE = 256 * 1024,
+
+   RECORD_HEADER_SIZE = 1 + 4 + 8
+};
+
+const std::string TrafficJournal::MAGIC = "fxjournal";
+
+std::shared_ptr<TrafficJournal> TrafficJournal::_current;
+std::atomic<bool> TrafficJournal::_capturing(false);
+
+bool TrafficJournal::start(const std::string &path) {
+   FILE *file = fopen(path.c_str(), "wb");
+
+   if (file == NULL) return false;
+
+   std::shared_ptr<TrafficJournal> journal(new TrafficJournal(file));
+
+   // previous journal is flushed and closed by the last thread using it
+   std::atomic_store(&_current, journal);
+   _capturing = true;
+
+   return true;
+}
+
+void TrafficJournal::stop() {
+   _capturing = false;
+   std::atomic_store(&_current, std::shared_ptr<TrafficJournal>());
+}
+
+void TrafficJournal::abandon() {
+   _capturing = false;
+
+   const std::shared_ptr<TrafficJournal> journal = std::atomic_exchange(&_current,
+                                                                        std::shared_ptr<TrafficJournal>());
+
+   if (!journal) return;
+
+   journal->_synchronization->lock();
+
+   journal->_stopped = true;
+
+   // threads are gone already when process exits, the object is left
+   journal->_writeThread = nullptr;
+
+   fwrite(journal->_pending.data(), 1, journal->_pending.size(), journal->_file);
+   fflush(journal->_file);
+   journal->_pending.clear();
+
+   journal->_synchronization->unlock();
+}
+
+void TrafficJournal::record(Kind kind,
+                            const std::string &connection,
+                            const std::string &frame) {
+   if (!isCapturing()) return;
+
+   const std::shared_ptr<TrafficJournal> journal = std::atomic_load(&_current);
+
+   if (journal) journal->append(kind, connection, frame);
+}
+
+uint64 TrafficJournal::monotonicMicroseconds() {
+   return std::chrono::duration_cast<std::chrono::microseconds>(std::chrono::steady_clock::now()
+                                                                .time_since_epoch()).count();
+}
+
+TrafficJournal::TrafficJournal(FILE *file)
+   : _file(file)
+   , _synchronization(Platform::instance().createMonitor())
+   , _writeThread(nullptr)
+   , _stopped(false)
+   , _dropped(0) {
+
+   const int version = Platform::instance().htonl(VERSION);
+
+   _pending.append(MAGIC);
+   _pending.append((const char *)&version, 4);
+
+   _writeThread = Platform::instance().createThread(std::bind(&TrafficJournal::wtWriteThreadMethod,
+                                                              this));
+}
+
+void TrafficJournal::appendHeader(Kind kind, int connection, uint64 time) {
+   const int convertedConnection = Platform::instance().htonl(connection);
+   const uint64 convertedTime = Platform::instance().htonll(time);
+
+   _pending.push_back((char)kind);
+   _pending.append((const char *)&convertedConnection, 4);
+   _pending.append((const char *)&convertedTime, 8);
+}
+
+void TrafficJournal::append(Kind kind,
+                            const std::string &connection,
+                            const std::string &frame) {
+   const uint64 time = monotonicMicroseconds();
+
+   _synchronization->lock();
+
+   const size_t sizeBefore = _pending.size();
+
+   if (sizeBefore + frame.size() + 2 * RECORD_HEADER_SIZE + connection.size() > MAX_PENDING) {
+      ++_dropped;
+      _synchronization->unlock();
+      return;
+   }
+
+   std::map<std::string, int>::const_iterator found = _connections.find(connection);
+
+   int id;
+
+   if (found == _connections.end()) {
+      id = _connections.size();
+      _connections[connection] = id;
+
+      const int size = Platform::instance().htonl(connection.size());
+
+      appendHeader(KEY, id, time);
+      _pending.append((const char *)&size, 4);
+      _pending.append(connection);
+   } else {
+      id = found->second;
+   }
+
+   appendHeader(kind, id, time);
+
+   if (kind == RECEIVED || kind == SENT) {
+      const int size = Platform::instance().htonl(frame.size());
+
+      _pending.append((const char *)&size, 4);
+      _pending.append(frame.data(), frame.size());
+   }
+
+   if (sizeBefore < WAKE_SIZE && _pending.size() >= WAKE_SIZE) _synchronization->notify();
+
+   _synchronization->unlock();
+}
+
+void TrafficJournal::wtWriteThreadMethod() {
+   std::string chunk;
+
+   _synchronization->lock();
+
+   while (true) {
+      if (_pending.empty()) {
+         if (_stopped) break;
+
+         _synchronization->wait(FLUSH_INTERVAL_MS);
+         continue;
+      }
+
+      chunk.swap(_pending);
+      _pending.clear();
+
+      _synchronization->unlock();
+
+      fwrite(chunk.data(), 1, chunk.size(), _file);
+      fflush(_file);
+      chunk.clear();
+
+      _synchronization->lock();
+   }
+
+   _synchronization->unlock();
+}
+
+TrafficJournal::~TrafficJournal() {
+   _synchronization->lock();
+   _stopped = true;
+   _synchronization->notify();
+   _synchronization->unlock();
+
+   Thread::joinAndDelete(_writeThread);
+
+   if (_dropped > 0) printf("traffic journal: %llu records dropped\n", _dropped);
+
+   fclose(_file);
+
+   delete _synchronization;
+}
+
+TrafficJournal::Reader::Reader(const std::string &path)
+   : _file(path.c_str(), std::ios::in | std::ios::binary)
+   , _valid(false) {
+
+   std::string magic(MAGIC.size(), '\0');
+   int version;
+
+   _valid = read(&magic[0], magic.size())
+      && magic == MAGIC
+      && readInt(version)
+      && version == VERSION;
+}
+
+bool TrafficJournal::Reader::read(void *data, size_t size) {
+   return (bool)_file.read((char *)data, size);
+}
+
+bool TrafficJournal::Reader::readInt(int &value) {
+   if (!read(&value, 4)) return false;
+
+   value = Platform::instance().ntohl(value);
+   return true;
+}
+
+bool TrafficJournal::Reader::readLong(uint64 &value) {
+   if (!read(&value, 8)) return false;
+
+   value = Platform::instance().ntohll(value);
+   return true;
+}
+
+bool TrafficJournal::Reader::next(Record &record) {
+   if (!_valid) return false;
+
+   while (true) {
+      char kind;
+      int connection;
+      int size;
+
+      if (!read(&kind, 1) || !readInt(connection) || !readLong(record.time)) return false;
+
+      record.kind = (Kind)kind;
+
+      if (kind == KEY) {
+         std::string name;
+
+         if (!readInt(size) || size < 0) return false;
+
+         name.resize(size);
+         if (!read(&name[0], size)) return false;
+
+         _connections[connection] = name;
+         continue;
+      }
+
+      record.connection = _connections[connection];
+      record.frame.clear();
+
+      if (kind == RECEIVED || kind == SENT) {
+         if (!readInt(size) || size < 0) return false;
+
+         record.frame.resize(size);
+         if (size > 0 && !read(&record.frame[0], size)) return false;
+      }
+
+      return true;
+   }
+}
@@ -0,0 +1,144 @@
+#ifndef __7C2E9A41D5B84F0E9A6B13C8F2D47E65_TRAFFICJOURNAL_H_INCLUDED__
+#define __7C2E9A41D5B84F0E9A6B13C8F2D47E65_TRAFFICJOURNAL_H_INCLUDED__
+
+#include <string>
+#include <map>
+#include <memory>
+#include <atomic>
+#include <fstream>
+#include <stdio.h>
+#include "platform.h"
+
+/**
+ * Capture of frames going between connections and hubs, to reproduce
+ * exactly what a terminal has seen.
+ *
+ * Capture is process wide and off by default, start() makes every
+ * connected connection append its frames, stop() flushes and closes the
+ * journal. Frames are appended to memory under short lock and written to
+ * file by background thread, so reading and writing threads never wait
+ * for the disk. If the disk can't keep up, frames over MAX_PENDING are
+ * dropped and counted.
+ *
+ * Journal is a header followed by records, numbers are big endian:
+ *
+ *   "fxjournal" version:int32
+ *   kind:int8 connection:int32 time:int64 [payload]
+ *
+ * Time is in microseconds of monotonic clock. Connections are named by
+ * their logger prefix (like "trade-host:port-key"), KEY record with name
+ * as payload comes before the first record of a connection. RECEIVED and
+ * SENT records have the frame as payload (int32 size and bytes, frame
+ * without its size prefix), CONNECTED and DISCONNECTED have none.
+ */
+class TrafficJournal {
+   TrafficJournal(const TrafficJournal &referenceToCopyFrom);
+   void operator=(const TrafficJournal &referenceToCopyFrom);
+
+public:
+
+   enum Kind {
+      KEY = 'K',
+      CONNECTED = 'C',
+      RECEIVED = 'R',
+      SENT = 'S',
+      DISCONNECTED = 'D'
+   };
+
+   enum {
+      VERSION = 1,
+      MAX_PENDING = 64 * 1024 * 1024
+   };
+
+   static const std::string MAGIC;
+
+   /**
+    * Starts capture to file at path, replaces running one. Returns false
+    * if file can't be created.
+    */
+   static bool start(const std::string &path);
+   static void stop();
+
+   /**
+    * For unloading of the dll, where threads can't be joined: writes what
+    * is pending and closes the journal, its writer isn't joined.
+    */
+   static void abandon();
+
+   static bool isCapturing() { return _capturing.load(std::memory_order_relaxed); }
+
+   /**
+    * Called by connections from any thread, does nothing if capture is
+    * not running.
+    */
+   static void record(Kind kind,
+                      const std::string &connection,
+                      const std::string &frame = std::string());
+
+   static uint64 monotonicMicroseconds();
+
+   struct Record {
+      Kind kind;
+      std::string connection;
+      uint64 time;
+      std::string frame;
+   };
+
+   /**
+    * Reads journal written by capture, record by record.
+    */
+   class Reader {
+      Reader(const Reader &referenceToCopyFrom);
+      void operator=(const Reader &referenceToCopyFrom);
+
+   public:
+      Reader(const std::string &path);
+
+      // false if file can't be opened or isn't a journal
+      bool isValid() const { return _valid; }
+
+      // false at the end of journal, or at truncated record
+      bool next(Record &record);
+
+   private:
+      bool read(void *data, size_t size);
+      bool readInt(int &value);
+      bool readLong(uint64 &value);
+
+   private:
+      std::ifstream _file;
+      bool _valid;
+
+      std::map<int, std::string> _connections;
+   };
+
+   ~TrafficJournal();
+
+private:
+
+   TrafficJournal(FILE *file);
+
+   void append(Kind kind, const std::string &connection, const std::string &frame);
+
+   void appendHeader(Kind kind, int connection, uint64 time);
+
+   void wtWriteThreadMethod();
+
+private:
+
+   static std::shared_ptr<TrafficJournal> _current;
+   static std::atomic<bool> _capturing;
+
+   FILE *_file;
+
+   Monitor *_synchronization;
+   Thread *_writeThread;
+   bool _stopped;
+
+   std::string _pending;
+   uint64 _dropped;
+
+   std::map<std::string, int> _connections;
+};
+
+#endif 	// __7C2E9A41D5B84F0E9A6B13C8F2D47E65_TRAFFICJOURNAL_H_INCLUDED__
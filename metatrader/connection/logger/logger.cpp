@@ -3,7 +3,10 @@
 #include "platform.h"
 #include <iostream>
 
+// benchmarks build with DISABLE_LOGGER to measure connector, not console
+#ifndef DISABLE_LOGGER
 #define ENABLE_LOGGER
+#endif
 
 Logger::Logger(const std::string &type, const std::string &address, int port, const std::string &key)
    : _monitor(Platform::instance().createMonitor()) {
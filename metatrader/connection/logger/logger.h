@@ -15,6 +15,9 @@ public:
    void log(const std::string& line);
    void log(const std::function<void(std::ostream &)> logFunction);
 
+   // type, address and key, names connection in logs and captures
+   const std::string &prefix() const { return _prefix; }
+
    ~Logger();
 private:
    std::string _prefix;
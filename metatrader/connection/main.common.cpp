@@ -142,9 +142,9 @@ void testTicksSender() {
 
    int id = connector->createTicksSink("127.0.0.1", 9101, "mt-test");
 
-   connector->sendTick(id, 1.2);
-   connector->sendTick(id, 1.2334);
-   connector->sendTick(id, -1.2334);
+   connector->sendTick(id, 1.2, 1.2);
+   connector->sendTick(id, 1.2334, 1.2334);
+   connector->sendTick(id, -1.2334, -1.2334);
 
    std::string buffer;
    
@@ -157,7 +157,7 @@ void testTicksSender() {
 
       std::cout << "got: " << buffer << std::endl;
 
-      connector->sendTick(id, tick);
+      connector->sendTick(id, tick, tick);
    } 
 
    delete connector;
@@ -175,6 +175,8 @@ void sleepTest() {
    std::cout << platform.currentTime() << ", done" << std::endl;
 } 
 
+// measures nothing and needs real hub, see main.hub-bench.cpp for load test
+// against built-in hub emulator
 void hardTestMTConnector() {
    // ctRunLoop = new RunLoop();
 
@@ -243,7 +245,7 @@ void hardTestMTConnector() {
                monitor->unlock();
 
                
-               connector->sendTick(sinkId, priceToSend);
+               connector->sendTick(sinkId, priceToSend, priceToSend);
 
                // monitor->lock();
                // ++count;
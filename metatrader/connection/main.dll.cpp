@@ -2,21 +2,65 @@
 
 #include "MTConnector.h"
 #include "WinPlatform.h"
+#include "TrafficJournal.h"
+#include "TickRecorder.h"
 #include <stdio.h>
+#include <stdlib.h>
+#include <atomic>
 
 bool isUnicode;
 MTConnector *mtConnector;
+TickRecorder *tickRecorder;
+// charts recording ticks, the last one stops recorder
+std::atomic<int> tickRecorderUsers(0);
+
+// empty if terminal's environment has no such variable
+static std::string environmentVariable(const char *name) {
+   char value[1024];
+   const DWORD length = GetEnvironmentVariableA(name, value, sizeof(value));
+
+   return length > 0 && length < sizeof(value) ? std::string(value, length) : std::string();
+}
+
+/**
+ * Count of ct shards, MT_CONNECTOR_SHARDS of terminal's environment or count
+ * of processors, charts are spread over them.
+ */
+static int connectorShards() {
+   const int shards = atoi(environmentVariable("MT_CONNECTOR_SHARDS").c_str());
+
+   return shards > 0 ? shards : Platform::instance().processorsCount();
+}
+
+/**
+ * Threads of connector by MT_CONNECTOR_THREADS, see
+ * Platform::configureThreads(), for example "ct:affinity=0x4,priority=high".
+ */
+static void configureThreads() {
+   const std::string configuration = environmentVariable("MT_CONNECTOR_THREADS");
+
+   if (!configuration.empty() && !Platform::instance().configureThreads(configuration)) {
+      printf("MT_CONNECTOR_THREADS ignored: %s\n", configuration.c_str());
+   }
+}
 
 extern "C" BOOL WINAPI DllMain(HINSTANCE hinstDLL, DWORD fdwReason, LPVOID lpvReserved) {
 
    switch (fdwReason) {
       case DLL_PROCESS_ATTACH:
          Platform::init(new WinPlatform());
-         mtConnector = new MTConnector();
+         configureThreads();
+         mtConnector = new MTConnector(connectorShards());
+         tickRecorder = new TickRecorder();
          break;
 
       case DLL_PROCESS_DETACH:
+         // joining threads under loader lock can deadlock: recorder and
+         // capture are stopped by deinit() of EAs, what's left is released
+         tickRecorder->abandon();
+         delete tickRecorder;
          delete mtConnector;
+         TrafficJournal::abandon();
          Platform::cleanup();
          break;
    } 
@@ -96,6 +140,74 @@ extern "C" void FreeTradeConnector(int id) {
    mtConnector->freeTradeConnector(id);
 }
 
+// mql has 32 bit ints, it's compared for change only
+extern "C" int PendingTradeChangesSeq(int id) {
+   return (int)mtConnector->PendingTradeChangesSeq(id);
+}
+
+extern "C" bool WaitForTradeChanges(int id, int timeoutMs) {
+   return mtConnector->WaitForTradeChanges(id, timeoutMs > 0 ? timeoutMs : 0);
+}
+
+// arrays of doubles, fields are listed at MTTradeConnector::ReconcileTrades()
+extern "C" int ReconcileTrades(int id,
+                               const double *market,
+                               const double *orders,
+                               int ordersCount,
+                               bool retryOpenings,
+                               double *actions,
+                               int maxActions) {
+   if (market == NULL || actions == NULL || (orders == NULL && ordersCount > 0)) return 0;
+
+   return mtConnector->ReconcileTrades(id, market, orders, ordersCount, retryOpenings, actions, maxActions);
+}
+
+extern "C" bool ReportTradeActions(int id, const double *results, int count) {
+   if (results == NULL) return false;
+
+   return mtConnector->ReportTradeActions(id, results, count);
+}
+
+// recording of ticks of all charts, see TickRecorder; every chart which
+// started it calls StopTickRecorder() from deinit(), as threads can't be
+// stopped when dll is unloaded
+extern "C" bool StartTickRecorder(const char *directory) {
+   if (directory == NULL) return false;
+
+   ++tickRecorderUsers;
+
+   if (tickRecorder->start(ensureUtf8(directory))) return true;
+
+   --tickRecorderUsers;
+
+   return false;
+}
+
+extern "C" void RecordTick(const char *symbol, int time, double bid, double ask) {
+   if (symbol == NULL) return;
+
+   tickRecorder->recordTick(ensureUtf8(symbol), (unsigned int)time, bid, ask);
+}
+
+extern "C" void StopTickRecorder() {
+   if (--tickRecorderUsers <= 0) {
+      tickRecorderUsers = 0;
+      tickRecorder->stop();
+   }
+}
+
+// capture of hub traffic of all connections, see TrafficJournal; stopped
+// by deinit() of EA which started it, as StopTickRecorder()
+extern "C" bool StartTrafficCapture(const char *path) {
+   if (path == NULL) return false;
+
+   return TrafficJournal::start(ensureUtf8(path));
+}
+
+extern "C" void StopTrafficCapture() {
+   TrafficJournal::stop();
+}
+
  
 
 #define TRADE_FORWARD_CALL(name)                \
@@ -130,26 +242,26 @@ extern "C" void FreeTradeConnector(int id) {
 
 #define FORWARD_CURRENT_TRADE_GET_BOUNDARY(name)        \
    extern "C" double TradeGet##name(int id) {           \
-      return mtConnector->TradeGet##name(id).value();   \
+      return mtConnector->TradeGet##name(id).value().toDouble(); \
    }
 
 #define FORWARD_CURRENT_TRADE_SET_BOUNDARY(name)                \
    extern "C" void TradeSet##name(int id, double value) {       \
-      mtConnector->TradeSet##name(id, Boundary(value));         \
+      mtConnector->TradeSet##name(id, Boundary(Price::fromDouble(value))); \
    }
 
 
 #define FORWARD_CURRENT_TRADE_GET_OPT_BOUNDARY(name)            \
    extern "C" double TradeGet##name(int id) {                   \
       auto opt = mtConnector->TradeGet##name(id);               \
-         if (opt.isDefined()) return opt.get().value();         \
+         if (opt.isDefined()) return opt.get().value().toDouble(); \
          else return 0;                                         \
    }
 
 #define FORWARD_CURRENT_TRADE_SET_OPT_BOUNDARY(name)                    \
    extern "C" void TradeSet##name(int id, double value) {               \
       if (value == 0) mtConnector->TradeSet##name(id, Option<Boundary>()); \
-         else            mtConnector->TradeSet##name(id, Option<Boundary>(value)); \
+         else            mtConnector->TradeSet##name(id, Option<Boundary>(Boundary(Price::fromDouble(value)))); \
    }
 
 #include "trade.forwards.inc"
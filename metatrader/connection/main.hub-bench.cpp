@@ -0,0 +1,496 @@
+// Load test of the connector against HubEmulator.
+//
+// Emulator runs in forked process, so cpu time of this process is the cost
+// of the connector (and of calling it). Ticks carry their sequence number
+// as bid, send times are put to memory shared with the emulator, which
+// measures latency from sendTick() to arrival of the tick at the hub.
+//
+// Trade connectors are polled by "mt" threads which confirm opening and
+// closing of every trade the emulator requests, trade latency is from
+// OpenTrade (CloseRequest) sent by hub to OpenedResponse (ExternallyClosed)
+// received back, so it includes the poll interval. With --wait-changes 1
+// they wait for changes of trades instead, by WaitForTradeChanges(). With
+// --id-ranges N the emulator opens trades with ids granted in ranges of N,
+// without RequestNewId round trip before every trade.
+//
+//   ./hub-bench --sinks 10 --traders 2 --rate 1000 --duration 10
+//   ./hub-bench --sinks 40 --rate 0 --shards 4
+//   ./hub-bench --threads "ct:affinity=0x2,priority=high;write:affinity=0x4"
+//   ./hub-bench --threads "ct:spin=50;write:spin=20"
+//   ./hub-bench --serve 9101
+//
+// With --capture traffic of all connections is written to TrafficJournal,
+// to measure the cost of capture and to get journals for replay.
+
+#include <iostream>
+#include <iomanip>
+#include <sstream>
+#include <vector>
+#include <atomic>
+#include <new>
+#include <stdlib.h>
+#include <string.h>
+#include <signal.h>
+#include <time.h>
+#include <unistd.h>
+#include <sys/mman.h>
+#include <sys/prctl.h>
+#include <sys/resource.h>
+#include <sys/wait.h>
+
+#include "NixPlatform.h"
+#include "MTConnector.h"
+#include "HubEmulator.h"
+#include "LatencyHistogram.h"
+#include "TrafficJournal.h"
+
+static const std::string SINK_PREFIX = "bench-sink-";
+static const std::string TRADER_PREFIX = "bench-trader-";
+
+struct Options {
+   Options()
+      : sinks(10)
+      , traders(1)
+      , rate(1000)
+      , duration(10)
+      , warmup(1)
+      , pollMs(1)
+      , waitChanges(0)
+      , idRanges(0)
+      , shards(1)
+      , servePort(-1) {}
+
+   std::string capturePath;
+   // see Platform::configureThreads()
+   std::string threads;
+
+   int sinks;
+   int traders;
+   // ticks per second per sink, zero sends as fast as possible
+   int rate;
+   int duration;
+   int warmup;
+   int pollMs;
+   // traders wait for changes of trades instead of sleeping poll interval
+   int waitChanges;
+   // size of ranges of trade ids, zero requests every id
+   int idRanges;
+   // ct shards of the connector
+   int shards;
+   int servePort;
+};
+
+/**
+ * Lives in anonymous shared mapping, followed by ring of send times for
+ * every sink.
+ */
+struct Shared {
+   enum {
+      SLOTS = 1 << 16,
+      SLOTS_MASK = SLOTS - 1
+   };
+
+   struct Slot {
+      std::atomic<int64_t> sequence;
+      std::atomic<int64_t> sentAt;
+   };
+
+   static size_t sizeFor(int sinks) {
+      return sizeof(Shared) + (size_t)sinks * SLOTS * sizeof(Slot);
+   }
+
+   Slot &slot(int sink, int64_t sequence) {
+      return ((Slot *)(this + 1))[(size_t)sink * SLOTS + (sequence & SLOTS_MASK)];
+   }
+
+   bool isInWindow(int64_t time) const {
+      const int64_t start = windowStart.load();
+      return start != 0 && time >= start && time <= windowEnd.load();
+   }
+
+   std::atomic<int> port;
+   std::atomic<int> registered;
+
+   std::atomic<int64_t> windowStart;
+   std::atomic<int64_t> windowEnd;
+
+   std::atomic<uint64_t> ticksReceived;
+   std::atomic<uint64_t> ticksUnmatched;
+
+   LatencyHistogram tickLatency;
+   LatencyHistogram openLatency;
+   LatencyHistogram closeLatency;
+};
+
+class BenchListener : public HubEmulator::Listener {
+public:
+   BenchListener(Shared &shared) : _shared(shared) {}
+
+   void onRegistered(const std::string &key, bool isTradeConnector) {
+      ++_shared.registered;
+   }
+
+   void onTick(const std::string &key, uint64 tickSequence, uint64 tickTime, double bid, double ask) {
+      const int64_t time = HubEmulator::now();
+
+      const int sink = atoi(key.c_str() + SINK_PREFIX.size());
+      const int64_t sequence = (int64_t)bid;
+
+      Shared::Slot &slot = _shared.slot(sink, sequence);
+
+      // sender lapped the ring, send time is lost
+      if (slot.sequence.load(std::memory_order_acquire) != sequence) {
+         ++_shared.ticksUnmatched;
+         return;
+      }
+
+      const int64_t sentAt = slot.sentAt.load(std::memory_order_relaxed);
+
+      if (_shared.isInWindow(sentAt)) {
+         _shared.tickLatency.record(time - sentAt);
+         ++_shared.ticksReceived;
+      }
+   }
+
+   void onTradeOpened(const std::string &key, int64_t nanoseconds) {
+      if (_shared.isInWindow(HubEmulator::now())) _shared.openLatency.record(nanoseconds);
+   }
+
+   void onTradeClosed(const std::string &key, int64_t nanoseconds) {
+      if (_shared.isInWindow(HubEmulator::now())) _shared.closeLatency.record(nanoseconds);
+   }
+
+private:
+   Shared &_shared;
+};
+
+class PrintingListener : public HubEmulator::Listener {
+public:
+   void onRegistered(const std::string &key, bool isTradeConnector) {
+      std::cout << (isTradeConnector ? "trade connector" : "ticks provider")
+                << " registered: " << key << std::endl;
+   }
+
+   void onTick(const std::string &key, uint64 sequence, uint64 time, double bid, double ask) {
+      std::cout << key << " " << sequence << ": " << bid << "|" << ask << std::endl;
+   }
+
+   void onTicksLost(const std::string &key, uint64 count) {
+      std::cout << key << ": " << count << " ticks lost" << std::endl;
+   }
+
+   void onTradeOpened(const std::string &key, int64_t nanoseconds) {
+      std::cout << key << ": trade opened in " << nanoseconds / 1000 << " us" << std::endl;
+   }
+
+   void onTradeClosed(const std::string &key, int64_t nanoseconds) {
+      std::cout << key << ": trade closed in " << nanoseconds / 1000 << " us" << std::endl;
+   }
+};
+
+static void sleepUntil(int64_t time) {
+   timespec target;
+   target.tv_sec = time / 1000000000;
+   target.tv_nsec = time % 1000000000;
+
+   while (clock_nanosleep(CLOCK_MONOTONIC, TIMER_ABSTIME, &target, NULL) != 0) {}
+}
+
+static int64_t cpuTime() {
+   rusage usage;
+   getrusage(RUSAGE_SELF, &usage);
+
+   return ((int64_t)usage.ru_utime.tv_sec + usage.ru_stime.tv_sec) * 1000000000
+      + ((int64_t)usage.ru_utime.tv_usec + usage.ru_stime.tv_usec) * 1000;
+}
+
+static std::string microseconds(int64_t nanoseconds) {
+   std::ostringstream result;
+   result << std::fixed << std::setprecision(1) << nanoseconds / 1000.0;
+   return result.str();
+}
+
+static void printLatency(const char *name, const LatencyHistogram &histogram) {
+   std::cout << name << " latency us (" << histogram.count() << " samples): "
+             << "p50 " << microseconds(histogram.percentile(0.5))
+             << ", p99 " << microseconds(histogram.percentile(0.99))
+             << ", p999 " << microseconds(histogram.percentile(0.999))
+             << ", max " << microseconds(histogram.max()) << std::endl;
+}
+
+static void runEmulator(Shared *shared, bool driveTrades, int idRanges) {
+   prctl(PR_SET_PDEATHSIG, SIGKILL);
+
+   Platform::init(new NixPlatform());
+
+   BenchListener listener(*shared);
+   HubEmulator emulator(listener, driveTrades);
+   emulator.setIdRanges(idRanges);
+
+   if (!emulator.listen(0)) {
+      shared->port = -1;
+      _exit(1);
+   }
+
+   shared->port = emulator.port();
+
+   emulator.run();
+
+   _exit(0);
+}
+
+static void pollTrades(MTConnector &connector, int id) {
+   connector.StartNextTradesIteration(id);
+
+   while (connector.ShiftToNextTrade(id)) {
+      if (connector.TradeGetIsWantsClose(id)) {
+         connector.TradeNotifyClosed(id);
+         connector.FreeTrade(id);
+      } else if (!connector.TradeGetIsOpened(id)) {
+         connector.TradeSetIsOpened(id, true);
+         connector.TradeNotifyOpened(id);
+      }
+   }
+}
+
+static int bench(const Options &options) {
+   const size_t sharedSize = Shared::sizeFor(options.sinks);
+
+   void *mapping = mmap(NULL, sharedSize, PROT_READ | PROT_WRITE, MAP_SHARED | MAP_ANONYMOUS, -1, 0);
+
+   if (mapping == MAP_FAILED) {
+      std::cerr << "can't map shared memory" << std::endl;
+      return 1;
+   }
+
+   // anonymous mapping is zeroed, which is valid initial state for slots
+   Shared *shared = new (mapping) Shared();
+
+   // forked before any thread is started
+   const pid_t emulator = fork();
+
+   if (emulator == 0) runEmulator(shared, options.traders > 0, options.idRanges);
+
+   Platform::init(new NixPlatform());
+
+   if (!Platform::instance().configureThreads(options.threads)) {
+      std::cerr << "can't parse threads: " << options.threads << std::endl;
+      kill(emulator, SIGKILL);
+      return 1;
+   }
+
+   while (shared->port == 0) Platform::instance().sleep(1);
+
+   if (shared->port < 0) {
+      std::cerr << "emulator can't listen" << std::endl;
+      return 1;
+   }
+
+   if (!options.capturePath.empty() && !TrafficJournal::start(options.capturePath)) {
+      std::cerr << "can't create " << options.capturePath << std::endl;
+      kill(emulator, SIGKILL);
+      return 1;
+   }
+
+   MTConnector *connector = new MTConnector(options.shards);
+
+   std::vector<int> sinks;
+   std::vector<int> traders;
+
+   for (int i = 0; i < options.sinks; ++i) {
+      std::ostringstream key;
+      key << SINK_PREFIX << i;
+      sinks.push_back(connector->createTicksSink("127.0.0.1", shared->port, key.str()));
+   }
+
+   for (int i = 0; i < options.traders; ++i) {
+      std::ostringstream key;
+      key << TRADER_PREFIX << i;
+      traders.push_back(connector->createTradeConnector("127.0.0.1", shared->port, key.str(), 1000, 1000));
+   }
+
+   const int expected = options.sinks + options.traders;
+
+   for (int i = 0; i < 10000 && shared->registered < expected; ++i) Platform::instance().sleep(1);
+
+   if (shared->registered < expected) {
+      std::cerr << "only " << shared->registered << " of " << expected << " connections registered" << std::endl;
+      kill(emulator, SIGKILL);
+      return 1;
+   }
+
+   std::atomic<bool> stopped(false);
+   std::atomic<bool> measuring(false);
+   std::atomic<uint64_t> ticksSent(0);
+
+   std::vector<Thread *> threads;
+
+   for (int i = 0; i < options.sinks; ++i) {
+      threads.push_back(Platform::instance().createThread([&, i]() -> void {
+               const int64_t interval = options.rate > 0 ? 1000000000 / options.rate : 0;
+
+               int64_t next = HubEmulator::now();
+
+               for (int64_t sequence = 0; !stopped; ++sequence) {
+                  if (interval != 0) {
+                     next += interval;
+                     sleepUntil(next);
+                  }
+
+                  Shared::Slot &slot = shared->slot(i, sequence);
+
+                  slot.sentAt.store(HubEmulator::now(), std::memory_order_relaxed);
+                  slot.sequence.store(sequence, std::memory_order_release);
+
+                  connector->sendTick(sinks[i], sequence, sequence + 0.5);
+
+                  if (measuring) ++ticksSent;
+               }
+            } ));
+   }
+
+   for (int i = 0; i < options.traders; ++i) {
+      threads.push_back(Platform::instance().createThread([&, i]() -> void {
+               while (!stopped) {
+                  pollTrades(*connector, traders[i]);
+
+                  if (options.waitChanges) connector->WaitForTradeChanges(traders[i], 100);
+                  else                     Platform::instance().sleep(options.pollMs);
+               }
+            } ));
+   }
+
+   Platform::instance().sleep(options.warmup * 1000);
+
+   const int64_t cpuStart = cpuTime();
+   const int64_t start = HubEmulator::now();
+
+   shared->windowEnd = INT64_MAX;
+   shared->windowStart = start;
+   measuring = true;
+
+   Platform::instance().sleep(options.duration * 1000);
+
+   measuring = false;
+
+   const int64_t end = HubEmulator::now();
+   const int64_t cpuEnd = cpuTime();
+
+   shared->windowEnd = end;
+
+   stopped = true;
+
+   for (Thread *thread : threads) Thread::joinAndDelete(thread);
+
+   // lets ticks sent at the end of window to arrive
+   Platform::instance().sleep(500);
+
+   const double seconds = (end - start) / 1e9;
+   const uint64_t sent = ticksSent;
+   const uint64_t received = shared->ticksReceived;
+
+   std::cout << "sinks: " << options.sinks
+             << ", trade connectors: " << options.traders
+             << ", rate per sink: " << (options.rate > 0 ? std::to_string(options.rate) : "unlimited")
+             << ", duration: " << seconds << " s" << std::endl;
+
+   std::cout << "ticks sent: " << sent << " (" << (uint64_t)(sent / seconds) << "/s)"
+             << ", received: " << received << " (" << (uint64_t)(received / seconds) << "/s)"
+             << ", unmatched: " << shared->ticksUnmatched << std::endl;
+
+   printLatency("tick", shared->tickLatency);
+
+   std::cout << "cpu: " << std::fixed << std::setprecision(1)
+             << 100.0 * (cpuEnd - cpuStart) / (end - start) << "% of one core, "
+             << (sent > 0 ? (cpuEnd - cpuStart) / (int64_t)sent : 0) << " ns per tick" << std::endl;
+
+   // busy poll of run loops, by spin= of --threads
+   const RunLoop::PollStats polls = RunLoop::pollStats();
+
+   std::cout << "run loops: " << polls.caught << " posts caught spinning, " << polls.parked << " parks ("
+             << (polls.caught + polls.parked > 0 ? 100.0 * polls.caught / (polls.caught + polls.parked) : 0.0)
+             << "% spin)" << std::endl;
+
+   if (options.traders > 0) {
+      std::cout << "trade cycles: " << shared->closeLatency.count()
+                << " (" << (uint64_t)(shared->closeLatency.count() / seconds) << "/s)" << std::endl;
+
+      printLatency("trade open", shared->openLatency);
+      printLatency("trade close", shared->closeLatency);
+   }
+
+   delete connector;
+
+   TrafficJournal::stop();
+
+   kill(emulator, SIGKILL);
+   waitpid(emulator, NULL, 0);
+
+   Platform::cleanup();
+
+   munmap(mapping, sharedSize);
+
+   return 0;
+}
+
+static int serve(int port) {
+   Platform::init(new NixPlatform());
+
+   PrintingListener listener;
+   HubEmulator emulator(listener, true);
+
+   if (!emulator.listen(port)) {
+      std::cerr << "can't listen on " << port << std::endl;
+      return 1;
+   }
+
+   std::cout << "listening on " << emulator.port() << std::endl;
+
+   emulator.run();
+
+   Platform::cleanup();
+
+   return 0;
+}
+
+static bool parse(int argc, char **argv, Options &options) {
+   for (int i = 1; i < argc; i += 2) {
+      if (i + 1 >= argc) return false;
+
+      const std::string name = argv[i];
+      const int value = atoi(argv[i + 1]);
+
+      if (name == "--sinks") options.sinks = value;
+      else if (name == "--traders") options.traders = value;
+      else if (name == "--rate") options.rate = value;
+      else if (name == "--duration") options.duration = value;
+      else if (name == "--warmup") options.warmup = value;
+      else if (name == "--poll-ms") options.pollMs = value;
+      else if (name == "--wait-changes") options.waitChanges = value;
+      else if (name == "--id-ranges") options.idRanges = value;
+      else if (name == "--shards") options.shards = value;
+      else if (name == "--serve") options.servePort = value;
+      else if (name == "--capture") options.capturePath = argv[i + 1];
+      else if (name == "--threads") options.threads = argv[i + 1];
+      else return false;
+   }
+
+   return options.sinks >= 0 && options.traders >= 0 && options.duration > 0 && options.shards > 0;
+}
+
+int main(int argc, char **argv) {
+   Options options;
+
+   if (!parse(argc, argv, options)) {
+      std::cerr << "usage: " << argv[0]
+                << " [--sinks N] [--traders M] [--rate ticks-per-sink-per-second, 0 unlimited]"
+                << " [--duration s] [--warmup s] [--poll-ms ms] [--wait-changes 0|1] [--id-ranges N] [--shards N] [--capture journal]"
+                << " [--threads \"role:name=n,affinity=mask,priority=p,stack=bytes;...\"]" << std::endl
+                << "       " << argv[0] << " --serve port" << std::endl;
+      return 1;
+   }
+
+   if (options.servePort >= 0) return serve(options.servePort);
+
+   return bench(options);
+}
@@ -0,0 +1,628 @@
+// Microbenchmarks of the connector's hot paths and of monitors under
+// contention, results are JSON to compare builds:
+//
+//   ./micro-bench > before.json
+//   ./micro-bench --filter run_loop --min-ms 500 --output after.json
+//
+// Every benchmark repeats its body until it takes at least --min-ms and
+// reports nanoseconds and operations per second, with parameters of the
+// case (producers, queue depth, trades). Progress goes to stderr. Logger
+// and the connector print to stdout, which is sent to /dev/null while
+// benchmarks run, so JSON stays valid without --output.
+
+#include <iostream>
+#include <sstream>
+#include <vector>
+#include <atomic>
+#include <chrono>
+#include <random>
+#include <algorithm>
+#include <stdio.h>
+#include <stdlib.h>
+#include <fcntl.h>
+#include <time.h>
+#include <unistd.h>
+
+#include "NixPlatform.h"
+#include "NixMonitor.h"
+#include "NixFutexMonitor.h"
+#include "RunLoop.h"
+#include "OutputDataBuffer.h"
+#include "InputDataBuffer.h"
+#include "protocol.h"
+#include "TradesSet.h"
+#include "TradeReconciler.h"
+#include "MTConnector.h"
+#include "HubEmulator.h"
+#include "logger.h"
+
+struct Options {
+   Options()
+      : minMs(200)
+      , maxProducers(8)
+      , ticks(20000) {}
+
+   std::string filter;
+   std::string output;
+
+   int minMs;
+   int maxProducers;
+   int ticks;
+};
+
+struct Result {
+   std::string name;
+   std::vector<std::pair<std::string, int64> > params;
+
+   uint64 operations;
+   double nanoseconds;
+};
+
+// results of benchmarked code go here, so it's not optimized away
+static std::atomic<uint64> sink(0);
+
+static int64 now() {
+   return std::chrono::duration_cast<std::chrono::nanoseconds>(
+      std::chrono::steady_clock::now().time_since_epoch()).count();
+}
+
+class Suite {
+public:
+   Suite(const Options &options) : _options(options) {}
+
+   bool isSelected(const std::string &name) const {
+      return _options.filter.empty() || name.find(_options.filter) != std::string::npos;
+   }
+
+   void measure(const std::string &name,
+                const std::vector<std::pair<std::string, int64> > &params,
+                const std::function<void(uint64 operations)> &body) {
+      measureExcluding(name, params, [&body](uint64 operations) -> int64 {
+            body(operations);
+            return 0;
+         } );
+   }
+
+   /**
+    * Runs body with growing count of operations until it takes at least
+    * the minimum time. Body returns nanoseconds of its preparations, which
+    * aren't counted.
+    */
+   void measureExcluding(const std::string &name,
+                         const std::vector<std::pair<std::string, int64> > &params,
+                         const std::function<int64(uint64 operations)> &body) {
+      if (!isSelected(name)) return;
+
+      const int64 minimum = (int64)_options.minMs * 1000000;
+
+      uint64 operations = 1;
+
+      while (true) {
+         const int64 start = now();
+         const int64 excluded = body(operations);
+         const int64 elapsed = now() - start - excluded;
+
+         if (elapsed >= minimum) {
+            add(name, params, operations, elapsed);
+            return;
+         }
+
+         // aims at 1.2 of minimum, but grows at most 100 times at once
+         const double scale = elapsed > 0 ? 1.2 * minimum / elapsed : 100;
+         operations = (uint64)(operations * (scale < 100 ? (scale > 2 ? scale : 2) : 100));
+      }
+   }
+
+   // for benchmarks which count and time themselves
+   void add(const std::string &name,
+            const std::vector<std::pair<std::string, int64> > &params,
+            uint64 operations,
+            int64 nanoseconds) {
+      Result result;
+      result.name = name;
+      result.params = params;
+      result.operations = operations;
+      result.nanoseconds = nanoseconds;
+
+      _results.push_back(result);
+
+      std::cerr << name;
+      for (const auto &param : params) std::cerr << " " << param.first << "=" << param.second;
+      std::cerr << ": " << nanoseconds / (double)operations << " ns/op" << std::endl;
+   }
+
+   void writeJson(FILE *file) const {
+      fprintf(file, "{\n");
+      fprintf(file, "  \"suite\": \"connector-micro\",\n");
+      fprintf(file, "  \"compiler\": \"%s\",\n", __VERSION__);
+#ifdef __OPTIMIZE__
+      fprintf(file, "  \"optimized\": true,\n");
+#else
+      fprintf(file, "  \"optimized\": false,\n");
+#endif
+      fprintf(file, "  \"timestamp\": %lld,\n", (long long)time(NULL));
+      fprintf(file, "  \"min_ms\": %d,\n", _options.minMs);
+      fprintf(file, "  \"results\": [");
+
+      for (size_t i = 0; i < _results.size(); ++i) {
+         const Result &result = _results[i];
+
+         fprintf(file, "%s\n    {\"name\": \"%s\", \"params\": {", i ? "," : "", result.name.c_str());
+
+         for (size_t j = 0; j < result.params.size(); ++j) {
+            fprintf(file, "%s\"%s\": %lld", j ? ", " : "",
+                    result.params[j].first.c_str(), (long long)result.params[j].second);
+         }
+
+         fprintf(file, "}, \"operations\": %llu, \"ns_per_op\": %.3f, \"ops_per_sec\": %.1f}",
+                 (unsigned long long)result.operations,
+                 result.nanoseconds / result.operations,
+                 result.operations * 1e9 / result.nanoseconds);
+      }
+
+      fprintf(file, "\n  ]\n}\n");
+   }
+
+private:
+   const Options &_options;
+   std::vector<Result> _results;
+};
+
+static std::string openTradePacket(uint64 id) {
+   // as hub sends it: request of value, type and no delay, stop, no take
+   // profit
+   return OutputDataBuffer()
+      .putString(Protocol::OpenTrade::NAME)
+      .putLong(id)
+      .putPrice(Price::fromDouble(0.01))
+      .putString("Buy")
+      .putBool(false)
+      .putBool(true)
+      .putBool(true)
+      .putPrice(Price::fromDouble(1.2345))
+      .putBool(false)
+      .buffer();
+}
+
+static void benchmarkBuffers(Suite &suite) {
+   suite.measure("output_buffer.on_tick", {}, [](uint64 operations) -> void {
+         for (uint64 i = 0; i < operations; ++i) {
+            sink += Protocol::OnTick(i + 1,
+                                     1400000000000ULL + i,
+                                     Price::fromDouble(1.23456 + i * 1e-5, 5),
+                                     Price::fromDouble(1.23466, 5)).buffer().size();
+         }
+      } );
+
+   suite.measure("output_buffer.open_trade", {}, [](uint64 operations) -> void {
+         for (uint64 i = 0; i < operations; ++i) sink += openTradePacket(i).size();
+      } );
+
+   const std::string tick = Protocol::OnTick(1,
+                                             1400000000000ULL,
+                                             Price::fromDouble(1.23456, 5),
+                                             Price::fromDouble(1.23466, 5)).buffer();
+
+   suite.measure("input_buffer.on_tick", {}, [&tick](uint64 operations) -> void {
+         for (uint64 i = 0; i < operations; ++i) {
+            InputDataBuffer input(tick);
+
+            sink += input.nextString().size();
+            sink += input.nextLong() + input.nextLong();
+            sink += (uint64)(input.nextPrice() + input.nextPrice()).units();
+         }
+      } );
+
+   const std::string openTrade = openTradePacket(42);
+
+   suite.measure("input_buffer.open_trade", {}, [&openTrade](uint64 operations) -> void {
+         for (uint64 i = 0; i < operations; ++i) {
+            InputDataBuffer input(openTrade);
+
+            sink += input.nextString().size();
+            sink += Protocol::OpenTrade(input).id();
+         }
+      } );
+}
+
+static void benchmarkRunLoopProducers(Suite &suite, const Options &options) {
+   for (int producers = 1; producers <= options.maxProducers; producers *= 2) {
+      suite.measure("run_loop.post_pop", { { "producers", producers } }, [producers](uint64 operations) -> void {
+            RunLoop runLoop;
+
+            const uint64 perProducer = (operations + producers - 1) / producers;
+            uint64 executed = 0;
+
+            std::vector<Thread *> threads;
+
+            for (int i = 0; i < producers; ++i) {
+               threads.push_back(Platform::instance().createThread([&runLoop, &executed, perProducer]() -> void {
+                        for (uint64 j = 0; j < perProducer; ++j) {
+                           runLoop.post([&executed]() -> void { ++executed; } );
+                        }
+                     } ));
+            }
+
+            // stops the loop after all posted tasks, posted when producers
+            // are done
+            Thread *finisher = Platform::instance().createThread([&]() -> void {
+                  for (Thread *thread : threads) Thread::joinAndDelete(thread);
+                  runLoop.post([&runLoop]() -> void { runLoop.terminate(); } );
+               } );
+
+            runLoop.run();
+
+            Thread::joinAndDelete(finisher);
+
+            sink += executed;
+         } );
+   }
+}
+
+/**
+ * Threads lock the monitor for a counter increment, the recursive pthread
+ * monitor and the futex one, which platform creates now.
+ */
+static void benchmarkMonitors(Suite &suite, const Options &options) {
+   const std::function<Monitor *()> monitors[] = {
+      []() -> Monitor * { return new NixMonitor(); },
+      []() -> Monitor * { return new NixFutexMonitor(); }
+   };
+
+   const char * const names[] = { "monitor.pthread_recursive", "monitor.futex" };
+
+   for (int kind = 0; kind < 2; ++kind) {
+      for (int threads = 1; threads <= options.maxProducers; threads *= 2) {
+         suite.measure(names[kind], { { "threads", threads } }, [&, kind, threads](uint64 operations) -> void {
+               Monitor *monitor = monitors[kind]();
+
+               const uint64 perThread = (operations + threads - 1) / threads;
+               uint64 counter = 0;
+
+               std::vector<Thread *> workers;
+
+               for (int i = 0; i < threads; ++i) {
+                  workers.push_back(Platform::instance().createThread([monitor, &counter, perThread]() -> void {
+                           for (uint64 j = 0; j < perThread; ++j) {
+                              monitor->lock();
+                              ++counter;
+                              monitor->unlock();
+                           }
+                        } ));
+               }
+
+               for (Thread *worker : workers) Thread::joinAndDelete(worker);
+
+               delete monitor;
+
+               sink += counter;
+            } );
+      }
+   }
+}
+
+/**
+ * Task bounced between loops of two threads, round trip is two handoffs,
+ * with sleeping loops and with busy polling ones.
+ */
+static void benchmarkRunLoopHandoff(Suite &suite) {
+   for (int busyPoll : { 0, 50 }) {
+      suite.measure("run_loop.round_trip", { { "busy_poll_us", busyPoll } }, [busyPoll](uint64 operations) -> void {
+            RunLoop ping;
+            RunLoop pong;
+
+            ping.setBusyPoll(busyPoll);
+            pong.setBusyPoll(busyPoll);
+
+            uint64 rounds = 0;
+            std::function<void()> bounce;
+
+            bounce = [&]() -> void {
+               if (rounds++ == operations) {
+                  pong.post([&pong]() -> void { pong.terminate(); } );
+                  ping.terminate();
+                  return;
+               }
+
+               pong.post([&]() -> void { ping.post(bounce); } );
+            };
+
+            Thread *thread = Platform::instance().createThread([&pong]() -> void { pong.run(); } );
+
+            ping.post(bounce);
+            ping.run();
+
+            Thread::joinAndDelete(thread);
+
+            sink += rounds;
+         } );
+   }
+}
+
+static void fillTimers(RunLoop &runLoop, int depth) {
+   // far in the future and in order, so filling is cheap
+   for (int i = 0; i < depth; ++i) runLoop.postDelayed(3600000 + i, []() -> void {} );
+}
+
+static void benchmarkRunLoopTimers(Suite &suite) {
+   for (int depth = 10; depth <= 100000; depth *= 10) {
+      RunLoop runLoop;
+      fillTimers(runLoop, depth);
+
+      std::minstd_rand random(depth);
+
+      // timer at random place of the queue, cancelled so depth stays
+      suite.measure("run_loop.timed_post_cancel", { { "depth", depth } }, [&](uint64 operations) -> void {
+            for (uint64 i = 0; i < operations; ++i) {
+               RunLoop::Task *task = runLoop.postDelayed(3600000 + random() % depth, []() -> void {} );
+               runLoop.cancel(task);
+            }
+         } );
+   }
+
+   for (int depth = 10; depth <= 100000; depth *= 10) {
+      enum { BATCH = 1000 };
+
+      // immediate tasks posted and run while timers wait, terminate
+      // deletes timers, so every batch has a loop of its own
+      suite.measureExcluding("run_loop.post_run_with_timers", { { "depth", depth } }, [depth](uint64 operations) -> int64 {
+            int64 excluded = 0;
+
+            for (uint64 done = 0; done < operations; ) {
+               const int64 fillStart = now();
+
+               RunLoop *runLoop = new RunLoop();
+               fillTimers(*runLoop, depth);
+
+               excluded += now() - fillStart;
+
+               uint64 executed = 0;
+               const uint64 batch = std::min<uint64>(BATCH, operations - done);
+
+               for (uint64 i = 0; i < batch; ++i) runLoop->post([&executed]() -> void { ++executed; } );
+
+               // deleting of timers isn't measured, as filling
+               runLoop->post([runLoop, &excluded]() -> void {
+                     const int64 terminateStart = now();
+                     runLoop->terminate();
+                     excluded += now() - terminateStart;
+                  } );
+
+               runLoop->run();
+
+               delete runLoop;
+
+               sink += executed;
+               done += batch;
+            }
+
+            return excluded;
+         } );
+   }
+}
+
+static Trade trade(uint64 id) {
+   return Trade(id, TradeBuy, 0.01, Option<Boundary>(), Boundary(Price::fromDouble(1.2345)), Option<Boundary>());
+}
+
+static void benchmarkTradesSet(Suite &suite) {
+   for (int count = 1; count <= 10000; count *= 10) {
+      TradesSet trades;
+
+      for (int i = 0; i < count; ++i) trades.postAdd(trade(i));
+      trades.applyModifications();
+
+      // every trade modified, as trade connector does on hub's requests
+      suite.measure("trades_set.apply", { { "trades", count } }, [&trades, count](uint64 operations) -> void {
+            for (uint64 done = 0; done < operations; ) {
+               for (int i = 0; i < count && done < operations; ++i, ++done) {
+                  trades.postModify(i, [](Trade &trade) -> void { trade.setIsOpened(true); } );
+               }
+
+               trades.applyModifications();
+            }
+         } );
+
+      // every trade visited, as mt does in iteration of trades
+      suite.measure("trades_set.iterate", { { "trades", count } }, [&trades](uint64 operations) -> void {
+            for (uint64 done = 0; done < operations; ) {
+               const std::list<uint64> ids = trades.idsOfActiveTrades();
+
+               for (uint64 id : ids) {
+                  if (done++ == operations) break;
+
+                  Trade *found = trades.tradeById(id);
+                  if (found) sink += found->getIsOpened();
+               }
+            }
+         } );
+
+      if (count > 1000) continue;
+
+      // steady state of trades cycle: all trades opened as requested, mt
+      // gets no actions
+      std::vector<TradeReconciler::Order> orders;
+
+      for (int i = 0; i < count; ++i) {
+         Trade *opened = trades.tradeById(i);
+
+         opened->setMtId(i + 1);
+         opened->setBestSetStop(opened->getRequestedStop());
+
+         orders.push_back({ i + 1, TradeReconciler::OP_BUY, 0.01, 1.3 });
+      }
+
+      TradeReconciler::Events events;
+      events.log = [](const std::string &) -> void {};
+      events.message = [](uint64, const std::string &) -> void {};
+      events.opened = events.closed = events.freed = [](uint64) -> void {};
+
+      TradeReconciler reconciler(events);
+
+      const TradeReconciler::Market market = { 1.3, 1.3002, 0.0001, 4, 10, 5, 0.01, 0.01, 100000 };
+
+      std::vector<TradeReconciler::Action> actions;
+
+      suite.measure("trade_reconciler.plan", { { "trades", count } }, [&](uint64 operations) -> void {
+            for (uint64 done = 0; done < operations; done += count) {
+               reconciler.plan(trades, market, orders, false, actions);
+               sink += actions.size();
+            }
+         } );
+   }
+}
+
+static void benchmarkLogger(Suite &suite) {
+   Logger logger("bench", "127.0.0.1", 9101, "micro");
+
+   suite.measure("logger.log", {}, [&logger](uint64 operations) -> void {
+         for (uint64 i = 0; i < operations; ++i) logger.log("sent tick 1.23456|1.23466");
+      } );
+
+   suite.measure("logger.log_function", {}, [&logger](uint64 operations) -> void {
+         for (uint64 i = 0; i < operations; ++i) {
+            logger.log([i](std::ostream &stream) -> void { stream << "sent tick " << i << "|" << 1.23466; } );
+         }
+      } );
+}
+
+// of time sent with ticks from the wall clock
+static const int64 MAX_TIME_SKEW_MS = 60000;
+
+class CountingListener : public HubEmulator::Listener {
+public:
+   CountingListener() : registered(0), ticks(0), timeSkewMs(0) {}
+
+   void onRegistered(const std::string &key, bool isTradeConnector) { ++registered; }
+
+   void onTick(const std::string &key, uint64 sequence, uint64 time, double bid, double ask) {
+      ++ticks;
+
+      // time of tick is of Platform, checked against the clock of std
+      const int64 wall = std::chrono::duration_cast<std::chrono::milliseconds>(
+         std::chrono::system_clock::now().time_since_epoch()).count();
+
+      const int64 skew = std::abs((int64)time - wall);
+
+      if (skew > timeSkewMs) timeSkewMs = skew;
+   }
+
+   std::atomic<int> registered;
+   std::atomic<uint64> ticks;
+   // largest, written by the emulator's connection thread only
+   std::atomic<int64> timeSkewMs;
+};
+
+static void benchmarkSendTick(Suite &suite, const Options &options) {
+   if (!suite.isSelected("mt_connector.send_tick")) return;
+
+   CountingListener listener;
+   HubEmulator emulator(listener, false);
+
+   if (!emulator.listen(0)) {
+      std::cerr << "emulator can't listen" << std::endl;
+      return;
+   }
+
+   Thread *hub = Platform::instance().createThread([&emulator]() -> void { emulator.run(); } );
+
+   MTConnector *connector = new MTConnector();
+   const int id = connector->createTicksSink("127.0.0.1", emulator.port(), "micro");
+
+   for (int i = 0; i < 10000 && listener.registered == 0; ++i) Platform::instance().sleep(1);
+
+   if (listener.registered != 0) {
+      const int64 start = now();
+
+      for (int i = 0; i < options.ticks; ++i) connector->sendTick(id, 1.23456, 1.23466);
+
+      const int64 posted = now();
+
+      // a minute at most
+      for (int i = 0; i < 60000 && listener.ticks < (uint64)options.ticks; ++i) Platform::instance().sleep(1);
+
+      const int64 received = now();
+
+      // sent time is since the epoch, late by the time in queues at most
+      if (listener.timeSkewMs > MAX_TIME_SKEW_MS) {
+         std::cerr << "time of ticks is " << listener.timeSkewMs << " ms off the wall clock" << std::endl;
+      }
+
+      suite.add("mt_connector.send_tick_call", {}, options.ticks, posted - start);
+      suite.add("mt_connector.send_tick_to_socket", { { "received", (int64)listener.ticks },
+                                                      { "time_skew_ms", (int64)listener.timeSkewMs } },
+                options.ticks, received - start);
+   } else {
+      std::cerr << "sink hasn't registered" << std::endl;
+   }
+
+   connector->freeTicksSink(id);
+   delete connector;
+
+   emulator.stop();
+   Thread::joinAndDelete(hub);
+}
+
+static bool parse(int argc, char **argv, Options &options) {
+   for (int i = 1; i < argc; i += 2) {
+      if (i + 1 >= argc) return false;
+
+      const std::string name = argv[i];
+      const std::string value = argv[i + 1];
+
+      if (name == "--filter") options.filter = value;
+      else if (name == "--output") options.output = value;
+      else if (name == "--min-ms") options.minMs = atoi(value.c_str());
+      else if (name == "--max-producers") options.maxProducers = atoi(value.c_str());
+      else if (name == "--ticks") options.ticks = atoi(value.c_str());
+      else return false;
+   }
+
+   return options.minMs > 0 && options.maxProducers > 0 && options.ticks > 0;
+}
+
+int main(int argc, char **argv) {
+   Options options;
+
+   if (!parse(argc, argv, options)) {
+      std::cerr << "usage: " << argv[0]
+                << " [--filter name-part] [--output file.json] [--min-ms ms]"
+                << " [--max-producers N] [--ticks N]" << std::endl;
+      return 1;
+   }
+
+   FILE *output = options.output.empty() ? fdopen(dup(STDOUT_FILENO), "w") : fopen(options.output.c_str(), "w");
+
+   if (output == NULL) {
+      std::cerr << "can't write " << options.output << std::endl;
+      return 1;
+   }
+
+   // logger and connector print to stdout
+   fflush(stdout);
+   const int null = open("/dev/null", O_WRONLY);
+   dup2(null, STDOUT_FILENO);
+   close(null);
+
+   Platform::init(new NixPlatform());
+
+   Suite suite(options);
+
+   benchmarkBuffers(suite);
+   benchmarkMonitors(suite, options);
+   benchmarkRunLoopProducers(suite, options);
+   benchmarkRunLoopHandoff(suite);
+   benchmarkRunLoopTimers(suite);
+   benchmarkTradesSet(suite);
+   benchmarkLogger(suite);
+   benchmarkSendTick(suite, options);
+
+   fflush(stdout);
+
+   suite.writeJson(output);
+   fclose(output);
+
+   Platform::cleanup();
+
+   return 0;
+}
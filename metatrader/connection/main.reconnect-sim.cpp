@@ -0,0 +1,134 @@
+// Runs HubInteraction against SimulatedHub in virtual time.
+//
+// Hours of reconnects, failovers, ping timeouts and backoff pass in
+// milliseconds, trace is the same for the same seed in every run, its
+// hash is printed to compare runs quickly:
+//
+//   ./reconnect-sim --hours 24 --seed 7
+//   ./reconnect-sim --hours 1 --seed 7 --endpoints primary,backup --trace
+
+#include <iostream>
+#include <stdlib.h>
+#include <time.h>
+
+#include "NixPlatform.h"
+#include "Clock.h"
+#include "RunLoop.h"
+#include "HubInteraction.h"
+#include "SimulatedHub.h"
+#include "protocol.h"
+
+struct Options {
+   Options()
+      : hours(24)
+      , seed(1)
+      , endpoints("primary,backup")
+      , trace(false) {}
+
+   int hours;
+   uint32 seed;
+   std::string endpoints;
+   bool trace;
+};
+
+static bool parse(int argc, char **argv, Options &options) {
+   for (int i = 1; i < argc; ++i) {
+      const std::string name = argv[i];
+
+      if (name == "--trace") {
+         options.trace = true;
+         continue;
+      }
+
+      if (i + 1 >= argc) return false;
+
+      const std::string value = argv[++i];
+
+      if (name == "--hours") options.hours = atoi(value.c_str());
+      else if (name == "--seed") options.seed = strtoul(value.c_str(), NULL, 10);
+      else if (name == "--endpoints") options.endpoints = value;
+      else return false;
+   }
+
+   return options.hours > 0;
+}
+
+int main(int argc, char **argv) {
+   Options options;
+
+   if (!parse(argc, argv, options)) {
+      std::cerr << "usage: " << argv[0]
+                << " [--hours H] [--seed S] [--endpoints a,b,...] [--trace]" << std::endl;
+      return 1;
+   }
+
+   Platform::init(new NixPlatform());
+
+   const clock_t cpuStart = clock();
+
+   VirtualClock virtualClock;
+   RunLoop runLoop(virtualClock);
+
+   Logger logger("sim", options.endpoints, 0, "sim");
+
+   // fnv-1a of all trace lines
+   uint64 hash = 14695981039346656037ULL;
+   int events = 0;
+
+   const SimulatedHub::Tracer tracer = [&](const std::string &line) -> void {
+      for (char c : line + "\n") {
+         hash ^= (unsigned char)c;
+         hash *= 1099511628211ULL;
+      }
+
+      ++events;
+
+      if (options.trace) std::cout << line << std::endl;
+   };
+
+   SimulatedHub hub(runLoop, logger, options.seed, SimulatedHub::Config(), tracer);
+
+   HubInteraction *interaction = nullptr;
+
+   runLoop.post([&]() -> void {
+         interaction = new HubInteraction(runLoop,
+                                          logger,
+                                          options.endpoints,
+                                          9101,
+                                          [&]() -> void {
+                                             // first connection starts inside of constructor
+                                             if (interaction) {
+                                                interaction->sendRawData(Protocol::RegisterTicksProvider("sim").buffer());
+                                             }
+                                          },
+                                          HubInteraction::PacketReceiver(),
+                                          HubInteraction::EventReceiver(),
+                                          hub.connectionFactory());
+      } );
+
+   runLoop.postDelayed((Platform::Milliseconds)options.hours * 60 * 60 * 1000,
+                       [&]() -> void {
+                          delete interaction;
+                          runLoop.terminate();
+                       } );
+
+   runLoop.run();
+
+   const double cpuMs = 1000.0 * (clock() - cpuStart) / CLOCKS_PER_SEC;
+
+   const SimulatedHub::Stats &stats = hub.stats();
+
+   std::cout << "virtual time: " << options.hours << " h, cpu: " << cpuMs << " ms" << std::endl
+             << "attempts: " << stats.attempts
+             << ", refused: " << stats.refused
+             << ", connected: " << stats.connected << std::endl
+             << "closed by hub: " << stats.closedByHub
+             << ", went silent: " << stats.wentSilent
+             << ", ping timeouts: " << stats.pingTimeouts
+             << ", endpoint outages: " << stats.outages << std::endl
+             << "trace: " << events << " events, hash " << std::hex << hash << std::dec << std::endl;
+
+   Platform::cleanup();
+
+   return 0;
+}
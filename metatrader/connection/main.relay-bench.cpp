@@ -0,0 +1,495 @@
+// Fan out benchmark of TicksRelay.
+//
+// Relay runs in this process on its own run loop, one ticks sink of the
+// connector is its provider and sends ticks carrying their sequence number
+// as bid. Subscribers are plain sockets served by a few epoll threads, they
+// answer probes and ping the relay as the connector would. Latency is from
+// sendTick() to arrival of the tick at a subscriber, every subscriber's
+// copy is a sample:
+//
+//   ./relay-bench --subscribers 2000 --rate 1000 --duration 10
+
+#include <iostream>
+#include <iomanip>
+#include <sstream>
+#include <vector>
+#include <atomic>
+#include <stdlib.h>
+#include <string.h>
+#include <errno.h>
+#include <signal.h>
+#include <time.h>
+#include <unistd.h>
+#include <fcntl.h>
+#include <sys/epoll.h>
+#include <sys/resource.h>
+
+#include "NixPlatform.h"
+#include "RunLoop.h"
+#include "MTConnector.h"
+#include "OutputDataBuffer.h"
+#include "protocol.h"
+#include "TicksRelay.h"
+#include "LatencyHistogram.h"
+#include "HubEmulator.h"
+
+// after platform, which has methods named as socket macros
+#include <sys/socket.h>
+#include <netinet/in.h>
+#include <netinet/tcp.h>
+#include <arpa/inet.h>
+
+static const std::string KEY = "relay-bench";
+
+enum {
+   SLOTS = 1 << 16,
+   SLOTS_MASK = SLOTS - 1,
+
+   PING_INTERVAL_NS = 1000000000,
+   EPOLL_TIMEOUT_MS = 100,
+   EVENTS = 256,
+   READ_SIZE = 64 * 1024,
+
+   PROBE_MARKER = -1,
+   PROBE_REPLY_MARKER = -2,
+   PROBE_SIZE = 12
+};
+
+struct Options {
+   Options()
+      : subscribers(1000)
+      , rate(1000)
+      , duration(10)
+      , warmup(1)
+      , readers(2) {}
+
+   int subscribers;
+   // ticks per second, zero sends as fast as possible
+   int rate;
+   int duration;
+   int warmup;
+   int readers;
+};
+
+struct Slot {
+   std::atomic<int64_t> sequence;
+   std::atomic<int64_t> sentAt;
+};
+
+struct Shared {
+   Shared()
+      : windowStart(0)
+      , windowEnd(0)
+      , connected(0)
+      , received(0)
+      , unmatched(0)
+      , stopped(false) {
+      for (Slot &slot : slots) {
+         slot.sequence = -1;
+         slot.sentAt = 0;
+      }
+   }
+
+   bool isInWindow(int64_t time) const {
+      const int64_t start = windowStart.load();
+      return start != 0 && time >= start && time <= windowEnd.load();
+   }
+
+   Slot slots[SLOTS];
+
+   std::atomic<int64_t> windowStart;
+   std::atomic<int64_t> windowEnd;
+
+   std::atomic<int> connected;
+   std::atomic<uint64_t> received;
+   std::atomic<uint64_t> unmatched;
+
+   std::atomic<bool> stopped;
+
+   LatencyHistogram latency;
+};
+
+struct Subscriber {
+   Subscriber() : socket(-1) {}
+
+   int socket;
+   std::string input;
+};
+
+static std::string framed(const std::string &packet) {
+   return OutputDataBuffer().putInt(packet.size()).buffer() + packet;
+}
+
+static uint32_t readInt(const char *data) {
+   const unsigned char *bytes = (const unsigned char *)data;
+   return (uint32_t)bytes[0] << 24 | bytes[1] << 16 | bytes[2] << 8 | bytes[3];
+}
+
+// writes whole of small packet, socket is non blocking
+static void writeAll(int socket, const std::string &data) {
+   size_t written = 0;
+
+   while (written < data.size()) {
+      const ssize_t result = send(socket, data.data() + written, data.size() - written, MSG_NOSIGNAL);
+
+      if (result > 0) {
+         written += result;
+      } else if (result < 0 && errno != EAGAIN && errno != EINTR) {
+         return;
+      }
+   }
+}
+
+static void onPacket(Shared &shared, Subscriber &subscriber, const char *packet, size_t size, int64_t time) {
+   // buffers need the platform, so these are built on first use
+   static const std::string ON_TICK = OutputDataBuffer().putString("OnTick").buffer();
+   static const std::string CONNECTED = OutputDataBuffer().putString("TickProviderConnected").buffer();
+
+   if (size >= ON_TICK.size() && memcmp(packet, ON_TICK.data(), ON_TICK.size()) == 0) {
+      // bid is Fraction's 8 bytes after the name, sequence and time
+      const char *bid = packet + ON_TICK.size() + 16;
+
+      if (size < ON_TICK.size() + 24) return;
+
+      const int64_t units = (int64_t)((uint64_t)readInt(bid) << 32 | readInt(bid + 4));
+      const int64_t sequence = units / Price::SCALE;
+
+      const Slot &slot = shared.slots[sequence & SLOTS_MASK];
+
+      if (slot.sequence.load(std::memory_order_acquire) != sequence) {
+         ++shared.unmatched;
+         return;
+      }
+
+      const int64_t sentAt = slot.sentAt.load(std::memory_order_relaxed);
+
+      if (shared.isInWindow(sentAt)) {
+         shared.latency.record(time - sentAt);
+         ++shared.received;
+      }
+
+      return;
+   }
+
+   if (size == PROBE_SIZE && (int32_t)readInt(packet) == PROBE_MARKER) {
+      writeAll(subscriber.socket,
+               framed(OutputDataBuffer()
+                      .putInt(PROBE_REPLY_MARKER)
+                      .buffer() + std::string(packet + 4, 8)));
+      return;
+   }
+
+   if (size == CONNECTED.size() && memcmp(packet, CONNECTED.data(), size) == 0) ++shared.connected;
+}
+
+static void onReadable(Shared &shared, Subscriber &subscriber) {
+   char buffer[READ_SIZE];
+
+   while (true) {
+      const ssize_t size = recv(subscriber.socket, buffer, sizeof(buffer), 0);
+
+      if (size <= 0) break;
+
+      const int64_t time = HubEmulator::now();
+
+      subscriber.input.append(buffer, size);
+
+      size_t offset = 0;
+
+      while (subscriber.input.size() - offset >= 4) {
+         const size_t length = readInt(subscriber.input.data() + offset);
+
+         if (subscriber.input.size() - offset - 4 < length) break;
+
+         onPacket(shared, subscriber, subscriber.input.data() + offset + 4, length, time);
+
+         offset += 4 + length;
+      }
+
+      subscriber.input.erase(0, offset);
+   }
+}
+
+static void serveSubscribers(Shared &shared, std::vector<Subscriber *> subscribers) {
+   const int poll = epoll_create1(EPOLL_CLOEXEC);
+
+   for (Subscriber *subscriber : subscribers) {
+      epoll_event event;
+      event.events = EPOLLIN;
+      event.data.ptr = subscriber;
+      epoll_ctl(poll, EPOLL_CTL_ADD, subscriber->socket, &event);
+   }
+
+   const std::string ping = framed("");
+
+   int64_t nextPing = HubEmulator::now() + PING_INTERVAL_NS;
+
+   epoll_event events[EVENTS];
+
+   while (!shared.stopped) {
+      const int count = epoll_wait(poll, events, EVENTS, EPOLL_TIMEOUT_MS);
+
+      for (int i = 0; i < count; ++i) onReadable(shared, *(Subscriber *)events[i].data.ptr);
+
+      if (HubEmulator::now() >= nextPing) {
+         for (Subscriber *subscriber : subscribers) writeAll(subscriber->socket, ping);
+         nextPing += PING_INTERVAL_NS;
+      }
+   }
+
+   close(poll);
+}
+
+static int connectTo(int port) {
+   const int result = socket(AF_INET, SOCK_STREAM | SOCK_CLOEXEC, 0);
+
+   sockaddr_in address;
+   memset(&address, 0, sizeof(address));
+   address.sin_family = AF_INET;
+   address.sin_port = htons(port);
+   address.sin_addr.s_addr = htonl(INADDR_LOOPBACK);
+
+   if (connect(result, (sockaddr *)&address, sizeof(address)) != 0) {
+      close(result);
+      return -1;
+   }
+
+   int noDelay = 1;
+   setsockopt(result, IPPROTO_TCP, TCP_NODELAY, &noDelay, sizeof(noDelay));
+
+   return result;
+}
+
+static void sleepUntil(int64_t time) {
+   timespec target;
+   target.tv_sec = time / 1000000000;
+   target.tv_nsec = time % 1000000000;
+
+   while (clock_nanosleep(CLOCK_MONOTONIC, TIMER_ABSTIME, &target, NULL) != 0) {}
+}
+
+static int64_t cpuTime() {
+   rusage usage;
+   getrusage(RUSAGE_SELF, &usage);
+
+   return ((int64_t)usage.ru_utime.tv_sec + usage.ru_stime.tv_sec) * 1000000000
+      + ((int64_t)usage.ru_utime.tv_usec + usage.ru_stime.tv_usec) * 1000;
+}
+
+static std::string microseconds(int64_t nanoseconds) {
+   std::ostringstream result;
+   result << std::fixed << std::setprecision(1) << nanoseconds / 1000.0;
+   return result.str();
+}
+
+static bool waitFor(const std::function<bool()> &condition) {
+   for (int i = 0; i < 30000; ++i) {
+      if (condition()) return true;
+      Platform::instance().sleep(1);
+   }
+
+   return condition();
+}
+
+static int bench(const Options &options) {
+   Shared *shared = new Shared();
+
+   RunLoop runLoop;
+   TicksRelay relay(runLoop);
+
+   if (!relay.listen("127.0.0.1", 0)) {
+      std::cerr << "relay can't listen" << std::endl;
+      return 1;
+   }
+
+   relay.start();
+
+   Thread *relayThread = Platform::instance().createThread([&runLoop]() -> void { runLoop.run(); } );
+
+   MTConnector *connector = new MTConnector();
+   const int sink = connector->createTicksSink("127.0.0.1", relay.port(), KEY);
+
+   if (!waitFor([&relay]() -> bool { return relay.stats().providers == 1; } )) {
+      std::cerr << "sink hasn't registered" << std::endl;
+      return 1;
+   }
+
+   const std::string ask = framed(Protocol::AskTicksProvider(KEY).buffer());
+
+   std::vector<Subscriber> subscribers(options.subscribers);
+   std::vector<std::vector<Subscriber *> > parts(options.readers);
+
+   for (int i = 0; i < options.subscribers; ++i) {
+      Subscriber &subscriber = subscribers[i];
+
+      subscriber.socket = connectTo(relay.port());
+
+      if (subscriber.socket < 0) {
+         std::cerr << "can't connect subscriber " << i << ": " << strerror(errno) << std::endl;
+         return 1;
+      }
+
+      writeAll(subscriber.socket, ask);
+      fcntl(subscriber.socket, F_SETFL, fcntl(subscriber.socket, F_GETFL) | O_NONBLOCK);
+
+      parts[i % options.readers].push_back(&subscriber);
+   }
+
+   std::vector<Thread *> readers;
+
+   for (const std::vector<Subscriber *> &part : parts) {
+      readers.push_back(Platform::instance().createThread([shared, part]() -> void {
+               serveSubscribers(*shared, part);
+            } ));
+   }
+
+   if (!waitFor([&]() -> bool { return shared->connected == options.subscribers; } )) {
+      std::cerr << "only " << shared->connected << " of " << options.subscribers
+                << " subscribers connected" << std::endl;
+      return 1;
+   }
+
+   std::atomic<bool> sending(true);
+   std::atomic<bool> measuring(false);
+   std::atomic<uint64_t> ticksSent(0);
+
+   Thread *sender = Platform::instance().createThread([&]() -> void {
+         const int64_t interval = options.rate > 0 ? 1000000000 / options.rate : 0;
+
+         int64_t next = HubEmulator::now();
+
+         for (int64_t sequence = 0; sending; ++sequence) {
+            if (interval != 0) {
+               next += interval;
+               sleepUntil(next);
+            }
+
+            Slot &slot = shared->slots[sequence & SLOTS_MASK];
+
+            slot.sentAt.store(HubEmulator::now(), std::memory_order_relaxed);
+            slot.sequence.store(sequence, std::memory_order_release);
+
+            connector->sendTick(sink, sequence, sequence + 0.5);
+
+            if (measuring) ++ticksSent;
+         }
+      } );
+
+   Platform::instance().sleep(options.warmup * 1000);
+
+   const TicksRelay::Stats before = relay.stats();
+   const int64_t cpuStart = cpuTime();
+   const int64_t start = HubEmulator::now();
+
+   shared->windowEnd = INT64_MAX;
+   shared->windowStart = start;
+   measuring = true;
+
+   Platform::instance().sleep(options.duration * 1000);
+
+   measuring = false;
+
+   const int64_t end = HubEmulator::now();
+   const int64_t cpuEnd = cpuTime();
+   const TicksRelay::Stats after = relay.stats();
+
+   shared->windowEnd = end;
+
+   sending = false;
+   Thread::joinAndDelete(sender);
+
+   // lets ticks sent at the end of window to arrive
+   Platform::instance().sleep(500);
+
+   shared->stopped = true;
+   for (Thread *reader : readers) Thread::joinAndDelete(reader);
+
+   const double seconds = (end - start) / 1e9;
+   const uint64_t sent = ticksSent;
+   const uint64_t expected = sent * options.subscribers;
+   const uint64_t received = shared->received;
+   const uint64_t frames = after.frames - before.frames;
+
+   std::cout << "subscribers: " << options.subscribers
+             << ", rate: " << (options.rate > 0 ? std::to_string(options.rate) : "unlimited")
+             << ", duration: " << seconds << " s" << std::endl;
+
+   std::cout << "ticks sent: " << sent << " (" << (uint64_t)(sent / seconds) << "/s)"
+             << ", relayed: " << after.ticks - before.ticks
+             << ", frames: " << frames << " (" << (uint64_t)(frames / seconds) << "/s)" << std::endl;
+
+   std::cout << "delivered: " << received << " of " << expected
+             << " (" << (uint64_t)(received / seconds) << "/s)"
+             << ", unmatched: " << shared->unmatched << std::endl;
+
+   std::cout << "fan out latency us (" << shared->latency.count() << " samples): "
+             << "p50 " << microseconds(shared->latency.percentile(0.5))
+             << ", p99 " << microseconds(shared->latency.percentile(0.99))
+             << ", p999 " << microseconds(shared->latency.percentile(0.999))
+             << ", max " << microseconds(shared->latency.max()) << std::endl;
+
+   std::cout << "cpu: " << std::fixed << std::setprecision(1)
+             << 100.0 * (cpuEnd - cpuStart) / (end - start) << "% of one core, "
+             << (frames > 0 ? (cpuEnd - cpuStart) / (int64_t)frames : 0) << " ns per frame" << std::endl;
+
+   connector->freeTicksSink(sink);
+   delete connector;
+
+   for (Subscriber &subscriber : subscribers) close(subscriber.socket);
+
+   runLoop.post([&]() -> void {
+         relay.stop();
+         runLoop.terminate();
+      } );
+
+   Thread::joinAndDelete(relayThread);
+
+   delete shared;
+
+   return 0;
+}
+
+static bool parse(int argc, char **argv, Options &options) {
+   for (int i = 1; i < argc; i += 2) {
+      if (i + 1 >= argc) return false;
+
+      const std::string name = argv[i];
+      const int value = atoi(argv[i + 1]);
+
+      if (name == "--subscribers") options.subscribers = value;
+      else if (name == "--rate") options.rate = value;
+      else if (name == "--duration") options.duration = value;
+      else if (name == "--warmup") options.warmup = value;
+      else if (name == "--readers") options.readers = value;
+      else return false;
+   }
+
+   return options.subscribers > 0 && options.rate >= 0 && options.duration > 0 && options.readers > 0;
+}
+
+int main(int argc, char **argv) {
+   Options options;
+
+   if (!parse(argc, argv, options)) {
+      std::cerr << "usage: " << argv[0]
+                << " [--subscribers N] [--rate ticks-per-second, 0 unlimited]"
+                << " [--duration s] [--warmup s] [--readers threads]" << std::endl;
+      return 1;
+   }
+
+   // every subscriber is a socket here and two in the relay
+   rlimit files;
+   getrlimit(RLIMIT_NOFILE, &files);
+   files.rlim_cur = files.rlim_max;
+   setrlimit(RLIMIT_NOFILE, &files);
+
+   signal(SIGPIPE, SIG_IGN);
+
+   Platform::init(new NixPlatform());
+
+   const int result = bench(options);
+
+   Platform::cleanup();
+
+   return result;
+}
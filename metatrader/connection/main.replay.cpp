@@ -0,0 +1,171 @@
+// Replays traffic captured by TrafficJournal into MTTradeConnector.
+//
+// Frames one trade connection has received are fed to the connector in
+// the order and, by default, with the pace they were captured, packets it
+// sends back are counted and dropped. With --max-speed it is a benchmark
+// of the trade command path, from hub packet to trade waiting for mt:
+//
+//   ./replay capture.fxj --list
+//   ./replay capture.fxj --connection trade-127.0.0.1:9101-key --max-speed
+
+#include <iostream>
+#include <iomanip>
+#include <vector>
+#include <stdlib.h>
+
+#include "NixPlatform.h"
+#include "RunLoop.h"
+#include "MTTradeConnector.h"
+#include "JournalReplay.h"
+#include "logger.h"
+
+static const std::string TRADE_PREFIX = "trade-";
+
+struct Options {
+   Options()
+      : list(false)
+      , maxSpeed(false) {}
+
+   std::string path;
+   std::string connection;
+   bool list;
+   bool maxSpeed;
+};
+
+static bool parse(int argc, char **argv, Options &options) {
+   for (int i = 1; i < argc; ++i) {
+      const std::string name = argv[i];
+
+      if (name == "--list") options.list = true;
+      else if (name == "--max-speed") options.maxSpeed = true;
+      else if (name == "--connection" && i + 1 < argc) options.connection = argv[++i];
+      else if (name[0] != '-' && options.path.empty()) options.path = name;
+      else return false;
+   }
+
+   return !options.path.empty();
+}
+
+static int list(const Options &options) {
+   std::vector<std::pair<std::string, uint64> > connections;
+
+   if (!JournalReplay::listConnections(options.path, connections)) {
+      std::cerr << "can't read journal " << options.path << std::endl;
+      return 1;
+   }
+
+   for (auto &connection : connections) {
+      std::cout << connection.first << ": " << connection.second << " packets received" << std::endl;
+   }
+
+   return 0;
+}
+
+static bool findTradeConnection(Options &options) {
+   std::vector<std::pair<std::string, uint64> > connections;
+
+   if (!JournalReplay::listConnections(options.path, connections)) return false;
+
+   for (auto &connection : connections) {
+      if (connection.first.compare(0, TRADE_PREFIX.size(), TRADE_PREFIX) == 0) {
+         options.connection = connection.first;
+         return true;
+      }
+   }
+
+   return false;
+}
+
+static int replay(const Options &options) {
+   RunLoop runLoop;
+   Logger logger("replay", options.path, 0, options.connection);
+
+   JournalReplay::Config config;
+   config.maxSpeed = options.maxSpeed;
+
+   MTTradeConnector *connector = nullptr;
+   int pendingTrades = 0;
+
+   JournalReplay replay(runLoop,
+                        logger,
+                        options.path,
+                        options.connection,
+                        config,
+                        [&]() -> void {
+                           // called by the connection, which connector owns
+                           runLoop.post([&]() -> void {
+                                 // playing mt here, to see trades have got through
+                                 connector->StartNextTradesIteration();
+                                 while (connector->ShiftToNextTrade()) ++pendingTrades;
+
+                                 delete connector;
+                                 connector = nullptr;
+
+                                 runLoop.terminate();
+                              } );
+                        } );
+
+   if (!replay.isLoaded()) {
+      std::cerr << "can't read journal " << options.path << std::endl;
+      return 1;
+   }
+
+   std::cout << "replaying " << replay.frames() << " packets of " << options.connection
+             << (options.maxSpeed ? " at max speed" : " at original pace") << std::endl;
+
+   runLoop.post([&]() -> void {
+         connector = new MTTradeConnector(runLoop,
+                                          "replay",
+                                          0,
+                                          "replay",
+                                          1000,
+                                          1000,
+                                          replay.connectionFactory());
+      } );
+
+   runLoop.run();
+
+   const JournalReplay::Stats &stats = replay.stats();
+   const double seconds = (stats.finishedAt - stats.startedAt) / 1e6;
+
+   std::cout << "delivered: " << stats.delivered << " packets, " << stats.deliveredBytes << " bytes"
+             << ", sent back: " << stats.sent << std::endl
+             << "trades waiting for mt: " << pendingTrades << std::endl
+             << "time: " << std::fixed << std::setprecision(3) << seconds << " s";
+
+   if (seconds > 0) {
+      std::cout << ", " << (uint64)(stats.delivered / seconds) << " packets/s"
+                << ", " << std::setprecision(0) << 1e9 * seconds / stats.delivered << " ns per packet";
+   }
+
+   std::cout << std::endl;
+
+   return 0;
+}
+
+int main(int argc, char **argv) {
+   Options options;
+
+   if (!parse(argc, argv, options)) {
+      std::cerr << "usage: " << argv[0] << " journal --list" << std::endl
+                << "       " << argv[0] << " journal [--connection name] [--max-speed]" << std::endl;
+      return 1;
+   }
+
+   Platform::init(new NixPlatform());
+
+   int result;
+
+   if (options.list) {
+      result = list(options);
+   } else if (options.connection.empty() && !findTradeConnection(options)) {
+      std::cerr << "no trade connection in " << options.path << std::endl;
+      result = 1;
+   } else {
+      result = replay(options);
+   }
+
+   Platform::cleanup();
+
+   return result;
+}
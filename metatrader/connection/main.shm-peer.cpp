@@ -0,0 +1,210 @@
+// Test peer for the shared memory transport.
+//
+// "serve" echoes every framed packet back, both on shm channel and on tcp
+// port, "bench" connects to either of them through the SocketConnector and
+// measures round trip latency and streaming throughput, so the two
+// transports can be compared on the same box:
+//
+//   ./shm-peer serve test 9199 &
+//   ./shm-peer bench shm://test 0
+//   ./shm-peer bench 127.0.0.1 9199
+
+// platform goes first, optimized netinet/in.h defines htonl as macro
+#include "NixPlatform.h"
+#include "NixSocket.h"
+#include "NixShmSocket.h"
+#include "InputDataBuffer.h"
+#include "OutputDataBuffer.h"
+
+#include <iostream>
+#include <vector>
+#include <algorithm>
+#include <chrono>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+#include <netinet/in.h>
+#include <sys/socket.h>
+
+typedef std::chrono::steady_clock Clock;
+
+bool readPacket(Socket *socket, std::string &packet) {
+   std::string size;
+
+   if (!socket->read(size, 4)) return false;
+
+   return socket->read(packet, InputDataBuffer(size).nextInt());
+}
+
+// single write per frame, so tcp numbers are not about nagle
+bool writePacket(Socket *socket, const std::string &packet) {
+   return socket->write(OutputDataBuffer().putInt(packet.size()).buffer() + packet);
+}
+
+void echo(Socket *socket) {
+   std::string packet;
+
+   while (readPacket(socket, packet) && writePacket(socket, packet)) {}
+
+   socket->close();
+   delete socket;
+}
+
+int listenTcp(int port) {
+   const int listener = socket(AF_INET, SOCK_STREAM, 0);
+
+   int reuse = 1;
+   setsockopt(listener, SOL_SOCKET, SO_REUSEADDR, &reuse, sizeof(reuse));
+
+   sockaddr_in address;
+   memset(&address, 0, sizeof(address));
+   address.sin_family = AF_INET;
+   address.sin_port = htons(port);
+   address.sin_addr.s_addr = htonl(INADDR_LOOPBACK);
+
+   if (bind(listener, (sockaddr *)&address, sizeof(address)) != 0
+       || listen(listener, 16) != 0) {
+      return -1;
+   }
+
+   return listener;
+}
+
+int serve(const std::string &name, int port) {
+   const int shmListener = NixShmSocket::listen(NixShmSocket::SCHEME + name);
+   const int tcpListener = listenTcp(port);
+
+   if (shmListener < 0 || tcpListener < 0) {
+      std::cerr << "can't listen" << std::endl;
+      return 1;
+   }
+
+   // threads are never joined, peer serves until killed
+   Platform::instance().createThread([tcpListener]() -> void {
+         while (true) {
+            const int connection = accept(tcpListener, NULL, NULL);
+            if (connection < 0) continue;
+
+            Socket *socket = new NixSocket(connection);
+            Platform::instance().createThread(std::bind(&echo, socket));
+         }
+      } );
+
+   while (true) {
+      Socket *socket = NixShmSocket::accept(shmListener);
+      if (socket == nullptr) continue;
+
+      Platform::instance().createThread(std::bind(&echo, socket));
+   }
+
+   return 0;
+}
+
+Socket *connect(const std::string &address, int port) {
+   Monitor *monitor = Platform::instance().createMonitor();
+
+   Socket *result = nullptr;
+   bool done = false;
+
+   monitor->lock();
+
+   Platform::instance().socketConnector().connect(address,
+                                                  port,
+                                                  5000,
+                                                  [&](Socket *socket) -> void {
+                                                     monitor->lock();
+                                                     result = socket;
+                                                     done = true;
+                                                     monitor->notify();
+                                                     monitor->unlock();
+                                                  } );
+
+   while (!done) monitor->wait();
+
+   monitor->unlock();
+
+   delete monitor;
+
+   return result;
+}
+
+double microseconds(Clock::duration duration) {
+   return std::chrono::duration_cast<std::chrono::nanoseconds>(duration).count() / 1000.0;
+}
+
+int bench(const std::string &address, int port, int packets, int size) {
+   Socket *socket = connect(address, port);
+
+   if (socket == nullptr) {
+      std::cerr << "can't connect to " << address << ":" << port << std::endl;
+      return 1;
+   }
+
+   const std::string packet(size, 'x');
+   std::string received;
+
+   std::vector<double> latencies;
+   latencies.reserve(packets);
+
+   for (int i = 0; i < packets; ++i) {
+      const Clock::time_point start = Clock::now();
+
+      if (!writePacket(socket, packet) || !readPacket(socket, received)) {
+         std::cerr << "connection lost" << std::endl;
+         return 1;
+      }
+
+      latencies.push_back(microseconds(Clock::now() - start));
+   }
+
+   std::sort(latencies.begin(), latencies.end());
+
+   const Clock::time_point start = Clock::now();
+
+   Thread *writer = Platform::instance().createThread([&]() -> void {
+         for (int i = 0; i < packets; ++i) writePacket(socket, packet);
+      } );
+
+   int echoed = 0;
+   while (echoed < packets && readPacket(socket, received)) ++echoed;
+
+   const double seconds = microseconds(Clock::now() - start) / 1000000;
+
+   Thread::joinAndDelete(writer);
+
+   socket->close();
+   delete socket;
+
+   std::cout << "transport: " << address << std::endl
+             << "packet size: " << size << std::endl
+             << "round trip us: p50 " << latencies[latencies.size() / 2]
+             << ", p99 " << latencies[latencies.size() * 99 / 100]
+             << ", max " << latencies.back() << std::endl
+             << "streaming: " << (echoed / seconds) << " packets/s, "
+             << (echoed * (size + 4.0) / seconds / 1024 / 1024) << " MiB/s each way" << std::endl;
+
+   return 0;
+}
+
+int main(int argc, char **argv) {
+   Platform::init(new NixPlatform());
+
+   int result = 1;
+
+   if (argc == 4 && std::string(argv[1]) == "serve") {
+      result = serve(argv[2], atoi(argv[3]));
+   } else if (argc >= 4 && std::string(argv[1]) == "bench") {
+      result = bench(argv[2],
+                     atoi(argv[3]),
+                     argc > 4 ? atoi(argv[4]) : 100000,
+                     argc > 5 ? atoi(argv[5]) : 64);
+   } else {
+      std::cerr << "usage: " << argv[0] << " serve <shm-name> <tcp-port>" << std::endl
+                << "       " << argv[0] << " bench <address> <port> [packets] [packet-size]" << std::endl;
+   }
+
+   Platform::cleanup();
+
+   return result;
+}
@@ -0,0 +1,374 @@
+// Terminal simulated without MetaTrader: plays TicksSink.mq4 and
+// TradeConnector.mq4 against the hub, to soak test strategies.
+//
+// Ticks recorded by TickRecorder (or generated) are sent to the hub as
+// ticks provider, trades the hub requests are executed by SimulatedBroker
+// through ReconcileTrades() and ReportTradeActions(), as the EA does.
+// After every tick it waits for the strategy: the next tick is sent when
+// no changes of trades came for --settle ms. With --speed N ticks keep
+// their recorded pace, N times faster, otherwise they go as fast as the
+// strategy takes them.
+//
+//   ./sim-terminal ticks-directory EURUSD --port 9101 --key sim-eurusd
+//   ./sim-terminal --generate 100000 --key sim --settle 2 --stop-level 20
+//   ./sim-terminal ticks-directory EURUSD --key sim --speed 600
+
+#include <iostream>
+#include <iomanip>
+#include <vector>
+#include <random>
+#include <stdlib.h>
+#include <math.h>
+#include <time.h>
+
+#include "NixPlatform.h"
+#include "MTConnector.h"
+#include "SimulatedBroker.h"
+#include "TickLog.h"
+
+// openings with invalid stops are retried this many times per cycle
+static const int MAX_RETRY_COUNT = 5;
+
+// layouts of arrays of ReconcileTrades() and ReportTradeActions()
+enum {
+   MARKET_FIELDS = 9,
+   ORDER_FIELDS = 4,
+   ACTION_FIELDS = 8,
+   RESULT_FIELDS = 6,
+
+   MAX_ORDERS = 256,
+   MAX_ACTIONS = 64
+};
+
+struct Options {
+   Options()
+      : address("127.0.0.1")
+      , port(9101)
+      , generate(0)
+      , speed(0)
+      , settle(5)
+      , warmup(1000) {}
+
+   std::string directory;
+   std::string symbol;
+
+   std::string address;
+   int port;
+   std::string key;
+   // of trade connector, key of ticks provider by default
+   std::string tradeKey;
+
+   // random walk ticks instead of recorded ones
+   long generate;
+   // of recorded pace, zero doesn't keep it
+   double speed;
+   int settle;
+   // for connections to register before the first tick
+   int warmup;
+
+   SimulatedBroker::Config broker;
+};
+
+/**
+ * Plays mt: ticks go to the broker and to the hub, then trades cycle of
+ * the EA runs.
+ */
+class Terminal {
+public:
+   Terminal(MTConnector &connector,
+            int ticksSink,
+            int tradeConnector,
+            SimulatedBroker &broker)
+      : _connector(connector)
+      , _ticksSink(ticksSink)
+      , _tradeConnector(tradeConnector)
+      , _broker(broker)
+      , _reportedBalance(broker.balance())
+      , _market(MARKET_FIELDS)
+      , _orders(MAX_ORDERS * ORDER_FIELDS)
+      , _actions(MAX_ACTIONS * ACTION_FIELDS)
+      , _results(MAX_ACTIONS * RESULT_FIELDS)
+      , _cycles(0)
+      , _actionsExecuted(0) {}
+
+   void onTick(double bid, double ask, int settle) {
+      _broker.onTick(bid, ask);
+
+      _connector.sendTick(_ticksSink, bid, ask);
+      _connector.UpdateEquity(_tradeConnector, _broker.equity());
+
+      runTradesCycle();
+
+      while (_connector.WaitForTradeChanges(_tradeConnector, settle)) runTradesCycle();
+   }
+
+   uint64 cycles() const { return _cycles; }
+   uint64 actionsExecuted() const { return _actionsExecuted; }
+
+private:
+
+   void runTradesCycle() {
+      ++_cycles;
+
+      for (int attempt = 0; attempt < MAX_RETRY_COUNT; ++attempt) {
+         fillMarket();
+         const int ordersCount = fillOrders();
+
+         const int count = _connector.ReconcileTrades(_tradeConnector,
+                                                      &_market[0],
+                                                      &_orders[0],
+                                                      ordersCount,
+                                                      attempt > 0,
+                                                      &_actions[0],
+                                                      MAX_ACTIONS);
+
+         for (int i = 0; i < count; ++i) executeAction(i);
+
+         _actionsExecuted += count;
+
+         // of closed orders and of stops and take profits hit by the tick
+         updateBalance();
+
+         if (count == 0 || !_connector.ReportTradeActions(_tradeConnector, &_results[0], count)) break;
+      }
+   }
+
+   void fillMarket() {
+      const TradeReconciler::Market &market = _broker.market();
+
+      _market[0] = market.bid;
+      _market[1] = market.ask;
+      _market[2] = market.point;
+      _market[3] = market.digits;
+      _market[4] = market.stopLevel;
+      _market[5] = market.freezeLevel;
+      _market[6] = market.minLot;
+      _market[7] = market.lotStep;
+      _market[8] = market.lotSize;
+   }
+
+   int fillOrders() {
+      _broker.orders(_currentOrders);
+
+      const int count = std::min<int>(_currentOrders.size(), MAX_ORDERS);
+
+      for (int i = 0; i < count; ++i) {
+         double *fields = &_orders[i * ORDER_FIELDS];
+
+         fields[0] = _currentOrders[i].ticket;
+         fields[1] = _currentOrders[i].type;
+         fields[2] = _currentOrders[i].lots;
+         fields[3] = _currentOrders[i].openPrice;
+      }
+
+      return count;
+   }
+
+   void executeAction(int index) {
+      const double *fields = &_actions[index * ACTION_FIELDS];
+
+      TradeReconciler::Action action = TradeReconciler::Action();
+      action.kind     = (TradeReconciler::Kind)(int)fields[0];
+      action.ticket   = (int)fields[1];
+      action.opType   = (int)fields[2];
+      action.lots     = fields[3];
+      action.price    = fields[4];
+      action.stop     = fields[5];
+      action.take     = fields[6];
+      action.slippage = (int)fields[7];
+
+      const TradeReconciler::Result result = _broker.execute(action);
+
+      double *output = &_results[index * RESULT_FIELDS];
+
+      output[0] = result.status;
+      output[1] = result.error;
+      output[2] = result.orderType;
+      output[3] = result.openPrice;
+      output[4] = result.closePrice;
+      output[5] = result.profit;
+   }
+
+   void updateBalance() {
+      if (_broker.balance() == _reportedBalance) return;
+
+      _reportedBalance = _broker.balance();
+
+      _connector.UpdateBalance(_tradeConnector, _reportedBalance);
+   }
+
+private:
+   MTConnector &_connector;
+   const int _ticksSink;
+   const int _tradeConnector;
+
+   SimulatedBroker &_broker;
+   double _reportedBalance;
+
+   std::vector<double> _market;
+   std::vector<double> _orders;
+   std::vector<double> _actions;
+   std::vector<double> _results;
+
+   std::vector<TradeReconciler::Order> _currentOrders;
+
+   uint64 _cycles;
+   uint64 _actionsExecuted;
+};
+
+static bool parse(int argc, char **argv, Options &options) {
+   for (int i = 1; i < argc; ++i) {
+      const std::string name = argv[i];
+
+      if (name[0] != '-') {
+         if (options.directory.empty()) options.directory = name;
+         else if (options.symbol.empty()) options.symbol = name;
+         else return false;
+
+         continue;
+      }
+
+      if (i + 1 >= argc) return false;
+
+      const std::string value = argv[++i];
+
+      if (name == "--address") options.address = value;
+      else if (name == "--port") options.port = atoi(value.c_str());
+      else if (name == "--key") options.key = value;
+      else if (name == "--trade-key") options.tradeKey = value;
+      else if (name == "--generate") options.generate = atol(value.c_str());
+      else if (name == "--speed") options.speed = atof(value.c_str());
+      else if (name == "--settle") options.settle = atoi(value.c_str());
+      else if (name == "--warmup") options.warmup = atoi(value.c_str());
+      else if (name == "--digits") options.broker.digits = atoi(value.c_str());
+      else if (name == "--stop-level") options.broker.stopLevel = atof(value.c_str());
+      else if (name == "--freeze-level") options.broker.freezeLevel = atof(value.c_str());
+      else if (name == "--slippage") options.broker.maxSlippage = atoi(value.c_str());
+      else if (name == "--lot-size") options.broker.lotSize = atof(value.c_str());
+      else if (name == "--balance") options.broker.balance = atof(value.c_str());
+      else if (name == "--seed") options.broker.seed = atoi(value.c_str());
+      else return false;
+   }
+
+   if (options.tradeKey.empty()) options.tradeKey = options.key;
+
+   const bool hasTicks = options.generate > 0 || !options.symbol.empty();
+
+   return hasTicks && !options.key.empty() && options.settle >= 0 && options.speed >= 0;
+}
+
+static int simulate(const Options &options) {
+   TickLog::Reader *reader = options.generate > 0 ? nullptr : new TickLog::Reader(options.directory, options.symbol);
+
+   std::minstd_rand random(options.broker.seed);
+   std::uniform_int_distribution<int> step(-3, 3);
+   const double point = pow(10, -options.broker.digits);
+   long generated = 0;
+
+   // random walk with spread of 2 points, a tick a second
+   TickLog::Tick walk = { (uint64)::time(NULL), 1.3, 1.3 + 2 * point };
+
+   auto next = [&](TickLog::Tick &tick) -> bool {
+      if (reader != nullptr) return reader->next(tick);
+
+      if (generated++ == options.generate) return false;
+
+      walk.time += 1;
+      walk.bid += step(random) * point;
+      walk.ask = walk.bid + 2 * point;
+
+      tick = walk;
+
+      return true;
+   };
+
+   MTConnector connector;
+   SimulatedBroker broker(options.broker);
+
+   const int ticksSink = connector.createTicksSink(options.address, options.port, options.key);
+   const int tradeConnector = connector.createTradeConnector(options.address,
+                                                             options.port,
+                                                             options.tradeKey,
+                                                             broker.balance(),
+                                                             broker.balance());
+
+   Terminal terminal(connector, ticksSink, tradeConnector, broker);
+
+   Platform::instance().sleep(options.warmup);
+
+   TickLog::Tick tick;
+   uint64 ticks = 0;
+   uint64 firstTime = 0;
+   uint64 lastTime = 0;
+
+   const Platform::Milliseconds start = Platform::instance().currentTime();
+
+   while (next(tick)) {
+      if (ticks == 0) firstTime = tick.time;
+      lastTime = tick.time;
+
+      if (options.speed > 0) {
+         const Platform::Milliseconds due = start + (Platform::Milliseconds)((tick.time - firstTime) * 1000 / options.speed);
+         const Platform::Milliseconds now = Platform::instance().currentTime();
+
+         if (due > now) Platform::instance().sleep(due - now);
+      }
+
+      terminal.onTick(tick.bid, tick.ask, options.settle);
+      ++ticks;
+   }
+
+   const double seconds = (Platform::instance().currentTime() - start) / 1000.0;
+
+   connector.freeTicksSink(ticksSink);
+   connector.freeTradeConnector(tradeConnector);
+
+   delete reader;
+
+   if (ticks == 0) {
+      std::cerr << "no ticks of " << options.symbol << " in " << options.directory << std::endl;
+      return 1;
+   }
+
+   const SimulatedBroker::Stats &stats = broker.stats();
+
+   std::cout << "ticks: " << ticks << " in " << std::fixed << std::setprecision(3) << seconds << " s";
+
+   if (seconds > 0) {
+      std::cout << ", " << (uint64)(ticks / seconds) << " ticks/s"
+                << ", " << std::setprecision(0) << (lastTime - firstTime) / seconds << "x real time";
+   }
+
+   std::cout << std::endl
+             << "trades cycles: " << terminal.cycles() << ", actions: " << terminal.actionsExecuted() << std::endl
+             << "orders opened: " << stats.opened << ", limits filled: " << stats.limitsFilled
+             << ", modified: " << stats.modified << ", closed: " << stats.closed
+             << ", deleted: " << stats.deleted << std::endl
+             << "stops hit: " << stats.stopsHit << ", take profits hit: " << stats.takesHit
+             << ", rejected: " << stats.rejected << std::endl
+             << "balance: " << std::setprecision(2) << broker.balance()
+             << ", equity: " << broker.equity() << std::endl;
+
+   return 0;
+}
+
+int main(int argc, char **argv) {
+   Options options;
+
+   if (!parse(argc, argv, options)) {
+      std::cerr << "usage: " << argv[0] << " directory symbol --key key [options]" << std::endl
+                << "       " << argv[0] << " --generate N --key key [options]" << std::endl
+                << "options: [--address hub] [--port N] [--trade-key key] [--speed x] [--settle ms] [--warmup ms]" << std::endl
+                << "         [--digits N] [--stop-level points] [--freeze-level points] [--slippage points]" << std::endl
+                << "         [--lot-size value] [--balance value] [--seed N]" << std::endl;
+      return 1;
+   }
+
+   Platform::init(new NixPlatform());
+
+   const int result = simulate(options);
+
+   Platform::cleanup();
+
+   return result;
+}
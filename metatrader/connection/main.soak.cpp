@@ -0,0 +1,569 @@
+// Soak test of connection churn through MTConnector.
+//
+// Worker threads create and free ticks sinks and trade connectors at
+// random, send ticks and run trade cycles the emulator drives, while the
+// emulator (in forked process, so numbers here are of the connector only)
+// injects faults by the script. Every few seconds throughput, RSS, threads
+// and descriptors are printed, and live ConnectionState and RunLoop::Task
+// objects, which should not grow.
+//
+// Connector is deleted at the end, after that nothing should be left
+// alive. If workers make no progress for a while, it's reported as a
+// deadlock. Exit code is non zero in both cases.
+//
+//   ./soak --duration 600 --workers 8 --shards 4
+//   ./soak --faults "0:none;10:disconnect=0.02,halfopen=0.01,slow=0.02;50:none"
+//
+// Faults script is phases "second:fault=chance,...", chances are per
+// connection per second (see HubEmulator::Faults), slow-ms is the delay
+// of slow reads.
+
+#include <iostream>
+#include <iomanip>
+#include <sstream>
+#include <vector>
+#include <atomic>
+#include <random>
+#include <new>
+#include <stdlib.h>
+#include <string.h>
+#include <dirent.h>
+#include <signal.h>
+#include <unistd.h>
+#include <sys/mman.h>
+#include <sys/prctl.h>
+#include <sys/wait.h>
+
+#include "NixPlatform.h"
+#include "MTConnector.h"
+#include "ConnectionState.h"
+#include "HubEmulator.h"
+
+enum {
+   MAX_FAULT_PHASES = 32,
+   TEARDOWN_WAIT_MS = 3000
+};
+
+struct FaultPhase {
+   int second;
+   HubEmulator::Faults faults;
+};
+
+struct Options {
+   Options()
+      : duration(60)
+      , workers(8)
+      , maxPerWorker(4)
+      , pauseMs(1)
+      , reportSeconds(5)
+      , stallSeconds(30)
+      , shards(1)
+      , seed(1) {}
+
+   int duration;
+   int workers;
+   // of sinks and of trade connectors
+   int maxPerWorker;
+   int pauseMs;
+   int reportSeconds;
+   int stallSeconds;
+   // ct shards of the connector
+   int shards;
+   uint32 seed;
+
+   std::vector<FaultPhase> phases;
+};
+
+/**
+ * Lives in anonymous shared mapping, written by the emulator.
+ */
+struct Shared {
+   std::atomic<int> port;
+
+   std::atomic<uint64> registrations;
+   std::atomic<uint64> ticks;
+   std::atomic<uint64> ticksLost;
+   std::atomic<uint64> tradeCycles;
+
+   std::atomic<uint64> faults[3];
+
+   int phaseCount;
+   FaultPhase phases[MAX_FAULT_PHASES];
+};
+
+struct Counters {
+   Counters()
+      : operations(0)
+      , sinksCreated(0)
+      , sinksFreed(0)
+      , tradersCreated(0)
+      , tradersFreed(0)
+      , ticksSent(0) {}
+
+   std::atomic<uint64> operations;
+   std::atomic<uint64> sinksCreated;
+   std::atomic<uint64> sinksFreed;
+   std::atomic<uint64> tradersCreated;
+   std::atomic<uint64> tradersFreed;
+   std::atomic<uint64> ticksSent;
+};
+
+struct Sample {
+   uint64 rss;
+   int threads;
+   int descriptors;
+   int64 states;
+   int64 tasks;
+};
+
+class SoakListener : public HubEmulator::Listener {
+public:
+   SoakListener(Shared &shared) : _shared(shared) {}
+
+   void onRegistered(const std::string &key, bool isTradeConnector) {
+      ++_shared.registrations;
+   }
+
+   void onTick(const std::string &key, uint64 sequence, uint64 time, double bid, double ask) {
+      ++_shared.ticks;
+   }
+
+   void onTicksLost(const std::string &key, uint64 count) {
+      _shared.ticksLost += count;
+   }
+
+   void onTradeClosed(const std::string &key, int64_t nanoseconds) {
+      ++_shared.tradeCycles;
+   }
+
+   void onFault(HubEmulator::Fault fault) {
+      ++_shared.faults[fault];
+   }
+
+private:
+   Shared &_shared;
+};
+
+static uint64 readRss() {
+   FILE *file = fopen("/proc/self/statm", "r");
+   if (file == NULL) return 0;
+
+   unsigned long size = 0, resident = 0;
+   if (fscanf(file, "%lu %lu", &size, &resident) != 2) resident = 0;
+
+   fclose(file);
+
+   return (uint64)resident * sysconf(_SC_PAGESIZE);
+}
+
+static int readThreads() {
+   FILE *file = fopen("/proc/self/status", "r");
+   if (file == NULL) return 0;
+
+   char line[256];
+   int threads = 0;
+
+   while (fgets(line, sizeof(line), file)) {
+      if (sscanf(line, "Threads: %d", &threads) == 1) break;
+   }
+
+   fclose(file);
+
+   return threads;
+}
+
+static int readDescriptors() {
+   DIR *directory = opendir("/proc/self/fd");
+   if (directory == NULL) return 0;
+
+   int count = 0;
+   while (readdir(directory) != NULL) ++count;
+
+   closedir(directory);
+
+   // ".", ".." and the directory itself
+   return count - 3;
+}
+
+static Sample sample() {
+   Sample result;
+
+   result.rss = readRss();
+   result.threads = readThreads();
+   result.descriptors = readDescriptors();
+   result.states = ConnectionState::instances();
+   result.tasks = RunLoop::liveTasks();
+
+   return result;
+}
+
+static bool parseFaults(const std::string &text, HubEmulator::Faults &faults) {
+   faults = HubEmulator::Faults();
+
+   if (text.empty() || text == "none") return true;
+
+   std::istringstream items(text);
+   std::string item;
+
+   while (std::getline(items, item, ',')) {
+      const size_t equals = item.find('=');
+      if (equals == std::string::npos) return false;
+
+      const std::string name = item.substr(0, equals);
+      const double value = atof(item.c_str() + equals + 1);
+
+      if (name == "disconnect") faults.disconnects = value;
+      else if (name == "halfopen") faults.halfOpens = value;
+      else if (name == "slow") faults.slowReads = value;
+      else if (name == "slow-ms") faults.slowReadDelayMs = (int)value;
+      else return false;
+   }
+
+   return true;
+}
+
+static bool parseScript(const std::string &text, std::vector<FaultPhase> &phases) {
+   std::istringstream items(text);
+   std::string item;
+
+   phases.clear();
+
+   while (std::getline(items, item, ';')) {
+      const size_t colon = item.find(':');
+      if (colon == std::string::npos) return false;
+
+      FaultPhase phase;
+      phase.second = atoi(item.c_str());
+
+      if (!parseFaults(item.substr(colon + 1), phase.faults)) return false;
+
+      phases.push_back(phase);
+   }
+
+   return phases.size() <= MAX_FAULT_PHASES;
+}
+
+static void runEmulator(Shared *shared) {
+   prctl(PR_SET_PDEATHSIG, SIGKILL);
+
+   Platform::init(new NixPlatform());
+
+   SoakListener listener(*shared);
+   HubEmulator emulator(listener, true);
+
+   if (!emulator.listen(0)) {
+      shared->port = -1;
+      _exit(1);
+   }
+
+   Thread *script = Platform::instance().createThread([shared, &emulator]() -> void {
+         int elapsed = 0;
+
+         for (int i = 0; i < shared->phaseCount; ++i) {
+            const FaultPhase &phase = shared->phases[i];
+
+            if (phase.second > elapsed) {
+               Platform::instance().sleep((phase.second - elapsed) * 1000);
+               elapsed = phase.second;
+            }
+
+            emulator.setFaults(phase.faults);
+         }
+      } );
+
+   shared->port = emulator.port();
+
+   emulator.run();
+
+   Thread::joinAndDelete(script);
+
+   _exit(0);
+}
+
+static void pollTrades(MTConnector &connector, int id) {
+   connector.StartNextTradesIteration(id);
+
+   while (connector.ShiftToNextTrade(id)) {
+      if (connector.TradeGetIsWantsClose(id)) {
+         connector.TradeNotifyClosed(id);
+         connector.FreeTrade(id);
+      } else if (!connector.TradeGetIsOpened(id)) {
+         connector.TradeSetIsOpened(id, true);
+         connector.TradeNotifyOpened(id);
+      }
+   }
+}
+
+/**
+ * One worker's connections, created and freed at random, everything left
+ * is freed when it stops.
+ */
+static void work(MTConnector &connector,
+                 const Options &options,
+                 int port,
+                 int worker,
+                 Counters &counters,
+                 const std::atomic<bool> &stopped) {
+   std::minstd_rand random(options.seed * 7919 + worker);
+   std::uniform_int_distribution<int> percent(0, 99);
+
+   std::vector<int> sinks;
+   std::vector<int> traders;
+
+   int created = 0;
+
+   while (!stopped) {
+      const int roll = percent(random);
+
+      if (roll < 5 && (int)sinks.size() < options.maxPerWorker) {
+         std::ostringstream key;
+         key << "soak-sink-" << worker << "-" << created++;
+
+         sinks.push_back(connector.createTicksSink("127.0.0.1", port, key.str()));
+         ++counters.sinksCreated;
+
+      } else if (roll < 10 && !sinks.empty()) {
+         const size_t index = random() % sinks.size();
+
+         connector.freeTicksSink(sinks[index]);
+         sinks.erase(sinks.begin() + index);
+         ++counters.sinksFreed;
+
+      } else if (roll < 15 && (int)traders.size() < options.maxPerWorker) {
+         std::ostringstream key;
+         key << "soak-trader-" << worker << "-" << created++;
+
+         traders.push_back(connector.createTradeConnector("127.0.0.1", port, key.str(), 1000, 1000));
+         ++counters.tradersCreated;
+
+      } else if (roll < 20 && !traders.empty()) {
+         const size_t index = random() % traders.size();
+
+         connector.freeTradeConnector(traders[index]);
+         traders.erase(traders.begin() + index);
+         ++counters.tradersFreed;
+
+      } else if (roll < 60 && !sinks.empty()) {
+         connector.sendTick(sinks[random() % sinks.size()], 1.1, 1.2);
+         ++counters.ticksSent;
+
+      } else if (!traders.empty()) {
+         pollTrades(connector, traders[random() % traders.size()]);
+      }
+
+      ++counters.operations;
+
+      if (options.pauseMs > 0) Platform::instance().sleep(options.pauseMs);
+   }
+
+   for (int sink : sinks) connector.freeTicksSink(sink);
+   for (int trader : traders) connector.freeTradeConnector(trader);
+}
+
+static std::string megabytes(uint64 bytes) {
+   std::ostringstream result;
+   result << std::fixed << std::setprecision(1) << bytes / 1048576.0 << " MB";
+   return result.str();
+}
+
+static void printSample(int second, const Sample &current, uint64 operations, const Shared &shared) {
+   std::cout << std::setw(5) << second << " s"
+             << "  ops " << operations
+             << ", registrations " << shared.registrations
+             << ", rss " << megabytes(current.rss)
+             << ", threads " << current.threads
+             << ", fds " << current.descriptors
+             << ", states " << current.states
+             << ", tasks " << current.tasks << std::endl;
+}
+
+static int soak(const Options &options) {
+   void *mapping = mmap(NULL, sizeof(Shared), PROT_READ | PROT_WRITE, MAP_SHARED | MAP_ANONYMOUS, -1, 0);
+
+   if (mapping == MAP_FAILED) {
+      std::cerr << "can't map shared memory" << std::endl;
+      return 1;
+   }
+
+   Shared *shared = new (mapping) Shared();
+
+   shared->phaseCount = options.phases.size();
+   for (size_t i = 0; i < options.phases.size(); ++i) shared->phases[i] = options.phases[i];
+
+   // forked before any thread is started
+   const pid_t emulator = fork();
+
+   if (emulator == 0) runEmulator(shared);
+
+   Platform::init(new NixPlatform());
+
+   while (shared->port == 0) Platform::instance().sleep(1);
+
+   if (shared->port < 0) {
+      std::cerr << "emulator can't listen" << std::endl;
+      return 1;
+   }
+
+   const Sample initial = sample();
+
+   MTConnector *connector = new MTConnector(options.shards);
+
+   Counters counters;
+   std::atomic<bool> stopped(false);
+   std::vector<Thread *> workers;
+
+   for (int i = 0; i < options.workers; ++i) {
+      workers.push_back(Platform::instance().createThread([&, i]() -> void {
+               work(*connector, options, shared->port, i, counters, stopped);
+            } ));
+   }
+
+   Sample first = initial;
+   Sample last = initial;
+   int maxThreads = initial.threads;
+
+   uint64 lastOperations = 0;
+   int stalledFor = 0;
+   bool deadlocked = false;
+
+   for (int second = 1; second <= options.duration; ++second) {
+      Platform::instance().sleep(1000);
+
+      last = sample();
+      if (last.threads > maxThreads) maxThreads = last.threads;
+
+      // growth is measured from the first report, when churn is running
+      if (second == options.reportSeconds) first = last;
+
+      const uint64 operations = counters.operations;
+
+      stalledFor = operations == lastOperations ? stalledFor + 1 : 0;
+      lastOperations = operations;
+
+      if (second % options.reportSeconds == 0) printSample(second, last, operations, *shared);
+
+      if (stalledFor >= options.stallSeconds) {
+         deadlocked = true;
+         break;
+      }
+   }
+
+   if (deadlocked) {
+      // workers are stuck, nothing can be torn down
+      std::cout << "DEADLOCK: no operation completed for " << stalledFor << " s" << std::endl;
+
+      kill(emulator, SIGKILL);
+      _exit(2);
+   }
+
+   stopped = true;
+   for (Thread *worker : workers) Thread::joinAndDelete(worker);
+
+   delete connector;
+
+   // connections' threads are joined by their states, so after delete of
+   // the connector the counts should drop to zero at once, the wait only
+   // makes leak reports stable
+   Sample final = sample();
+
+   for (int waited = 0; waited < TEARDOWN_WAIT_MS && (final.states != 0 || final.tasks != 0); waited += 10) {
+      Platform::instance().sleep(10);
+      final = sample();
+   }
+
+   // platform keeps connect thread of its own till cleanup
+   Platform::cleanup();
+
+   final = sample();
+
+   const double seconds = options.duration;
+
+   std::cout << std::endl
+             << "operations: " << counters.operations
+             << " (" << (uint64)(counters.operations / seconds) << "/s)"
+             << ", sinks created/freed: " << counters.sinksCreated << "/" << counters.sinksFreed
+             << ", trade connectors created/freed: " << counters.tradersCreated << "/" << counters.tradersFreed
+             << std::endl;
+
+   std::cout << "hub: registrations " << shared->registrations
+             << ", ticks " << shared->ticks << " of " << counters.ticksSent << " sent"
+             << " (" << shared->ticksLost << " lost)"
+             << ", trade cycles " << shared->tradeCycles
+             << ", faults: disconnects " << shared->faults[HubEmulator::DISCONNECT]
+             << ", half open " << shared->faults[HubEmulator::HALF_OPEN]
+             << ", slow reads " << shared->faults[HubEmulator::SLOW_READ] << std::endl;
+
+   const int64 rssGrowth = (int64)last.rss - (int64)first.rss;
+
+   std::cout << "rss: " << megabytes(initial.rss) << " at start, " << megabytes(first.rss)
+             << " at " << options.reportSeconds << " s, " << megabytes(last.rss) << " at the end"
+             << " (" << (rssGrowth >= 0 ? "+" : "-") << megabytes(rssGrowth >= 0 ? rssGrowth : -rssGrowth) << ")"
+             << std::endl;
+
+   std::cout << "threads: " << initial.threads << " at start, " << maxThreads << " max, "
+             << final.threads << " after teardown" << std::endl;
+
+   std::cout << "after teardown: states " << final.states
+             << ", tasks " << final.tasks
+             << ", fds " << final.descriptors << " (" << initial.descriptors << " at start)" << std::endl;
+
+   const bool leaked = final.states != 0
+      || final.tasks != 0
+      || final.threads > initial.threads
+      || final.descriptors > initial.descriptors;
+
+   std::cout << (leaked ? "LEAKED" : "OK") << std::endl;
+
+   kill(emulator, SIGKILL);
+   waitpid(emulator, NULL, 0);
+
+   munmap(mapping, sizeof(Shared));
+
+   return leaked ? 1 : 0;
+}
+
+static bool parse(int argc, char **argv, Options &options) {
+   for (int i = 1; i < argc; i += 2) {
+      if (i + 1 >= argc) return false;
+
+      const std::string name = argv[i];
+      const int value = atoi(argv[i + 1]);
+
+      if (name == "--duration") options.duration = value;
+      else if (name == "--workers") options.workers = value;
+      else if (name == "--max-per-worker") options.maxPerWorker = value;
+      else if (name == "--pause-ms") options.pauseMs = value;
+      else if (name == "--report") options.reportSeconds = value;
+      else if (name == "--stall") options.stallSeconds = value;
+      else if (name == "--shards") options.shards = value;
+      else if (name == "--seed") options.seed = strtoul(argv[i + 1], NULL, 10);
+      else if (name == "--faults") {
+         if (!parseScript(argv[i + 1], options.phases)) return false;
+      } else {
+         return false;
+      }
+   }
+
+   return options.duration > 0
+      && options.workers > 0
+      && options.maxPerWorker > 0
+      && options.reportSeconds > 0
+      && options.stallSeconds > 0
+      && options.shards > 0;
+}
+
+int main(int argc, char **argv) {
+   Options options;
+
+   parseScript("0:disconnect=0.01,halfopen=0.005,slow=0.01", options.phases);
+
+   if (!parse(argc, argv, options)) {
+      std::cerr << "usage: " << argv[0]
+                << " [--duration s] [--workers N] [--max-per-worker N] [--pause-ms ms]"
+                << " [--report s] [--stall s] [--shards N] [--seed S]"
+                << " [--faults \"second:disconnect=p,halfopen=p,slow=p,slow-ms=ms;...\"]" << std::endl;
+      return 1;
+   }
+
+   return soak(options);
+}
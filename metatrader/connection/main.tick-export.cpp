@@ -0,0 +1,119 @@
+// Exports ticks recorded by TickRecorder as ticks.mt.txt, the format
+// TickGetter.mq4 used to write and the hub's tools read.
+//
+//   ./tick-export ticks-directory EURUSD > EURUSD.ticks.mt.txt
+//   ./tick-export ticks-directory EURUSD --digits 5 --output EURUSD.ticks.mt.txt
+//
+// With --record N it records N generated ticks first, to measure recorder.
+
+#include <iostream>
+#include <stdio.h>
+#include <stdlib.h>
+#include <time.h>
+#include <chrono>
+
+#include "NixPlatform.h"
+#include "TickLog.h"
+#include "TickRecorder.h"
+#include "TicksText.h"
+
+struct Options {
+   Options()
+      : digits(-1)
+      , record(0) {}
+
+   std::string directory;
+   std::string symbol;
+   std::string output;
+   int digits;
+   long record;
+};
+
+static bool parse(int argc, char **argv, Options &options) {
+   for (int i = 1; i < argc; ++i) {
+      const std::string name = argv[i];
+
+      if (name[0] != '-') {
+         if (options.directory.empty()) options.directory = name;
+         else if (options.symbol.empty()) options.symbol = name;
+         else return false;
+
+         continue;
+      }
+
+      if (i + 1 >= argc) return false;
+
+      const std::string value = argv[++i];
+
+      if (name == "--digits") options.digits = atoi(value.c_str());
+      else if (name == "--output") options.output = value;
+      else if (name == "--record") options.record = atol(value.c_str());
+      else return false;
+   }
+
+   return !options.directory.empty() && !options.symbol.empty();
+}
+
+static void record(const Options &options) {
+   TickRecorder recorder;
+
+   if (!recorder.start(options.directory)) {
+      std::cerr << "can't record to " << options.directory << std::endl;
+      return;
+   }
+
+   const uint64 start = ::time(NULL);
+   const std::chrono::steady_clock::time_point began = std::chrono::steady_clock::now();
+
+   for (long i = 0; i < options.record; ++i) {
+      const double bid = 1.3 + (i % 1000) * 0.00001;
+      recorder.recordTick(options.symbol, start + i / 10, bid, bid + 0.0002);
+   }
+
+   const double seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - began).count();
+
+   recorder.stop();
+
+   std::cerr << "recorded " << options.record << " ticks in " << seconds << " s, "
+             << (options.record > 0 ? 1e9 * seconds / options.record : 0) << " ns per tick" << std::endl;
+}
+
+int main(int argc, char **argv) {
+   Options options;
+
+   if (!parse(argc, argv, options)) {
+      std::cerr << "usage: " << argv[0]
+                << " directory symbol [--digits N] [--output file] [--record N]" << std::endl;
+      return 1;
+   }
+
+   Platform::init(new NixPlatform());
+
+   if (options.record > 0) record(options);
+
+   FILE *output = options.output.empty() ? stdout : fopen(options.output.c_str(), "w");
+
+   if (output == NULL) {
+      std::cerr << "can't create " << options.output << std::endl;
+      return 1;
+   }
+
+   TickLog::Reader reader(options.directory, options.symbol);
+   TickLog::Tick tick;
+
+   char line[TicksText::MAX_LINE_SIZE + 1];
+   uint64 count = 0;
+
+   while (reader.next(tick)) {
+      fwrite(line, 1, TicksText::formatLine(line, tick.time, tick.bid, options.digits), output);
+      ++count;
+   }
+
+   if (output != stdout) fclose(output);
+
+   std::cerr << count << " ticks exported" << std::endl;
+
+   Platform::cleanup();
+
+   return 0;
+}
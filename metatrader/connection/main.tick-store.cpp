@@ -0,0 +1,281 @@
+// Tool for TickStore: imports history from the hub's formats, prints it
+// back and measures scans and seeks.
+//
+//   ./tick-store import-text EURUSD.ticks.mt.txt EURUSD.fxts [--threads 4]
+//   ./tick-store parse EURUSD.ticks.mt.txt [--threads 4]
+//   ./tick-store import-cache EURUSD.ticks.bin.cache.v3 EURUSD.fxts
+//   ./tick-store info EURUSD.fxts
+//   ./tick-store export EURUSD.fxts > EURUSD.ticks.mt.txt
+//   ./tick-store scan EURUSD.fxts
+//   ./tick-store seek EURUSD.fxts 2013-05-17-14-03-59 [count]
+//   ./tick-store seeks EURUSD.fxts 1000000
+
+#include <iostream>
+#include <iomanip>
+#include <vector>
+#include <chrono>
+#include <random>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "NixPlatform.h"
+#include "TickStore.h"
+#include "TicksText.h"
+#include "TicksTextParser.h"
+#include "TicksBinaryCache.h"
+
+static double secondsSince(const std::chrono::steady_clock::time_point &start) {
+   return std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+}
+
+static bool finishImport(TickStoreWriter &writer, uint64 imported, uint64 skipped, double seconds) {
+   if (!writer.close()) {
+      std::cerr << "can't write store" << std::endl;
+      return false;
+   }
+
+   std::cerr << imported << " ticks imported, " << skipped << " lines skipped in "
+             << std::fixed << std::setprecision(2) << seconds << " s" << std::endl;
+
+   return true;
+}
+
+static bool importText(const std::string &input, const std::string &output, int threads) {
+   const std::chrono::steady_clock::time_point start = std::chrono::steady_clock::now();
+
+   TicksTextParser::Columns columns;
+
+   if (!TicksTextParser::parseFile(input, threads, columns)) {
+      std::cerr << "can't open " << input << std::endl;
+      return false;
+   }
+
+   TickStoreWriter writer(output);
+
+   if (!writer.isOpened()) {
+      std::cerr << "can't create " << output << std::endl;
+      return false;
+   }
+
+   for (size_t i = 0; i < columns.times.size(); ++i) writer.add(columns.times[i], columns.prices[i]);
+
+   return finishImport(writer, columns.times.size(), columns.skipped, secondsSince(start));
+}
+
+static bool parse(const std::string &input, int threads) {
+   MappedFile *file = Platform::instance().mapFileForReading(input);
+   const uint64 size = file ? file->size() : 0;
+   delete file;
+
+   const std::chrono::steady_clock::time_point start = std::chrono::steady_clock::now();
+
+   TicksTextParser::Columns columns;
+
+   if (!TicksTextParser::parseFile(input, threads, columns)) {
+      std::cerr << "can't open " << input << std::endl;
+      return false;
+   }
+
+   const double seconds = secondsSince(start);
+
+   int64 sum = 0;
+   for (size_t i = 0; i < columns.times.size(); ++i) sum += columns.times[i] ^ columns.prices[i];
+
+   std::cout << columns.times.size() << " ticks, " << columns.skipped << " lines skipped, "
+             << size << " bytes parsed in " << std::fixed << std::setprecision(3) << seconds << " s, "
+             << std::setprecision(2) << (seconds > 0 ? size / seconds / 1e9 : 0) << " GB/s"
+             << " (checksum " << sum << ")" << std::endl;
+
+   return true;
+}
+
+static bool importCache(const std::string &input, const std::string &output) {
+   TicksBinaryCache::Reader reader(input);
+
+   if (!reader.isValid()) {
+      std::cerr << "can't read " << input << std::endl;
+      return false;
+   }
+
+   TickStoreWriter writer(output);
+
+   if (!writer.isOpened()) {
+      std::cerr << "can't create " << output << std::endl;
+      return false;
+   }
+
+   const std::chrono::steady_clock::time_point start = std::chrono::steady_clock::now();
+
+   int64 time, price;
+   uint64 imported = 0;
+
+   while (reader.next(time, price)) {
+      writer.add(time, price);
+      ++imported;
+   }
+
+   return finishImport(writer, imported, 0, secondsSince(start));
+}
+
+static void printTicks(TickStore::Cursor &cursor, uint64 count, FILE *output) {
+   char line[TicksText::MAX_LINE_SIZE + 1];
+   int64 time, price;
+
+   for (uint64 i = 0; i < count && cursor.next(time, price); ++i) {
+      fwrite(line, 1, TicksText::formatScaledLine(line, time, price), output);
+   }
+}
+
+static void info(const TickStore &store, uint64 fileSize) {
+   char first[TicksText::MAX_LINE_SIZE + 1];
+   char last[TicksText::MAX_LINE_SIZE + 1];
+
+   TicksText::formatScaledLine(first, store.firstTime(), 0);
+   TicksText::formatScaledLine(last, store.lastTime(), 0);
+
+   std::cout << "ticks: " << store.ticks() << ", chunks: " << store.chunks() << std::endl
+             << "from " << std::string(first, 19) << " to " << std::string(last, 19) << std::endl
+             << "size: " << fileSize << " bytes, "
+             << std::fixed << std::setprecision(2)
+             << (store.ticks() > 0 ? (double)fileSize / store.ticks() : 0) << " bytes per tick" << std::endl;
+}
+
+static void scan(const TickStore &store) {
+   TickStore::Chunk *chunk = new TickStore::Chunk();
+
+   const std::chrono::steady_clock::time_point start = std::chrono::steady_clock::now();
+
+   // sums keep decoding from being optimized out
+   int64 sum = 0;
+
+   for (uint64 i = 0; i < store.chunks(); ++i) {
+      store.decode(i, *chunk);
+
+      for (uint32 j = 0; j < chunk->count; ++j) sum += chunk->prices[j] ^ chunk->times[j];
+   }
+
+   const double seconds = secondsSince(start);
+
+   delete chunk;
+
+   std::cout << "scanned " << store.ticks() << " ticks in " << std::fixed << std::setprecision(3)
+             << seconds << " s, " << std::setprecision(2)
+             << (seconds > 0 ? 1e9 * seconds / store.ticks() : 0) << " ns per tick, "
+             << (seconds > 0 ? store.ticks() * 16 / seconds / 1e9 : 0) << " GB/s decoded"
+             << " (checksum " << sum << ")" << std::endl;
+}
+
+static void seeks(const TickStore &store, int count) {
+   std::minstd_rand random(1);
+
+   const int64 first = store.firstTime();
+   const int64 span = store.lastTime() - first + 1;
+
+   TickStore::Cursor cursor(store);
+
+   const std::chrono::steady_clock::time_point start = std::chrono::steady_clock::now();
+
+   int64 sum = 0;
+
+   for (int i = 0; i < count; ++i) {
+      cursor.seek(first + (int64)((double)random() / random.max() * span));
+
+      int64 time, price;
+      if (cursor.next(time, price)) sum += price;
+   }
+
+   const double seconds = secondsSince(start);
+
+   std::cout << count << " seeks in " << std::fixed << std::setprecision(3) << seconds << " s, "
+             << std::setprecision(0) << (count > 0 ? 1e9 * seconds / count : 0) << " ns per seek"
+             << " (checksum " << sum << ")" << std::endl;
+}
+
+static bool parseTime(const std::string &value, int64 &time) {
+   int64 price;
+   const std::string line = value + " 0";
+
+   return TicksText::parseLine(line.data(), line.data() + line.size(), time, price);
+}
+
+static int usage(const char *name) {
+   std::cerr << "usage: " << name << " import-text ticks.mt.txt store [--threads n]" << std::endl
+             << "       " << name << " parse ticks.mt.txt [--threads n]" << std::endl
+             << "       " << name << " import-cache ticks.bin.cache.v3 store" << std::endl
+             << "       " << name << " info|export|scan store" << std::endl
+             << "       " << name << " seek store YYYY-MM-DD-hh-mm-ss [count]" << std::endl
+             << "       " << name << " seeks store count" << std::endl;
+   return 1;
+}
+
+int main(int argc, char **argv) {
+   if (argc < 3) return usage(argv[0]);
+
+   const std::string command = argv[1];
+   const std::string path = argv[2];
+
+   Platform::init(new NixPlatform());
+
+   int result = 0;
+
+   if (command == "import-text" || command == "parse") {
+      const int arguments = command == "parse" ? 3 : 4;
+
+      int threads = 1;
+
+      if (argc == arguments + 2 && strcmp(argv[arguments], "--threads") == 0) {
+         threads = atoi(argv[arguments + 1]);
+      } else if (argc != arguments) {
+         return usage(argv[0]);
+      }
+
+      const bool done = command == "parse" ? parse(path, threads) : importText(path, argv[3], threads);
+
+      result = done ? 0 : 1;
+   } else if (command == "import-cache") {
+      if (argc != 4) return usage(argv[0]);
+
+      result = importCache(path, argv[3]) ? 0 : 1;
+   } else {
+      TickStore *store = TickStore::open(path);
+
+      if (store == nullptr) {
+         std::cerr << "can't open store " << path << std::endl;
+         Platform::cleanup();
+         return 1;
+      }
+
+      TickStore::Cursor *cursor = new TickStore::Cursor(*store);
+
+      if (command == "info") {
+         MappedFile *file = Platform::instance().mapFileForReading(path);
+         info(*store, file->size());
+         delete file;
+      } else if (command == "export") {
+         printTicks(*cursor, store->ticks(), stdout);
+      } else if (command == "scan") {
+         scan(*store);
+      } else if (command == "seek" && argc >= 4) {
+         int64 time;
+
+         if (parseTime(argv[3], time)) {
+            cursor->seek(time);
+            printTicks(*cursor, argc > 4 ? atoi(argv[4]) : 10, stdout);
+         } else {
+            result = usage(argv[0]);
+         }
+      } else if (command == "seeks" && argc >= 4) {
+         seeks(*store, atoi(argv[3]));
+      } else {
+         result = usage(argv[0]);
+      }
+
+      delete cursor;
+      delete store;
+   }
+
+   Platform::cleanup();
+
+   return result;
+}
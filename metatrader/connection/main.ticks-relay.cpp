@@ -0,0 +1,119 @@
+// Relay of ticks speaking the hub protocol, for many listeners of a few
+// tick providers. Sinks of the connector register as usual, listeners ask
+// for a provider with AskTicksProvider, as they would ask the hub:
+//
+//   ./ticks-relay --bind 0.0.0.0 --port 9101 --stats 10
+
+#include <iostream>
+#include <stdlib.h>
+#include <signal.h>
+#include <pthread.h>
+
+#include "NixPlatform.h"
+#include "RunLoop.h"
+#include "TicksRelay.h"
+
+struct Options {
+   Options()
+      : address("127.0.0.1")
+      , port(9101)
+      , statsSeconds(0) {}
+
+   std::string address;
+   int port;
+   // zero doesn't print stats
+   int statsSeconds;
+};
+
+static bool parse(int argc, char **argv, Options &options) {
+   for (int i = 1; i < argc; i += 2) {
+      if (i + 1 >= argc) return false;
+
+      const std::string name = argv[i];
+
+      if (name == "--bind") options.address = argv[i + 1];
+      else if (name == "--port") options.port = atoi(argv[i + 1]);
+      else if (name == "--stats") options.statsSeconds = atoi(argv[i + 1]);
+      else return false;
+   }
+
+   return options.port >= 0 && options.statsSeconds >= 0;
+}
+
+static void printStats(const TicksRelay &relay) {
+   const TicksRelay::Stats stats = relay.stats();
+
+   std::cout << "providers: " << stats.providers
+             << ", subscribers: " << stats.subscribers
+             << ", ticks: " << stats.ticks
+             << " (" << stats.ticksLost << " lost)"
+             << ", frames: " << stats.frames << std::endl;
+}
+
+static void postStats(RunLoop &runLoop, const TicksRelay &relay, int seconds) {
+   runLoop.postDelayed(seconds * 1000, [&runLoop, &relay, seconds]() -> void {
+         printStats(relay);
+         postStats(runLoop, relay, seconds);
+      } );
+}
+
+int main(int argc, char **argv) {
+   Options options;
+
+   if (!parse(argc, argv, options)) {
+      std::cerr << "usage: " << argv[0] << " [--bind address] [--port port] [--stats seconds]" << std::endl;
+      return 1;
+   }
+
+   // signals are taken by the thread waiting for them, threads started
+   // later inherit the mask
+   sigset_t signals;
+   sigemptyset(&signals);
+   sigaddset(&signals, SIGINT);
+   sigaddset(&signals, SIGTERM);
+   sigaddset(&signals, SIGPIPE);
+   pthread_sigmask(SIG_BLOCK, &signals, NULL);
+
+   Platform::init(new NixPlatform());
+
+   RunLoop runLoop;
+   TicksRelay *relay = new TicksRelay(runLoop);
+
+   if (!relay->listen(options.address, options.port)) {
+      std::cerr << "can't listen on " << options.address << ":" << options.port << std::endl;
+      delete relay;
+      Platform::cleanup();
+      return 1;
+   }
+
+   std::cout << "listening on " << options.address << ":" << relay->port() << std::endl;
+
+   relay->start();
+
+   if (options.statsSeconds > 0) postStats(runLoop, *relay, options.statsSeconds);
+
+   Thread *waiter = Platform::instance().createThread([&]() -> void {
+         int signal = 0;
+
+         do {
+            sigwait(&signals, &signal);
+         } while (signal == SIGPIPE);
+
+         runLoop.post([&]() -> void {
+               relay->stop();
+               runLoop.terminate();
+            } );
+      } );
+
+   runLoop.run();
+
+   Thread::joinAndDelete(waiter);
+
+   printStats(*relay);
+
+   delete relay;
+
+   Platform::cleanup();
+
+   return 0;
+}
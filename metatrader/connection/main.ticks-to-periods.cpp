@@ -0,0 +1,242 @@
+// Builds periods of several lengths from tick history in one pass, for the
+// hub's tools which read periods.
+//
+//   ./ticks-to-periods EURUSD.ticks.mt.txt EURUSD
+//   ./ticks-to-periods EURUSD.ticks.bin.cache.v3 EURUSD --threads 4
+//   ./ticks-to-periods EURUSD.fxts EURUSD --periods M1,H1,D1
+//
+// Writes EURUSD.M1.txt as the hub's PeriodsText and next to it
+// EURUSD.M1.txt.periods.bin.cache.v3, newer than the text, which the hub
+// reads instead of it.
+
+#include <iostream>
+#include <iomanip>
+#include <vector>
+#include <chrono>
+#include <stdio.h>
+#include <stdlib.h>
+#include <sys/stat.h>
+#include <utime.h>
+
+#include "NixPlatform.h"
+#include "TickStore.h"
+#include "TicksTextParser.h"
+#include "TicksBinaryCache.h"
+#include "TicksToPeriods.h"
+#include "PeriodsText.h"
+#include "PeriodsBinaryCache.h"
+
+struct Options {
+   Options()
+      : threads(1) {}
+
+   std::string input;
+   std::string output;
+   std::vector<int> lengths;
+   int threads;
+};
+
+static bool endsWith(const std::string &value, const std::string &suffix) {
+   return value.size() >= suffix.size()
+      && value.compare(value.size() - suffix.size(), suffix.size(), suffix) == 0;
+}
+
+static int periodLength(const std::string &name) {
+   const int lengths[] = { TicksToPeriods::M1, TicksToPeriods::M5, TicksToPeriods::M15,
+                           TicksToPeriods::M30, TicksToPeriods::H1, TicksToPeriods::H4,
+                           TicksToPeriods::D1 };
+
+   for (int length : lengths) {
+      if (TicksToPeriods::name(length) == name) return length;
+   }
+
+   // length in seconds
+   return atoi(name.c_str());
+}
+
+static bool parse(int argc, char **argv, Options &options) {
+   std::string periods = "M1,M5,M15,M30,H1,H4,D1";
+
+   for (int i = 1; i < argc; ++i) {
+      const std::string name = argv[i];
+
+      if (name[0] != '-') {
+         if (options.input.empty()) options.input = name;
+         else if (options.output.empty()) options.output = name;
+         else return false;
+
+         continue;
+      }
+
+      if (i + 1 >= argc) return false;
+
+      const std::string value = argv[++i];
+
+      if (name == "--threads") options.threads = atoi(value.c_str());
+      else if (name == "--periods") periods = value;
+      else return false;
+   }
+
+   for (size_t start = 0; start <= periods.size(); ) {
+      size_t end = periods.find(',', start);
+      if (end == std::string::npos) end = periods.size();
+
+      const int length = periodLength(periods.substr(start, end - start));
+      if (length <= 0) return false;
+
+      options.lengths.push_back(length);
+      start = end + 1;
+   }
+
+   return !options.input.empty() && !options.output.empty();
+}
+
+static bool load(const Options &options, TicksTextParser::Columns &ticks) {
+   if (endsWith(options.input, ".fxts")) {
+      TickStore *store = TickStore::open(options.input);
+      if (store == nullptr) return false;
+
+      TickStore::Chunk *chunk = new TickStore::Chunk();
+
+      ticks.times.reserve(store->ticks());
+      ticks.prices.reserve(store->ticks());
+
+      for (uint64 i = 0; i < store->chunks(); ++i) {
+         store->decode(i, *chunk);
+
+         ticks.times.insert(ticks.times.end(), chunk->times, chunk->times + chunk->count);
+         ticks.prices.insert(ticks.prices.end(), chunk->prices, chunk->prices + chunk->count);
+      }
+
+      delete chunk;
+      delete store;
+
+      return true;
+   }
+
+   if (endsWith(options.input, ".bin.cache.v3")) {
+      TicksBinaryCache::Reader reader(options.input);
+      if (!reader.isValid()) return false;
+
+      int64 time, price;
+
+      while (reader.next(time, price)) {
+         ticks.times.push_back(time);
+         ticks.prices.push_back(price);
+      }
+
+      return true;
+   }
+
+   return TicksTextParser::parseFile(options.input, options.threads, ticks);
+}
+
+static bool write(const std::string &path, const TicksToPeriods::Periods &periods) {
+   FILE *text = fopen(path.c_str(), "wb");
+
+   if (text == NULL) return false;
+
+   PeriodsBinaryCache::Writer cache(path + ".periods.bin.cache.v3");
+
+   if (!cache.isOpened()) {
+      fclose(text);
+      return false;
+   }
+
+   bool written = fputs(PeriodsText::HEADER, text) >= 0;
+
+   char line[PeriodsText::MAX_LINE_SIZE + 1];
+
+   for (uint64 i = 0; i < periods.size(); ++i) {
+      const int size = PeriodsText::formatLine(line,
+                                               periods.times[i],
+                                               periods.opens[i],
+                                               periods.maxs[i],
+                                               periods.mins[i],
+                                               periods.closes[i]);
+
+      written = fwrite(line, 1, size, text) == (size_t)size && written;
+
+      cache.write(periods.times[i], periods.opens[i], periods.closes[i], periods.mins[i], periods.maxs[i]);
+   }
+
+   written = fclose(text) == 0 && written;
+   written = cache.close() && written;
+
+   // the hub uses cache only if it's newer than the text
+   struct stat status;
+
+   if (written && stat(path.c_str(), &status) == 0) {
+      struct utimbuf times;
+      times.actime = status.st_mtime + 1;
+      times.modtime = status.st_mtime + 1;
+
+      written = utime((path + ".periods.bin.cache.v3").c_str(), &times) == 0;
+   }
+
+   return written;
+}
+
+static double secondsSince(const std::chrono::steady_clock::time_point &start) {
+   return std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+}
+
+int main(int argc, char **argv) {
+   Options options;
+
+   if (!parse(argc, argv, options)) {
+      std::cerr << "usage: " << argv[0] << " ticks.mt.txt|ticks.bin.cache.v3|store.fxts output"
+                << " [--threads n] [--periods M1,M5,H1,...]" << std::endl;
+      return 1;
+   }
+
+   Platform::init(new NixPlatform());
+
+   std::chrono::steady_clock::time_point start = std::chrono::steady_clock::now();
+
+   TicksTextParser::Columns ticks;
+
+   if (!load(options, ticks)) {
+      std::cerr << "can't read " << options.input << std::endl;
+      Platform::cleanup();
+      return 1;
+   }
+
+   const double loading = secondsSince(start);
+
+   start = std::chrono::steady_clock::now();
+
+   std::vector<TicksToPeriods::Periods> periods;
+
+   TicksToPeriods::build(ticks.times.data(),
+                         ticks.prices.data(),
+                         ticks.times.size(),
+                         options.lengths,
+                         options.threads,
+                         periods);
+
+   const double building = secondsSince(start);
+
+   std::cerr << ticks.times.size() << " ticks read in " << std::fixed << std::setprecision(3)
+             << loading << " s, periods built in " << building << " s ("
+             << std::setprecision(1) << (building > 0 ? ticks.times.size() / building / 1e6 : 0)
+             << "M ticks/s)" << std::endl;
+
+   int result = 0;
+
+   for (const TicksToPeriods::Periods &built : periods) {
+      const std::string path = options.output + "." + TicksToPeriods::name(built.length) + ".txt";
+
+      if (!write(path, built)) {
+         std::cerr << "can't write " << path << std::endl;
+         result = 1;
+         continue;
+      }
+
+      std::cerr << path << ": " << built.size() << " periods" << std::endl;
+   }
+
+   Platform::cleanup();
+
+   return result;
+}
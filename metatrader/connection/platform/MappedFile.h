@@ -0,0 +1,21 @@
+#ifndef __6A1F0D3E9B7C4A52B8E4F17D20C5A938_MAPPEDFILE_H_INCLUDED__
+#define __6A1F0D3E9B7C4A52B8E4F17D20C5A938_MAPPEDFILE_H_INCLUDED__
+
+#include "common.h"
+
+/**
+ * File mapped to memory as whole, see Platform::mapFile().
+ */
+class MappedFile {
+public:
+
+   virtual char *data() = 0;
+   virtual uint64 size() = 0;
+
+   // writes changed range to disk, returns when it's written
+   virtual bool flush(uint64 offset, uint64 size) = 0;
+
+   virtual ~MappedFile() {}
+};
+
+#endif 	// __6A1F0D3E9B7C4A52B8E4F17D20C5A938_MAPPEDFILE_H_INCLUDED__
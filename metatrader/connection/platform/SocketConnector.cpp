@@ -0,0 +1,463 @@
+#include "SocketConnector.h"
+#include "platform.h"
+#include <sstream>
+#include <algorithm>
+
+enum {
+   // rfc 8305 recommended connection attempt delay
+   ATTEMPT_DELAY_MS = 250,
+
+   DNS_CACHE_MS = 60000,
+
+   MAX_WAIT_MS = 1000,
+
+   // lookup of a name which doesn't answer shouldn't delay others
+   MAX_RESOLVERS = 4
+};
+
+struct SocketConnector::Attempt {
+   Attempt(AttemptId id,
+           const std::string &address,
+           int port,
+           Milliseconds deadline,
+           const Callback &callback)
+      : id(id)
+      , address(address)
+      , port(port)
+      , deadline(deadline)
+      , callback(callback)
+      , cancelled(false)
+      , completed(false)
+      , resolved(false)
+      , nextCandidate(0)
+      , nextStartAt(0) {}
+
+   const AttemptId id;
+   const std::string address;
+   const int port;
+   const Milliseconds deadline;
+   const Callback callback;
+
+   // guarded by monitor
+   bool cancelled;
+
+   bool completed;
+   bool resolved;
+
+   std::vector<Candidate> candidates;
+   size_t nextCandidate;
+   Milliseconds nextStartAt;
+
+   std::vector<Handle> inFlight;
+};
+
+SocketConnector::SocketConnector()
+   : _monitor(Platform::instance().createMonitor())
+   , _thread(nullptr)
+   , _terminated(false)
+   , _lastId(0)
+   , _runningCallback(0)
+   , _resolverMonitor(Platform::instance().createMonitor())
+   , _idleResolvers(0)
+   , _resolverStopped(false) {
+
+}
+
+SocketConnector::AttemptId SocketConnector::connect(const std::string &address,
+                                                    int port,
+                                                    Milliseconds timeout,
+                                                    const Callback &callback) {
+   const Milliseconds deadline = Platform::instance().currentTime() + timeout;
+
+   _monitor->lock();
+
+   const AttemptId id = ++_lastId;
+
+   _attempts.push_back(new Attempt(id,
+                                   Thread::threadSafeCopy(address),
+                                   port,
+                                   deadline,
+                                   callback));
+
+   const bool wasRunning = ensureThreadStarted();
+
+   _monitor->unlock();
+
+   if (wasRunning) wakeUp();
+
+   return id;
+}
+
+bool SocketConnector::ensureThreadStarted() {
+   if (_thread) return true;
+
+   _thread = Platform::instance().createThread(Platform::instance().threadSpec(Thread::CONNECT),
+                                               std::bind(&SocketConnector::threadMethod,
+                                                         this));
+   return false;
+}
+
+void SocketConnector::cancel(AttemptId id) {
+   _monitor->lock();
+
+   for (Attempt *attempt : _attempts) {
+      if (attempt->id == id) attempt->cancelled = true;
+   }
+
+   while (_runningCallback == id) {
+      _monitor->wait(10);
+   }
+
+   _monitor->unlock();
+
+   wakeUp();
+}
+
+void SocketConnector::terminate() {
+   _monitor->lock();
+   _terminated = true;
+   _monitor->unlock();
+
+   wakeUp();
+
+   Thread::joinAndDelete(_thread);
+
+   _resolverMonitor->lock();
+   _resolverStopped = true;
+   _resolverMonitor->notify();
+   _resolverMonitor->unlock();
+
+   // waits for lookups in progress, if any
+   for (Thread *&resolver : _resolverThreads) {
+      Thread::joinAndDelete(resolver);
+   }
+
+   _resolverThreads.clear();
+
+   for (Attempt *attempt : _attempts) {
+      closeAllHandles(attempt);
+      delete attempt;
+   }
+
+   _attempts.clear();
+}
+
+void SocketConnector::threadMethod() {
+   std::vector<Attempt *> attempts;
+   std::vector<Handle> handles;
+   std::vector<Handle> finished;
+   std::map<Handle, Attempt *> owners;
+
+   while (true) {
+      _monitor->lock();
+
+      if (_terminated) {
+         _monitor->unlock();
+         break;
+      }
+
+      for (auto i = _attempts.begin(); i != _attempts.end(); ) {
+         Attempt *attempt = *i;
+
+         if (attempt->cancelled || attempt->completed) {
+            closeAllHandles(attempt);
+            delete attempt;
+            i = _attempts.erase(i);
+         } else {
+            ++i;
+         }
+      }
+
+      attempts.assign(_attempts.begin(), _attempts.end());
+
+      _monitor->unlock();
+
+      Milliseconds now = Platform::instance().currentTime();
+
+      for (Attempt *attempt : attempts) {
+         processAttempt(attempt, now);
+      }
+
+      now = Platform::instance().currentTime();
+
+      Milliseconds wait = MAX_WAIT_MS;
+
+      handles.clear();
+      owners.clear();
+
+      for (Attempt *attempt : attempts) {
+         if (attempt->completed) continue;
+
+         for (Handle handle : attempt->inFlight) {
+            handles.push_back(handle);
+            owners[handle] = attempt;
+         }
+
+         const Milliseconds wakeAt
+            = attempt->nextCandidate < attempt->candidates.size()
+            ? std::min(attempt->nextStartAt, attempt->deadline)
+            : attempt->deadline;
+
+         const Milliseconds untilWake = wakeAt > now ? wakeAt - now : 0;
+
+         if (untilWake < wait) wait = untilWake;
+      }
+
+      finished.clear();
+
+      waitForAny(handles, wait, finished);
+
+      now = Platform::instance().currentTime();
+
+      for (Handle handle : finished) {
+         Attempt *attempt = owners[handle];
+
+         if (!attempt->completed) onHandleFinished(attempt, handle, now);
+      }
+   }
+}
+
+void SocketConnector::processAttempt(Attempt *attempt, Milliseconds now) {
+   if (!attempt->resolved) {
+      if (isLocalAddress(attempt->address)) {
+         attempt->resolved = true;
+         finish(attempt, connectLocal(attempt->address));
+         return;
+      }
+
+      const Resolution resolution = resolveCached(attempt, now);
+
+      if (resolution == RESOLVING) {
+         if (now >= attempt->deadline) finish(attempt, nullptr);
+         return;
+      }
+
+      attempt->resolved = true;
+
+      if (resolution == RESOLVE_FAILED) {
+         finish(attempt, nullptr);
+         return;
+      }
+   }
+
+   if (now >= attempt->deadline) {
+      closeAllHandles(attempt);
+      finish(attempt, nullptr);
+      return;
+   }
+
+   if (attempt->inFlight.empty() || now >= attempt->nextStartAt) {
+      startNextCandidate(attempt, now);
+   }
+
+   if (attempt->inFlight.empty()) {
+      // all addresses failed, they could be outdated
+      _resolutions.erase(cacheKey(attempt->address, attempt->port));
+
+      finish(attempt, nullptr);
+   }
+}
+
+void SocketConnector::onHandleFinished(Attempt *attempt, Handle handle, Milliseconds now) {
+   attempt->inFlight.erase(std::remove(attempt->inFlight.begin(),
+                                       attempt->inFlight.end(),
+                                       handle),
+                           attempt->inFlight.end());
+
+   if (isConnected(handle)) {
+      closeAllHandles(attempt);
+      finish(attempt, wrap(handle));
+      return;
+   }
+
+   closeHandle(handle);
+
+   // don't wait for attempt delay, previous candidate already failed
+   startNextCandidate(attempt, now);
+
+   if (attempt->inFlight.empty()) {
+      _resolutions.erase(cacheKey(attempt->address, attempt->port));
+
+      finish(attempt, nullptr);
+   }
+}
+
+void SocketConnector::startNextCandidate(Attempt *attempt, Milliseconds now) {
+   while (attempt->nextCandidate < attempt->candidates.size()) {
+      const Handle handle = startConnect(attempt->candidates[attempt->nextCandidate++]);
+
+      if (handle != InvalidHandle) {
+         attempt->inFlight.push_back(handle);
+         attempt->nextStartAt = now + ATTEMPT_DELAY_MS;
+         return;
+      }
+   }
+}
+
+void SocketConnector::closeAllHandles(Attempt *attempt) {
+   for (Handle handle : attempt->inFlight) {
+      closeHandle(handle);
+   }
+
+   attempt->inFlight.clear();
+}
+
+void SocketConnector::finish(Attempt *attempt, Socket *socket) {
+   attempt->completed = true;
+
+   _monitor->lock();
+
+   const bool cancelled = attempt->cancelled;
+
+   if (!cancelled) _runningCallback = attempt->id;
+
+   _monitor->unlock();
+
+   if (cancelled) {
+      if (socket) {
+         socket->close();
+         delete socket;
+      }
+
+      return;
+   }
+
+   attempt->callback(socket);
+
+   _monitor->lock();
+   _runningCallback = 0;
+   _monitor->notify();
+   _monitor->unlock();
+}
+
+std::string SocketConnector::cacheKey(const std::string &address, int port) {
+   std::ostringstream key;
+   key << address << "|" << port;
+   return key.str();
+}
+
+SocketConnector::Resolution SocketConnector::resolveCached(Attempt *attempt, Milliseconds now) {
+   const std::string key = cacheKey(attempt->address, attempt->port);
+
+   auto cached = _resolutions.find(key);
+
+   if (cached != _resolutions.end() && cached->second.expiresAt > now) {
+      attempt->candidates = cached->second.candidates;
+      return RESOLVED;
+   }
+
+   std::vector<Candidate> resolved;
+
+   _resolverMonitor->lock();
+
+   auto found = _lookups.find(key);
+
+   if (found == _lookups.end()) {
+      Lookup &lookup = _lookups[key];
+      lookup.address = attempt->address;
+      lookup.port = attempt->port;
+      lookup.started = false;
+      lookup.done = false;
+      lookup.succeeded = false;
+
+      if (_idleResolvers == 0 && _resolverThreads.size() < MAX_RESOLVERS) {
+         _resolverThreads.push_back(Platform::instance().createThread(Platform::instance().threadSpec(Thread::CONNECT),
+                                                                      std::bind(&SocketConnector::resolverMethod,
+                                                                                this)));
+      }
+
+      _resolverMonitor->notify();
+      _resolverMonitor->unlock();
+
+      return RESOLVING;
+   }
+
+   if (!found->second.done) {
+      _resolverMonitor->unlock();
+      return RESOLVING;
+   }
+
+   // other attempts to the same address find it in cache, or look it up
+   // again if it failed
+   const bool succeeded = found->second.succeeded;
+   resolved.swap(found->second.candidates);
+
+   _lookups.erase(found);
+
+   _resolverMonitor->unlock();
+
+   if (!succeeded || resolved.empty()) return RESOLVE_FAILED;
+
+   // interleave address families, starting from the one resolver
+   // preferred, so broken family costs only attempt delay
+   std::vector<Candidate> preferred;
+   std::vector<Candidate> other;
+
+   for (const Candidate &candidate : resolved) {
+      if (candidate.family == resolved.front().family) preferred.push_back(candidate);
+      else                                             other.push_back(candidate);
+   }
+
+   for (size_t i = 0; i < std::max(preferred.size(), other.size()); ++i) {
+      if (i < preferred.size()) attempt->candidates.push_back(preferred[i]);
+      if (i < other.size())     attempt->candidates.push_back(other[i]);
+   }
+
+   CachedResolution &entry = _resolutions[key];
+   entry.candidates = attempt->candidates;
+   entry.expiresAt = Platform::instance().currentTime() + DNS_CACHE_MS;
+
+   return RESOLVED;
+}
+
+void SocketConnector::resolverMethod() {
+   _resolverMonitor->lock();
+
+   while (!_resolverStopped) {
+      Lookup *next = nullptr;
+
+      for (auto &lookup : _lookups) {
+         if (!lookup.second.started) {
+            next = &lookup.second;
+            break;
+         }
+      }
+
+      if (next == nullptr) {
+         ++_idleResolvers;
+         _resolverMonitor->wait(MAX_WAIT_MS);
+         --_idleResolvers;
+         continue;
+      }
+
+      // connector thread erases only done lookups, so this one stays
+      next->started = true;
+
+      const std::string address = next->address;
+      const int port = next->port;
+
+      _resolverMonitor->unlock();
+
+      std::vector<Candidate> candidates;
+      const bool succeeded = resolve(address, port, candidates);
+
+      _resolverMonitor->lock();
+
+      next->done = true;
+      next->succeeded = succeeded;
+      next->candidates.swap(candidates);
+
+      _resolverMonitor->unlock();
+
+      wakeUp();
+
+      _resolverMonitor->lock();
+   }
+
+   _resolverMonitor->unlock();
+}
+
+SocketConnector::~SocketConnector() {
+   delete _resolverMonitor;
+   delete _monitor;
+}
@@ -0,0 +1,178 @@
+#ifndef __2B5A6FE3DD5B95658C72A83EC7713EEE_SOCKETCONNECTOR_H_INCLUDED__
+#define __2B5A6FE3DD5B95658C72A83EC7713EEE_SOCKETCONNECTOR_H_INCLUDED__
+
+#include <string>
+#include <vector>
+#include <list>
+#include <map>
+#include <functional>
+#include <stdint.h>
+#include "common.h"
+#include "Monitor.h"
+#include "Socket.h"
+#include "Thread.h"
+
+/**
+ * Establishes outgoing connections without thread per connection.
+ *
+ * All attempts are served by one thread, which uses nonblocking connect
+ * and waits for all pending sockets at once. Candidates of different
+ * address families are tried Happy-Eyeballs style (rfc 8305): next
+ * candidate is started if previous one did not succeed during attempt
+ * delay, first connected socket wins and others are closed.
+ *
+ * Names are resolved by a few threads of their own, so slow or failing dns
+ * doesn't hold up other attempts or their timers, attempt waiting for dns
+ * still fails at its deadline. Resolved addresses are cached for some
+ * time, so reconnects don't wait for dns.
+ *
+ * Platform may also support local transports, selected by address scheme
+ * (like "shm://name"), they are connected directly, bypassing dns.
+ *
+ * Platform specific parts are socket primitives, implemented by
+ * subclasses.
+ */
+class SocketConnector {
+   SocketConnector(const SocketConnector &referenceToCopyFrom);
+   void operator=(const SocketConnector &referenceToCopyFrom);
+
+public:
+   typedef uint64 Milliseconds;
+
+   typedef uint64 AttemptId;
+
+   /**
+    * Called on connector's thread, with connected socket or with nullptr
+    * if connection failed. Callback owns the socket.
+    */
+   typedef std::function<void(Socket *)> Callback;
+
+   SocketConnector();
+
+   AttemptId connect(const std::string &address,
+                     int port,
+                     Milliseconds timeout,
+                     const Callback &callback);
+
+   /**
+    * After this returns, callback of the attempt will not be called and is
+    * not running. Should not be called from inside of the callback.
+    */
+   void cancel(AttemptId id);
+
+   virtual ~SocketConnector();
+
+protected:
+
+   typedef intptr_t Handle;
+
+   enum {
+      InvalidHandle = -1
+   };
+
+   struct Candidate {
+      int family;
+      // raw sockaddr of platform
+      std::string address;
+   };
+
+   // should be called by subclass destructor, as thread uses primitives
+   void terminate();
+
+   virtual bool isLocalAddress(const std::string &address) = 0;
+
+   // returns nullptr on failure
+   virtual Socket *connectLocal(const std::string &address) = 0;
+
+   virtual bool resolve(const std::string &address,
+                        int port,
+                        std::vector<Candidate> &output) = 0;
+
+   // starts nonblocking connect, returns InvalidHandle on failure
+   virtual Handle startConnect(const Candidate &candidate) = 0;
+
+   // waits until some of handles finished connecting, timeout passed or
+   // wakeUp called
+   virtual void waitForAny(const std::vector<Handle> &handles,
+                           Milliseconds timeout,
+                           std::vector<Handle> &finished) = 0;
+
+   // checks result of finished connect
+   virtual bool isConnected(Handle handle) = 0;
+
+   // makes socket blocking again and wraps it
+   virtual Socket *wrap(Handle handle) = 0;
+
+   virtual void closeHandle(Handle handle) = 0;
+
+   virtual void wakeUp() = 0;
+
+private:
+
+   struct Attempt;
+
+   struct CachedResolution {
+      std::vector<Candidate> candidates;
+      Milliseconds expiresAt;
+   };
+
+   // of resolver thread, by cache key
+   struct Lookup {
+      std::string address;
+      int port;
+
+      bool started;
+      bool done;
+      bool succeeded;
+      std::vector<Candidate> candidates;
+   };
+
+   enum Resolution {
+      RESOLVED,
+      RESOLVING,
+      RESOLVE_FAILED
+   };
+
+   void threadMethod();
+   void resolverMethod();
+
+   // returns true if thread was already running
+   bool ensureThreadStarted();
+
+   void processAttempt(Attempt *attempt, Milliseconds now);
+   void onHandleFinished(Attempt *attempt, Handle handle, Milliseconds now);
+
+   void startNextCandidate(Attempt *attempt, Milliseconds now);
+   void closeAllHandles(Attempt *attempt);
+   void finish(Attempt *attempt, Socket *socket);
+
+   // candidates from cache, or from lookup of resolver thread
+   Resolution resolveCached(Attempt *attempt, Milliseconds now);
+
+   static std::string cacheKey(const std::string &address, int port);
+
+private:
+
+   Monitor *_monitor;
+   Thread *_thread;
+
+   bool _terminated;
+
+   AttemptId _lastId;
+   AttemptId _runningCallback;
+
+   // guarded by monitor
+   std::list<Attempt *> _attempts;
+
+   // used only from connector's thread
+   std::map<std::string, CachedResolution> _resolutions;
+
+   // lookups are guarded by resolver monitor, own one as it's waited on
+   Monitor *_resolverMonitor;
+   std::vector<Thread *> _resolverThreads;
+   size_t _idleResolvers;
+   bool _resolverStopped;
+   std::map<std::string, Lookup> _lookups;
+};
+
+#endif 	// __2B5A6FE3DD5B95658C72A83EC7713EEE_SOCKETCONNECTOR_H_INCLUDED__
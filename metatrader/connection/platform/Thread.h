@@ -1,13 +1,62 @@
 #ifndef __2B5A6FE3DD5B95658C72A83EC7713EEE_THREAD_H_INCLUDED__
 #define __2B5A6FE3DD5B95658C72A83EC7713EEE_THREAD_H_INCLUDED__
 
+#include "common.h"
 #include <string>
 #include <functional>
+#include <stddef.h>
+
+/**
+ * How thread is created, defaults leave everything to the platform.
+ */
+struct ThreadSpec {
+   enum Priority {
+      LOW,
+      NORMAL,
+      HIGH,
+      // SCHED_FIFO on nix, time critical on windows
+      REALTIME
+   };
+
+   ThreadSpec()
+      : affinity(0)
+      , priority(NORMAL)
+      , stackSize(0)
+      , busyPollMicroseconds(0) {}
+
+   explicit ThreadSpec(const std::string &name)
+      : name(name)
+      , affinity(0)
+      , priority(NORMAL)
+      , stackSize(0)
+      , busyPollMicroseconds(0) {}
+
+   // seen in debuggers and top, cut to 15 characters on nix
+   std::string name;
+   // mask of processors to run on, zero is any
+   uint64 affinity;
+   Priority priority;
+   // zero is default of the platform
+   size_t stackSize;
+   // of run loop the thread runs, see RunLoop::setBusyPoll()
+   uint64 busyPollMicroseconds;
+};
 
 class Thread {
 public:
    typedef std::function<void()> Action;
 
+   // threads of the connector, which are configured by
+   // Platform::configureThreads()
+   enum Role {
+      CT,
+      READ,
+      WRITE,
+      CONNECT,
+
+      ROLES
+   };
+
    Thread(const Action &action) : _action(action) {}
    
    virtual ~Thread() {}
@@ -0,0 +1,140 @@
+#include "NixFutexMonitor.h"
+#include <stdio.h>
+#include <stdlib.h>
+#include <time.h>
+#include <unistd.h>
+#include <linux/futex.h>
+#include <sys/syscall.h>
+
+enum {
+   UNLOCKED,
+   LOCKED,
+   CONTENDED
+};
+
+enum {
+   MIN_SPINS = 10,
+   MAX_SPINS = 200,
+
+   // share of the last spins in the estimate is 1/SPINS_SMOOTHING
+   SPINS_SMOOTHING = 8
+};
+
+static bool isSpinningUseful() {
+   static const bool useful = sysconf(_SC_NPROCESSORS_ONLN) > 1;
+   return useful;
+}
+
+static pid_t currentThread() {
+   static thread_local pid_t thread = syscall(SYS_gettid);
+   return thread;
+}
+
+static inline void relax() {
+#if defined(__x86_64__) || defined(__i386__)
+   __builtin_ia32_pause();
+#else
+   asm volatile("" ::: "memory");
+#endif
+}
+
+static int futex(std::atomic<int> &word, int operation, int value, const timespec *timeout) {
+   return syscall(SYS_futex, (int *)&word, operation | FUTEX_PRIVATE_FLAG, value, timeout, NULL, 0);
+}
+
+NixFutexMonitor::NixFutexMonitor()
+   : _state(UNLOCKED)
+   , _sequence(0)
+   , _waiters(0)
+   , _spins(MIN_SPINS)
+   , _owner(0) {
+
+}
+
+void NixFutexMonitor::lock() {
+   const pid_t thread = currentThread();
+
+   if (_owner.load(std::memory_order_relaxed) == thread) {
+      printf("monitor %p is locked again by its owner, thread %d\n", (void *)this, (int)thread);
+      fflush(stdout);
+      abort();
+   }
+
+   int expected = UNLOCKED;
+
+   if (!_state.compare_exchange_strong(expected, LOCKED, std::memory_order_acquire)) lockContended();
+
+   _owner.store(thread, std::memory_order_relaxed);
+}
+
+void NixFutexMonitor::lockContended() {
+   if (isSpinningUseful()) {
+      const int estimate = _spins.load(std::memory_order_relaxed);
+      const int limit = estimate * 2 + MIN_SPINS < MAX_SPINS ? estimate * 2 + MIN_SPINS : MAX_SPINS;
+
+      for (int spins = 0; spins < limit; ++spins) {
+         relax();
+
+         int expected = UNLOCKED;
+
+         if (_state.load(std::memory_order_relaxed) == UNLOCKED
+             && _state.compare_exchange_weak(expected, LOCKED, std::memory_order_acquire)) {
+            _spins.store(estimate + (spins - estimate) / SPINS_SMOOTHING, std::memory_order_relaxed);
+            return;
+         }
+      }
+
+      _spins.store(estimate + (limit - estimate) / SPINS_SMOOTHING, std::memory_order_relaxed);
+   }
+
+   // whoever unlocks then wakes one of the sleeping
+   while (_state.exchange(CONTENDED, std::memory_order_acquire) != UNLOCKED) {
+      futex(_state, FUTEX_WAIT, CONTENDED, NULL);
+   }
+}
+
+void NixFutexMonitor::unlock() {
+   _owner.store(0, std::memory_order_relaxed);
+
+   if (_state.exchange(UNLOCKED, std::memory_order_release) == CONTENDED) {
+      futex(_state, FUTEX_WAKE, 1, NULL);
+   }
+}
+
+void NixFutexMonitor::waitFor(const timespec *timeout) {
+   ++_waiters;
+
+   const int sequence = _sequence.load();
+
+   unlock();
+
+   // returns at once if notified after the sequence was read
+   futex(_sequence, FUTEX_WAIT, sequence, timeout);
+
+   lock();
+
+   --_waiters;
+}
+
+void NixFutexMonitor::wait() {
+   waitFor(NULL);
+}
+
+void NixFutexMonitor::wait(uint64 milliseconds) {
+   // relative, so it's on monotonic clock
+   timespec timeout;
+   timeout.tv_sec = milliseconds / 1000;
+   timeout.tv_nsec = (milliseconds % 1000) * 1000000L;
+
+   waitFor(&timeout);
+}
+
+void NixFutexMonitor::notify() {
+   ++_sequence;
+
+   if (_waiters.load() > 0) futex(_sequence, FUTEX_WAKE, 1, NULL);
+}
+
+NixFutexMonitor::~NixFutexMonitor() {
+
+}
@@ -0,0 +1,48 @@
+#ifndef __3F0C6B1D8E2A4957B6D1C0E7A59F2B84_NIXFUTEXMONITOR_H_INCLUDED__
+#define __3F0C6B1D8E2A4957B6D1C0E7A59F2B84_NIXFUTEXMONITOR_H_INCLUDED__
+
+#include <atomic>
+#include <sys/types.h>
+#include "platform.h"
+
+/**
+ * Non recursive monitor on futexes: lock spins for a while, as locks of
+ * the connector are short, then sleeps. Spinning adapts to how long the
+ * lock was waited for lately, there's no spinning on one processor.
+ * Recursive locking is a bug, it's reported and aborts.
+ */
+class NixFutexMonitor : public Monitor {
+   NixFutexMonitor(const NixFutexMonitor &referenceToCopyFrom);
+   void operator=(const NixFutexMonitor &referenceToCopyFrom);
+
+public:
+   NixFutexMonitor();
+
+   void lock();
+   void unlock();
+
+   void wait();
+   void wait(uint64 milliseconds);
+   void notify();
+
+   ~NixFutexMonitor();
+
+private:
+
+   void lockContended();
+   void waitFor(const timespec *timeout);
+
+   // UNLOCKED, LOCKED or CONTENDED, when someone may sleep in lock
+   std::atomic<int> _state;
+
+   // changed by notify, waiting threads sleep on it
+   std::atomic<int> _sequence;
+   std::atomic<int> _waiters;
+
+   // spins lock took lately, only a hint
+   std::atomic<int> _spins;
+
+   std::atomic<pid_t> _owner;
+};
+
+#endif 	// __3F0C6B1D8E2A4957B6D1C0E7A59F2B84_NIXFUTEXMONITOR_H_INCLUDED__
@@ -0,0 +1,66 @@
+#include "NixMappedFile.h"
+#include <fcntl.h>
+#include <unistd.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+
+NixMappedFile *NixMappedFile::open(const std::string &path, uint64 size, bool writable) {
+   const int fd = writable
+      ? ::open(path.c_str(), O_RDWR | O_CREAT | O_CLOEXEC, 0644)
+      : ::open(path.c_str(), O_RDONLY | O_CLOEXEC);
+
+   if (fd < 0) return nullptr;
+
+   struct stat status;
+
+   if (fstat(fd, &status) != 0) {
+      close(fd);
+      return nullptr;
+   }
+
+   if (writable && (uint64)status.st_size < size) {
+      // blocks are allocated now, not when pages are dirtied
+      if (posix_fallocate(fd, 0, size) != 0 && ftruncate(fd, size) != 0) {
+         close(fd);
+         return nullptr;
+      }
+   } else {
+      size = status.st_size;
+   }
+
+   if (size == 0) {
+      close(fd);
+      return nullptr;
+   }
+
+   void *data = mmap(NULL,
+                     size,
+                     writable ? PROT_READ | PROT_WRITE : PROT_READ,
+                     MAP_SHARED,
+                     fd,
+                     0);
+
+   // mapping keeps the file
+   close(fd);
+
+   if (data == MAP_FAILED) return nullptr;
+
+   return new NixMappedFile((char *)data, size);
+}
+
+NixMappedFile::NixMappedFile(char *data, uint64 size)
+   : _data(data)
+   , _size(size) {
+
+}
+
+bool NixMappedFile::flush(uint64 offset, uint64 size) {
+   const uint64 page = sysconf(_SC_PAGESIZE);
+   const uint64 start = offset / page * page;
+
+   return msync(_data + start, offset + size - start, MS_SYNC) == 0;
+}
+
+NixMappedFile::~NixMappedFile() {
+   munmap(_data, _size);
+}
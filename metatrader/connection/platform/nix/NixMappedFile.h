@@ -0,0 +1,31 @@
+#ifndef __6A1F0D3E9B7C4A52B8E4F17D20C5A938_NIXMAPPEDFILE_H_INCLUDED__
+#define __6A1F0D3E9B7C4A52B8E4F17D20C5A938_NIXMAPPEDFILE_H_INCLUDED__
+
+#include <string>
+#include "MappedFile.h"
+
+class NixMappedFile : public MappedFile {
+   NixMappedFile(const NixMappedFile &referenceToCopyFrom);
+   void operator=(const NixMappedFile &referenceToCopyFrom);
+
+public:
+
+   // nullptr if file can't be opened or mapped
+   static NixMappedFile *open(const std::string &path, uint64 size, bool writable);
+
+   char *data() { return _data; }
+   uint64 size() { return _size; }
+
+   bool flush(uint64 offset, uint64 size);
+
+   ~NixMappedFile();
+
+private:
+   NixMappedFile(char *data, uint64 size);
+
+private:
+   char *_data;
+   uint64 _size;
+};
+
+#endif 	// __6A1F0D3E9B7C4A52B8E4F17D20C5A938_NIXMAPPEDFILE_H_INCLUDED__
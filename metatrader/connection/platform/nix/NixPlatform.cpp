@@ -3,11 +3,15 @@
 #include <sys/time.h>
 
 #include "NixThread.h"
-#include "NixMonitor.h"
+#include "NixFutexMonitor.h"
 #include "NixSocket.h"
+#include "NixSocketConnector.h"
+#include "NixMappedFile.h"
 
 #include <arpa/inet.h>
 #include <unistd.h>
+#include <errno.h>
+#include <sys/stat.h>
 
 #include <endian.h>
 
@@ -19,20 +23,41 @@ Socket *NixPlatform::createSocket() {
    return new NixSocket();
 } 
 
+SocketConnector *NixPlatform::createSocketConnector() {
+   return new NixSocketConnector();
+}
+
 Monitor *NixPlatform::createMonitor() {
-   return new NixMonitor();
+   return new NixFutexMonitor();
 } 
 
 Thread *NixPlatform::createThread(const Thread::Action &action) {
    return new NixThread(action);
 } 
 
+Thread *NixPlatform::createThread(const ThreadSpec &spec, const Thread::Action &action) {
+   return new NixThread(spec, action);
+}
+
 Platform::Milliseconds NixPlatform::currentTime() {
    timeval currentTime;
 
    gettimeofday(&currentTime, NULL);
 
-   return currentTime.tv_sec * 1000L + currentTime.tv_usec / 1000L;
+   // long is 32 bits on windows and i686, seconds in milliseconds aren't
+   return (uint64)currentTime.tv_sec * 1000 + currentTime.tv_usec / 1000;
+}
+
+MappedFile *NixPlatform::mapFile(const std::string &path, uint64 size) {
+   return NixMappedFile::open(path, size, true);
+}
+
+MappedFile *NixPlatform::mapFileForReading(const std::string &path) {
+   return NixMappedFile::open(path, 0, false);
+}
+
+bool NixPlatform::createDirectory(const std::string &path) {
+   return mkdir(path.c_str(), 0755) == 0 || errno == EEXIST;
 }
 
 void NixPlatform::sleep(const Milliseconds time) {
@@ -50,7 +75,14 @@ void NixPlatform::sleep(const Milliseconds time) {
    } 
 } 
 
-int NixPlatform::htonl(int i) {
+int NixPlatform::processorsCount() {
+   const long count = sysconf(_SC_NPROCESSORS_ONLN);
+   return count > 0 ? (int)count : 1;
+}
+
+// names are in parentheses, because with optimization glibc defines htonl
+// and ntohl as macros
+int (NixPlatform::htonl)(int i) {
    return ::htonl(i);
 }
 
@@ -58,7 +90,7 @@ uint64 NixPlatform::htonll(uint64 i) {
    return ::htobe64(i);
 } 
 
-int NixPlatform::ntohl(int i) {
+int (NixPlatform::ntohl)(int i) {
    return ::ntohl(i);
 }
 
@@ -14,11 +14,18 @@ public:
    virtual Monitor *createMonitor();
 
    virtual Thread *createThread(const Thread::Action &action);
+   virtual Thread *createThread(const ThreadSpec &spec, const Thread::Action &action) override;
 
    virtual Milliseconds currentTime() override;
 
+   virtual MappedFile *mapFile(const std::string &path, uint64 size) override;
+   virtual MappedFile *mapFileForReading(const std::string &path) override;
+   virtual bool createDirectory(const std::string &path) override;
+
    virtual void sleep(const Milliseconds time) override;
 
+   virtual int processorsCount() override;
+
    virtual int htonl(int );
    virtual uint64 htonll(uint64 );
 
@@ -27,6 +34,10 @@ public:
 
    virtual ~NixPlatform();
 
+protected:
+
+   virtual SocketConnector *createSocketConnector();
+
 private:
    
 };
@@ -0,0 +1,356 @@
+#include "NixShmSocket.h"
+#include <memory.h>
+#include <stddef.h>
+#include <unistd.h>
+#include <poll.h>
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <sys/socket.h>
+#include <sys/un.h>
+#include <sys/eventfd.h>
+#include <algorithm>
+
+enum {
+   RING_SIZE = 1 << 20,
+   RING_MASK = RING_SIZE - 1,
+   CACHE_LINE = 64
+};
+
+struct NixShmSocket::Ring {
+   std::atomic<uint64_t> head;
+   char padding0[CACHE_LINE - sizeof(std::atomic<uint64_t>)];
+
+   std::atomic<uint64_t> tail;
+   char padding1[CACHE_LINE - sizeof(std::atomic<uint64_t>)];
+
+   std::atomic<uint32_t> readerWaiting;
+   std::atomic<uint32_t> writerWaiting;
+   char padding2[CACHE_LINE - 2 * sizeof(std::atomic<uint32_t>)];
+};
+
+const size_t NixShmSocket::MAPPING_SIZE = 2 * sizeof(NixShmSocket::Ring) + 2 * RING_SIZE;
+
+const std::string NixShmSocket::SCHEME = "shm://";
+
+bool NixShmSocket::isShmAddress(const std::string &address) {
+   return address.compare(0, SCHEME.size(), SCHEME) == 0;
+}
+
+std::string NixShmSocket::channelName(const std::string &address) {
+   return "forex-shm/" + address.substr(SCHEME.size());
+}
+
+static bool fillAddress(const std::string &name, sockaddr_un &address, socklen_t &size) {
+   memset(&address, 0, sizeof(address));
+   address.sun_family = AF_UNIX;
+
+   // abstract namespace: leading zero byte, nothing left in file system
+   if (name.size() + 1 > sizeof(address.sun_path)) return false;
+
+   memcpy(address.sun_path + 1, name.data(), name.size());
+
+   size = offsetof(sockaddr_un, sun_path) + 1 + name.size();
+
+   return true;
+}
+
+int NixShmSocket::listen(const std::string &address) {
+   sockaddr_un socketAddress;
+   socklen_t size;
+
+   if (!isShmAddress(address) || !fillAddress(channelName(address), socketAddress, size)) return -1;
+
+   const int listener = socket(AF_UNIX, SOCK_STREAM | SOCK_CLOEXEC, 0);
+
+   if (listener < 0) return -1;
+
+   if (bind(listener, (sockaddr *)&socketAddress, size) != 0
+       || ::listen(listener, 16) != 0) {
+      ::close(listener);
+      return -1;
+   }
+
+   return listener;
+}
+
+NixShmSocket *NixShmSocket::connectTo(const std::string &address) {
+   sockaddr_un socketAddress;
+   socklen_t size;
+
+   if (!isShmAddress(address) || !fillAddress(channelName(address), socketAddress, size)) return nullptr;
+
+   int descriptors[1 + EventsCount];
+
+   const int memory = memfd_create("forex-shm", MFD_CLOEXEC | MFD_ALLOW_SEALING);
+
+   if (memory < 0) return nullptr;
+
+   descriptors[0] = memory;
+
+   for (int i = 0; i < EventsCount; ++i) {
+      descriptors[i + 1] = eventfd(0, EFD_NONBLOCK | EFD_CLOEXEC);
+   }
+
+   const int control = socket(AF_UNIX, SOCK_STREAM | SOCK_CLOEXEC, 0);
+
+   bool success
+      = control >= 0
+      && ftruncate(memory, MAPPING_SIZE) == 0
+      // accepting side checks that size of memory can't change, see accept()
+      && fcntl(memory, F_ADD_SEALS, F_SEAL_SHRINK | F_SEAL_GROW | F_SEAL_SEAL) == 0
+      && ::connect(control, (sockaddr *)&socketAddress, size) == 0;
+
+   for (int i = 0; i < EventsCount; ++i) {
+      success = success && descriptors[i + 1] >= 0;
+   }
+
+   if (success) {
+      char marker = 0;
+      iovec payload = { &marker, 1 };
+
+      char controlBuffer[CMSG_SPACE(sizeof(descriptors))];
+      memset(controlBuffer, 0, sizeof(controlBuffer));
+
+      msghdr message;
+      memset(&message, 0, sizeof(message));
+      message.msg_iov = &payload;
+      message.msg_iovlen = 1;
+      message.msg_control = controlBuffer;
+      message.msg_controllen = sizeof(controlBuffer);
+
+      cmsghdr *header = CMSG_FIRSTHDR(&message);
+      header->cmsg_level = SOL_SOCKET;
+      header->cmsg_type = SCM_RIGHTS;
+      header->cmsg_len = CMSG_LEN(sizeof(descriptors));
+      memcpy(CMSG_DATA(header), descriptors, sizeof(descriptors));
+
+      success = sendmsg(control, &message, MSG_NOSIGNAL) == 1;
+   }
+
+   if (!success) {
+      for (int descriptor : descriptors) {
+         if (descriptor >= 0) ::close(descriptor);
+      }
+
+      if (control >= 0) ::close(control);
+
+      return nullptr;
+   }
+
+   return new NixShmSocket(control, memory, descriptors + 1, false);
+}
+
+NixShmSocket *NixShmSocket::accept(int listener) {
+   const int control = accept4(listener, NULL, NULL, SOCK_CLOEXEC);
+
+   if (control < 0) return nullptr;
+
+   int descriptors[1 + EventsCount];
+
+   char marker;
+   iovec payload = { &marker, 1 };
+
+   char controlBuffer[CMSG_SPACE(sizeof(descriptors))];
+
+   msghdr message;
+   memset(&message, 0, sizeof(message));
+   message.msg_iov = &payload;
+   message.msg_iovlen = 1;
+   message.msg_control = controlBuffer;
+   message.msg_controllen = sizeof(controlBuffer);
+
+   const bool received = recvmsg(control, &message, MSG_CMSG_CLOEXEC) == 1;
+
+   cmsghdr *header = received ? CMSG_FIRSTHDR(&message) : NULL;
+
+   if (header == NULL
+       || header->cmsg_type != SCM_RIGHTS
+       || header->cmsg_len != CMSG_LEN(sizeof(descriptors))) {
+      ::close(control);
+      return nullptr;
+   }
+
+   memcpy(descriptors, CMSG_DATA(header), sizeof(descriptors));
+
+   // rings are accessed without checks, so memory of a truncated or hostile
+   // peer would be SIGBUS on first access: it should have the whole mapping
+   // and be sealed against shrinking
+   struct stat memory;
+   const int seals = fcntl(descriptors[0], F_GET_SEALS);
+
+   if (fstat(descriptors[0], &memory) != 0
+       || (uint64_t)memory.st_size < MAPPING_SIZE
+       || seals < 0
+       || (seals & F_SEAL_SHRINK) == 0) {
+      for (int descriptor : descriptors) ::close(descriptor);
+      ::close(control);
+      return nullptr;
+   }
+
+   return new NixShmSocket(control, descriptors[0], descriptors + 1, true);
+}
+
+NixShmSocket::NixShmSocket(int control,
+                           int memory,
+                           const int *events,
+                           bool isListeningSide)
+   : _control(control)
+   , _memory(memory)
+   , _mapping(mmap(NULL, MAPPING_SIZE, PROT_READ | PROT_WRITE, MAP_SHARED, memory, 0))
+   , _closed(_mapping == MAP_FAILED) {
+
+   // events are passed as data and space doorbells of the ring from
+   // connecting side, then of the ring to it
+   const int first = isListeningSide ? 0 : 2;
+   const int second = isListeningSide ? 2 : 0;
+
+   _events[EventInData] = events[first];
+   _events[EventInSpace] = events[first + 1];
+   _events[EventOutData] = events[second];
+   _events[EventOutSpace] = events[second + 1];
+
+   if (_mapping == MAP_FAILED) {
+      _mapping = NULL;
+      _in = _out = NULL;
+      _inData = _outData = NULL;
+      return;
+   }
+
+   Ring *rings = (Ring *)_mapping;
+   char *data = (char *)(rings + 2);
+
+   const int inIndex = isListeningSide ? 0 : 1;
+   const int outIndex = 1 - inIndex;
+
+   _in = rings + inIndex;
+   _out = rings + outIndex;
+   _inData = data + inIndex * RING_SIZE;
+   _outData = data + outIndex * RING_SIZE;
+}
+
+bool NixShmSocket::waitFor(int event) {
+   Ring *ring = event == EventInData ? _in : _out;
+   std::atomic<uint32_t> &flag = event == EventInData ? ring->readerWaiting : ring->writerWaiting;
+
+   auto ready = [ring, event]() -> bool {
+      const uint64_t used = ring->head.load() - ring->tail.load();
+      return event == EventInData ? used > 0 : used < RING_SIZE;
+   };
+
+   flag.store(1);
+
+   // other side could change ring before it saw the flag
+   if (ready()) {
+      flag.store(0);
+      return true;
+   }
+
+   pollfd descriptors[2];
+   descriptors[0].fd = _events[event];
+   descriptors[0].events = POLLIN;
+   descriptors[1].fd = _control;
+   descriptors[1].events = POLLIN | POLLRDHUP;
+
+   poll(descriptors, 2, -1);
+
+   flag.store(0);
+
+   if (descriptors[0].revents) {
+      eventfd_t value;
+      eventfd_read(_events[event], &value);
+   }
+
+   if (_closed) return false;
+
+   if (descriptors[1].revents) {
+      // peer is gone, but still deliver what it managed to write
+      return event == EventInData && ready();
+   }
+
+   return true;
+}
+
+bool NixShmSocket::read(std::string &outputBuffer, int count) {
+   outputBuffer.resize(count);
+
+   int offset = 0;
+
+   while (offset < count) {
+      if (_closed) return false;
+
+      const uint64_t tail = _in->tail.load(std::memory_order_relaxed);
+      const uint64_t available = _in->head.load(std::memory_order_acquire) - tail;
+
+      if (available == 0) {
+         if (!waitFor(EventInData)) return false;
+         continue;
+      }
+
+      const size_t size = std::min<uint64_t>(available, count - offset);
+      const size_t start = tail & RING_MASK;
+      const size_t firstPart = std::min<size_t>(size, RING_SIZE - start);
+
+      memcpy(&outputBuffer[offset], _inData + start, firstPart);
+      memcpy(&outputBuffer[offset + firstPart], _inData, size - firstPart);
+
+      _in->tail.store(tail + size);
+
+      if (_in->writerWaiting.exchange(0)) eventfd_write(_events[EventInSpace], 1);
+
+      offset += size;
+   }
+
+   return true;
+}
+
+bool NixShmSocket::write(const std::string &buffer) {
+   size_t offset = 0;
+
+   while (offset < buffer.size()) {
+      if (_closed) return false;
+
+      const uint64_t head = _out->head.load(std::memory_order_relaxed);
+      const uint64_t space = RING_SIZE - (head - _out->tail.load(std::memory_order_acquire));
+
+      if (space == 0) {
+         if (!waitFor(EventOutSpace)) return false;
+         continue;
+      }
+
+      const size_t size = std::min<uint64_t>(space, buffer.size() - offset);
+      const size_t start = head & RING_MASK;
+      const size_t firstPart = std::min<size_t>(size, RING_SIZE - start);
+
+      memcpy(_outData + start, buffer.data() + offset, firstPart);
+      memcpy(_outData, buffer.data() + offset + firstPart, size - firstPart);
+
+      _out->head.store(head + size);
+
+      if (_out->readerWaiting.exchange(0)) eventfd_write(_events[EventOutData], 1);
+
+      offset += size;
+   }
+
+   return true;
+}
+
+void NixShmSocket::close() {
+   if (_closed.exchange(true)) return;
+
+   // wakes up own threads waiting in poll and tells peer we are gone
+   shutdown(_control, SHUT_RDWR);
+}
+
+NixShmSocket::~NixShmSocket() {
+   close();
+
+   if (_mapping) munmap(_mapping, MAPPING_SIZE);
+
+   for (int event : _events) {
+      if (event >= 0) ::close(event);
+   }
+
+   ::close(_memory);
+   ::close(_control);
+}
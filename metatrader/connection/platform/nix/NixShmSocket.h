@@ -0,0 +1,90 @@
+#ifndef __CD021F925D4953D69758BEA97E0C4F76_NIXSHMSOCKET_H_INCLUDED__
+#define __CD021F925D4953D69758BEA97E0C4F76_NIXSHMSOCKET_H_INCLUDED__
+
+#include "Socket.h"
+#include <string>
+#include <atomic>
+#include <stdint.h>
+
+/**
+ * Same host transport: a pair of single producer single consumer byte
+ * rings in shared memory, one for every direction, with eventfd doorbells.
+ *
+ * Connecting side creates memfd and eventfds and passes them to the
+ * listening side over unix socket (abstract name derived from channel
+ * name). Unix socket stays open as the control channel: when it is closed
+ * or shut down, other side sees end of stream.
+ *
+ * Doorbell is rung only if other side announced it is going to sleep, so
+ * under load data passes without any syscalls.
+ */
+class NixShmSocket : public Socket {
+   NixShmSocket(const NixShmSocket &referenceToCopyFrom);
+   void operator=(const NixShmSocket &referenceToCopyFrom);
+
+public:
+
+   static const std::string SCHEME;
+
+   static bool isShmAddress(const std::string &address);
+
+   // returns nullptr if connection failed
+   static NixShmSocket *connectTo(const std::string &address);
+
+   // accepts connection on listening socket returned by listen()
+   static NixShmSocket *accept(int listener);
+
+   // returns listening socket for name or -1
+   static int listen(const std::string &address);
+
+   // sockets are created connected
+   bool connect(const std::string &address,
+                int port) { return false; }
+
+   bool read(std::string& buffer, int count);
+   bool write(const std::string& buffer);
+
+   void close();
+
+   ~NixShmSocket();
+
+private:
+
+   struct Ring;
+
+   static const size_t MAPPING_SIZE;
+
+   enum {
+      EventInData,
+      EventInSpace,
+      EventOutData,
+      EventOutSpace,
+      EventsCount
+   };
+
+   NixShmSocket(int control,
+                int memory,
+                const int *events,
+                bool isListeningSide);
+
+   bool waitFor(int event);
+
+   static std::string channelName(const std::string &address);
+
+private:
+   const int _control;
+   const int _memory;
+   int _events[EventsCount];
+
+   void *_mapping;
+
+   Ring *_in;
+   Ring *_out;
+
+   char *_inData;
+   char *_outData;
+
+   std::atomic<bool> _closed;
+};
+
+#endif 	// __CD021F925D4953D69758BEA97E0C4F76_NIXSHMSOCKET_H_INCLUDED__
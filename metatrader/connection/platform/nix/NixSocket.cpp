@@ -9,6 +9,11 @@ NixSocket::NixSocket() {
    _socket = socket(AF_INET, SOCK_STREAM, 0);
 }
 
+NixSocket::NixSocket(int socket)
+   : _socket(socket) {
+
+}
+
 bool NixSocket::connect(const std::string &address,
                         int port) {
 
@@ -90,15 +95,20 @@ bool NixSocket::write(const std::string& buffer) {
       if (sent <= 0) return false;
 
       leftToSend -= sent;
+      offset += sent;
    }
 
    return true;
 }
 
 void NixSocket::close() {
-   ::close(_socket);
+   // close alone doesn't wake up threads blocked in recv on the socket;
+   // descriptor is released only in destructor, when no thread can use it,
+   // otherwise its number could be reused by a new connection and read by
+   // thread of the closed one
+   shutdown(_socket, SHUT_RDWR);
 }
 
 NixSocket::~NixSocket() {
-   // should be cleaned up in close
+   if (_socket >= 0) ::close(_socket);
 }
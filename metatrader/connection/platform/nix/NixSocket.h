@@ -8,6 +8,9 @@ class NixSocket : public Socket {
 public:
 
    NixSocket();
+
+   // wraps already connected socket
+   NixSocket(int socket);
    
    bool connect(const std::string &address,
                 int port);
@@ -0,0 +1,130 @@
+#include "NixSocketConnector.h"
+#include "NixSocket.h"
+#include "NixShmSocket.h"
+#include <memory.h>
+#include <unistd.h>
+#include <fcntl.h>
+#include <errno.h>
+#include <poll.h>
+#include <sys/types.h>
+#include <sys/socket.h>
+#include <sys/eventfd.h>
+#include <netdb.h>
+#include <stdio.h>
+
+NixSocketConnector::NixSocketConnector()
+   : _wakeUpEvent(eventfd(0, EFD_NONBLOCK)) {
+
+}
+
+bool NixSocketConnector::isLocalAddress(const std::string &address) {
+   return NixShmSocket::isShmAddress(address);
+}
+
+Socket *NixSocketConnector::connectLocal(const std::string &address) {
+   return NixShmSocket::connectTo(address);
+}
+
+bool NixSocketConnector::resolve(const std::string &address,
+                                 int port,
+                                 std::vector<Candidate> &output) {
+   struct addrinfo hints;
+   addrinfo *info;
+
+   memset(&hints, 0, sizeof(struct addrinfo));
+   hints.ai_family = AF_UNSPEC;
+   hints.ai_socktype = SOCK_STREAM;
+   hints.ai_flags = AI_ADDRCONFIG;
+
+   char service[16];
+   snprintf(service, sizeof(service), "%d", port);
+
+   if (getaddrinfo(address.c_str(), service, &hints, &info) != 0) return false;
+
+   for (addrinfo *i = info; i != NULL; i = i->ai_next) {
+      Candidate candidate;
+      candidate.family = i->ai_family;
+      candidate.address.assign((const char *)i->ai_addr,
+                               i->ai_addrlen);
+
+      output.push_back(candidate);
+   }
+
+   freeaddrinfo(info);
+
+   return true;
+}
+
+SocketConnector::Handle NixSocketConnector::startConnect(const Candidate &candidate) {
+   const int handle = socket(candidate.family,
+                             SOCK_STREAM | SOCK_NONBLOCK | SOCK_CLOEXEC,
+                             0);
+
+   if (handle < 0) return InvalidHandle;
+
+   const int result = ::connect(handle,
+                                (const sockaddr *)candidate.address.data(),
+                                candidate.address.size());
+
+   if (result != 0 && errno != EINPROGRESS) {
+      ::close(handle);
+      return InvalidHandle;
+   }
+
+   return handle;
+}
+
+void NixSocketConnector::waitForAny(const std::vector<Handle> &handles,
+                                    Milliseconds timeout,
+                                    std::vector<Handle> &finished) {
+   std::vector<pollfd> descriptors(handles.size() + 1);
+
+   descriptors[0].fd = _wakeUpEvent;
+   descriptors[0].events = POLLIN;
+
+   for (size_t i = 0; i < handles.size(); ++i) {
+      descriptors[i + 1].fd = handles[i];
+      descriptors[i + 1].events = POLLOUT;
+   }
+
+   if (poll(descriptors.data(), descriptors.size(), timeout) <= 0) return;
+
+   if (descriptors[0].revents) {
+      eventfd_t value;
+      eventfd_read(_wakeUpEvent, &value);
+   }
+
+   for (size_t i = 1; i < descriptors.size(); ++i) {
+      if (descriptors[i].revents) finished.push_back(descriptors[i].fd);
+   }
+}
+
+bool NixSocketConnector::isConnected(Handle handle) {
+   int error = 0;
+   socklen_t size = sizeof(error);
+
+   if (getsockopt(handle, SOL_SOCKET, SO_ERROR, &error, &size) != 0) return false;
+
+   return error == 0;
+}
+
+Socket *NixSocketConnector::wrap(Handle handle) {
+   const int flags = fcntl(handle, F_GETFL);
+   fcntl(handle, F_SETFL, flags & ~O_NONBLOCK);
+
+   return new NixSocket(handle);
+}
+
+void NixSocketConnector::closeHandle(Handle handle) {
+   ::close(handle);
+}
+
+void NixSocketConnector::wakeUp() {
+   eventfd_write(_wakeUpEvent, 1);
+}
+
+NixSocketConnector::~NixSocketConnector() {
+   terminate();
+
+   ::close(_wakeUpEvent);
+}
@@ -0,0 +1,40 @@
+#ifndef __CD021F925D4953D69758BEA97E0C4F76_NIXSOCKETCONNECTOR_H_INCLUDED__
+#define __CD021F925D4953D69758BEA97E0C4F76_NIXSOCKETCONNECTOR_H_INCLUDED__
+
+#include "SocketConnector.h"
+
+class NixSocketConnector : public SocketConnector {
+public:
+   NixSocketConnector();
+
+   ~NixSocketConnector();
+
+protected:
+
+   bool isLocalAddress(const std::string &address);
+
+   Socket *connectLocal(const std::string &address);
+
+   bool resolve(const std::string &address,
+                int port,
+                std::vector<Candidate> &output);
+
+   Handle startConnect(const Candidate &candidate);
+
+   void waitForAny(const std::vector<Handle> &handles,
+                   Milliseconds timeout,
+                   std::vector<Handle> &finished);
+
+   bool isConnected(Handle handle);
+
+   Socket *wrap(Handle handle);
+
+   void closeHandle(Handle handle);
+
+   void wakeUp();
+
+private:
+   int _wakeUpEvent;
+};
+
+#endif 	// __CD021F925D4953D69758BEA97E0C4F76_NIXSOCKETCONNECTOR_H_INCLUDED__
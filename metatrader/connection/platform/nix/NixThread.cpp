@@ -1,17 +1,100 @@
 #include "NixThread.h"
+#include <stdio.h>
+#include <sched.h>
+#include <unistd.h>
+#include <sys/resource.h>
+#include <sys/syscall.h>
+
+enum {
+   // nice of low and high priorities, high one needs CAP_SYS_NICE
+   NICE_LOW = 10,
+   NICE_HIGH = -10,
+
+   // pthread names are limited to 16 bytes with zero
+   NAME_LENGTH = 15
+};
 
 NixThread::NixThread(const Action &action)
-   : Thread(action) {
+   : NixThread(ThreadSpec(), action) {
+
+}
+
+NixThread::NixThread(const ThreadSpec &spec, const Action &action)
+   : Thread(action)
+   , _spec(spec) {
 
    pthread_attr_init(&_attr);
    pthread_attr_setdetachstate(&_attr, PTHREAD_CREATE_JOINABLE);
+
+   // threads don't inherit realtime policy of threads which create them
+   sched_param parameters;
+   parameters.sched_priority = 0;
+
+   pthread_attr_setinheritsched(&_attr, PTHREAD_EXPLICIT_SCHED);
+   pthread_attr_setschedpolicy(&_attr, SCHED_OTHER);
+   pthread_attr_setschedparam(&_attr, &parameters);
+
+   if (_spec.stackSize > 0) pthread_attr_setstacksize(&_attr, _spec.stackSize);
+
+   if (_spec.affinity != 0) {
+      cpu_set_t cpus;
+      CPU_ZERO(&cpus);
+
+      for (int cpu = 0; cpu < 64; ++cpu) {
+         if (_spec.affinity & (1ULL << cpu)) CPU_SET(cpu, &cpus);
+      }
+
+      pthread_attr_setaffinity_np(&_attr, sizeof(cpus), &cpus);
+   }
    
    pthread_create(&_thread,
                   &_attr,
-                  (void *(*)(void *))callAction,
+                  (void *(*)(void *))start,
                   this);
 }
 
+void *NixThread::start(NixThread *self) {
+   self->applySpec();
+   callAction(self);
+   return NULL;
+}
+
+void NixThread::applySpec() {
+   if (!_spec.name.empty()) {
+      pthread_setname_np(pthread_self(), _spec.name.substr(0, NAME_LENGTH).c_str());
+   }
+
+   bool applied = true;
+
+   switch (_spec.priority) {
+      case ThreadSpec::LOW:
+         applied = setpriority(PRIO_PROCESS, syscall(SYS_gettid), NICE_LOW) == 0;
+         break;
+
+      case ThreadSpec::HIGH:
+         applied = setpriority(PRIO_PROCESS, syscall(SYS_gettid), NICE_HIGH) == 0;
+         break;
+
+      case ThreadSpec::REALTIME: {
+         sched_param parameters;
+         parameters.sched_priority = (sched_get_priority_min(SCHED_FIFO) + sched_get_priority_max(SCHED_FIFO)) / 2;
+
+         applied = pthread_setschedparam(pthread_self(), SCHED_FIFO, &parameters) == 0;
+         break;
+      }
+
+      case ThreadSpec::NORMAL:
+         // nice is inherited too, it's the one of process then
+         if (getpriority(PRIO_PROCESS, syscall(SYS_gettid)) != getpriority(PRIO_PROCESS, getpid())) {
+            applied = setpriority(PRIO_PROCESS, syscall(SYS_gettid), getpriority(PRIO_PROCESS, getpid())) == 0;
+         }
+         break;
+   }
+
+   // thread runs anyway, as without the spec
+   if (!applied) printf("thread %s: can't set priority\n", _spec.name.c_str());
+}
+
 NixThread::~NixThread() {
    pthread_join(_thread, NULL);
    pthread_attr_destroy(&_attr);
@@ -10,10 +10,18 @@ class NixThread : public Thread {
 
 public:
    NixThread(const Action &action);
+   NixThread(const ThreadSpec &spec, const Action &action);
 
    ~NixThread();
 private:
+
+   // name and priority are set by the thread itself, before the action
+   static void *start(NixThread *self);
+
+   void applySpec();
    
+   const ThreadSpec _spec;
+
    pthread_t _thread;
    pthread_attr_t _attr;
 };
@@ -1,18 +1,110 @@
 #include <cstddef>
+#include <stdlib.h>
+#include <sstream>
 #include "platform.h"
 
 Platform * Platform::_instance;
 
+static const char * const ROLE_NAMES[Thread::ROLES] = { "ct", "read", "write", "connect" };
+
+Platform::Platform() : _socketConnector(nullptr) {
+   for (int role = 0; role < Thread::ROLES; ++role) {
+      _threadSpecs[role].name = std::string("mt-") + ROLE_NAMES[role];
+   }
+}
+
+static bool parseRole(const std::string &name, int &role) {
+   for (role = 0; role < Thread::ROLES; ++role) {
+      if (name == ROLE_NAMES[role]) return true;
+   }
+
+   return false;
+}
+
+static bool parsePriority(const std::string &name, ThreadSpec::Priority &priority) {
+   if (name == "low") priority = ThreadSpec::LOW;
+   else if (name == "normal") priority = ThreadSpec::NORMAL;
+   else if (name == "high") priority = ThreadSpec::HIGH;
+   else if (name == "realtime") priority = ThreadSpec::REALTIME;
+   else return false;
+
+   return true;
+}
+
+static bool parseNumber(const std::string &text, uint64 &number) {
+   char *end = nullptr;
+   number = strtoull(text.c_str(), &end, 0);
+   return !text.empty() && *end == 0;
+}
+
+static bool parseSpec(const std::string &text, ThreadSpec &spec) {
+   std::istringstream settings(text);
+   std::string setting;
+
+   while (std::getline(settings, setting, ',')) {
+      const size_t equals = setting.find('=');
+      if (equals == std::string::npos) return false;
+
+      const std::string key = setting.substr(0, equals);
+      const std::string value = setting.substr(equals + 1);
+
+      uint64 number = 0;
+
+      if (key == "name") spec.name = value;
+      else if (key == "priority") {
+         if (!parsePriority(value, spec.priority)) return false;
+      } else if (key == "affinity" && parseNumber(value, number)) spec.affinity = number;
+      else if (key == "stack" && parseNumber(value, number)) spec.stackSize = (size_t)number;
+      else if (key == "spin" && parseNumber(value, number)) spec.busyPollMicroseconds = number;
+      else return false;
+   }
+
+   return true;
+}
+
+bool Platform::configureThreads(const std::string &configuration) {
+   ThreadSpec specs[Thread::ROLES];
+
+   for (int role = 0; role < Thread::ROLES; ++role) specs[role] = _threadSpecs[role];
+
+   std::istringstream roles(configuration);
+   std::string item;
+
+   while (std::getline(roles, item, ';')) {
+      if (item.empty()) continue;
+
+      const size_t colon = item.find(':');
+      int role = 0;
+
+      if (colon == std::string::npos
+          || !parseRole(item.substr(0, colon), role)
+          || !parseSpec(item.substr(colon + 1), specs[role])) {
+         return false;
+      }
+   }
+
+   for (int role = 0; role < Thread::ROLES; ++role) _threadSpecs[role] = specs[role];
+
+   return true;
+}
+
 Platform &Platform::instance() {
    return *_instance;
 } 
 
 void Platform::init(Platform *instance) {
    _instance = instance;
+
+   // connector uses platform itself, so can be created only after
+   // instance is set
+   _instance->_socketConnector = _instance->createSocketConnector();
 }
 
 void Platform::cleanup() {
    if (_instance) {
+      delete _instance->_socketConnector;
+      _instance->_socketConnector = NULL;
+
       delete _instance;
       _instance = NULL;
    } 
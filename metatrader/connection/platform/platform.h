@@ -6,10 +6,14 @@
 #include "Monitor.h"
 #include "Socket.h"
 #include "Thread.h"
+#include "SocketConnector.h"
+#include "MappedFile.h"
 
 class Platform {
 public:
 
+   Platform();
+
    typedef uint64 Milliseconds;
    
    static void init(Platform *);
@@ -19,14 +23,45 @@ public:
 
    virtual Socket *createSocket() = 0;
 
+   SocketConnector &socketConnector() { return *_socketConnector; }
+
    virtual Monitor *createMonitor() = 0;
 
    virtual Thread *createThread(const Thread::Action &action) = 0;
+   virtual Thread *createThread(const ThreadSpec &spec, const Thread::Action &action) = 0;
+
+   const ThreadSpec &threadSpec(Thread::Role role) const { return _threadSpecs[role]; }
+   void setThreadSpec(Thread::Role role, const ThreadSpec &spec) { _threadSpecs[role] = spec; }
+
+   /**
+    * Sets specs of roles from "role:key=value,...;...", roles are ct,
+    * read, write and connect, keys are name, affinity (mask, 0x... too),
+    * priority (low, normal, high, realtime), stack (bytes) and spin
+    * (microseconds of busy poll of run loops of ct and write). Applies to
+    * threads created after the call, false (and nothing set) if it can't
+    * be parsed.
+    */
+   bool configureThreads(const std::string &configuration);
 
    virtual Milliseconds currentTime() = 0;
 
+   /**
+    * Maps file for reading and writing, file is created or extended to
+    * size if it's smaller. Returns nullptr on failure.
+    */
+   virtual MappedFile *mapFile(const std::string &path, uint64 size) = 0;
+
+   // maps existing file as it is, nullptr if there is no such file
+   virtual MappedFile *mapFileForReading(const std::string &path) = 0;
+
+   // true if directory exists after the call
+   virtual bool createDirectory(const std::string &path) = 0;
+
    virtual void sleep(const Milliseconds time) = 0;
 
+   // processors available to the process, at least one
+   virtual int processorsCount() = 0;
+
    virtual int htonl(int ) = 0;
    virtual uint64 htonll(uint64 ) = 0;
 
@@ -34,9 +69,18 @@ public:
    virtual uint64 ntohll(uint64 ) = 0;
 
    virtual ~Platform() {}
+
+protected:
+
+   virtual SocketConnector *createSocketConnector() = 0;
+
 private:
 
    static Platform *_instance;
+
+   SocketConnector *_socketConnector;
+
+   ThreadSpec _threadSpecs[Thread::ROLES];
 };
 
 
@@ -0,0 +1,73 @@
+#include "WinMappedFile.h"
+
+WinMappedFile *WinMappedFile::open(const std::string &path, uint64 size, bool writable) {
+   HANDLE file = CreateFileA(path.c_str(),
+                             writable ? GENERIC_READ | GENERIC_WRITE : GENERIC_READ,
+                             FILE_SHARE_READ | FILE_SHARE_WRITE,
+                             NULL,
+                             writable ? OPEN_ALWAYS : OPEN_EXISTING,
+                             FILE_ATTRIBUTE_NORMAL,
+                             NULL);
+
+   if (file == INVALID_HANDLE_VALUE) return nullptr;
+
+   LARGE_INTEGER fileSize;
+
+   if (!GetFileSizeEx(file, &fileSize)) {
+      CloseHandle(file);
+      return nullptr;
+   }
+
+   // mapping of writable file extends it to size
+   if (!writable || (uint64)fileSize.QuadPart >= size) size = fileSize.QuadPart;
+
+   if (size == 0) {
+      CloseHandle(file);
+      return nullptr;
+   }
+
+   HANDLE mapping = CreateFileMappingA(file,
+                                       NULL,
+                                       writable ? PAGE_READWRITE : PAGE_READONLY,
+                                       (DWORD)(size >> 32),
+                                       (DWORD)(size & 0xFFFFFFFF),
+                                       NULL);
+
+   if (mapping == NULL) {
+      CloseHandle(file);
+      return nullptr;
+   }
+
+   void *data = MapViewOfFile(mapping,
+                              writable ? FILE_MAP_WRITE : FILE_MAP_READ,
+                              0,
+                              0,
+                              size);
+
+   if (data == NULL) {
+      CloseHandle(mapping);
+      CloseHandle(file);
+      return nullptr;
+   }
+
+   return new WinMappedFile(file, mapping, (char *)data, size);
+}
+
+WinMappedFile::WinMappedFile(HANDLE file, HANDLE mapping, char *data, uint64 size)
+   : _file(file)
+   , _mapping(mapping)
+   , _data(data)
+   , _size(size) {
+
+}
+
+bool WinMappedFile::flush(uint64 offset, uint64 size) {
+   return FlushViewOfFile(_data + offset, size)
+      && FlushFileBuffers(_file);
+}
+
+WinMappedFile::~WinMappedFile() {
+   UnmapViewOfFile(_data);
+   CloseHandle(_mapping);
+   CloseHandle(_file);
+}
@@ -0,0 +1,34 @@
+#ifndef __6A1F0D3E9B7C4A52B8E4F17D20C5A938_WINMAPPEDFILE_H_INCLUDED__
+#define __6A1F0D3E9B7C4A52B8E4F17D20C5A938_WINMAPPEDFILE_H_INCLUDED__
+
+#include <string>
+#include "windows.h"
+#include "MappedFile.h"
+
+class WinMappedFile : public MappedFile {
+   WinMappedFile(const WinMappedFile &referenceToCopyFrom);
+   void operator=(const WinMappedFile &referenceToCopyFrom);
+
+public:
+
+   // nullptr if file can't be opened or mapped
+   static WinMappedFile *open(const std::string &path, uint64 size, bool writable);
+
+   char *data() { return _data; }
+   uint64 size() { return _size; }
+
+   bool flush(uint64 offset, uint64 size);
+
+   ~WinMappedFile();
+
+private:
+   WinMappedFile(HANDLE file, HANDLE mapping, char *data, uint64 size);
+
+private:
+   HANDLE _file;
+   HANDLE _mapping;
+   char *_data;
+   uint64 _size;
+};
+
+#endif 	// __6A1F0D3E9B7C4A52B8E4F17D20C5A938_WINMAPPEDFILE_H_INCLUDED__
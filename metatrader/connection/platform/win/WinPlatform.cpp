@@ -6,6 +6,8 @@
 #include "WinThread.h"
 #include "WinMonitor.h"
 #include "WinSocket.h"
+#include "WinSocketConnector.h"
+#include "WinMappedFile.h"
 
 WinPlatform::WinPlatform() {
    WSADATA wsaData = {0};
@@ -16,6 +18,10 @@ Socket *WinPlatform::createSocket() {
    return new WinSocket();
 } 
 
+SocketConnector *WinPlatform::createSocketConnector() {
+   return new WinSocketConnector();
+}
+
 Monitor *WinPlatform::createMonitor() {
    return new WinMonitor();
 } 
@@ -24,18 +30,41 @@ Thread *WinPlatform::createThread(const Thread::Action &action) {
    return new WinThread(action);
 } 
 
+Thread *WinPlatform::createThread(const ThreadSpec &spec, const Thread::Action &action) {
+   return new WinThread(spec, action);
+}
+
 Platform::Milliseconds WinPlatform::currentTime() {
    timeval currentTime;
 
    gettimeofday(&currentTime, NULL);
 
-   return currentTime.tv_sec * 1000L + currentTime.tv_usec / 1000L;
+   // long is 32 bits on windows and i686, seconds in milliseconds aren't
+   return (uint64)currentTime.tv_sec * 1000 + currentTime.tv_usec / 1000;
+}
+
+MappedFile *WinPlatform::mapFile(const std::string &path, uint64 size) {
+   return WinMappedFile::open(path, size, true);
+}
+
+MappedFile *WinPlatform::mapFileForReading(const std::string &path) {
+   return WinMappedFile::open(path, 0, false);
+}
+
+bool WinPlatform::createDirectory(const std::string &path) {
+   return CreateDirectoryA(path.c_str(), NULL) || GetLastError() == ERROR_ALREADY_EXISTS;
 }
 
 void WinPlatform::sleep(const Milliseconds time) {
    Sleep(time);
 } 
 
+int WinPlatform::processorsCount() {
+   SYSTEM_INFO info;
+   GetSystemInfo(&info);
+   return info.dwNumberOfProcessors > 0 ? (int)info.dwNumberOfProcessors : 1;
+}
+
 int WinPlatform::htonl(int i) {
    return ::htonl(i);
 }
@@ -10,6 +10,11 @@ WinSocket::WinSocket() {
    _socket = socket(AF_INET, SOCK_STREAM, 0);
 }
 
+WinSocket::WinSocket(int socket)
+   : _socket(socket) {
+
+}
+
 bool WinSocket::connect(const std::string &address,
                         int port) {
 
@@ -72,7 +77,7 @@ bool WinSocket::read(std::string &outputBuffer, int count) {
                           count);
    }
 
-   delete buffer;
+   delete[] buffer;
 
    return success;
 }
@@ -91,15 +96,19 @@ bool WinSocket::write(const std::string& buffer) {
       if (sent <= 0) return false;
 
       leftToSend -= sent;
+      offset += sent;
    }
 
    return true;
 }
 
 void WinSocket::close() {
-   closesocket(_socket);
+   // wakes up threads blocked in recv; socket is released only in
+   // destructor, when reader thread is joined, otherwise its handle could be
+   // reused by a new connection and read by thread of the closed one
+   shutdown(_socket, SD_BOTH);
 }
 
 WinSocket::~WinSocket() {
-   // should be cleaned up in close
+   if ((SOCKET)_socket != INVALID_SOCKET) closesocket(_socket);
 }
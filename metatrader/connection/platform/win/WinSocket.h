@@ -8,6 +8,9 @@ class WinSocket : public Socket {
 public:
 
    WinSocket();
+
+   // wraps already connected socket
+   WinSocket(int socket);
    
    bool connect(const std::string &address,
                 int port);
@@ -0,0 +1,187 @@
+#include "WinSocketConnector.h"
+#include "WinSocket.h"
+
+#undef UNICODE
+
+#include <winsock2.h>
+#include <ws2tcpip.h>
+#include <stdio.h>
+#include <string.h>
+
+enum {
+   // without wake up socket
+   MAX_WAIT_MS = 20
+};
+
+WinSocketConnector::WinSocketConnector()
+   : _wakeUpSocket(InvalidHandle) {
+
+   const SOCKET wakeUpSocket = socket(AF_INET, SOCK_DGRAM, IPPROTO_UDP);
+
+   if (wakeUpSocket == INVALID_SOCKET) return;
+
+   sockaddr_in address;
+   memset(&address, 0, sizeof(address));
+   address.sin_family = AF_INET;
+   address.sin_addr.s_addr = htonl(INADDR_LOOPBACK);
+   address.sin_port = 0;
+
+   int size = sizeof(address);
+
+   u_long nonBlocking = 1;
+
+   if (bind(wakeUpSocket, (const sockaddr *)&address, size) != 0
+       || getsockname(wakeUpSocket, (sockaddr *)&address, &size) != 0
+       || ioctlsocket(wakeUpSocket, FIONBIO, &nonBlocking) != 0) {
+      closesocket(wakeUpSocket);
+      return;
+   }
+
+   _wakeUpSocket = wakeUpSocket;
+   _wakeUpAddress.assign((const char *)&address, size);
+}
+
+bool WinSocketConnector::isLocalAddress(const std::string &address) {
+   // no local transports yet
+   return false;
+}
+
+Socket *WinSocketConnector::connectLocal(const std::string &address) {
+   return nullptr;
+}
+
+bool WinSocketConnector::resolve(const std::string &address,
+                                 int port,
+                                 std::vector<Candidate> &output) {
+   struct addrinfo hints;
+   addrinfo *info;
+
+   memset(&hints, 0, sizeof(struct addrinfo));
+   hints.ai_family = AF_UNSPEC;
+   hints.ai_socktype = SOCK_STREAM;
+
+   char service[16];
+   snprintf(service, sizeof(service), "%d", port);
+
+   if (getaddrinfo(address.c_str(), service, &hints, &info) != 0) return false;
+
+   for (addrinfo *i = info; i != NULL; i = i->ai_next) {
+      Candidate candidate;
+      candidate.family = i->ai_family;
+      candidate.address.assign((const char *)i->ai_addr,
+                               i->ai_addrlen);
+
+      output.push_back(candidate);
+   }
+
+   freeaddrinfo(info);
+
+   return true;
+}
+
+SocketConnector::Handle WinSocketConnector::startConnect(const Candidate &candidate) {
+   const SOCKET handle = socket(candidate.family, SOCK_STREAM, 0);
+
+   if (handle == INVALID_SOCKET) return InvalidHandle;
+
+   u_long nonBlocking = 1;
+   ioctlsocket(handle, FIONBIO, &nonBlocking);
+
+   const int result = ::connect(handle,
+                                (const sockaddr *)candidate.address.data(),
+                                candidate.address.size());
+
+   if (result != 0 && WSAGetLastError() != WSAEWOULDBLOCK) {
+      closesocket(handle);
+      return InvalidHandle;
+   }
+
+   return handle;
+}
+
+void WinSocketConnector::waitForAny(const std::vector<Handle> &handles,
+                                    Milliseconds timeout,
+                                    std::vector<Handle> &finished) {
+   const bool canWakeUp = _wakeUpSocket != InvalidHandle;
+
+   if (!canWakeUp && timeout > MAX_WAIT_MS) timeout = MAX_WAIT_MS;
+
+   // select fails without sockets
+   if (handles.empty() && !canWakeUp) {
+      Sleep(timeout);
+      return;
+   }
+
+   fd_set readable;
+   fd_set writable;
+   fd_set failed;
+
+   FD_ZERO(&readable);
+   FD_ZERO(&writable);
+   FD_ZERO(&failed);
+
+   if (canWakeUp) FD_SET((SOCKET)_wakeUpSocket, &readable);
+
+   // winsock fd_set is array, not bit mask, so FD_SETSIZE limits count of
+   // sockets, not their values
+   for (size_t i = 0; i < handles.size() && i < FD_SETSIZE - 1; ++i) {
+      FD_SET((SOCKET)handles[i], &writable);
+      FD_SET((SOCKET)handles[i], &failed);
+   }
+
+   timeval wait;
+   wait.tv_sec = timeout / 1000;
+   wait.tv_usec = (timeout % 1000) * 1000;
+
+   if (select(0, &readable, &writable, &failed, &wait) <= 0) return;
+
+   if (canWakeUp && FD_ISSET((SOCKET)_wakeUpSocket, &readable)) {
+      char buffer[64];
+      while (recv((SOCKET)_wakeUpSocket, buffer, sizeof(buffer), 0) > 0) {}
+   }
+
+   for (Handle handle : handles) {
+      if (FD_ISSET((SOCKET)handle, &writable) || FD_ISSET((SOCKET)handle, &failed)) {
+         finished.push_back(handle);
+      }
+   }
+}
+
+bool WinSocketConnector::isConnected(Handle handle) {
+   int error = 0;
+   int size = sizeof(error);
+
+   if (getsockopt((SOCKET)handle, SOL_SOCKET, SO_ERROR, (char *)&error, &size) != 0) return false;
+
+   return error == 0;
+}
+
+Socket *WinSocketConnector::wrap(Handle handle) {
+   u_long nonBlocking = 0;
+   ioctlsocket((SOCKET)handle, FIONBIO, &nonBlocking);
+
+   return new WinSocket(handle);
+}
+
+void WinSocketConnector::closeHandle(Handle handle) {
+   closesocket((SOCKET)handle);
+}
+
+void WinSocketConnector::wakeUp() {
+   if (_wakeUpSocket == InvalidHandle) return;
+
+   const char marker = 0;
+
+   sendto((SOCKET)_wakeUpSocket,
+          &marker,
+          1,
+          0,
+          (const sockaddr *)_wakeUpAddress.data(),
+          _wakeUpAddress.size());
+}
+
+WinSocketConnector::~WinSocketConnector() {
+   terminate();
+
+   if (_wakeUpSocket != InvalidHandle) closesocket((SOCKET)_wakeUpSocket);
+}
@@ -0,0 +1,47 @@
+#ifndef __CD021F925D4953D69758BEA97E0C4F76_WINSOCKETCONNECTOR_H_INCLUDED__
+#define __CD021F925D4953D69758BEA97E0C4F76_WINSOCKETCONNECTOR_H_INCLUDED__
+
+#include "SocketConnector.h"
+
+/**
+ * Winsock can't select on events, so connector is woken up by a datagram
+ * it sends to its own loopback socket. Without that socket wait is limited
+ * by short interval instead.
+ */
+class WinSocketConnector : public SocketConnector {
+public:
+   WinSocketConnector();
+
+   ~WinSocketConnector();
+
+protected:
+
+   bool isLocalAddress(const std::string &address);
+
+   Socket *connectLocal(const std::string &address);
+
+   bool resolve(const std::string &address,
+                int port,
+                std::vector<Candidate> &output);
+
+   Handle startConnect(const Candidate &candidate);
+
+   void waitForAny(const std::vector<Handle> &handles,
+                   Milliseconds timeout,
+                   std::vector<Handle> &finished);
+
+   bool isConnected(Handle handle);
+
+   Socket *wrap(Handle handle);
+
+   void closeHandle(Handle handle);
+
+   void wakeUp();
+
+private:
+   Handle _wakeUpSocket;
+   // raw sockaddr of wake up socket
+   std::string _wakeUpAddress;
+};
+
+#endif 	// __CD021F925D4953D69758BEA97E0C4F76_WINSOCKETCONNECTOR_H_INCLUDED__
@@ -1,11 +1,71 @@
 #include "WinThread.h"
+#include <stdio.h>
+
+// windows 10 and newer only, so it's looked up
+typedef HRESULT (WINAPI *SetThreadDescriptionFunction)(HANDLE, PCWSTR);
 
 WinThread::WinThread(const Action &action)
+   : WinThread(ThreadSpec(), action) {
+
+}
+
+WinThread::WinThread(const ThreadSpec &spec, const Action &action)
    : Thread(action) {
-   _thread = CreateThread(NULL, 0, (LPTHREAD_START_ROUTINE)callAction, this, 0, NULL);
+   _thread = CreateThread(NULL,
+                          spec.stackSize,
+                          (LPTHREAD_START_ROUTINE)callAction,
+                          this,
+                          CREATE_SUSPENDED | (spec.stackSize > 0 ? STACK_SIZE_PARAM_IS_A_RESERVATION : 0),
+                          NULL);
+
+   if (_thread == NULL) {
+      printf("thread %s: can't be created\n", spec.name.c_str());
+      return;
+   }
+
+   applySpec(spec);
+
+   ResumeThread(_thread);
+}
+
+void WinThread::applySpec(const ThreadSpec &spec) {
+   // mask is cut to the first 32 processors in 32 bit dll
+   if (spec.affinity != 0 && !SetThreadAffinityMask(_thread, (DWORD_PTR)spec.affinity)) {
+      printf("thread %s: can't set affinity\n", spec.name.c_str());
+   }
+
+   int priority = THREAD_PRIORITY_NORMAL;
+
+   switch (spec.priority) {
+      case ThreadSpec::LOW: priority = THREAD_PRIORITY_BELOW_NORMAL; break;
+      case ThreadSpec::NORMAL: priority = THREAD_PRIORITY_NORMAL; break;
+      case ThreadSpec::HIGH: priority = THREAD_PRIORITY_HIGHEST; break;
+      case ThreadSpec::REALTIME: priority = THREAD_PRIORITY_TIME_CRITICAL; break;
+   }
+
+   if (priority != THREAD_PRIORITY_NORMAL && !SetThreadPriority(_thread, priority)) {
+      printf("thread %s: can't set priority\n", spec.name.c_str());
+   }
+
+   if (spec.name.empty()) return;
+
+   const SetThreadDescriptionFunction setThreadDescription
+      = (SetThreadDescriptionFunction)GetProcAddress(GetModuleHandleA("kernel32.dll"), "SetThreadDescription");
+
+   if (setThreadDescription == NULL) return;
+
+   const int count = MultiByteToWideChar(CP_UTF8, 0, spec.name.c_str(), -1, NULL, 0);
+   wchar_t *name = new wchar_t[count];
+
+   MultiByteToWideChar(CP_UTF8, 0, spec.name.c_str(), -1, name, count);
+   setThreadDescription(_thread, name);
+
+   delete[] name;
 }
 
 WinThread::~WinThread() {
+   if (_thread == NULL) return;
+
    WaitForSingleObject(_thread, INFINITE);
    CloseHandle(_thread);
 }
@@ -10,9 +10,13 @@ class WinThread : public Thread {
 
 public:
    WinThread(const Action &action);
+   WinThread(const ThreadSpec &spec, const Action &action);
 
    ~WinThread();
 private:
+   // thread is created suspended, spec is applied, then it's resumed
+   void applySpec(const ThreadSpec &spec);
+
    HANDLE _thread;
 };
 
@@ -11,34 +11,61 @@ RegisterTicksProvider::RegisterTicksProvider(const std::string &key) {
       .buffer();
 }
 
-RegisterTradeConnector::RegisterTradeConnector(const std::string &key, double balance, double equity) {
+AskTicksProvider::AskTicksProvider(const std::string &key) {
+   _buffer = OutputDataBuffer()
+      .putString("AskTicksProvider")
+      .putString(key)
+      .buffer();
+}
+
+RegisterTradeConnector::RegisterTradeConnector(const std::string &key, const Price &balance, const Price &equity) {
    _buffer = OutputDataBuffer()
       .putString("RegisterTradeConnector")
       .putString(key)
-      .putDouble(balance)
-      .putDouble(equity)
+      .putPrice(balance)
+      .putPrice(equity)
       .buffer();
 }
 
-CurrentBalance::CurrentBalance(double balance) {
+CurrentBalance::CurrentBalance(const Price &balance) {
    _buffer = OutputDataBuffer()
       .putString("CurrentBalance")
-      .putDouble(balance)
+      .putPrice(balance)
       .buffer();
 }
 
-CurrentEquity::CurrentEquity(double equity) {
+CurrentEquity::CurrentEquity(const Price &equity) {
    _buffer = OutputDataBuffer()
       .putString("CurrentEquity")
-      .putDouble(equity)
+      .putPrice(equity)
       .buffer();
 }
 
-OnTick::OnTick(double bid, double ack) {
+OnTick::OnTick(uint64 sequence, uint64 time, const Price &bid, const Price &ack) {
    _buffer = OutputDataBuffer()
       .putString("OnTick")
-      .putDouble(bid)
-      .putDouble(ack)
+      .putLong(sequence)
+      .putLong(time)
+      .putPrice(bid)
+      .putPrice(ack)
+      .buffer();
+}
+
+const std::string Protocol::ResumeTicks::NAME = "ResumeTicks";
+
+ResumeTicks::ResumeTicks(uint64 sequence)
+   : _sequence(sequence) {
+
+}
+
+ResumeTicks::ResumeTicks(InputDataBuffer buffer) {
+   _sequence = buffer.nextLong();
+}
+
+std::string ResumeTicks::buffer() const {
+   return OutputDataBuffer()
+      .putString(NAME)
+      .putLong(_sequence)
       .buffer();
 }
 
@@ -51,6 +78,20 @@ NewId::NewId(uint64 id) {
 
 const std::string Protocol::RequestNewId::NAME = "RequestNewId";
 
+NewIdRange::NewIdRange(uint64 start, int count) {
+   _buffer = OutputDataBuffer()
+      .putString("NewIdRange")
+      .putLong(start)
+      .putInt(count)
+      .buffer();
+}
+
+const std::string Protocol::RequestNewIdRange::NAME = "RequestNewIdRange";
+
+RequestNewIdRange::RequestNewIdRange(InputDataBuffer buffer) {
+   _count = buffer.nextInt();
+}
+
 const std::string Protocol::OpenTrade::NAME = "OpenTrade";
 
 
@@ -61,7 +102,7 @@ Boundary readBoundary(InputDataBuffer& buffer) {
    // now only value parsed from boundary, not the direction or equality flag
    buffer.nextBool();
       
-   return Boundary(buffer.nextDouble());
+   return Boundary(buffer.nextPrice());
 } 
 
 Option<Boundary> readOptionaBoundary(InputDataBuffer& buffer) {
@@ -77,7 +118,7 @@ Option<Boundary> readOptionaBoundary(InputDataBuffer& buffer) {
 OpenTrade::OpenTrade(InputDataBuffer buffer) {
    _id = buffer.nextLong();
 
-   const double value = buffer.nextDouble();
+   const Price value = buffer.nextPrice();
 
    TradeType tradeType = TradeBuy;
 
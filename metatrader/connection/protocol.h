@@ -21,10 +21,22 @@ namespace Protocol {
       std::string _buffer;
    };
 
+   class AskTicksProvider {
+
+   public:
+      AskTicksProvider(const std::string &key);
+
+      std::string buffer() { return _buffer; };
+
+      virtual ~AskTicksProvider() {}
+   private:
+      std::string _buffer;
+   };
+
    class RegisterTradeConnector {
 
    public:
-      RegisterTradeConnector(const std::string &key, double balance, double equity);
+      RegisterTradeConnector(const std::string &key, const Price &balance, const Price &equity);
 
       std::string buffer() { return _buffer; };
 
@@ -36,7 +48,7 @@ namespace Protocol {
    class CurrentBalance {
 
    public:
-      CurrentBalance(double balance);
+      CurrentBalance(const Price &balance);
 
       std::string buffer() { return _buffer; };
 
@@ -48,7 +60,7 @@ namespace Protocol {
    class CurrentEquity {
 
    public:
-      CurrentEquity(double equity);
+      CurrentEquity(const Price &equity);
 
       std::string buffer() { return _buffer; };
 
@@ -57,9 +69,13 @@ namespace Protocol {
       std::string _buffer;
    };   
 
+   /**
+    * Ticks of a provider are numbered from 1, time is of terminal, so the
+    * hub sees ticks lost and how late they come.
+    */
    class OnTick {
    public:
-      OnTick(double bid, double ack);
+      OnTick(uint64 sequence, uint64 time, const Price &bid, const Price &ack);
 
       std::string buffer() { return _buffer; };
 
@@ -68,6 +84,28 @@ namespace Protocol {
       std::string _buffer;
    };
 
+   /**
+    * Hub's answer to RegisterTicksProvider: ticks from sequence on are sent
+    * again, zero when the hub hasn't seen the provider. Provider holds
+    * ticks till it comes.
+    */
+   class ResumeTicks {
+   public:
+      static const std::string NAME;
+
+      ResumeTicks(uint64 sequence);
+      ResumeTicks(InputDataBuffer buffer);
+
+      uint64 sequence() const { return _sequence; }
+
+      std::string buffer() const;
+
+      virtual ~ResumeTicks() {}
+
+   private:
+      uint64 _sequence;
+   };
+
    class NewId {
    public:
       NewId(uint64 id);
@@ -84,6 +122,37 @@ namespace Protocol {
       static const std::string NAME;
    };
 
+   /**
+    * Ids start..start + count - 1 granted in advance, hub opens trades with
+    * them without asking for every id. Granted ids are valid till the
+    * connection is lost.
+    */
+   class NewIdRange {
+   public:
+      NewIdRange(uint64 start, int count);
+
+      std::string buffer() { return _buffer; };
+
+      virtual ~NewIdRange() {}
+   private:
+      std::string _buffer;
+   };
+
+   // hub switches to ranges of ids of this size, see NewIdRange
+   class RequestNewIdRange {
+   public:
+      static const std::string NAME;
+
+      RequestNewIdRange(InputDataBuffer buffer);
+
+      int count() const { return _count; }
+
+      virtual ~RequestNewIdRange() {}
+
+   private:
+      int _count;
+   };
+
    class OpenTrade {
    public:
       static const std::string NAME;
@@ -0,0 +1,426 @@
+#include "TicksRelay.h"
+#include "ConnectionHandle.h"
+#include "ConnectionHandleListener.h"
+#include "StateConnected.h"
+#include "OutputDataBuffer.h"
+#include "protocol.h"
+#include "NixSocket.h"
+#include "logger.h"
+#include <stdio.h>
+#include <errno.h>
+#include <memory.h>
+#include <unistd.h>
+#include <sys/socket.h>
+#include <netinet/in.h>
+#include <netinet/tcp.h>
+#include <arpa/inet.h>
+#include <algorithm>
+
+enum {
+   LISTEN_BACKLOG = 1024,
+
+   // replies are written by connection's write thread, which stops when
+   // connection is deleted, so rejected connections live this long
+   REJECTED_LINGER_MS = 100,
+
+   ACCEPT_RETRY_US = 10000
+};
+
+static std::string packet(const std::string &name) {
+   return OutputDataBuffer().putString(name).buffer();
+}
+
+// built on first use, as buffers need the platform
+static const std::string &onTickPrefix() {
+   static const std::string prefix = packet("OnTick");
+   return prefix;
+}
+
+/**
+ * Reads string of packet at offset, packets of introduction come from
+ * anyone, so sizes are checked.
+ */
+static bool readString(const std::string &packet, size_t &offset, std::string &value) {
+   if (packet.size() < offset + 4) return false;
+
+   const uint8 *size = (const uint8 *)packet.data() + offset;
+   const uint32 length = (uint32)size[0] << 24 | size[1] << 16 | size[2] << 8 | size[3];
+
+   if (packet.size() - offset - 4 < length) return false;
+
+   value.assign(packet, offset + 4, length);
+   offset += 4 + length;
+
+   return true;
+}
+
+static bool readLong(const std::string &packet, size_t offset, uint64 &value) {
+   if (packet.size() < offset + 8) return false;
+
+   const uint8 *bytes = (const uint8 *)packet.data() + offset;
+
+   value = 0;
+   for (int i = 0; i < 8; ++i) value = value << 8 | bytes[i];
+
+   return true;
+}
+
+class TicksRelay::Client : public ConnectionHandleListener {
+   Client(const Client &referenceToCopyFrom);
+   void operator=(const Client &referenceToCopyFrom);
+
+public:
+
+   enum Role {
+      NEW,
+      PROVIDER,
+      SUBSCRIBER
+   };
+
+   Client(TicksRelay &relay, const std::string &address, int port, const std::string &name)
+      : relay(relay)
+      , logger("relay", address, port, name)
+      , handle(nullptr)
+      , role(NEW)
+      , channel(nullptr)
+      , dropped(false) {}
+
+   void onPacket(const std::string &buffer) {
+      if (!dropped) relay.onPacket(this, buffer);
+   }
+
+   void onDisconnect() {
+      if (!dropped) relay.onDisconnect(this);
+   }
+
+   void onConnected() {}
+   void onConnectFailed() {}
+
+   ~Client() {
+      delete handle;
+   }
+
+   TicksRelay &relay;
+   Logger logger;
+   ConnectionHandle *handle;
+
+   Role role;
+   std::string key;
+   Channel *channel;
+
+   // connection is deleted later, nothing is delivered till then
+   bool dropped;
+};
+
+TicksRelay::TicksRelay(RunLoop &runLoop)
+   : RunLoopUser(runLoop)
+   , _socket(-1)
+   , _port(0)
+   , _acceptThread(nullptr)
+   , _stopped(false)
+   , _lastClientId(0)
+   , _providers(0)
+   , _subscribers(0)
+   , _ticks(0)
+   , _ticksLost(0)
+   , _frames(0) {
+
+}
+
+bool TicksRelay::listen(const std::string &address, int port) {
+   _socket = socket(AF_INET, SOCK_STREAM | SOCK_CLOEXEC, 0);
+
+   if (_socket < 0) return false;
+
+   int reuse = 1;
+   setsockopt(_socket, SOL_SOCKET, SO_REUSEADDR, &reuse, sizeof(reuse));
+
+   sockaddr_in bound;
+   memset(&bound, 0, sizeof(bound));
+   bound.sin_family = AF_INET;
+   bound.sin_port = htons(port);
+
+   if (inet_pton(AF_INET, address.c_str(), &bound.sin_addr) != 1) return false;
+
+   socklen_t size = sizeof(bound);
+
+   if (bind(_socket, (sockaddr *)&bound, size) != 0
+       || ::listen(_socket, LISTEN_BACKLOG) != 0
+       || getsockname(_socket, (sockaddr *)&bound, &size) != 0) {
+      return false;
+   }
+
+   _port = ntohs(bound.sin_port);
+
+   return true;
+}
+
+void TicksRelay::start() {
+   _acceptThread = Platform::instance().createThread(std::bind(&TicksRelay::acceptLoop, this));
+}
+
+void TicksRelay::acceptLoop() {
+   while (!_stopped) {
+      sockaddr_in peer;
+      socklen_t size = sizeof(peer);
+
+      const int descriptor = accept4(_socket, (sockaddr *)&peer, &size, SOCK_CLOEXEC);
+
+      if (_stopped) {
+         if (descriptor >= 0) ::close(descriptor);
+         break;
+      }
+
+      if (descriptor < 0) {
+         // out of descriptors, for example, nothing to do but wait
+         if (errno != EINTR && errno != ECONNABORTED) usleep(ACCEPT_RETRY_US);
+         continue;
+      }
+
+      // ticks are small and are sent as soon as they come
+      int noDelay = 1;
+      setsockopt(descriptor, IPPROTO_TCP, TCP_NODELAY, &noDelay, sizeof(noDelay));
+
+      char host[INET_ADDRSTRLEN] = "";
+      inet_ntop(AF_INET, &peer.sin_addr, host, sizeof(host));
+
+      const std::string address = host;
+      const int port = ntohs(peer.sin_port);
+
+      post([this, descriptor, address, port]() -> void {
+            onAccepted(descriptor, address, port);
+         } );
+   }
+}
+
+void TicksRelay::onAccepted(int descriptor, const std::string &address, int port) {
+   if (_stopped) {
+      ::close(descriptor);
+      return;
+   }
+
+   char name[16];
+   snprintf(name, sizeof(name), "%d", ++_lastClientId);
+
+   Client *client = new Client(*this, address, port, name);
+
+   _clients.insert(client);
+
+   client->handle = new ConnectionHandle(runLoop(),
+                                         client->logger,
+                                         *client,
+                                         [descriptor](const ConnectionState::Context &context) -> ConnectionState * {
+                                            return new StateConnected(context,
+                                                                      new NixSocket(descriptor),
+                                                                      std::list<std::string>());
+                                         } );
+}
+
+void TicksRelay::onPacket(Client *client, const std::string &packet) {
+   if (client->role == Client::PROVIDER) {
+      const std::string &prefix = onTickPrefix();
+
+      if (packet.compare(0, prefix.size(), prefix) == 0) {
+         relayTick(*client->channel, packet);
+      } else {
+         // ticks provider can't send anything except of tick
+         client->logger.log("tick provider \"" + client->key + "\" sent wrong packet");
+         dropProvider(client);
+      }
+
+      return;
+   }
+
+   if (client->role == Client::SUBSCRIBER) {
+      // nothing can be sent from the ticks listener
+      client->logger.log("tick listener sent packet");
+      drop(client);
+      return;
+   }
+
+   size_t offset = 0;
+   std::string name;
+   std::string key;
+
+   const bool parsed = readString(packet, offset, name) && readString(packet, offset, key);
+
+   if (parsed && name == "RegisterTicksProvider") {
+      registerProvider(client, key);
+   } else if (parsed && name == "AskTicksProvider") {
+      addSubscriber(client, key);
+   } else {
+      client->logger.log("unexpected packet: " + (parsed ? name : std::string("malformed")));
+      drop(client);
+   }
+}
+
+void TicksRelay::registerProvider(Client *client, const std::string &key) {
+   Channel &channel = _channels[key];
+
+   if (channel.provider != nullptr) {
+      client->logger.log("tried REregister as tick provider: \"" + key + "\"");
+
+      client->handle->sendRawData(packet("AlreadyRegistered"));
+      drop(client);
+      return;
+   }
+
+   client->logger.log("registered as tick provider: \"" + key + "\"");
+
+   client->role = Client::PROVIDER;
+   client->key = key;
+   client->channel = &channel;
+
+   channel.provider = client;
+
+   ++_providers;
+
+   auto last = _tickSequences.find(key);
+
+   if (last != _tickSequences.end()) {
+      channel.tickSequence = last->second;
+      _tickSequences.erase(last);
+   }
+
+   client->handle->sendRawData(packet("Registered"));
+   client->handle->sendRawData(Protocol::ResumeTicks(channel.tickSequence > 0 ? channel.tickSequence + 1 : 0).buffer());
+}
+
+void TicksRelay::addSubscriber(Client *client, const std::string &key) {
+   auto found = _channels.find(key);
+
+   if (found == _channels.end() || found->second.provider == nullptr) {
+      client->logger.log("failed to obtain tick provider \"" + key + "\"");
+
+      client->handle->sendRawData(packet("ResourceNotFound"));
+      drop(client);
+      return;
+   }
+
+   client->role = Client::SUBSCRIBER;
+   client->key = key;
+   client->channel = &found->second;
+
+   found->second.subscribers.push_back(client);
+
+   ++_subscribers;
+
+   client->handle->sendRawData(packet("TickProviderConnected"));
+}
+
+void TicksRelay::relayTick(Channel &channel, const std::string &packet) {
+   ++_ticks;
+
+   uint64 sequence;
+
+   if (readLong(packet, onTickPrefix().size(), sequence)) {
+      // lower sequence is of restarted provider, it numbers ticks from 1 again
+      if (channel.tickSequence > 0 && sequence > channel.tickSequence + 1) {
+         _ticksLost += sequence - channel.tickSequence - 1;
+      }
+
+      channel.tickSequence = sequence;
+   }
+
+   if (channel.subscribers.empty()) return;
+
+   const ConnectionHandle::SharedFrame frame = ConnectionHandle::frame(packet);
+
+   for (Client *subscriber : channel.subscribers) subscriber->handle->sendFrame(frame, RunLoop::TICKS);
+
+   _frames += channel.subscribers.size();
+}
+
+void TicksRelay::onDisconnect(Client *client) {
+   client->logger.log("disconnected");
+
+   if (client->role == Client::PROVIDER) {
+      dropProvider(client);
+   } else {
+      drop(client);
+   }
+}
+
+void TicksRelay::dropProvider(Client *provider) {
+   Channel *channel = provider->channel;
+
+   // listeners of provider are closed with it
+   for (Client *subscriber : channel->subscribers) {
+      subscriber->channel = nullptr;
+      subscriber->role = Client::NEW;
+
+      --_subscribers;
+
+      drop(subscriber);
+   }
+
+   --_providers;
+
+   provider->channel = nullptr;
+   provider->role = Client::NEW;
+
+   if (channel->tickSequence > 0) _tickSequences[provider->key] = channel->tickSequence;
+
+   _channels.erase(provider->key);
+
+   drop(provider);
+}
+
+void TicksRelay::drop(Client *client) {
+   if (client->dropped) return;
+
+   client->dropped = true;
+
+   if (client->role == Client::SUBSCRIBER) {
+      std::vector<Client *> &subscribers = client->channel->subscribers;
+
+      subscribers.erase(std::find(subscribers.begin(), subscribers.end(), client));
+
+      --_subscribers;
+   }
+
+   // connection is deleted later, as this is called from its callbacks
+   postDelayed(client->role == Client::NEW ? REJECTED_LINGER_MS : 0,
+               [this, client]() -> void {
+                  if (_clients.erase(client) > 0) delete client;
+               } );
+}
+
+TicksRelay::Stats TicksRelay::stats() const {
+   Stats stats;
+
+   stats.providers = _providers;
+   stats.subscribers = _subscribers;
+   stats.ticks = _ticks;
+   stats.ticksLost = _ticksLost;
+   stats.frames = _frames;
+
+   return stats;
+}
+
+void TicksRelay::stop() {
+   if (_stopped.exchange(true)) return;
+
+   // wakes up accept
+   if (_socket >= 0) ::shutdown(_socket, SHUT_RDWR);
+
+   Thread::joinAndDelete(_acceptThread);
+   _acceptThread = nullptr;
+
+   for (Client *client : _clients) {
+      client->dropped = true;
+      delete client;
+   }
+
+   _clients.clear();
+   _channels.clear();
+
+   _providers = 0;
+   _subscribers = 0;
+}
+
+TicksRelay::~TicksRelay() {
+   stop();
+
+   if (_socket >= 0) ::close(_socket);
+}
@@ -0,0 +1,113 @@
+#ifndef __7C2E9A41D35B4F6E8A1B0C94E2D7F356_TICKSRELAY_H_INCLUDED__
+#define __7C2E9A41D35B4F6E8A1B0C94E2D7F356_TICKSRELAY_H_INCLUDED__
+
+#include <string>
+#include <map>
+#include <set>
+#include <vector>
+#include <atomic>
+#include "platform.h"
+#include "RunLoopUser.h"
+
+/**
+ * Ticks part of the hub (HubService with RelayChannel and
+ * TickProviderController) for many listeners of one feed.
+ *
+ * Accepts connections speaking HubProtocol: RegisterTicksProvider makes
+ * connection provider of the key, AskTicksProvider subscribes it to the
+ * provider's ticks. Replies, and drops of connections which send something
+ * unexpected, are as in the hub. Trade connectors are not relayed.
+ *
+ * Last tick sequence of a key outlives its provider, reconnected provider
+ * is asked with ResumeTicks for ticks after it, as by the hub.
+ *
+ * Every connection is ConnectionHandle served on the run loop. OnTick of
+ * provider is framed once and the frame is shared by all subscribers, so
+ * fan out to N of them is N posts of a pointer to their write threads.
+ */
+class TicksRelay : private RunLoopUser {
+   TicksRelay(const TicksRelay &referenceToCopyFrom);
+   void operator=(const TicksRelay &referenceToCopyFrom);
+
+public:
+
+   struct Stats {
+      uint64 providers;
+      uint64 subscribers;
+
+      // received from providers
+      uint64 ticks;
+      // gaps in sequences of ticks of providers
+      uint64 ticksLost;
+      // sent to subscribers
+      uint64 frames;
+   };
+
+   TicksRelay(RunLoop &runLoop);
+
+   // zero port picks any free one, see port()
+   bool listen(const std::string &address, int port);
+
+   int port() const { return _port; }
+
+   // accepts connections on thread of its own until stop()
+   void start();
+
+   /**
+    * Stops accepting and drops all connections, should be called on the
+    * run loop thread or when it's not running.
+    */
+   void stop();
+
+   // can be called from any thread
+   Stats stats() const;
+
+   ~TicksRelay();
+
+private:
+
+   class Client;
+
+   struct Channel {
+      Channel() : provider(nullptr), tickSequence(0) {}
+
+      Client *provider;
+      uint64 tickSequence;
+      std::vector<Client *> subscribers;
+   };
+
+   void acceptLoop();
+
+   void onAccepted(int descriptor, const std::string &address, int port);
+   void onPacket(Client *client, const std::string &packet);
+   void onDisconnect(Client *client);
+
+   void registerProvider(Client *client, const std::string &key);
+   void addSubscriber(Client *client, const std::string &key);
+   void relayTick(Channel &channel, const std::string &packet);
+
+   void dropProvider(Client *provider);
+   void drop(Client *client);
+
+private:
+   int _socket;
+   int _port;
+
+   Thread *_acceptThread;
+   std::atomic<bool> _stopped;
+
+   int _lastClientId;
+
+   std::set<Client *> _clients;
+   std::map<std::string, Channel> _channels;
+   // of keys without provider
+   std::map<std::string, uint64> _tickSequences;
+
+   std::atomic<uint64> _providers;
+   std::atomic<uint64> _subscribers;
+   std::atomic<uint64> _ticks;
+   std::atomic<uint64> _ticksLost;
+   std::atomic<uint64> _frames;
+};
+
+#endif 	// __7C2E9A41D35B4F6E8A1B0C94E2D7F356_TICKSRELAY_H_INCLUDED__
@@ -0,0 +1,75 @@
+#include "PeriodsBinaryCache.h"
+
+enum {
+   TC_BLOCKDATA = 0x77,
+   TC_BLOCKDATALONG = 0x7A
+};
+
+// java.io.ObjectStreamConstants STREAM_MAGIC and STREAM_VERSION
+static const uint8 STREAM_HEADER[4] = { 0xAC, 0xED, 0x00, 0x05 };
+
+PeriodsBinaryCache::Writer::Writer(const std::string &path)
+   : _file(fopen(path.c_str(), "wb"))
+   , _failed(false)
+   , _blockSize(0) {
+
+   if (_file == NULL) return;
+
+   if (fwrite(STREAM_HEADER, 1, sizeof(STREAM_HEADER), _file) != sizeof(STREAM_HEADER)) _failed = true;
+}
+
+void PeriodsBinaryCache::Writer::writeBlock() {
+   if (_blockSize == 0) return;
+
+   uint8 header[5];
+   size_t headerSize;
+
+   if (_blockSize <= 0xFF) {
+      header[0] = TC_BLOCKDATA;
+      header[1] = _blockSize;
+      headerSize = 2;
+   } else {
+      header[0] = TC_BLOCKDATALONG;
+      header[1] = _blockSize >> 24;
+      header[2] = _blockSize >> 16;
+      header[3] = _blockSize >> 8;
+      header[4] = _blockSize;
+      headerSize = 5;
+   }
+
+   if (fwrite(header, 1, headerSize, _file) != headerSize
+       || fwrite(_block, 1, _blockSize, _file) != _blockSize) _failed = true;
+
+   _blockSize = 0;
+}
+
+void PeriodsBinaryCache::Writer::writeLong(int64 value) {
+   // block is multiple of 8, so long is never split
+   if (_blockSize == sizeof(_block)) writeBlock();
+
+   for (int i = 7; i >= 0; --i) _block[_blockSize++] = (uint8)((uint64)value >> (8 * i));
+}
+
+void PeriodsBinaryCache::Writer::write(int64 time, int64 open, int64 close, int64 min, int64 max) {
+   writeLong(open);
+   writeLong(close);
+   writeLong(min);
+   writeLong(max);
+
+   writeLong(time / 1000 * 1000);
+}
+
+bool PeriodsBinaryCache::Writer::close() {
+   if (_file == NULL) return false;
+
+   writeBlock();
+
+   if (fclose(_file) != 0) _failed = true;
+   _file = NULL;
+
+   return !_failed;
+}
+
+PeriodsBinaryCache::Writer::~Writer() {
+   if (_file != NULL) close();
+}
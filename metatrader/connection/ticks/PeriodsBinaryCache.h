@@ -0,0 +1,50 @@
+#ifndef __1E5C7B93A2D64F08B6A9C3E5D7F18240_PERIODSBINARYCACHE_H_INCLUDED__
+#define __1E5C7B93A2D64F08B6A9C3E5D7F18240_PERIODSBINARYCACHE_H_INCLUDED__
+
+#include <string>
+#include <stdio.h>
+#include "common.h"
+
+/**
+ * Writer of periods.bin.cache.v3 files as the hub's PeriodsBinaryCache
+ * writes them: java ObjectOutputStream with open, close, min and max price
+ * (Fraction, long scaled by TicksText::PRICE_SCALE) and time (long
+ * milliseconds, whole seconds) for every period.
+ *
+ * Longs are written to block data records of 1024 bytes, as java does, so
+ * the file is the same as the hub would write.
+ */
+class PeriodsBinaryCache {
+public:
+
+   class Writer {
+      Writer(const Writer &referenceToCopyFrom);
+      void operator=(const Writer &referenceToCopyFrom);
+
+   public:
+      Writer(const std::string &path);
+
+      // false if file can't be created
+      bool isOpened() const { return _file != NULL; }
+
+      void write(int64 time, int64 open, int64 close, int64 min, int64 max);
+
+      // writes the rest, false if writing failed
+      bool close();
+
+      ~Writer();
+
+   private:
+      void writeLong(int64 value);
+      void writeBlock();
+
+   private:
+      FILE *_file;
+      bool _failed;
+
+      uint8 _block[1024];
+      uint32 _blockSize;
+   };
+};
+
+#endif 	// __1E5C7B93A2D64F08B6A9C3E5D7F18240_PERIODSBINARYCACHE_H_INCLUDED__
@@ -0,0 +1,30 @@
+#include "PeriodsText.h"
+#include "TicksText.h"
+#include <stdio.h>
+
+const char PeriodsText::HEADER[] = "<DATE> <TIME> <OPEN> <HIGH> <LOW> <CLOSE>\n";
+
+int PeriodsText::formatLine(char *buffer, int64 time, int64 open, int64 high, int64 low, int64 close) {
+   int year, month, day, hours, minutes, seconds;
+
+   TicksText::toCalendar(time / 1000, year, month, day, hours, minutes, seconds);
+
+   int size = snprintf(buffer,
+                       MAX_LINE_SIZE + 1,
+                       "%04d%02d%02d %02d%02d%02d",
+                       year, month, day, hours, minutes, seconds);
+
+   if (size < 0 || size > MAX_LINE_SIZE - 4 * (TicksText::MAX_PRICE_SIZE + 1) - 1) size = 0;
+
+   const int64 prices[4] = { open, high, low, close };
+
+   for (int i = 0; i < 4; ++i) {
+      buffer[size++] = ' ';
+      size += TicksText::formatPrice(buffer + size, prices[i]);
+   }
+
+   buffer[size++] = '\n';
+   buffer[size] = '\0';
+
+   return size;
+}
@@ -0,0 +1,31 @@
+#ifndef __1E5C7B93A2D64F08B6A9C3E5D7F18240_PERIODSTEXT_H_INCLUDED__
+#define __1E5C7B93A2D64F08B6A9C3E5D7F18240_PERIODSTEXT_H_INCLUDED__
+
+#include "common.h"
+
+/**
+ * Text format of periods as the hub's PeriodsText writes it, header and
+ * one period per line:
+ *
+ *   <DATE> <TIME> <OPEN> <HIGH> <LOW> <CLOSE>
+ *   20130517 140000 1.28561 1.28602 1.2855 1.28597
+ */
+class PeriodsText {
+public:
+
+   enum {
+      // longest line without newline
+      MAX_LINE_SIZE = 160
+   };
+
+   static const char HEADER[];
+
+   /**
+    * Writes line with newline to buffer of MAX_LINE_SIZE + 1, returns its
+    * size. Time is in milliseconds, prices are scaled by
+    * TicksText::PRICE_SCALE.
+    */
+   static int formatLine(char *buffer, int64 time, int64 open, int64 high, int64 low, int64 close);
+};
+
+#endif 	// __1E5C7B93A2D64F08B6A9C3E5D7F18240_PERIODSTEXT_H_INCLUDED__
@@ -0,0 +1,98 @@
+#include "TickLog.h"
+#include <string.h>
+#include <stdio.h>
+
+const char TickLog::MAGIC[8] = { 'f', 'x', 't', 'i', 'c', 'k', 's', '\0' };
+
+std::string TickLog::symbolDirectory(const std::string &root, const std::string &symbol) {
+   return root + "/" + symbol;
+}
+
+std::string TickLog::segmentPath(const std::string &root, const std::string &symbol, uint32 index) {
+   char name[32];
+   sprintf(name, "/%08u.tlog", index);
+
+   return symbolDirectory(root, symbol) + name;
+}
+
+bool TickLog::isValid(MappedFile &segment) {
+   const Header &segmentHeader = header(segment);
+
+   return segment.size() >= sizeof(Header)
+      && memcmp(segmentHeader.magic, MAGIC, sizeof(MAGIC)) == 0
+      && segmentHeader.version == VERSION
+      && segmentHeader.tickSize == sizeof(Tick);
+}
+
+bool TickLog::initialize(MappedFile &segment) {
+   if (segment.size() < SEGMENT_SIZE) return false;
+
+   Header &segmentHeader = header(segment);
+
+   if (memcmp(segmentHeader.magic, MAGIC, sizeof(MAGIC)) != 0) {
+      segmentHeader.version = VERSION;
+      segmentHeader.tickSize = sizeof(Tick);
+      segmentHeader.count = 0;
+      memcpy(segmentHeader.magic, MAGIC, sizeof(MAGIC));
+   }
+
+   return isValid(segment);
+}
+
+uint64 TickLog::countTicks(MappedFile &segment) {
+   const uint64 capacity = (segment.size() - sizeof(Header)) / sizeof(Tick);
+   const Tick *segmentTicks = ticks(segment);
+
+   // ticks before header's count are on disk, the rest is to be checked
+   uint64 count = header(segment).count;
+   if (count > capacity) count = 0;
+
+   while (count < capacity && segmentTicks[count].time != 0) ++count;
+
+   return count;
+}
+
+TickLog::Reader::Reader(const std::string &root, const std::string &symbol)
+   : _root(root)
+   , _symbol(symbol)
+   , _index(0)
+   , _segment(nullptr)
+   , _count(0)
+   , _position(0) {
+
+}
+
+bool TickLog::Reader::openNextSegment() {
+   delete _segment;
+
+   _segment = Platform::instance().mapFileForReading(segmentPath(_root, _symbol, _index));
+
+   if (_segment == nullptr) return false;
+
+   ++_index;
+
+   if (!isValid(*_segment)) {
+      delete _segment;
+      _segment = nullptr;
+      return false;
+   }
+
+   _count = countTicks(*_segment);
+   _position = 0;
+
+   return true;
+}
+
+bool TickLog::Reader::next(Tick &tick) {
+   while (_segment == nullptr || _position == _count) {
+      if (!openNextSegment()) return false;
+   }
+
+   tick = ticks(*_segment)[_position++];
+
+   return true;
+}
+
+TickLog::Reader::~Reader() {
+   delete _segment;
+}
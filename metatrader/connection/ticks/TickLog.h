@@ -0,0 +1,91 @@
+#ifndef __1E5C7B93A2D64F08B6A9C3E5D7F18240_TICKLOG_H_INCLUDED__
+#define __1E5C7B93A2D64F08B6A9C3E5D7F18240_TICKLOG_H_INCLUDED__
+
+#include <string>
+#include "platform.h"
+
+/**
+ * Append-only log of ticks of one symbol, written by TickRecorder.
+ *
+ * Log of symbol is directory root/symbol with segments 00000000.tlog,
+ * 00000001.tlog and so on. Segment is preallocated to SEGMENT_SIZE and
+ * mapped to memory, it's Header followed by Ticks, in byte order of the
+ * machine. Space not written yet is zeroes, so the first tick with zero
+ * time is the end of segment. Time of a tick is written after its prices,
+ * so tick is either whole or not there at all, even after crash.
+ *
+ * Header's count is the number of ticks known to be on disk, updated by
+ * the flusher, it's informational: readers go by time of ticks.
+ */
+class TickLog {
+public:
+
+   enum {
+      VERSION = 1,
+      SEGMENT_SIZE = 4 * 1024 * 1024
+   };
+
+   struct Header {
+      char magic[8];
+      uint32 version;
+      uint32 tickSize;
+      uint64 count;
+      uint64 reserved;
+   };
+
+   struct Tick {
+      // seconds, as mt gives it
+      uint64 time;
+      double bid;
+      double ask;
+   };
+
+   static const char MAGIC[8];
+
+   static const uint64 TICKS_PER_SEGMENT = (SEGMENT_SIZE - sizeof(Header)) / sizeof(Tick);
+
+   static std::string symbolDirectory(const std::string &root, const std::string &symbol);
+   static std::string segmentPath(const std::string &root, const std::string &symbol, uint32 index);
+
+   // false if segment is not of a tick log
+   static bool isValid(MappedFile &segment);
+
+   // header is written to fresh segment, left as is in valid one
+   static bool initialize(MappedFile &segment);
+
+   static Header &header(MappedFile &segment) { return *(Header *)segment.data(); }
+   static Tick *ticks(MappedFile &segment) { return (Tick *)(segment.data() + sizeof(Header)); }
+
+   // number of ticks written to segment
+   static uint64 countTicks(MappedFile &segment);
+
+   /**
+    * Reads ticks of symbol from the first segment to the last one.
+    */
+   class Reader {
+      Reader(const Reader &referenceToCopyFrom);
+      void operator=(const Reader &referenceToCopyFrom);
+
+   public:
+      Reader(const std::string &root, const std::string &symbol);
+
+      // false after the last tick
+      bool next(Tick &tick);
+
+      ~Reader();
+
+   private:
+      bool openNextSegment();
+
+   private:
+      const std::string _root;
+      const std::string _symbol;
+
+      uint32 _index;
+      MappedFile *_segment;
+      uint64 _count;
+      uint64 _position;
+   };
+};
+
+#endif 	// __1E5C7B93A2D64F08B6A9C3E5D7F18240_TICKLOG_H_INCLUDED__
@@ -0,0 +1,311 @@
+#include "TickRecorder.h"
+#include <atomic>
+#include <vector>
+
+TickRecorder::SymbolLog::SymbolLog()
+   : index(0)
+   , segment(nullptr)
+   , count(0)
+   , flushed(0)
+   , next(nullptr) {
+
+}
+
+TickRecorder::TickRecorder()
+   : _synchronization(Platform::instance().createMonitor())
+   , _flusherThread(nullptr)
+   , _stopped(true) {
+
+}
+
+bool TickRecorder::start(const std::string &directory) {
+   _synchronization->lock();
+
+   const bool sameDirectory = !_stopped && _directory == directory;
+
+   _synchronization->unlock();
+
+   if (sameDirectory) return true;
+
+   stop();
+
+   if (!Platform::instance().createDirectory(directory)) return false;
+
+   _synchronization->lock();
+
+   _directory = directory;
+   _stopped = false;
+   _flusherThread = Platform::instance().createThread(std::bind(&TickRecorder::ftFlusherThreadMethod,
+                                                                this));
+
+   _synchronization->unlock();
+
+   return true;
+}
+
+void TickRecorder::stop() {
+   _synchronization->lock();
+
+   if (_stopped) {
+      _synchronization->unlock();
+      return;
+   }
+
+   _stopped = true;
+   _synchronization->notify();
+
+   Thread *flusherThread = _flusherThread;
+   _flusherThread = nullptr;
+
+   _synchronization->unlock();
+
+   // flusher writes everything before exiting
+   Thread::joinAndDelete(flusherThread);
+
+   _synchronization->lock();
+   closeLogs();
+   _synchronization->unlock();
+}
+
+void TickRecorder::abandon() {
+   _synchronization->lock();
+
+   const bool wasRunning = !_stopped;
+
+   _stopped = true;
+
+   // threads are gone already when process exits, the object is left
+   _flusherThread = nullptr;
+
+   _synchronization->unlock();
+
+   if (!wasRunning) return;
+
+   flushAll();
+
+   _synchronization->lock();
+   closeLogs();
+   _synchronization->unlock();
+}
+
+void TickRecorder::recordTick(const std::string &symbol, uint64 time, double bid, double ask) {
+   // zero time marks the end of written ticks
+   if (time == 0) return;
+
+   _synchronization->lock();
+
+   if (_stopped) {
+      _synchronization->unlock();
+      return;
+   }
+
+   std::map<std::string, SymbolLog *>::iterator found = _logs.find(symbol);
+
+   SymbolLog *log = found == _logs.end()
+      ? openLog(symbol)
+      : found->second;
+
+   if (log != nullptr && log->count == TickLog::TICKS_PER_SEGMENT) {
+      if (log->segment) log->retired.push_back(std::make_pair(log->segment, log->flushed));
+
+      log->segment = nullptr;
+
+      if (log->next) {
+         ++log->index;
+         log->segment = log->next;
+         log->next = nullptr;
+         log->count = 0;
+         log->flushed = 0;
+      } else if (!openSegment(*log, symbol, log->index + 1)) {
+         // flusher was late to prepare it, and it can't be created, the
+         // next tick will try again
+         log = nullptr;
+      }
+   }
+
+   if (log != nullptr) {
+      TickLog::Tick &tick = TickLog::ticks(*log->segment)[log->count];
+
+      tick.bid = bid;
+      tick.ask = ask;
+
+      std::atomic_thread_fence(std::memory_order_release);
+
+      tick.time = time;
+
+      ++log->count;
+   }
+
+   _synchronization->unlock();
+}
+
+TickRecorder::SymbolLog *TickRecorder::openLog(const std::string &symbol) {
+   if (!Platform::instance().createDirectory(TickLog::symbolDirectory(_directory, symbol))) return nullptr;
+
+   // continues after the last existing segment
+   uint32 index = 0;
+
+   while (MappedFile *existing = Platform::instance().mapFileForReading(TickLog::segmentPath(_directory,
+                                                                                             symbol,
+                                                                                             index + 1))) {
+      delete existing;
+      ++index;
+   }
+
+   SymbolLog *log = new SymbolLog();
+
+   if (!openSegment(*log, symbol, index)) {
+      delete log;
+      return nullptr;
+   }
+
+   _logs[symbol] = log;
+
+   return log;
+}
+
+bool TickRecorder::openSegment(SymbolLog &log, const std::string &symbol, uint32 index) {
+   while (true) {
+      MappedFile *segment = mapSegment(symbol, index);
+
+      if (segment == nullptr) return false;
+
+      const uint64 count = TickLog::countTicks(*segment);
+
+      if (count < TickLog::TICKS_PER_SEGMENT) {
+         log.index = index;
+         log.segment = segment;
+         log.count = count;
+         log.flushed = count;
+         return true;
+      }
+
+      delete segment;
+      ++index;
+   }
+}
+
+MappedFile *TickRecorder::mapSegment(const std::string &symbol, uint32 index) {
+   MappedFile *segment = Platform::instance().mapFile(TickLog::segmentPath(_directory, symbol, index),
+                                                      TickLog::SEGMENT_SIZE);
+
+   if (segment != nullptr && !TickLog::initialize(*segment)) {
+      delete segment;
+      return nullptr;
+   }
+
+   return segment;
+}
+
+void TickRecorder::ftFlusherThreadMethod() {
+   _synchronization->lock();
+
+   while (!_stopped) {
+      _synchronization->wait(FLUSH_INTERVAL_MS);
+
+      _synchronization->unlock();
+      flushAll();
+      _synchronization->lock();
+   }
+
+   _synchronization->unlock();
+
+   flushAll();
+}
+
+void TickRecorder::flushAll() {
+   struct Work {
+      std::string symbol;
+      SymbolLog *log;
+
+      MappedFile *segment;
+      uint64 from;
+      uint64 count;
+
+      bool needsNext;
+      uint32 nextIndex;
+
+      std::list<std::pair<MappedFile *, uint64> > retired;
+   };
+
+   std::vector<Work> work;
+
+   _synchronization->lock();
+
+   for (auto &entry : _logs) {
+      SymbolLog &log = *entry.second;
+
+      work.push_back(Work());
+      Work &symbolWork = work.back();
+
+      symbolWork.symbol = entry.first;
+      symbolWork.log = &log;
+      symbolWork.segment = log.segment;
+      symbolWork.from = log.flushed;
+      symbolWork.count = log.count;
+      symbolWork.needsNext = log.segment && !log.next && log.count > TickLog::TICKS_PER_SEGMENT / 2;
+      symbolWork.nextIndex = log.index + 1;
+      symbolWork.retired.swap(log.retired);
+
+      log.flushed = log.count;
+   }
+
+   _synchronization->unlock();
+
+   // segments are deleted only here and after flusher is stopped, so
+   // they are safe to use without lock
+   for (Work &symbolWork : work) {
+      for (auto &retired : symbolWork.retired) {
+         flush(*retired.first, retired.second, TickLog::TICKS_PER_SEGMENT);
+         delete retired.first;
+      }
+
+      if (symbolWork.segment && symbolWork.count > symbolWork.from) {
+         flush(*symbolWork.segment, symbolWork.from, symbolWork.count);
+      }
+
+      if (!symbolWork.needsNext) continue;
+
+      MappedFile *next = mapSegment(symbolWork.symbol, symbolWork.nextIndex);
+
+      _synchronization->lock();
+
+      if (next && !symbolWork.log->next && symbolWork.log->index + 1 == symbolWork.nextIndex) {
+         symbolWork.log->next = next;
+         next = nullptr;
+      }
+
+      _synchronization->unlock();
+
+      delete next;
+   }
+}
+
+void TickRecorder::flush(MappedFile &segment, uint64 from, uint64 count) {
+   segment.flush(sizeof(TickLog::Header) + from * sizeof(TickLog::Tick),
+                 (count - from) * sizeof(TickLog::Tick));
+
+   TickLog::header(segment).count = count;
+   segment.flush(0, sizeof(TickLog::Header));
+}
+
+void TickRecorder::closeLogs() {
+   for (auto &entry : _logs) {
+      SymbolLog *log = entry.second;
+
+      delete log->segment;
+      delete log->next;
+
+      for (auto &retired : log->retired) delete retired.first;
+
+      delete log;
+   }
+
+   _logs.clear();
+}
+
+TickRecorder::~TickRecorder() {
+   stop();
+
+   delete _synchronization;
+}
@@ -0,0 +1,89 @@
+#ifndef __1E5C7B93A2D64F08B6A9C3E5D7F18240_TICKRECORDER_H_INCLUDED__
+#define __1E5C7B93A2D64F08B6A9C3E5D7F18240_TICKRECORDER_H_INCLUDED__
+
+#include <string>
+#include <map>
+#include <list>
+#include "platform.h"
+#include "TickLog.h"
+
+/**
+ * Records ticks of all symbols to TickLog under a directory.
+ *
+ * Recording a tick is a copy to mapped segment under short lock, disk is
+ * left to background flusher: every FLUSH_INTERVAL_MS it writes new ticks
+ * to disk, and it maps next segment of a symbol before current one gets
+ * full, so mt's threads don't wait for files to be created.
+ *
+ * Restarted recorder continues the logs after the last written tick.
+ */
+class TickRecorder {
+   TickRecorder(const TickRecorder &referenceToCopyFrom);
+   void operator=(const TickRecorder &referenceToCopyFrom);
+
+public:
+
+   enum {
+      FLUSH_INTERVAL_MS = 1000
+   };
+
+   TickRecorder();
+
+   /**
+    * Starts recording to directory, does nothing if already recording
+    * there. Returns false if directory can't be created.
+    */
+   bool start(const std::string &directory);
+
+   // flushes and closes all logs
+   void stop();
+
+   /**
+    * For unloading of the dll, where threads can't be joined: flushes and
+    * closes logs left by not stopped recorder, its flusher isn't joined.
+    */
+   void abandon();
+
+   // does nothing if not recording
+   void recordTick(const std::string &symbol, uint64 time, double bid, double ask);
+
+   ~TickRecorder();
+
+private:
+
+   struct SymbolLog {
+      SymbolLog();
+
+      uint32 index;
+      MappedFile *segment;
+      uint64 count;
+      uint64 flushed;
+
+      MappedFile *next;
+
+      // full segments the flusher hasn't finished yet
+      std::list<std::pair<MappedFile *, uint64> > retired;
+   };
+
+   SymbolLog *openLog(const std::string &symbol);
+   bool openSegment(SymbolLog &log, const std::string &symbol, uint32 index);
+   MappedFile *mapSegment(const std::string &symbol, uint32 index);
+
+   void ftFlusherThreadMethod();
+   void flushAll();
+
+   static void flush(MappedFile &segment, uint64 from, uint64 count);
+
+   void closeLogs();
+
+private:
+   Monitor *_synchronization;
+   Thread *_flusherThread;
+   bool _stopped;
+
+   std::string _directory;
+
+   std::map<std::string, SymbolLog *> _logs;
+};
+
+#endif 	// __1E5C7B93A2D64F08B6A9C3E5D7F18240_TICKRECORDER_H_INCLUDED__
@@ -0,0 +1,337 @@
+#include "TickStore.h"
+#include "TicksText.h"
+#include <string.h>
+#include <algorithm>
+
+enum {
+   COLUMN_PADDING = 8,
+   MAX_PACKED_BITS = 56,
+   MAX_UNIT_POWER = 18
+};
+
+const char TickStore::MAGIC[8] = { 'f', 'x', 't', 's', 't', 'o', 'r', 'e' };
+
+static const int64 POWERS_OF_TEN[MAX_UNIT_POWER + 1] = {
+   1LL, 10LL, 100LL, 1000LL, 10000LL, 100000LL, 1000000LL, 10000000LL,
+   100000000LL, 1000000000LL, 10000000000LL, 100000000000LL, 1000000000000LL,
+   10000000000000LL, 100000000000000LL, 1000000000000000LL,
+   10000000000000000LL, 100000000000000000LL, 1000000000000000000LL
+};
+
+static uint64 align(uint64 size) {
+   return (size + 7) / 8 * 8;
+}
+
+static uint64 zigzag(int64 value) {
+   return ((uint64)value << 1) ^ (uint64)(value >> 63);
+}
+
+static int64 unzigzag(uint64 value) {
+   return (int64)(value >> 1) ^ -(int64)(value & 1);
+}
+
+static void decodeColumn(const char *data,
+                         uint8 bits,
+                         uint8 unitPower,
+                         int64 first,
+                         uint32 count,
+                         int64 *output) {
+   const int64 unit = POWERS_OF_TEN[unitPower];
+
+   output[0] = first;
+
+   if (bits == 0) {
+      for (uint32 i = 1; i < count; ++i) output[i] = first;
+      return;
+   }
+
+   if (bits == 64) {
+      for (uint32 i = 1; i < count; ++i) {
+         uint64 raw;
+         memcpy(&raw, data + (i - 1) * 8, 8);
+         output[i] = output[i - 1] + unzigzag(raw) * unit;
+      }
+      return;
+   }
+
+   // every value is within 8 bytes from the byte it starts at, column is
+   // padded so reading them doesn't go past it
+   const uint64 mask = (1ULL << bits) - 1;
+   uint64 bit = 0;
+
+   for (uint32 i = 1; i < count; ++i, bit += bits) {
+      uint64 word;
+      memcpy(&word, data + (bit >> 3), 8);
+
+      output[i] = output[i - 1] + unzigzag((word >> (bit & 7)) & mask) * unit;
+   }
+}
+
+TickStore *TickStore::open(const std::string &path) {
+   MappedFile *file = Platform::instance().mapFileForReading(path);
+
+   if (file == nullptr) return nullptr;
+
+   const Header *header = (const Header *)file->data();
+
+   const bool valid = file->size() >= sizeof(Header)
+      && memcmp(header->magic, MAGIC, sizeof(MAGIC)) == 0
+      && header->version == VERSION
+      && header->chunkTicks == CHUNK_TICKS
+      && header->priceScale == TicksText::PRICE_SCALE
+      && header->indexOffset + header->chunks * sizeof(IndexEntry) <= file->size();
+
+   if (!valid) {
+      delete file;
+      return nullptr;
+   }
+
+   return new TickStore(file);
+}
+
+TickStore::TickStore(MappedFile *file)
+   : _file(file)
+   , _header((const Header *)file->data())
+   , _index((const IndexEntry *)(file->data() + _header->indexOffset)) {
+
+}
+
+const TickStore::ChunkHeader &TickStore::chunkHeader(uint64 chunk) const {
+   return *(const ChunkHeader *)(_file->data() + _index[chunk].offset);
+}
+
+int64 TickStore::firstTime() const {
+   return chunks() > 0 ? _index[0].firstTime : 0;
+}
+
+int64 TickStore::lastTime() const {
+   if (chunks() == 0) return 0;
+
+   Chunk *last = new Chunk();
+   decode(chunks() - 1, *last);
+
+   const int64 time = last->times[last->count - 1];
+
+   delete last;
+
+   return time;
+}
+
+void TickStore::decode(uint64 chunk, Chunk &output) const {
+   const ChunkHeader &header = chunkHeader(chunk);
+   const char *times = (const char *)(&header + 1);
+   const char *prices = times + header.timeBytes;
+
+   output.count = header.count;
+
+   decodeColumn(times, header.timeBits, header.timeUnitPower, header.firstTime, header.count, output.times);
+   decodeColumn(prices, header.priceBits, header.priceUnitPower, header.firstPrice, header.count, output.prices);
+}
+
+uint64 TickStore::findChunk(int64 time) const {
+   const IndexEntry *end = _index + chunks();
+
+   const IndexEntry *found = std::lower_bound(_index,
+                                              end,
+                                              time,
+                                              [](const IndexEntry &entry, int64 time) -> bool {
+                                                 return entry.firstTime < time;
+                                              } );
+
+   // ticks at time could start at the end of previous chunk
+   return found == _index ? 0 : found - _index - 1;
+}
+
+TickStore::~TickStore() {
+   delete _file;
+}
+
+TickStore::Cursor::Cursor(const TickStore &store)
+   : _store(store)
+   , _nextChunk(0)
+   , _position(0) {
+
+   _chunk.count = 0;
+}
+
+bool TickStore::Cursor::decodeNext() {
+   if (_nextChunk >= _store.chunks()) return false;
+
+   _store.decode(_nextChunk++, _chunk);
+   _position = 0;
+
+   return true;
+}
+
+void TickStore::Cursor::seek(int64 time) {
+   _nextChunk = _store.findChunk(time);
+   _chunk.count = 0;
+   _position = 0;
+
+   while (decodeNext()) {
+      _position = std::lower_bound(_chunk.times, _chunk.times + _chunk.count, time) - _chunk.times;
+
+      if (_position < _chunk.count) return;
+   }
+}
+
+TickStoreWriter::TickStoreWriter(const std::string &path)
+   : _file(fopen(path.c_str(), "wb"))
+   , _failed(false)
+   , _offset(0)
+   , _ticks(0) {
+
+   if (_file == NULL) return;
+
+   _times.reserve(TickStore::CHUNK_TICKS);
+   _prices.reserve(TickStore::CHUNK_TICKS);
+
+   // written again with counts when closed
+   TickStore::Header header;
+   memset(&header, 0, sizeof(header));
+
+   write(&header, sizeof(header));
+}
+
+void TickStoreWriter::write(const void *data, size_t size) {
+   if (fwrite(data, 1, size, _file) != size) _failed = true;
+
+   _offset += size;
+}
+
+void TickStoreWriter::add(int64 time, int64 price) {
+   _times.push_back(time);
+   _prices.push_back(price);
+
+   ++_ticks;
+
+   if (_times.size() == TickStore::CHUNK_TICKS) writeChunk();
+}
+
+void TickStoreWriter::encodeColumn(const int64 *values,
+                                   uint32 count,
+                                   uint8 &bits,
+                                   uint8 &unitPower,
+                                   std::string &output) {
+   output.clear();
+
+   // the largest power of ten all deltas are divisible by
+   unitPower = MAX_UNIT_POWER;
+
+   for (uint32 i = 1; i < count && unitPower > 0; ++i) {
+      const int64 delta = values[i] - values[i - 1];
+
+      while (unitPower > 0 && delta % POWERS_OF_TEN[unitPower] != 0) --unitPower;
+   }
+
+   const int64 unit = POWERS_OF_TEN[unitPower];
+
+   uint64 largest = 0;
+
+   for (uint32 i = 1; i < count; ++i) {
+      largest = std::max(largest, zigzag((values[i] - values[i - 1]) / unit));
+   }
+
+   bits = 0;
+   while (bits < 64 && (largest >> bits) != 0) ++bits;
+
+   if (bits > MAX_PACKED_BITS) bits = 64;
+
+   if (bits == 0) unitPower = 0;
+
+   uint64 accumulator = 0;
+   int accumulated = 0;
+
+   for (uint32 i = 1; i < count && bits > 0; ++i) {
+      const uint64 value = zigzag((values[i] - values[i - 1]) / unit);
+
+      if (bits == 64) {
+         output.append((const char *)&value, 8);
+         continue;
+      }
+
+      // less than a byte is left in accumulator, so value fits
+      accumulator |= value << accumulated;
+      accumulated += bits;
+
+      while (accumulated >= 8) {
+         output.push_back((char)(accumulator & 0xFF));
+         accumulator >>= 8;
+         accumulated -= 8;
+      }
+   }
+
+   while (accumulated > 0) {
+      output.push_back((char)(accumulator & 0xFF));
+      accumulator >>= 8;
+      accumulated -= 8;
+   }
+
+   output.append(COLUMN_PADDING, '\0');
+}
+
+void TickStoreWriter::writeChunk() {
+   if (_times.empty()) return;
+
+   TickStore::ChunkHeader header;
+   memset(&header, 0, sizeof(header));
+
+   header.firstTime = _times.front();
+   header.firstPrice = _prices.front();
+   header.count = _times.size();
+
+   TickStore::IndexEntry entry;
+   entry.firstTime = header.firstTime;
+   entry.offset = _offset;
+
+   _index.push_back(entry);
+
+   std::string prices;
+
+   encodeColumn(&_times[0], header.count, header.timeBits, header.timeUnitPower, _column);
+   encodeColumn(&_prices[0], header.count, header.priceBits, header.priceUnitPower, prices);
+
+   header.timeBytes = _column.size();
+   header.priceBytes = prices.size();
+
+   write(&header, sizeof(header));
+   write(_column.data(), _column.size());
+   write(prices.data(), prices.size());
+
+   const char zeroes[8] = { 0 };
+   write(zeroes, align(_offset) - _offset);
+
+   _times.clear();
+   _prices.clear();
+}
+
+bool TickStoreWriter::close() {
+   if (_file == NULL) return false;
+
+   writeChunk();
+
+   TickStore::Header header;
+   memset(&header, 0, sizeof(header));
+
+   memcpy(header.magic, TickStore::MAGIC, sizeof(header.magic));
+   header.version = TickStore::VERSION;
+   header.chunkTicks = TickStore::CHUNK_TICKS;
+   header.ticks = _ticks;
+   header.chunks = _index.size();
+   header.indexOffset = _offset;
+   header.priceScale = TicksText::PRICE_SCALE;
+
+   if (!_index.empty()) write(&_index[0], _index.size() * sizeof(TickStore::IndexEntry));
+
+   if (fseek(_file, 0, SEEK_SET) != 0) _failed = true;
+   if (fwrite(&header, 1, sizeof(header), _file) != sizeof(header)) _failed = true;
+
+   if (fclose(_file) != 0) _failed = true;
+   _file = NULL;
+
+   return !_failed;
+}
+
+TickStoreWriter::~TickStoreWriter() {
+   if (_file != NULL) close();
+}
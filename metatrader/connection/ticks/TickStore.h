@@ -0,0 +1,188 @@
+#ifndef __1E5C7B93A2D64F08B6A9C3E5D7F18240_TICKSTORE_H_INCLUDED__
+#define __1E5C7B93A2D64F08B6A9C3E5D7F18240_TICKSTORE_H_INCLUDED__
+
+#include <string>
+#include <vector>
+#include <stdio.h>
+#include "platform.h"
+
+/**
+ * Columnar store of tick history, read through memory mapping.
+ *
+ * Ticks are time in milliseconds since 1970 and price scaled by
+ * TicksText::PRICE_SCALE, as the hub's Time and Fraction. They are split
+ * to chunks of CHUNK_TICKS, chunk has the column of times followed by the
+ * column of prices. Column keeps its first value as it is and the rest as
+ * deltas, deltas are divided by the largest power of ten common to them
+ * (whole seconds, whole pips), zigzag encoded and bit packed with width of
+ * the largest one in the chunk. Decoding is shifts and sums, without
+ * branches on values.
+ *
+ * After the chunks goes sparse index, first time and offset of every
+ * chunk, so seek is a binary search in index and in one decoded chunk.
+ * Ticks are expected to be in order of time, seek doesn't work otherwise.
+ *
+ * Layout, in byte order of the machine:
+ *
+ *   Header
+ *   chunks: ChunkHeader, time column, price column, each column padded
+ *           with 8 zero bytes and the chunk aligned to 8 bytes
+ *   index:  IndexEntry for every chunk
+ */
+class TickStore {
+   TickStore(const TickStore &referenceToCopyFrom);
+   void operator=(const TickStore &referenceToCopyFrom);
+
+public:
+
+   enum {
+      VERSION = 1,
+      CHUNK_TICKS = 4096
+   };
+
+   static const char MAGIC[8];
+
+   struct Header {
+      char magic[8];
+      uint32 version;
+      uint32 chunkTicks;
+      uint64 ticks;
+      uint64 chunks;
+      uint64 indexOffset;
+      int64 priceScale;
+   };
+
+   struct ChunkHeader {
+      int64 firstTime;
+      int64 firstPrice;
+      uint32 count;
+      uint8 timeBits;
+      uint8 priceBits;
+      uint8 timeUnitPower;
+      uint8 priceUnitPower;
+      uint32 timeBytes;
+      uint32 priceBytes;
+   };
+
+   struct IndexEntry {
+      int64 firstTime;
+      uint64 offset;
+   };
+
+   /**
+    * Ticks of one chunk as columns.
+    */
+   struct Chunk {
+      uint32 count;
+      int64 times[CHUNK_TICKS];
+      int64 prices[CHUNK_TICKS];
+   };
+
+   // nullptr if file can't be mapped or isn't a store
+   static TickStore *open(const std::string &path);
+
+   uint64 ticks() const { return _header->ticks; }
+   uint64 chunks() const { return _header->chunks; }
+
+   int64 firstTime() const;
+   int64 lastTime() const;
+
+   // decodes chunk with given number
+   void decode(uint64 chunk, Chunk &output) const;
+
+   // number of the chunk where ticks at or after time begin
+   uint64 findChunk(int64 time) const;
+
+   /**
+    * Reads ticks one by one, decoding chunk by chunk.
+    */
+   class Cursor {
+   public:
+      Cursor(const TickStore &store);
+
+      // positions at the first tick at or after time
+      void seek(int64 time);
+
+      // false after the last tick
+      bool next(int64 &time, int64 &price) {
+         if (_position == _chunk.count && !decodeNext()) return false;
+
+         time = _chunk.times[_position];
+         price = _chunk.prices[_position];
+         ++_position;
+
+         return true;
+      }
+
+   private:
+      bool decodeNext();
+
+   private:
+      const TickStore &_store;
+
+      uint64 _nextChunk;
+      uint32 _position;
+      Chunk _chunk;
+   };
+
+   ~TickStore();
+
+private:
+   TickStore(MappedFile *file);
+
+   const ChunkHeader &chunkHeader(uint64 chunk) const;
+
+private:
+   MappedFile *_file;
+
+   const Header *_header;
+   const IndexEntry *_index;
+};
+
+/**
+ * Writes TickStore file, ticks should be added in order of time.
+ */
+class TickStoreWriter {
+   TickStoreWriter(const TickStoreWriter &referenceToCopyFrom);
+   void operator=(const TickStoreWriter &referenceToCopyFrom);
+
+public:
+   TickStoreWriter(const std::string &path);
+
+   // false if file can't be created
+   bool isOpened() const { return _file != NULL; }
+
+   void add(int64 time, int64 price);
+
+   // writes the rest and index, false if writing failed
+   bool close();
+
+   ~TickStoreWriter();
+
+private:
+   void writeChunk();
+
+   static void encodeColumn(const int64 *values,
+                            uint32 count,
+                            uint8 &bits,
+                            uint8 &unitPower,
+                            std::string &output);
+
+   void write(const void *data, size_t size);
+
+private:
+   FILE *_file;
+   bool _failed;
+
+   uint64 _offset;
+   uint64 _ticks;
+
+   std::vector<int64> _times;
+   std::vector<int64> _prices;
+
+   std::vector<TickStore::IndexEntry> _index;
+
+   std::string _column;
+};
+
+#endif 	// __1E5C7B93A2D64F08B6A9C3E5D7F18240_TICKSTORE_H_INCLUDED__
@@ -0,0 +1,98 @@
+#include "TicksBinaryCache.h"
+
+enum {
+   STREAM_MAGIC = 0xACED,
+   STREAM_VERSION = 5,
+
+   TC_BLOCKDATA = 0x77,
+   TC_BLOCKDATALONG = 0x7A,
+   TC_RESET = 0x79
+};
+
+TicksBinaryCache::Reader::Reader(const std::string &path)
+   : _file(fopen(path.c_str(), "rb"))
+   , _valid(false)
+   , _blockLeft(0) {
+
+   if (_file == NULL) return;
+
+   uint8 header[4];
+
+   _valid = fread(header, 1, 4, _file) == 4
+      && (header[0] << 8 | header[1]) == STREAM_MAGIC
+      && (header[2] << 8 | header[3]) == STREAM_VERSION;
+}
+
+bool TicksBinaryCache::Reader::nextBlock() {
+   while (true) {
+      const int tag = fgetc(_file);
+
+      if (tag == TC_RESET) continue;
+
+      if (tag == TC_BLOCKDATA) {
+         const int size = fgetc(_file);
+         if (size == EOF) return false;
+
+         _blockLeft = size;
+      } else if (tag == TC_BLOCKDATALONG) {
+         uint8 size[4];
+         if (fread(size, 1, 4, _file) != 4) return false;
+
+         _blockLeft = (uint32)size[0] << 24 | size[1] << 16 | size[2] << 8 | size[3];
+      } else {
+         return false;
+      }
+
+      if (_blockLeft > 0) return true;
+   }
+}
+
+bool TicksBinaryCache::Reader::readByte(uint8 &value) {
+   if (_blockLeft == 0 && !nextBlock()) return false;
+
+   const int byte = fgetc(_file);
+   if (byte == EOF) return false;
+
+   value = byte;
+   --_blockLeft;
+
+   return true;
+}
+
+bool TicksBinaryCache::Reader::readLong(int64 &value) {
+   // fast path, long is within current block
+   if (_blockLeft >= 8) {
+      uint8 bytes[8];
+      if (fread(bytes, 1, 8, _file) != 8) return false;
+
+      _blockLeft -= 8;
+
+      uint64 result = 0;
+      for (int i = 0; i < 8; ++i) result = result << 8 | bytes[i];
+
+      value = result;
+      return true;
+   }
+
+   uint64 result = 0;
+
+   for (int i = 0; i < 8; ++i) {
+      uint8 byte;
+      if (!readByte(byte)) return false;
+
+      result = result << 8 | byte;
+   }
+
+   value = result;
+   return true;
+}
+
+bool TicksBinaryCache::Reader::next(int64 &time, int64 &price) {
+   return _valid
+      && readLong(price)
+      && readLong(time);
+}
+
+TicksBinaryCache::Reader::~Reader() {
+   if (_file != NULL) fclose(_file);
+}
@@ -0,0 +1,48 @@
+#ifndef __1E5C7B93A2D64F08B6A9C3E5D7F18240_TICKSBINARYCACHE_H_INCLUDED__
+#define __1E5C7B93A2D64F08B6A9C3E5D7F18240_TICKSBINARYCACHE_H_INCLUDED__
+
+#include <string>
+#include <stdio.h>
+#include "common.h"
+
+/**
+ * Reader of ticks.bin.cache.v3 files written by the hub's TicksBinaryCache:
+ * java ObjectOutputStream with price (Fraction, long scaled by
+ * TicksText::PRICE_SCALE) and time (long milliseconds) for every tick.
+ *
+ * Longs of object stream are in block data records, which are unwrapped
+ * here, other records are not expected and end reading.
+ */
+class TicksBinaryCache {
+public:
+
+   class Reader {
+      Reader(const Reader &referenceToCopyFrom);
+      void operator=(const Reader &referenceToCopyFrom);
+
+   public:
+      Reader(const std::string &path);
+
+      // false if file can't be opened or isn't an object stream
+      bool isValid() const { return _valid; }
+
+      // false at the end of ticks
+      bool next(int64 &time, int64 &price);
+
+      ~Reader();
+
+   private:
+      bool readLong(int64 &value);
+      bool readByte(uint8 &value);
+      bool nextBlock();
+
+   private:
+      FILE *_file;
+      bool _valid;
+
+      // bytes left in current block data record
+      uint32 _blockLeft;
+   };
+};
+
+#endif 	// __1E5C7B93A2D64F08B6A9C3E5D7F18240_TICKSBINARYCACHE_H_INCLUDED__
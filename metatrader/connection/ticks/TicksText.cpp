@@ -0,0 +1,183 @@
+#include "TicksText.h"
+#include <stdio.h>
+
+enum {
+   SECONDS_PER_DAY = 24 * 60 * 60,
+   // days from 0000-03-01 to 1970-01-01
+   EPOCH_DAYS = 719468,
+   DAYS_PER_ERA = 146097,
+
+   MAX_DIGITS = 8
+};
+
+void TicksText::toCalendar(uint64 time,
+                           int &year, int &month, int &day,
+                           int &hours, int &minutes, int &seconds) {
+   const uint64 secondsOfDay = time % SECONDS_PER_DAY;
+
+   hours = secondsOfDay / 3600;
+   minutes = secondsOfDay % 3600 / 60;
+   seconds = secondsOfDay % 60;
+
+   // civil from days, years counted from march so leap day is the last
+   const uint64 days = time / SECONDS_PER_DAY + EPOCH_DAYS;
+   const uint64 era = days / DAYS_PER_ERA;
+   const uint64 dayOfEra = days - era * DAYS_PER_ERA;
+   const uint64 yearOfEra = (dayOfEra - dayOfEra / 1460 + dayOfEra / 36524 - dayOfEra / 146096) / 365;
+   const uint64 dayOfYear = dayOfEra - (365 * yearOfEra + yearOfEra / 4 - yearOfEra / 100);
+   const uint64 monthFromMarch = (5 * dayOfYear + 2) / 153;
+
+   day = dayOfYear - (153 * monthFromMarch + 2) / 5 + 1;
+   month = monthFromMarch < 10 ? monthFromMarch + 3 : monthFromMarch - 9;
+   year = yearOfEra + era * 400 + (month <= 2 ? 1 : 0);
+}
+
+uint64 TicksText::fromCalendar(int year, int month, int day,
+                               int hours, int minutes, int seconds) {
+   const uint64 marchYear = month <= 2 ? year - 1 : year;
+   const uint64 era = marchYear / 400;
+   const uint64 yearOfEra = marchYear - era * 400;
+   const uint64 dayOfYear = (153 * (month > 2 ? month - 3 : month + 9) + 2) / 5 + day - 1;
+   const uint64 dayOfEra = yearOfEra * 365 + yearOfEra / 4 - yearOfEra / 100 + dayOfYear;
+
+   const uint64 days = era * DAYS_PER_ERA + dayOfEra - EPOCH_DAYS;
+
+   return days * SECONDS_PER_DAY + hours * 3600 + minutes * 60 + seconds;
+}
+
+int TicksText::formatLine(char *buffer, uint64 time, double price, int digits) {
+   int year, month, day, hours, minutes, seconds;
+
+   toCalendar(time, year, month, day, hours, minutes, seconds);
+
+   int size = snprintf(buffer,
+                       MAX_LINE_SIZE + 1,
+                       "%04d-%02d-%02d-%02d-%02d-%02d %.*f",
+                       year, month, day, hours, minutes, seconds,
+                       digits < 0 || digits > MAX_DIGITS ? MAX_DIGITS : digits,
+                       price);
+
+   if (size < 0 || size > MAX_LINE_SIZE - 1) size = MAX_LINE_SIZE - 1;
+
+   if (digits < 0) {
+      while (buffer[size - 1] == '0') --size;
+      if (buffer[size - 1] == '.') --size;
+   }
+
+   buffer[size++] = '\n';
+   buffer[size] = '\0';
+
+   return size;
+}
+
+int TicksText::formatScaledLine(char *buffer, int64 time, int64 price) {
+   int year, month, day, hours, minutes, seconds;
+
+   toCalendar(time / 1000, year, month, day, hours, minutes, seconds);
+
+   int size = snprintf(buffer,
+                       MAX_LINE_SIZE + 1,
+                       "%04d-%02d-%02d-%02d-%02d-%02d ",
+                       year, month, day, hours, minutes, seconds);
+
+   if (size < 0 || size > MAX_LINE_SIZE - MAX_PRICE_SIZE - 1) size = 0;
+
+   size += formatPrice(buffer + size, price);
+
+   buffer[size++] = '\n';
+   buffer[size] = '\0';
+
+   return size;
+}
+
+int TicksText::formatPrice(char *buffer, int64 price) {
+   const uint64 absolute = price < 0 ? -price : price;
+
+   int size = snprintf(buffer,
+                       MAX_PRICE_SIZE + 1,
+                       "%s%llu.%010llu",
+                       price < 0 ? "-" : "",
+                       absolute / PRICE_SCALE,
+                       absolute % PRICE_SCALE);
+
+   if (size < 0 || size > MAX_PRICE_SIZE) size = MAX_PRICE_SIZE;
+
+   while (buffer[size - 1] == '0') --size;
+   if (buffer[size - 1] == '.') --size;
+
+   buffer[size] = '\0';
+
+   return size;
+}
+
+static bool parseNumber(const char *&position, const char *end, int digits, int &value) {
+   value = 0;
+
+   for (int i = 0; i < digits; ++i, ++position) {
+      if (position == end || *position < '0' || *position > '9') return false;
+
+      value = value * 10 + (*position - '0');
+   }
+
+   return true;
+}
+
+static bool skip(const char *&position, const char *end, char expected) {
+   if (position == end || *position != expected) return false;
+
+   ++position;
+   return true;
+}
+
+bool TicksText::parseLine(const char *begin, const char *end, int64 &time, int64 &price) {
+   const char *position = begin;
+
+   int year, month, day, hours, minutes, seconds;
+
+   if (!(parseNumber(position, end, 4, year) && skip(position, end, '-')
+         && parseNumber(position, end, 2, month) && skip(position, end, '-')
+         && parseNumber(position, end, 2, day) && skip(position, end, '-')
+         && parseNumber(position, end, 2, hours) && skip(position, end, '-')
+         && parseNumber(position, end, 2, minutes) && skip(position, end, '-')
+         && parseNumber(position, end, 2, seconds) && skip(position, end, ' '))) return false;
+
+   if (month < 1 || month > 12 || day < 1 || day > 31) return false;
+
+   time = fromCalendar(year, month, day, hours, minutes, seconds) * 1000;
+
+   // windows line ends
+   if (end > position && end[-1] == '\r') --end;
+
+   const bool isNegative = position != end && *position == '-';
+   if (isNegative) ++position;
+
+   int64 integral = 0;
+   int64 fraction = 0;
+   int fractionDigits = 0;
+   bool haveDigits = false;
+
+   for (; position != end && *position >= '0' && *position <= '9'; ++position) {
+      integral = integral * 10 + (*position - '0');
+      haveDigits = true;
+   }
+
+   if (position != end && *position == '.') {
+      for (++position; position != end && *position >= '0' && *position <= '9'; ++position) {
+         if (fractionDigits < PRICE_DIGITS) {
+            fraction = fraction * 10 + (*position - '0');
+            ++fractionDigits;
+         }
+
+         haveDigits = true;
+      }
+   }
+
+   if (!haveDigits || position != end) return false;
+
+   for (; fractionDigits < PRICE_DIGITS; ++fractionDigits) fraction *= 10;
+
+   price = integral * PRICE_SCALE + fraction;
+   if (isNegative) price = -price;
+
+   return true;
+}
@@ -0,0 +1,66 @@
+#ifndef __1E5C7B93A2D64F08B6A9C3E5D7F18240_TICKSTEXT_H_INCLUDED__
+#define __1E5C7B93A2D64F08B6A9C3E5D7F18240_TICKSTEXT_H_INCLUDED__
+
+#include <string>
+#include "common.h"
+
+/**
+ * Text format of ticks exported from mt (ticks.mt.txt), one tick per line:
+ *
+ *   2013-05-17-14-03-59 1.28561
+ *
+ * Time is wall clock of the terminal, with seconds precision.
+ */
+class TicksText {
+public:
+
+   enum {
+      // longest line without newline
+      MAX_LINE_SIZE = 64,
+
+      // longest price written by formatPrice
+      MAX_PRICE_SIZE = 32,
+
+      // parsed prices are integers with this many decimal digits, as
+      // tas.types.Fraction of the hub
+      PRICE_DIGITS = 10
+   };
+
+   static const int64 PRICE_SCALE = 10000000000LL;
+
+   /**
+    * Writes line with newline to buffer of MAX_LINE_SIZE + 1, returns its
+    * size. Price has digits after the point, or as few as needed if
+    * digits are negative.
+    */
+   static int formatLine(char *buffer, uint64 time, double price, int digits);
+
+   /**
+    * Same for time in milliseconds and price scaled by PRICE_SCALE,
+    * written as exactly as Fraction would be.
+    */
+   static int formatScaledLine(char *buffer, int64 time, int64 price);
+
+   /**
+    * Writes price scaled by PRICE_SCALE as Fraction's toString does to
+    * buffer of MAX_PRICE_SIZE + 1, returns its size.
+    */
+   static int formatPrice(char *buffer, int64 price);
+
+   /**
+    * Parses line without newline to milliseconds since 1970 and price
+    * scaled by PRICE_SCALE, digits after PRICE_DIGITS are dropped as
+    * Fraction does. Returns false if line is not a tick.
+    */
+   static bool parseLine(const char *begin, const char *end, int64 &time, int64 &price);
+
+   // seconds since 1970 to calendar, as mt's TimeYear() and friends
+   static void toCalendar(uint64 time,
+                          int &year, int &month, int &day,
+                          int &hours, int &minutes, int &seconds);
+
+   static uint64 fromCalendar(int year, int month, int day,
+                              int hours, int minutes, int seconds);
+};
+
+#endif 	// __1E5C7B93A2D64F08B6A9C3E5D7F18240_TICKSTEXT_H_INCLUDED__
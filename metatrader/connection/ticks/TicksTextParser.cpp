@@ -0,0 +1,317 @@
+#include "TicksTextParser.h"
+#include "TicksText.h"
+#include "platform.h"
+#include <string.h>
+#include <stdio.h>
+
+#ifdef __SSE2__
+#include <emmintrin.h>
+#endif
+
+enum {
+   // "YYYY-MM-DD-hh-mm-ss price"
+   PRICE_OFFSET = 20,
+
+   WORD_DIGITS = 8,
+   // fast path looks for line end in this many bytes after the date
+   LINE_END_WINDOW = 16,
+   // and reads two words of price, the second after the point
+   READ_SIZE = 2 * WORD_DIGITS + 1 > LINE_END_WINDOW ? 2 * WORD_DIGITS + 1 : LINE_END_WINDOW,
+
+   // to reserve columns
+   TYPICAL_LINE_SIZE = 26
+};
+
+static const uint64 ZEROES = 0x3030303030303030ULL;
+static const uint64 HIGH_BITS = 0x8080808080808080ULL;
+
+// characters of the date with '0' for digits, in byte order of little
+// endian machine
+static const uint64 DATE_PATTERN = 0x2D30302D30303030ULL;   // "0000-00-"
+static const uint64 DAY_PATTERN = 0x30302D30302D3030ULL;    // "00-00-00"
+static const uint64 CLOCK_PATTERN = 0x2030302D30302D30ULL;  // "0-00-00 "
+
+// added to the date minus pattern, set high bits of digits above 9 and of
+// separators above 0
+static const uint64 DATE_LIMITS = 0x7F76767F76767676ULL;
+static const uint64 DAY_LIMITS = 0x76767F76767F7676ULL;
+static const uint64 CLOCK_LIMITS = 0x7F76767F76767F76ULL;
+
+// low bytes of word holding first count characters
+static const uint64 COUNT_MASKS[WORD_DIGITS + 1] = {
+   0x0000000000000000ULL, 0x00000000000000FFULL, 0x000000000000FFFFULL,
+   0x0000000000FFFFFFULL, 0x00000000FFFFFFFFULL, 0x000000FFFFFFFFFFULL,
+   0x0000FFFFFFFFFFFFULL, 0x00FFFFFFFFFFFFFFULL, 0xFFFFFFFFFFFFFFFFULL
+};
+
+// multiplier of fraction with count digits, to PRICE_DIGITS
+static const int64 FRACTION_SCALES[WORD_DIGITS + 1] = {
+   10000000000LL, 1000000000LL, 100000000LL, 10000000LL, 1000000LL,
+   100000LL, 10000LL, 1000LL, 100LL
+};
+
+struct DayCache {
+   DayCache() : key(-1), seconds(0) {}
+
+   int key;
+   int64 seconds;
+};
+
+static inline uint64 loadWord(const char *data) {
+   uint64 word;
+   memcpy(&word, data, 8);
+   return word;
+}
+
+/**
+ * Number from the first count characters of word (in byte order of
+ * little endian machine, first character is the lowest byte). Invalid
+ * gets high bits if any of those characters is not a digit.
+ */
+static inline uint64 parseDigits(uint64 word, int count, uint64 &invalid) {
+   const uint64 mask = COUNT_MASKS[count];
+
+   // a byte below '0' gets high bit from subtraction, above '9' from
+   // addition, borrows and carries go only to following bytes
+   invalid |= ((word - ZEROES) | (word + 0x4646464646464646ULL) | word) & HIGH_BITS & mask;
+
+   // characters past count are shifted out, zeroes shifted in are leading
+   // zeroes of the number
+   uint64 digits = ((word & 0x0F0F0F0F0F0F0F0FULL & mask) << ((8 * (WORD_DIGITS - count)) & 63));
+
+   digits = (digits * 2561) >> 8;
+   digits = ((digits & 0x00FF00FF00FF00FFULL) * 6553601) >> 16;
+
+   return ((digits & 0x0000FFFF0000FFFFULL) * 42949672960001ULL) >> 32;
+}
+
+#ifdef __SSE2__
+
+// mask of bytes of block equal to character
+static inline unsigned matches(__m128i block, char character) {
+   return _mm_movemask_epi8(_mm_cmpeq_epi8(block, _mm_set1_epi8(character)));
+}
+
+#endif
+
+/**
+ * Line of usual shape which ends within LINE_END_WINDOW bytes after the
+ * date, at least PRICE_OFFSET + LINE_END_WINDOW bytes from line should be
+ * readable. Sets end of the line and returns true if it's parsed, line
+ * should be parsed by the slow path otherwise.
+ */
+static inline bool parseFast(const char *line,
+                             const char *&lineEnd,
+                             DayCache &days,
+                             int64 &time,
+                             int64 &price) {
+   const char *priceText = line + PRICE_OFFSET;
+
+#ifdef __SSE2__
+   const __m128i block = _mm_loadu_si128((const __m128i *)priceText);
+   const unsigned newlines = matches(block, '\n');
+
+   if (newlines == 0) return false;
+
+   int size = __builtin_ctz(newlines);
+#else
+   const char *newline = (const char *)memchr(priceText, '\n', LINE_END_WINDOW);
+
+   if (newline == NULL) return false;
+
+   int size = newline - priceText;
+#endif
+
+   // the newline is the end of line only if there are no newlines in the
+   // date, what is checked below
+   lineEnd = priceText + size;
+
+   if (size > 0 && priceText[size - 1] == '\r') --size;
+
+   // date is three words: "YYYY-MM-", "DD-hh-mm" and "h-mm-ss ", minus
+   // their patterns digits are 0..9 and separators are 0
+   const uint64 date = loadWord(line) - DATE_PATTERN;
+   const uint64 day = loadWord(line + 8) - DAY_PATTERN;
+   const uint64 clock = loadWord(line + 12) - CLOCK_PATTERN;
+
+   uint64 bad = ((date | (date + DATE_LIMITS)) | (day | (day + DAY_LIMITS))
+                 | (clock | (clock + CLOCK_LIMITS))) & HIGH_BITS;
+
+   // byte of each pair of digits gets its number
+   const uint64 datePairs = date * 10 + (date >> 8);
+   const uint64 dayPairs = day * 10 + (day >> 8);
+   const uint64 clockPairs = clock * 10 + (clock >> 8);
+
+   const int year = (datePairs & 0xFF) * 100 + ((datePairs >> 16) & 0xFF);
+   const int month = (datePairs >> 40) & 0xFF;
+   const int dayOfMonth = dayPairs & 0xFF;
+   const int hours = (dayPairs >> 24) & 0xFF;
+   const int minutes = (dayPairs >> 48) & 0xFF;
+   const int seconds = (clockPairs >> 40) & 0xFF;
+
+   bad |= ((unsigned)(month - 1) > 11) | ((unsigned)(dayOfMonth - 1) > 30);
+
+   // price is integral digits, point and fraction digits
+#ifdef __SSE2__
+   const unsigned points = matches(block, '.');
+   int point = points ? __builtin_ctz(points) : size;
+#else
+   const char *pointAt = (const char *)memchr(priceText, '.', size);
+   int point = pointAt ? pointAt - priceText : size;
+#endif
+
+   if (point > size) point = size;
+
+   const int integralDigits = point;
+   const int fractionDigits = point < size ? size - point - 1 : 0;
+
+   bad |= (integralDigits + fractionDigits == 0)
+      | (integralDigits > WORD_DIGITS)
+      | (fractionDigits > WORD_DIGITS);
+
+   if (bad) return false;
+
+   uint64 invalid = 0;
+
+   if (size <= WORD_DIGITS) {
+      // usual price fits a word, digits are parsed at once without point
+      const uint64 word = loadWord(priceText);
+      const uint64 integralMask = COUNT_MASKS[point];
+      const uint64 digits = (word & integralMask) | ((word >> 8) & ~integralMask);
+
+      price = parseDigits(digits, integralDigits + fractionDigits, invalid) * FRACTION_SCALES[fractionDigits];
+   } else {
+      const uint64 integral = parseDigits(loadWord(priceText), integralDigits, invalid);
+      const uint64 fraction = parseDigits(loadWord(priceText + point + 1), fractionDigits, invalid);
+
+      price = integral * TicksText::PRICE_SCALE + fraction * FRACTION_SCALES[fractionDigits];
+   }
+
+   if (invalid) return false;
+
+   // ticks come in order, so most of lines are of the same day
+   const int dayKey = (year * 16 + month) * 32 + dayOfMonth;
+
+   if (dayKey != days.key) {
+      days.key = dayKey;
+      days.seconds = TicksText::fromCalendar(year, month, dayOfMonth, 0, 0, 0);
+   }
+
+   time = (days.seconds + hours * 3600 + minutes * 60 + seconds) * 1000;
+
+   return true;
+}
+
+void TicksTextParser::parse(const char *begin, const char *end, Columns &output) {
+   parse(begin, end, end, output);
+}
+
+void TicksTextParser::parse(const char *begin, const char *end, const char *dataEnd, Columns &output) {
+   DayCache days;
+
+   const char *line = begin;
+
+   while (line < end) {
+      const char *lineEnd;
+      int64 time, price;
+
+      if (dataEnd - line >= PRICE_OFFSET + READ_SIZE && parseFast(line, lineEnd, days, time, price)) {
+         output.times.push_back(time);
+         output.prices.push_back(price);
+
+         line = lineEnd + 1;
+         continue;
+      }
+
+      lineEnd = (const char *)memchr(line, '\n', end - line);
+      if (lineEnd == NULL) lineEnd = end;
+
+      if (TicksText::parseLine(line, lineEnd, time, price)) {
+         output.times.push_back(time);
+         output.prices.push_back(price);
+      } else if (lineEnd != line) {
+         ++output.skipped;
+      }
+
+      line = lineEnd + 1;
+   }
+}
+
+bool TicksTextParser::parseFile(const std::string &path, int threads, Columns &output) {
+   MappedFile *file = Platform::instance().mapFileForReading(path);
+
+   if (file == nullptr) {
+      // empty files are not mapped
+      FILE *empty = fopen(path.c_str(), "rb");
+      if (empty == NULL) return false;
+
+      const bool isEmpty = fgetc(empty) == EOF;
+      fclose(empty);
+
+      return isEmpty;
+   }
+
+   const char *data = file->data();
+   const char *end = data + file->size();
+
+   if (threads < 1) threads = 1;
+
+   // parts start after line ends
+   std::vector<const char *> starts(threads + 1, end);
+   starts[0] = data;
+
+   for (int i = 1; i < threads; ++i) {
+      const char *start = data + file->size() * i / threads;
+      if (start < starts[i - 1]) start = starts[i - 1];
+
+      const char *lineEnd = (const char *)memchr(start, '\n', end - start);
+      starts[i] = lineEnd ? lineEnd + 1 : end;
+   }
+
+   std::vector<Columns> parts(threads);
+   std::vector<Thread *> workers;
+
+   for (int i = 0; i < threads; ++i) {
+      const char *begin = starts[i];
+      const char *partEnd = starts[i + 1];
+      Columns &part = parts[i];
+
+      const Thread::Action action = [begin, partEnd, end, &part]() -> void {
+         part.times.reserve((partEnd - begin) / TYPICAL_LINE_SIZE);
+         part.prices.reserve((partEnd - begin) / TYPICAL_LINE_SIZE);
+
+         parse(begin, partEnd, end, part);
+      };
+
+      if (i + 1 < threads) {
+         workers.push_back(Platform::instance().createThread(action));
+      } else {
+         action();
+      }
+   }
+
+   for (Thread *worker : workers) Thread::joinAndDelete(worker);
+
+   delete file;
+
+   if (threads == 1) {
+      output.times.swap(parts[0].times);
+      output.prices.swap(parts[0].prices);
+      output.skipped += parts[0].skipped;
+      return true;
+   }
+
+   size_t total = output.times.size();
+   for (const Columns &part : parts) total += part.times.size();
+
+   output.times.reserve(total);
+   output.prices.reserve(total);
+
+   for (const Columns &part : parts) {
+      output.times.insert(output.times.end(), part.times.begin(), part.times.end());
+      output.prices.insert(output.prices.end(), part.prices.begin(), part.prices.end());
+      output.skipped += part.skipped;
+   }
+
+   return true;
+}
@@ -0,0 +1,49 @@
+#ifndef __1E5C7B93A2D64F08B6A9C3E5D7F18240_TICKSTEXTPARSER_H_INCLUDED__
+#define __1E5C7B93A2D64F08B6A9C3E5D7F18240_TICKSTEXTPARSER_H_INCLUDED__
+
+#include <string>
+#include <vector>
+#include "common.h"
+
+/**
+ * Fast parser of whole ticks.mt.txt files (see TicksText) to columns of
+ * times in milliseconds and prices scaled by TicksText::PRICE_SCALE.
+ *
+ * File is mapped and parsed line by line. Lines of the usual shape (date
+ * and up to 16 characters of price) are parsed without branches on their
+ * characters: end of line and point of price are found in one 16 byte
+ * block with sse2 where it's available, date is checked and parsed as three
+ * 8 byte words against its pattern, digits of price as 8 byte words. Other
+ * lines go to TicksText::parseLine, so results are always the same as of
+ * it.
+ *
+ * With several threads file is split to parts on line boundaries, every
+ * thread parses its part to own columns, which are joined in order.
+ */
+class TicksTextParser {
+public:
+
+   struct Columns {
+      Columns() : skipped(0) {}
+
+      std::vector<int64> times;
+      std::vector<int64> prices;
+
+      // lines which are not ticks, empty lines are not counted
+      uint64 skipped;
+   };
+
+   /**
+    * Parses file with given number of threads, returns false if file
+    * can't be mapped. Empty file is parsed to empty columns.
+    */
+   static bool parseFile(const std::string &path, int threads, Columns &output);
+
+   // parses whole lines between begin and end, end is end of data
+   static void parse(const char *begin, const char *end, Columns &output);
+
+   // the same, for part which can be read up to dataEnd
+   static void parse(const char *begin, const char *end, const char *dataEnd, Columns &output);
+};
+
+#endif 	// __1E5C7B93A2D64F08B6A9C3E5D7F18240_TICKSTEXTPARSER_H_INCLUDED__
@@ -0,0 +1,205 @@
+#include "TicksToPeriods.h"
+#include "platform.h"
+#include <stdio.h>
+#include <algorithm>
+
+enum {
+   LANES = 4
+};
+
+/**
+ * Min and max of values, which are reduced in LANES independent
+ * accumulators without branches, so the loop is vectorized where there
+ * are instructions for it and pipelined otherwise.
+ */
+static void reduce(const int64 *values, uint64 count, int64 &min, int64 &max) {
+   int64 mins[LANES], maxs[LANES];
+
+   for (int lane = 0; lane < LANES; ++lane) mins[lane] = maxs[lane] = values[0];
+
+   uint64 i = 0;
+
+   for (; i + LANES <= count; i += LANES) {
+      for (int lane = 0; lane < LANES; ++lane) {
+         const int64 value = values[i + lane];
+
+         mins[lane] = value < mins[lane] ? value : mins[lane];
+         maxs[lane] = value > maxs[lane] ? value : maxs[lane];
+      }
+   }
+
+   for (; i < count; ++i) {
+      mins[0] = values[i] < mins[0] ? values[i] : mins[0];
+      maxs[0] = values[i] > maxs[0] ? values[i] : maxs[0];
+   }
+
+   min = std::min(std::min(mins[0], mins[1]), std::min(mins[2], mins[3]));
+   max = std::max(std::max(maxs[0], maxs[1]), std::max(maxs[2], maxs[3]));
+}
+
+// start of period of given length in milliseconds with time
+static int64 periodStart(int64 time, int64 length) {
+   const int64 remainder = time % length;
+
+   return time - (remainder < 0 ? remainder + length : remainder);
+}
+
+/**
+ * Calls add(start, first, end) for every range of times within one
+ * period, times are in order.
+ */
+template <typename Add>
+static void forEachPeriod(const int64 *times, uint64 count, int64 length, const Add &add) {
+   uint64 first = 0;
+
+   while (first < count) {
+      const int64 start = periodStart(times[first], length);
+      const uint64 end = std::lower_bound(times + first + 1, times + count, start + length) - times;
+
+      add(start, first, end);
+
+      first = end;
+   }
+}
+
+void TicksToPeriods::Periods::add(int64 time, int64 open, int64 close, int64 min, int64 max) {
+   times.push_back(time);
+   opens.push_back(open);
+   closes.push_back(close);
+   mins.push_back(min);
+   maxs.push_back(max);
+}
+
+void TicksToPeriods::Periods::append(const Periods &later) {
+   uint64 from = 0;
+
+   if (!times.empty() && later.size() > 0 && times.back() == later.times[0]) {
+      closes.back() = later.closes[0];
+      mins.back() = std::min(mins.back(), later.mins[0]);
+      maxs.back() = std::max(maxs.back(), later.maxs[0]);
+
+      from = 1;
+   }
+
+   times.insert(times.end(), later.times.begin() + from, later.times.end());
+   opens.insert(opens.end(), later.opens.begin() + from, later.opens.end());
+   closes.insert(closes.end(), later.closes.begin() + from, later.closes.end());
+   mins.insert(mins.end(), later.mins.begin() + from, later.mins.end());
+   maxs.insert(maxs.end(), later.maxs.begin() + from, later.maxs.end());
+}
+
+void TicksToPeriods::buildPart(const int64 *times,
+                               const int64 *prices,
+                               uint64 count,
+                               const std::vector<int> &lengths,
+                               std::vector<Periods> &output) {
+   output.assign(lengths.size(), Periods());
+
+   // shorter periods are built first, so longer can be built from them
+   std::vector<int> order(lengths.size());
+   for (size_t i = 0; i < order.size(); ++i) order[i] = i;
+
+   std::sort(order.begin(),
+             order.end(),
+             [&lengths](int left, int right) -> bool {
+                return lengths[left] < lengths[right];
+             } );
+
+   for (size_t i = 0; i < order.size(); ++i) {
+      Periods &periods = output[order[i]];
+      periods.length = lengths[order[i]];
+
+      const int64 length = (int64)periods.length * 1000;
+
+      // the longest of built periods this one is multiple of
+      const Periods *source = nullptr;
+
+      for (size_t j = i; j-- > 0; ) {
+         const Periods &shorter = output[order[j]];
+
+         if (shorter.length < periods.length && periods.length % shorter.length == 0) {
+            source = &shorter;
+            break;
+         }
+      }
+
+      if (source == nullptr) {
+         forEachPeriod(times,
+                       count,
+                       length,
+                       [prices, &periods](int64 start, uint64 first, uint64 end) -> void {
+                          int64 min, max;
+                          reduce(prices + first, end - first, min, max);
+
+                          periods.add(start, prices[first], prices[end - 1], min, max);
+                       } );
+      } else {
+         const Periods &shorter = *source;
+
+         forEachPeriod(shorter.times.data(),
+                       shorter.size(),
+                       length,
+                       [&shorter, &periods](int64 start, uint64 first, uint64 end) -> void {
+                          int64 min, max, unused;
+                          reduce(shorter.mins.data() + first, end - first, min, unused);
+                          reduce(shorter.maxs.data() + first, end - first, unused, max);
+
+                          periods.add(start, shorter.opens[first], shorter.closes[end - 1], min, max);
+                       } );
+      }
+   }
+}
+
+void TicksToPeriods::build(const int64 *times,
+                           const int64 *prices,
+                           uint64 count,
+                           const std::vector<int> &lengths,
+                           int threads,
+                           std::vector<Periods> &output) {
+   if (threads < 1) threads = 1;
+   if ((uint64)threads > count) threads = count > 0 ? count : 1;
+
+   std::vector<std::vector<Periods> > parts(threads);
+   std::vector<Thread *> workers;
+
+   for (int i = 0; i < threads; ++i) {
+      const uint64 first = count * i / threads;
+      const uint64 end = count * (i + 1) / threads;
+      std::vector<Periods> &part = parts[i];
+
+      const Thread::Action action = [times, prices, first, end, &lengths, &part]() -> void {
+         buildPart(times + first, prices + first, end - first, lengths, part);
+      };
+
+      if (i + 1 < threads) {
+         workers.push_back(Platform::instance().createThread(action));
+      } else {
+         action();
+      }
+   }
+
+   for (Thread *worker : workers) Thread::joinAndDelete(worker);
+
+   output.swap(parts[0]);
+
+   for (int i = 1; i < threads; ++i) {
+      for (size_t j = 0; j < output.size(); ++j) output[j].append(parts[i][j]);
+   }
+}
+
+std::string TicksToPeriods::name(int length) {
+   switch (length) {
+   case M1: return "M1";
+   case M5: return "M5";
+   case M15: return "M15";
+   case M30: return "M30";
+   case H1: return "H1";
+   case H4: return "H4";
+   case D1: return "D1";
+   }
+
+   char buffer[16];
+   snprintf(buffer, sizeof(buffer), "%d", length);
+
+   return buffer;
+}
@@ -0,0 +1,84 @@
+#ifndef __1E5C7B93A2D64F08B6A9C3E5D7F18240_TICKSTOPERIODS_H_INCLUDED__
+#define __1E5C7B93A2D64F08B6A9C3E5D7F18240_TICKSTOPERIODS_H_INCLUDED__
+
+#include <string>
+#include <vector>
+#include "common.h"
+
+/**
+ * Builds bid periods (open, close, min and max price) of several lengths
+ * from ticks at once, as the hub's Ticks2Periods does for one of them.
+ *
+ * Period starts at time which is multiple of its length since 1970, so D1
+ * periods start at midnight. Periods without ticks are not built. Ticks
+ * should be in order of time.
+ *
+ * Only the shortest period and periods which are not multiple of any
+ * other are built from ticks, the rest are built from the longest period
+ * they are multiple of (M5 from M1, H4 from H1). Min and max of the range
+ * are reduced in several independent lanes, without branches.
+ *
+ * With several threads ticks are split to equal parts, every thread builds
+ * all periods of its part and periods cut by the split are merged.
+ */
+class TicksToPeriods {
+public:
+
+   // lengths of mt's timeframes in seconds
+   enum {
+      M1 = 60,
+      M5 = 5 * M1,
+      M15 = 15 * M1,
+      M30 = 30 * M1,
+      H1 = 60 * M1,
+      H4 = 4 * H1,
+      D1 = 24 * H1
+   };
+
+   /**
+    * Periods of one length as columns, times are starts of periods in
+    * milliseconds, prices are as of ticks.
+    */
+   struct Periods {
+      Periods() : length(0) {}
+
+      // in seconds
+      int length;
+
+      std::vector<int64> times;
+      std::vector<int64> opens;
+      std::vector<int64> closes;
+      std::vector<int64> mins;
+      std::vector<int64> maxs;
+
+      uint64 size() const { return times.size(); }
+
+      void add(int64 time, int64 open, int64 close, int64 min, int64 max);
+
+      // adds periods of later ticks, the first is merged if it's the same
+      void append(const Periods &later);
+   };
+
+   /**
+    * Builds periods of every length in seconds to output in the same
+    * order.
+    */
+   static void build(const int64 *times,
+                     const int64 *prices,
+                     uint64 count,
+                     const std::vector<int> &lengths,
+                     int threads,
+                     std::vector<Periods> &output);
+
+   // mt's name of timeframe (M1, H4) or length in seconds
+   static std::string name(int length);
+
+private:
+   static void buildPart(const int64 *times,
+                         const int64 *prices,
+                         uint64 count,
+                         const std::vector<int> &lengths,
+                         std::vector<Periods> &output);
+};
+
+#endif 	// __1E5C7B93A2D64F08B6A9C3E5D7F18240_TICKSTOPERIODS_H_INCLUDED__
@@ -1,22 +1,34 @@
 #include "types.h"
-#include <limits>
+#include <stdio.h>
 
-const double InvalidDoubleValue = std::numeric_limits<double>::min();
+std::ostream &operator<<(std::ostream &str, const Price &price) {
+   const uint64 absolute = price.units() < 0 ? -(uint64)price.units() : price.units();
+
+   char fraction[Price::DIGITS + 2];
+   snprintf(fraction, sizeof(fraction), ".%010llu", absolute % Price::SCALE);
+
+   // trailing zeros are dropped, and the point if nothing is left
+   int length = Price::DIGITS;
+   while (length > 0 && fraction[length] == '0') --length;
+
+   if (price.units() < 0) str << '-';
+
+   str << absolute / Price::SCALE;
+   str.write(fraction, length > 0 ? length + 1 : 0);
+
+   return str;
+}
 
 Boundary::Boundary()
-   : _value(InvalidDoubleValue) {
+   : _value() {
       
 }
 
-Boundary::Boundary(const double value)
+Boundary::Boundary(const Price &value)
    : _value(value) {
       
 } 
 
-double Boundary::value() const {
-   return _value;
-} 
-   
 Boundary::~Boundary() {}
 
 
@@ -25,7 +37,7 @@ std::ostream &operator<<(std::ostream &str, const Boundary &boundary) {
    return str;
 }
 
-TradeRequest::TradeRequest(double value,
+TradeRequest::TradeRequest(const Price &value,
                            TradeType tradeType,
                            const Option<Boundary> &delay)
    : _value(value)
@@ -34,7 +46,7 @@ TradeRequest::TradeRequest(double value,
       
 } 
 
-double TradeRequest::value() const {
+const Price &TradeRequest::value() const {
    return _value;
 }
    
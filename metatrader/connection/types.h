@@ -2,33 +2,114 @@
 #define __5B38EFCBEAF9BC48BC4BB89BC5A06F67_TYPES_H_INCLUDED__
 
 #include "Option.h"
+#include "common.h"
+#include <math.h>
 
 enum TradeType {
    TradeBuy = 1,
    TradeSell = 2
 };
 
+/**
+ * Price, or amount of money, in SCALE parts as the hub's Fraction, so it
+ * is compared exactly, added without rounding and goes to the wire as
+ * Fraction's 8 bytes. Doubles of mt are rounded to digits of the symbol
+ * when converted, as NormalizeDouble() does.
+ */
+class Price {
+public:
+
+   enum {
+      DIGITS = 10
+   };
+
+   static const int64 SCALE = 10000000000LL;
+
+   Price() : _units(0) {}
+
+   static Price fromUnits(int64 units) { return Price(units); }
+
+   static Price fromDouble(double value, int digits = DIGITS) {
+      const int64 point = pointUnits(digits);
+
+      return Price(llround(value * (SCALE / point)) * point);
+   }
+
+   // 10^-digits
+   static Price point(int digits) { return Price(pointUnits(digits)); }
+
+   int64 units() const { return _units; }
+
+   double toDouble() const { return (double)_units / SCALE; }
+
+   // to the closest multiple of point of digits, halves away from zero
+   Price rounded(int digits) const {
+      const int64 point = pointUnits(digits);
+      const int64 half = _units < 0 ? -point / 2 : point / 2;
+
+      return Price((_units + half) / point * point);
+   }
+
+   bool isZero() const { return _units == 0; }
+
+   Price abs() const { return Price(_units < 0 ? -_units : _units); }
+
+   Price operator-() const { return Price(-_units); }
+
+   Price operator+(const Price &other) const { return Price(_units + other._units); }
+   Price operator-(const Price &other) const { return Price(_units - other._units); }
+
+   Price operator*(int64 times) const { return Price(_units * times); }
+   Price operator/(int64 divider) const { return Price(_units / divider); }
+
+   bool operator==(const Price &other) const { return _units == other._units; }
+   bool operator!=(const Price &other) const { return _units != other._units; }
+   bool operator<(const Price &other) const { return _units < other._units; }
+   bool operator>(const Price &other) const { return _units > other._units; }
+   bool operator<=(const Price &other) const { return _units <= other._units; }
+   bool operator>=(const Price &other) const { return _units >= other._units; }
+
+private:
+   explicit Price(int64 units) : _units(units) {}
+
+   static int64 pointUnits(int digits) {
+      static const int64 POINTS[DIGITS + 1] = {
+         10000000000LL, 1000000000LL, 100000000LL, 10000000LL, 1000000LL,
+         100000LL, 10000LL, 1000LL, 100LL, 10LL, 1LL
+      };
+
+      return POINTS[digits < 0 ? 0 : digits > DIGITS ? DIGITS : digits];
+   }
+
+private:
+   int64 _units;
+};
+
+// as Fraction's toString
+std::ostream &operator<<(std::ostream &str, const Price &price);
+
 class Boundary {
 public:
    Boundary();
-   Boundary(const double value);
+   Boundary(const Price &value);
 
-   double value() const;
+   const Price &value() const { return _value; }
    
    ~Boundary();
 private:
-   double _value;
+   Price _value;
 };
 
 std::ostream &operator<<(std::ostream &str, const Boundary &boundary); 
    
 class TradeRequest {
 public:
-   TradeRequest(double value,
+   // value is amount of money, as the hub's Fraction
+   TradeRequest(const Price &value,
                 TradeType tradeType,
                 const Option<Boundary> &delay);
 
-   double value() const;
+   const Price &value() const;
    TradeType tradeType() const;
    const Option<Boundary> &delay() const;
    
@@ -36,7 +117,7 @@ public:
 
 private:
 
-   const double _value;
+   const Price _value;
    const TradeType _tradeType;
    const Option<Boundary> _delay;
 };
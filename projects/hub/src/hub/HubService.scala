@@ -42,6 +42,9 @@ class HubService(runLoop:RunLoop,
                                               bindAddress,
                                               onNewConnection)
 
+  // of ticks providers, so reconnected one is asked for ticks it sent meanwhile
+  private val _tickSequences = Map[String, Long]()
+
   private val _tickProviderControllerFactory = new RelayChannel.ControllerFactory {
       def create(logger:Logger,
                  client:ConnectionHandle,
@@ -49,7 +52,8 @@ class HubService(runLoop:RunLoop,
                  onDisconnected:()=>Unit) = new TickProviderController(logger,
                                                                        client,
                                                                        key,
-                                                                       onDisconnected)
+                                                                       onDisconnected,
+                                                                       _tickSequences)
     }
 
   private val _ticksProviders =  new RelayChannel (logger, "tick provider")
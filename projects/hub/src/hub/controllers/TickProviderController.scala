@@ -1,6 +1,9 @@
 package tas.hub.controllers
 
-import scala.collection.mutable.ListBuffer
+import scala.collection.mutable.{
+  ListBuffer,
+  Map
+}
 
 import tas.service.ConnectionHandle
 
@@ -16,16 +19,32 @@ import tas.output.logger.Logger
 class TickProviderController(logger:Logger,
                              client:ConnectionHandle,
                              providerKey:String,
-                             onTickproviderDisconnected:()=>Unit) extends RelayChannel.Controller {
+                             onTickproviderDisconnected:()=>Unit,
+                             // last tick of every provider key, outlives providers
+                             tickSequences:Map[String, Long]) extends RelayChannel.Controller {
 
   private val _tickListeners = new ListBuffer[ConnectionHandle]
 
   client.setHandlers(onPacket = onIncomingPacket _,
                      onDisconnect = dropThisProvider _)
 
+  // ticks lost while provider was away are sent again
+  client.sendRawData(HubProtocol.writePacket(new HubProtocol.ResumeTicks(tickSequences.get(providerKey) match {
+                                                                            case Some(last) => last + 1
+                                                                            case None => 0
+                                                                          })))
+
   private def onIncomingPacket(packet:Array[Byte]) = {
     HubProtocol.readPacket(packet) match {
-      case _:HubProtocol.OnTick => {
+      case HubProtocol.OnTick(sequence, _, _, _) => {
+        // lower sequence is of restarted provider, it numbers ticks from 1 again
+        tickSequences.get(providerKey).foreach(last => {
+                                                 if (sequence > last + 1) {
+                                                   logger.log("Tick provider \"" + providerKey + "\" lost " + (sequence - last - 1) + " ticks")
+                                                 }
+                                               })
+
+        tickSequences(providerKey) = sequence
 
         _tickListeners.foreach(_.sendRawData(packet))
       }
@@ -104,7 +104,12 @@ class HubServiceTests extends FlatSpec with MockFactory {
         def onResouceConnected() = {
           // send several ticks
 
-          def sendTick(price:Price) = providerConnection.sendRawData(HubProtocol.writePacket(new HubProtocol.OnTick(price.bid, price.ask)))
+          var sequence = 0L
+
+          def sendTick(price:Price) = {
+            sequence += 1
+            providerConnection.sendRawData(HubProtocol.writePacket(new HubProtocol.OnTick(sequence, 0, price.bid, price.ask)))
+          }
 
           sendTick(Price.fromBid(Fraction("1.1"), 1))
           sendTick(Price.fromBid(Fraction("2.1"), 2))
@@ -123,7 +128,7 @@ class HubServiceTests extends FlatSpec with MockFactory {
                                                onResouceConnected()
                                              }
 
-                                             case HubProtocol.OnTick(bid, ask) => {
+                                             case HubProtocol.OnTick(_, _, bid, ask) => {
                                                onTickCall(new Price(bid, ask))
                                              }
 
@@ -142,6 +147,7 @@ class HubServiceTests extends FlatSpec with MockFactory {
                                              onRegistered()
                                              onRegisteredCall()
                                            }
+                                           case _:HubProtocol.ResumeTicks => /* nothing to replay */
                                            case _ => throw new Error("hub sent wrong packet")
                                          }
                                        },
@@ -194,6 +200,7 @@ class HubServiceTests extends FlatSpec with MockFactory {
                                              onRegistered()
                                              onRegisteredCall()
                                            }
+                                           case _:HubProtocol.ResumeTicks => /* nothing to replay */
                                            case _ => throw new Error("hub sent wrong packet")
                                          }
                                        },
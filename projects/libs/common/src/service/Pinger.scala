@@ -6,6 +6,22 @@ import tas.concurrency.RunLoop
 
 private object Pinger {
   val PingPacket = Array[Byte]()
+
+  // probe is sent by the metatrader connector to measure round trip time,
+  // it is marked by negative packet name size and should be echoed back
+  // with reply marker
+  private val ProbeSize = 12
+  private val ProbeMarker:Byte = -1
+  private val ProbeReplyMarker:Byte = -2
+
+  def isProbe(buffer:Array[Byte]) =
+    buffer.length == ProbeSize && buffer.take(4).forall(_ == ProbeMarker)
+
+  def probeReply(probe:Array[Byte]) = {
+    val reply = probe.clone()
+    reply(3) = ProbeReplyMarker
+    reply
+  }
 }
 
 private abstract class Pinger(runLoop:RunLoop,
@@ -23,9 +39,13 @@ private abstract class Pinger(runLoop:RunLoop,
 
 
   def consumePing(buffer:Array[Byte]) = {
+    // any packet proves that other side is alive
+    repostTimeout()
+
     if (Arrays.equals(buffer, Pinger.PingPacket)) {
-      // it is ping
-      repostTimeout()
+      true
+    } else if (Pinger.isProbe(buffer)) {
+      sendPingReply(Pinger.probeReply(buffer))
       true
     } else false
   }
@@ -49,6 +69,7 @@ private abstract class Pinger(runLoop:RunLoop,
   }
 
   protected def sendPing()
+  protected def sendPingReply(reply:Array[Byte])
   protected def onPingTimedOut()
 
   def stop() = {
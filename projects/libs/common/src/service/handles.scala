@@ -81,6 +81,10 @@ final class SocketConnectionHandle(runLoop:RunLoop,
         sendRawData(Pinger.PingPacket)
       }
 
+      def sendPingReply(reply:Array[Byte]) = {
+        sendRawData(reply)
+      }
+
       def onPingTimedOut() = {
         println("Ping timed out!")
         onConnectionLost()
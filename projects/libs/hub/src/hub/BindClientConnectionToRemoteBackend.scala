@@ -60,8 +60,21 @@ class BindClientConnectionToRemoteBackend(logger:Logger,
         send(new NewId(allocateNewId()))
       }
 
+      case RequestNewIdRange(count) => {
+        _idRangeSize = math.max(1, math.min(count, MaxIdRangeSize))
+        _lastUsedId = _nextId
+
+        grantIdRangeIfLow()
+      }
+
       case OpenTrade(id, request, stopValue, takeProfit) => {
 
+        if (_idRangeSize > 0 && id > _lastUsedId && id <= _nextId) {
+          _lastUsedId = id
+
+          grantIdRangeIfLow()
+        }
+
         def onMessage(message:String) = {
           send(new MessageAboutTrade(id, message))
         }
@@ -107,6 +120,24 @@ class BindClientConnectionToRemoteBackend(logger:Logger,
     _nextId
   }
 
+  private val MaxIdRangeSize = 1024
+
+  // zero till client asks for ranges, as trade connector does
+  private var _idRangeSize = 0
+  // last id of ranges client opened trade with
+  private var _lastUsedId:Long = 0
+
+  private def grantIdRangeIfLow() = {
+    // a quarter of range is left for ids in flight to the client
+    if (_nextId - _lastUsedId <= _idRangeSize / 4) {
+      val start = _nextId + 1
+
+      _nextId += _idRangeSize
+
+      send(new NewIdRange(start, _idRangeSize))
+    }
+  }
+
   private def send(packet:Packet) = if ( !isClosed ) remoteTradeClient.sendRawData(writePacket(packet))
 
   private def onDisconnected() = {
@@ -37,7 +37,8 @@ private object CPPIO {
       new String(bytes, ENCODING)
     }
 
-    def readFraction() = Fraction(readUTF8String())
+    // 8 bytes of Fraction, as connector's Price
+    def readFraction() = Fraction.IO.dataInputStream2FractionReader(stream).readFraction()
 
     def readTradeRequest():TradeRequest = {
       new TradeRequest(readFraction(),
@@ -90,7 +91,7 @@ private object CPPIO {
       stream.write(bytes, 0, length)
     }
 
-    def writeFraction(fraction:Fraction) = writeUTF8String(fraction.toString)
+    def writeFraction(fraction:Fraction) = Fraction.IO.dataOutputStream2FractionWriter(stream).writeFraction(fraction)
 
     def writeClassName(o:AnyRef) = {
       writeUTF8String(o.getClass.getSimpleName)
@@ -156,7 +157,15 @@ object HubProtocol {
   case class TradeConnectorConnected(val balance:Fraction,
                                      val equity:Fraction) extends Packet
 
-  case class OnTick(val bid:Fraction, val ack:Fraction) extends Packet
+  // sequence is of provider, from 1, time is of terminal in milliseconds
+  case class OnTick(val sequence:Long,
+                    val time:Long,
+                    val bid:Fraction,
+                    val ack:Fraction) extends Packet
+
+  // to registered provider: ticks from sequence on are sent again, 0 when
+  // provider wasn't seen before
+  case class ResumeTicks(val sequence:Long) extends Packet
 
   case class AskTicksProvider(val key:String) extends Packet
   case class AskTradeConnector(val key:String) extends Packet
@@ -168,6 +177,12 @@ object HubProtocol {
     override def toString() = "NewId: " + id
   }
 
+  // sent once after registration, trade connector grants ranges of ids
+  // then, next one unasked while ids of previous are used
+  case class RequestNewIdRange(val count:Int) extends Packet
+  // ids from start on are valid till connection is lost
+  case class NewIdRange(val start:Long, val count:Int) extends Packet
+
   case class FreeTrade(id:Long) extends Packet
 
   case class OpenTrade(val id:Long,
@@ -206,10 +221,13 @@ object HubProtocol {
                       }
                       case Registered() => /* no data, do nothing */
                       case AlreadyRegistered() => /* no data, do nothing */
-                      case OnTick(bid, ask) => {
+                      case OnTick(sequence, time, bid, ask) => {
+                        stream.writeLong(sequence)
+                        stream.writeLong(time)
                         stream.writeFraction(bid)
                         stream.writeFraction(ask)
                       }
+                      case ResumeTicks(sequence) => stream.writeLong(sequence)
                       case AskTicksProvider(key) => {
                         stream.writeUTF8String(key)
                       }
@@ -226,6 +244,11 @@ object HubProtocol {
                       case NewId(id) => {
                         stream.writeLong(id)
                       }
+                      case RequestNewIdRange(count) => stream.writeInt(count)
+                      case NewIdRange(start, count) => {
+                        stream.writeLong(start)
+                        stream.writeInt(count)
+                      }
                       case FreeTrade(id) => {
                         stream.writeLong(id)
                       }
@@ -272,8 +295,11 @@ object HubProtocol {
                                                                                   stream.readFraction())
                       case "Registered" => new Registered()
                       case "AlreadyRegistered" => new AlreadyRegistered()
-                      case "OnTick" => new OnTick(stream.readFraction(),
+                      case "OnTick" => new OnTick(stream.readLong(),
+                                                  stream.readLong(),
+                                                  stream.readFraction(),
                                                   stream.readFraction())
+                      case "ResumeTicks" => new ResumeTicks(stream.readLong())
                       case "AskTicksProvider" => new AskTicksProvider(stream.readUTF8String())
                       case "AskTradeConnector" => new AskTradeConnector(stream.readUTF8String())
                       case "TickProviderConnected" => new TickProviderConnected()
@@ -284,6 +310,10 @@ object HubProtocol {
 
                       case "NewId" => new NewId(stream.readLong())
 
+                      case "RequestNewIdRange" => new RequestNewIdRange(stream.readInt())
+                      case "NewIdRange" => new NewIdRange(stream.readLong(),
+                                                          stream.readInt())
+
                       case "FreeTrade" => new FreeTrade(stream.readLong())
 
                       case "OpenTrade" => new OpenTrade(stream.readLong(),
@@ -63,7 +63,7 @@ class HubConnectionTicksSource(runLoop:RunLoop,
 
   private def onPacketReceived(packet:Array[Byte]) = {
     HubProtocol.readPacket(packet) match {
-      case HubProtocol.OnTick(bid, ack) => _event << new Price(bid, ack)
+      case HubProtocol.OnTick(_, _, bid, ack) => _event << new Price(bid, ack)
       case HubProtocol.ResourceNotFound() => {
         _client.close()
         _client = null
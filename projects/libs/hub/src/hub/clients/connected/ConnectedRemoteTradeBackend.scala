@@ -12,7 +12,10 @@ import tas.service.{
 
 import tas.output.logger.Logger
 
-import scala.collection.mutable.ListBuffer
+import scala.collection.mutable.{
+  ListBuffer,
+  Queue
+}
 
 import tas.{
   Bound
@@ -36,9 +39,14 @@ class ConnectedRemoteTradeBackend(connection:ConnectionHandle,
   private var _executors = new ListBuffer[Executor]
   private var _disconnected = false
 
+  // of NewIdRange and of NewId which came after executor got other id
+  private val _grantedIds = new Queue[Long]
+
   connection.setHandlers(onPacket = handleRawPacket _,
                          onDisconnect = onDisconnect)
 
+  sendPacket(new RequestNewIdRange(ConnectedRemoteTradeBackend.IdRangeSize))
+
   private def onDisconnect():Unit = {
     connection.close()
     _disconnected = true
@@ -54,6 +62,10 @@ class ConnectedRemoteTradeBackend(connection:ConnectionHandle,
                                    onFreed,
                                    sendPacket _)
     _executors += newExecutor
+
+    if (_grantedIds.isEmpty) sendPacket(new RequestNewId())
+    else newExecutor.connected(_grantedIds.dequeue())
+
     newExecutor
   }
 
@@ -70,7 +82,8 @@ class ConnectedRemoteTradeBackend(connection:ConnectionHandle,
       case OpenedResponse(id) => forExecutorWithId(id, _.opened)
       case ExternallyClosed(id) => forExecutorWithId(id, _.externallyClosed)
 
-      case NewId(id) => forExecutorWithoutId(_.connected(id))
+      case NewId(id) => onNewIds(List(id))
+      case NewIdRange(start, count) => onNewIds(start until (start + count))
       case MessageAboutTrade(id, message) => forExecutorWithId(id, _.messageHandler(message))
       case FreeTrade(id) => freeExecutorWithId(id)
 
@@ -107,11 +120,22 @@ class ConnectedRemoteTradeBackend(connection:ConnectionHandle,
     }
   }
 
-  private def forExecutorWithoutId(action:Executor=>Unit) = {
-    forExecutorWithId(InvalidId, action)
+  // executors waiting for id take the first ones, whichever packet brings
+  // them, the rest is kept for next executors
+  private def onNewIds(ids:Seq[Long]) = {
+    _grantedIds ++= ids
+
+    for (executor <- _executors if executor.id == InvalidId && _grantedIds.nonEmpty) {
+      executor.connected(_grantedIds.dequeue())
+    }
   }
 
   final def close() = {
     connection.close()
   }
 }
+
+object ConnectedRemoteTradeBackend {
+  // trade connector caps it at 1024
+  val IdRangeSize = 64
+}
@@ -55,8 +55,6 @@ private [connected] class Executor(tradeRequest:TradeRequest,
   private var _onOpened:()=>Unit = null
   private var _onExtrnallyClosed:()=>Unit = null
 
-  sendPacket(new RequestNewId())
-  
   def openTrade(stopValue:Boundary,
                 takeProfit:Option[Boundary],
                 onOpened:()=>Unit,
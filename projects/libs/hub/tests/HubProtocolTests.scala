@@ -46,8 +46,11 @@ class HubProtocolTests extends ProtocolTests[Packet] {
 
   testPacket(List(new AlreadyRegistered()))  
 
-  testPacket(List(new OnTick(Fraction("0.12"), Fraction("0.13")),
-                  new OnTick(Fraction("1.610002"), Fraction("1.6100021"))))
+  testPacket(List(new OnTick(1, 1400000000000L, Fraction("0.12"), Fraction("0.13")),
+                  new OnTick(42, 1400000000001L, Fraction("1.610002"), Fraction("1.6100021"))))
+
+  testPacket(List(new ResumeTicks(0),
+                  new ResumeTicks(4097)))
 
   testPacket(List(new AskTicksProvider("t"),
                   new AskTicksProvider("ee")))
@@ -64,6 +67,8 @@ class HubProtocolTests extends ProtocolTests[Packet] {
 
   testPacket(List(new RequestNewId()))
   testPacket(List(new NewId(Constants.TestId)))
+  testPacket(List(new RequestNewIdRange(64)))
+  testPacket(List(new NewIdRange(Constants.TestId, 64)))
   testPacket(List(new FreeTrade(Constants.TestId)))
 
   testPacket(List(new OpenTrade(Constants.TestId,
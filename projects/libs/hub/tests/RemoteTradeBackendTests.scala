@@ -97,6 +97,14 @@ class RemoteTradeBackendTests extends FlatSpec with MockFactory with RunLoopSupp
 
   trait Executor extends TradeExecutor with NotBound
 
+  // sent by backend when created
+  def expectIdRangeRequest(connection:ConnectionHandle) = {
+    (connection.sendRawData _).expects(*)
+      .onCall((packet:Array[Byte]) => {
+                assert(HubProtocol.readPacket(packet) === new HubProtocol.RequestNewIdRange(ConnectedRemoteTradeBackend.IdRangeSize))
+              } )
+  }
+
   
   it should "propagate basic lifecycle events and gracefully terminate" in runLoopTest {
 
@@ -275,6 +283,8 @@ class RemoteTradeBackendTests extends FlatSpec with MockFactory with RunLoopSupp
                                                       rawPacketHandler = packetHandler
                                                     })
 
+    expectIdRangeRequest(connection)
+
     val backend = new ConnectedRemoteTradeBackend(connection,
                                                   logger,
                                                   "0",
@@ -328,6 +338,8 @@ class RemoteTradeBackendTests extends FlatSpec with MockFactory with RunLoopSupp
                                                       rawPacketHandler = packetHandler
                                                     })
 
+    expectIdRangeRequest(connection)
+
     val backend = new ConnectedRemoteTradeBackend(connection,
                                                   logger,
                                                   "0",
@@ -408,5 +420,110 @@ class RemoteTradeBackendTests extends FlatSpec with MockFactory with RunLoopSupp
 
   }
 
-  
+  it should "take ids of trades from granted ranges and ask for id when none is left" in runLoopTest {
+
+    import HubProtocol._
+
+    val connection = mock[ConnectionHandle]
+    val onDisconnect = mock[()=>Unit]
+
+    var rawPacketHandler:(Array[Byte])=>Unit = null
+
+    (connection.setHandlers _).expects(*, *).onCall((packetHandler, _) => {
+                                                      rawPacketHandler = packetHandler
+                                                    })
+
+    def expectPacket(expected:Packet) = {
+      (connection.sendRawData _).expects(*)
+        .onCall((packet:Array[Byte]) => {
+                  assert(readPacket(packet) === expected)
+                } )
+    }
+
+    def openTrade(id:Long) = new OpenTrade(id, Constants.TestRequest, Constants.TestBoundary, None)
+
+    inSequence {
+      expectPacket(new RequestNewIdRange(ConnectedRemoteTradeBackend.IdRangeSize))
+      expectPacket(openTrade(100))
+      expectPacket(openTrade(101))
+      expectPacket(new RequestNewId())
+      expectPacket(openTrade(7))
+    }
+
+    val backend = new ConnectedRemoteTradeBackend(connection,
+                                                  logger,
+                                                  "0",
+                                                  "0",
+                                                  onDisconnect)
+
+    rawPacketHandler(writePacket(new NewIdRange(100, 2)))
+
+    def newTrade() = backend.newTradeExecutor(Constants.TestRequest,
+                                              ignoreMessages,
+                                              () => {}).openTrade(Constants.TestBoundary,
+                                                                  None,
+                                                                  () => {},
+                                                                  () => {})
+
+    newTrade()
+    newTrade()
+    newTrade()
+
+    rawPacketHandler(writePacket(new NewId(7)))
+
+    complete
+  }
+
+  it should "give granted range to trade which asked for id and keep late id for next trade" in runLoopTest {
+
+    import HubProtocol._
+
+    val connection = mock[ConnectionHandle]
+    val onDisconnect = mock[()=>Unit]
+
+    var rawPacketHandler:(Array[Byte])=>Unit = null
+
+    (connection.setHandlers _).expects(*, *).onCall((packetHandler, _) => {
+                                                      rawPacketHandler = packetHandler
+                                                    })
+
+    def expectPacket(expected:Packet) = {
+      (connection.sendRawData _).expects(*)
+        .onCall((packet:Array[Byte]) => {
+                  assert(readPacket(packet) === expected)
+                } )
+    }
+
+    def openTrade(id:Long) = new OpenTrade(id, Constants.TestRequest, Constants.TestBoundary, None)
+
+    inSequence {
+      expectPacket(new RequestNewIdRange(ConnectedRemoteTradeBackend.IdRangeSize))
+      expectPacket(new RequestNewId())
+      expectPacket(openTrade(100))
+      expectPacket(openTrade(7))
+    }
+
+    val backend = new ConnectedRemoteTradeBackend(connection,
+                                                  logger,
+                                                  "0",
+                                                  "0",
+                                                  onDisconnect)
+
+    def newTrade() = backend.newTradeExecutor(Constants.TestRequest,
+                                              ignoreMessages,
+                                              () => {}).openTrade(Constants.TestBoundary,
+                                                                  None,
+                                                                  () => {},
+                                                                  () => {})
+
+    // range comes before the answer to RequestNewId
+    newTrade()
+
+    rawPacketHandler(writePacket(new NewIdRange(100, 1)))
+    rawPacketHandler(writePacket(new NewId(7)))
+
+    newTrade()
+
+    complete
+  }
 }